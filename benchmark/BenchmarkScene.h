@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "Core/MeshLoader.h"
+#include "Core/Intersection.h"
+#include "Core/Random.h"
+
+
+
+//the generated scene and the camera rays, which the traversal benchmarks share
+
+//a bumpy height field, so that some of the rays hit the scene more than once
+inline RT::Core::MeshInfo GenerateHeightField(uint32_t iGridSize)
+{
+	RT::Core::MeshInfo rtMesh{};
+	rtMesh.VertexCount = (uint64_t)(iGridSize + 1) * (uint64_t)(iGridSize + 1);
+	rtMesh.IndexCount = (uint64_t)iGridSize * (uint64_t)iGridSize * 6;
+	rtMesh.Vertices = new RT::Core::Vertex[rtMesh.VertexCount]{};
+	rtMesh.Indices = new RT::Core::Index[rtMesh.IndexCount];
+	uint32_t iSeed = 0x9e3779b9;
+
+	for (uint32_t y = 0; y <= iGridSize; y++)
+	{
+		for (uint32_t x = 0; x <= iGridSize; x++)
+		{
+			float fHeight = 4.0f * std::sin((float)x * 0.15f) * std::cos((float)y * 0.11f) + (float)(RT::Core::XorShift(iSeed) & 0xffff) / 65536.0f;
+			rtMesh.Vertices[y * (iGridSize + 1) + x].Position = RT::Math::float3((float)x, fHeight, (float)y);
+		}
+	}
+
+	//two triangles per cell
+	uint64_t iIndex = 0;
+	for (uint32_t y = 0; y < iGridSize; y++)
+	{
+		for (uint32_t x = 0; x < iGridSize; x++)
+		{
+			uint32_t iVertex = y * (iGridSize + 1) + x;
+			rtMesh.Indices[iIndex++] = iVertex;
+			rtMesh.Indices[iIndex++] = iVertex + 1;
+			rtMesh.Indices[iIndex++] = iVertex + iGridSize + 1;
+			rtMesh.Indices[iIndex++] = iVertex + 1;
+			rtMesh.Indices[iIndex++] = iVertex + iGridSize + 2;
+			rtMesh.Indices[iIndex++] = iVertex + iGridSize + 1;
+		}
+	}
+
+	rtMesh.SceneAABB.Min = rtMesh.Vertices[0].Position;
+	rtMesh.SceneAABB.Max = rtMesh.Vertices[0].Position;
+	for (uint64_t i = 1; i < rtMesh.VertexCount; i++)
+	{
+		rtMesh.SceneAABB.Min = RT::Math::min(rtMesh.SceneAABB.Min, rtMesh.Vertices[i].Position);
+		rtMesh.SceneAABB.Max = RT::Math::max(rtMesh.SceneAABB.Max, rtMesh.Vertices[i].Position);
+	}
+
+	return rtMesh;
+}
+
+//the arrays of a loaded or generated mesh (without a scene cache)
+inline void FreeMesh(RT::Core::MeshInfo& rtMesh)
+{
+	delete[] rtMesh.Indices;
+	delete[] rtMesh.Vertices;
+	delete[] rtMesh.Materials;
+	delete[] rtMesh.TextureNames;
+	rtMesh = RT::Core::MeshInfo{};
+}
+
+
+//coherent rays: ray i of a grid of iSide x iSide rays from above the scene towards its center
+inline RT::Core::Ray GetCameraRay(const RT::Core::AABB& rtSceneAABB, uint32_t i, uint32_t iSide)
+{
+	const RT::Math::float3 rtCenter = 0.5f * (rtSceneAABB.Min + rtSceneAABB.Max);
+	const RT::Math::float3 rtExtent = rtSceneAABB.Max - rtSceneAABB.Min;
+	const RT::Math::float3 rtEye = RT::Math::float3(rtCenter.x, rtSceneAABB.Max.y + 0.5f * rtExtent.x, rtSceneAABB.Min.z - 0.25f * rtExtent.z);
+	float fX = ((float)(i % iSide) + 0.5f) / (float)iSide - 0.5f;
+	float fZ = ((float)(i / iSide) + 0.5f) / (float)iSide - 0.5f;
+	RT::Math::float3 rtTarget = rtCenter + RT::Math::float3(fX * rtExtent.x, 0.0f, fZ * rtExtent.z);
+
+	RT::Core::Ray rtRay;
+	rtRay.Origin = rtEye;
+	rtRay.Direction = RT::Math::normalize(rtTarget - rtEye);
+	rtRay.TMin = 0.0f;
+	rtRay.TMax = 1e30f;
+	return rtRay;
+}
+
+inline void GenerateCameraRays(const RT::Core::AABB& rtSceneAABB, std::vector<RT::Core::Ray>& rtRays)
+{
+	const uint32_t iSide = (uint32_t)std::sqrt((double)rtRays.size());
+	for (uint32_t i = 0; i < (uint32_t)rtRays.size(); i++)
+	{
+		rtRays[i] = GetCameraRay(rtSceneAABB, i, iSide);
+	}
+}
\ No newline at end of file
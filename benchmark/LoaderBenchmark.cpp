@@ -0,0 +1,178 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <filesystem>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#include "Core/MeshLoader.h"
+#include "Core/Parallel.h"
+#include "Core/Random.h"
+
+
+
+//write a height field with uvs, but without normals, so that every stage of the loader has to run
+static bool GenerateMeshFile(const std::string& sFileName, uint64_t iNumTriangles)
+{
+	const uint64_t iGridSize = std::max<uint64_t>(1, (uint64_t)std::sqrt((double)iNumTriangles / 2.0));
+	uint32_t iSeed = 0x9e3779b9;
+
+	std::ofstream stdFile(sFileName, std::ios::binary);
+	if (!stdFile) return false;
+
+	std::string sText;
+	char cNumber[32];
+	auto fnAppendFloat = [&](float fValue)
+	{
+		sText += ' ';
+		sText.append(cNumber, std::to_chars(cNumber, cNumber + sizeof(cNumber), fValue).ptr);
+	};
+	auto fnAppendIndex = [&](uint64_t iIndex)
+	{
+		sText += ' ';
+		sText.append(cNumber, std::to_chars(cNumber, cNumber + sizeof(cNumber), iIndex).ptr);
+		sText += '/';
+		sText.append(cNumber, std::to_chars(cNumber, cNumber + sizeof(cNumber), iIndex).ptr);
+	};
+	auto fnFlush = [&]()
+	{
+		stdFile.write(sText.data(), sText.size());
+		sText.clear();
+	};
+
+	//the vertices
+	for (uint64_t y = 0; y <= iGridSize; y++)
+	{
+		for (uint64_t x = 0; x <= iGridSize; x++)
+		{
+			sText += "v";
+			fnAppendFloat((float)x);
+			fnAppendFloat((float)(RT::Core::XorShift(iSeed) & 0xffff) / 65536.0f);
+			fnAppendFloat((float)y);
+			sText += "\nvt";
+			fnAppendFloat((float)x / (float)iGridSize);
+			fnAppendFloat((float)y / (float)iGridSize);
+			sText += '\n';
+		}
+		fnFlush();
+	}
+
+	//two triangles per cell
+	for (uint64_t y = 0; y < iGridSize; y++)
+	{
+		for (uint64_t x = 0; x < iGridSize; x++)
+		{
+			uint64_t iIndex = y * (iGridSize + 1) + x + 1;
+			sText += "f";
+			fnAppendIndex(iIndex);
+			fnAppendIndex(iIndex + 1);
+			fnAppendIndex(iIndex + iGridSize + 1);
+			sText += "\nf";
+			fnAppendIndex(iIndex + 1);
+			fnAppendIndex(iIndex + iGridSize + 2);
+			fnAppendIndex(iIndex + iGridSize + 1);
+			sText += '\n';
+		}
+		fnFlush();
+	}
+
+	return stdFile.good();
+}
+
+
+
+static void PrintUsage()
+{
+	std::cout << "Usage: LoaderBenchmark [OBJ file or number of triangles in millions] [repetitions]\n";
+}
+
+//returns false, if the argument isn't a whole number from iMin to iMax
+static bool ParseArgument(const char* sArgument, uint32_t iMin, uint32_t iMax, uint32_t& iValue)
+{
+	const char* pEnd = sArgument + std::strlen(sArgument);
+	std::from_chars_result stdResult = std::from_chars(sArgument, pEnd, iValue);
+	return (stdResult.ec == std::errc()) && (stdResult.ptr == pEnd) && (iValue >= iMin) && (iValue <= iMax);
+}
+
+
+
+int main(int argc, char** argv)
+{
+	std::string sFileName;
+	bool bGeneratedFile = false;
+	uint32_t iNumTriangles = 4;
+	uint32_t iRepetitions = 3;
+	const bool bLoadFile = (argc > 1) && (std::filesystem::exists(argv[1]));
+	if (((argc > 1) && (!bLoadFile) && (!(ParseArgument(argv[1], 1, 1024, iNumTriangles)))) ||
+		((argc > 2) && (!(ParseArgument(argv[2], 1, 0xffff, iRepetitions)))))
+	{
+		std::cout << "Invalid arguments\n\n";
+		PrintUsage();
+		return 1;
+	}
+
+	if (bLoadFile)
+	{
+		sFileName = argv[1];
+	}
+	else
+	{
+		sFileName = (std::filesystem::temp_directory_path() / "LoaderBenchmark.obj").string();
+		std::cout << "Generating " << sFileName << " with about " << iNumTriangles << " million triangles\n";
+		if (!(GenerateMeshFile(sFileName, (uint64_t)iNumTriangles << 20)))
+		{
+			std::cout << "Error writing " << sFileName << "\n";
+			return 1;
+		}
+		bGeneratedFile = true;
+	}
+
+	//keep the fastest time of every stage
+	RT::Core::MeshLoadTimings rtBestTimings{ 1e30, 1e30, 1e30, 1e30, 1e30, 1e30 };
+	uint64_t iLoadedTriangles = 0;
+	uint64_t iLoadedVertices = 0;
+	for (uint32_t i = 0; i < iRepetitions; i++)
+	{
+		RT::Core::MeshLoadTimings rtTimings{};
+		RT::Core::MeshInfo rtMesh = RT::Core::LoadMeshFromFile(sFileName, &rtTimings);
+		if (!(rtMesh.Indices))
+		{
+			std::cout << "Error loading " << sFileName << "\n";
+			return 1;
+		}
+		iLoadedTriangles = rtMesh.IndexCount / 3;
+		iLoadedVertices = rtMesh.VertexCount;
+		delete[] rtMesh.Indices;
+		delete[] rtMesh.Vertices;
+		delete[] rtMesh.Materials;
+		delete[] rtMesh.TextureNames;
+
+		rtBestTimings.Parsing = std::min(rtBestTimings.Parsing, rtTimings.Parsing);
+		rtBestTimings.Triangles = std::min(rtBestTimings.Triangles, rtTimings.Triangles);
+		rtBestTimings.Welding = std::min(rtBestTimings.Welding, rtTimings.Welding);
+		rtBestTimings.SceneBounds = std::min(rtBestTimings.SceneBounds, rtTimings.SceneBounds);
+		rtBestTimings.Normals = std::min(rtBestTimings.Normals, rtTimings.Normals);
+		rtBestTimings.Tangents = std::min(rtBestTimings.Tangents, rtTimings.Tangents);
+	}
+	if (bGeneratedFile) std::filesystem::remove(sFileName);
+
+	std::cout << "\nMesh loader, " << RT::Core::GetThreadCount() << " threads, " << iLoadedTriangles << " triangles, " << iLoadedVertices << " vertices\n\n";
+	std::cout << std::setw(16) << "stage" << std::setw(14) << "time (ms)" << std::setw(20) << "Mtriangles/s" << "\n";
+
+	const char* sStageNames[6] = { "parsing", "triangles", "welding", "scene bounds", "normals", "tangents" };
+	const double dStageTimes[6] = { rtBestTimings.Parsing, rtBestTimings.Triangles, rtBestTimings.Welding, rtBestTimings.SceneBounds,
+		rtBestTimings.Normals, rtBestTimings.Tangents };
+	double dTotalTime = 0.0;
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		dTotalTime += dStageTimes[i];
+		std::cout << std::setw(16) << sStageNames[i] << std::setw(14) << std::fixed << std::setprecision(2) << (dStageTimes[i] * 1000.0);
+		if (dStageTimes[i] > 0.0) std::cout << std::setw(20) << ((double)iLoadedTriangles / (dStageTimes[i] * 1e6)) << "\n";
+		else std::cout << std::setw(20) << "skipped" << "\n"; // the normals of the file are used
+	}
+	std::cout << std::setw(16) << "total" << std::setw(14) << (dTotalTime * 1000.0) << std::setw(20) << ((double)iLoadedTriangles / (dTotalTime * 1e6)) << "\n";
+
+	return 0;
+}
\ No newline at end of file
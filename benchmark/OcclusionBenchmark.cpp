@@ -0,0 +1,275 @@
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <charconv>
+#include <string>
+#include <vector>
+
+#include "Core/MeshLoader.h"
+#include "Core/BVH.h"
+#include "Core/WideBVH.h"
+#include "Core/Intersection.h"
+#include "Core/Parallel.h"
+#include "Core/Random.h"
+
+#include "BenchmarkScene.h"
+
+
+
+//the trees, which the occlusion rays share with the closest hit rays
+struct BenchmarkScene
+{
+	std::vector<RT::Core::AABB> BVH;
+	std::vector<uint32_t> SkipLinks;
+	std::vector<RT::Core::IntersectionTriangle> Triangles;
+	std::vector<RT::Core::WideBVHNode<8>> WideBVH;
+	std::vector<RT::Core::IntersectionTriangle> WideTriangles;
+};
+
+enum TraversalType
+{
+	TraversalOrdered = 0,
+	TraversalStackless = 1,
+	TraversalWide = 2
+};
+
+
+//the closest hit of a ray, or any hit, if bAnyHit is set
+static void TraceRay(const BenchmarkScene& rtScene, TraversalType eTraversal, bool bAnyHit, const RT::Core::Ray& rtRay, RT::Math::float4& rtResult)
+{
+	RT::Core::Index iHitIndex = 0;
+	rtResult = RT::Math::float4(rtRay.TMax, 0.0f, 0.0f, 0.0f);
+	if (eTraversal == TraversalWide)
+	{
+		if (bAnyHit) RT::Core::TraverseWideBVH<true>(rtScene.WideBVH.data(), rtScene.WideTriangles.data(), rtRay, rtResult, iHitIndex);
+		else RT::Core::TraverseWideBVH<false>(rtScene.WideBVH.data(), rtScene.WideTriangles.data(), rtRay, rtResult, iHitIndex);
+	}
+	else if (eTraversal == TraversalStackless)
+	{
+		if (bAnyHit) RT::Core::TraverseBVHStackless<true>(rtScene.BVH.data(), rtScene.SkipLinks.data(), rtScene.Triangles.data(), rtRay, rtResult, iHitIndex);
+		else RT::Core::TraverseBVHStackless<false>(rtScene.BVH.data(), rtScene.SkipLinks.data(), rtScene.Triangles.data(), rtRay, rtResult, iHitIndex);
+	}
+	else
+	{
+		if (bAnyHit) RT::Core::TraverseBVH<true>(rtScene.BVH.data(), rtScene.Triangles.data(), rtRay, rtResult, iHitIndex);
+		else RT::Core::TraverseBVH<false>(rtScene.BVH.data(), rtScene.Triangles.data(), rtRay, rtResult, iHitIndex);
+	}
+}
+
+//the visibility mask of the rays (one bit per ray, like TraceOcclusionRays), returns the time in milliseconds
+//without bAnyHit, the rays are traced like closest hit rays, which is what the shadow rays cost without the occlusion query
+static double TraceVisibility(const BenchmarkScene& rtScene, TraversalType eTraversal, bool bAnyHit, const std::vector<RT::Core::Ray>& rtRays,
+	std::vector<uint32_t>& iVisibility)
+{
+	const uint32_t iNumRays = (uint32_t)rtRays.size();
+	iVisibility.assign((iNumRays + 31) / 32, 0);
+
+	auto stdStartTime = std::chrono::high_resolution_clock::now();
+	RT::Core::ParallelFor(iVisibility.size(), 32, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+	{
+		for (uint64_t iWord = iBegin; iWord < iEnd; iWord++)
+		{
+			uint32_t iMask = 0;
+			uint32_t iFirstRay = (uint32_t)iWord * 32;
+			uint32_t iNumWordRays = std::min(iNumRays - iFirstRay, 32u);
+			for (uint32_t i = 0; i < iNumWordRays; i++)
+			{
+				RT::Math::float4 rtResult;
+				TraceRay(rtScene, eTraversal, bAnyHit, rtRays[iFirstRay + i], rtResult);
+				if (rtResult.x == rtRays[iFirstRay + i].TMax) iMask |= 1u << i;
+			}
+			iVisibility[iWord] = iMask;
+		}
+	});
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - stdStartTime).count();
+}
+
+
+//shadow rays: camera rays from above the scene are traced to their closest hit, which is connected to a random point of an area light above the scene
+static void GenerateShadowRays(const BenchmarkScene& rtScene, const RT::Core::AABB& rtSceneAABB, std::vector<RT::Core::Ray>& rtRays)
+{
+	const RT::Math::float3 rtCenter = 0.5f * (rtSceneAABB.Min + rtSceneAABB.Max);
+	const RT::Math::float3 rtExtent = rtSceneAABB.Max - rtSceneAABB.Min;
+	const RT::Math::float3 rtLight = RT::Math::float3(rtSceneAABB.Min.x, rtSceneAABB.Max.y + 0.1f * rtExtent.y, rtCenter.z); // a low light, so that a lot of the points are in the shadow
+	const uint32_t iSide = (uint32_t)std::sqrt((double)rtRays.size());
+
+	RT::Core::ParallelFor(rtRays.size(), 1024, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+	{
+		for (uint64_t i = iBegin; i < iEnd; i++)
+		{
+			uint32_t iSeed = (uint32_t)i * 0x9e3779b9 + 1;
+			auto fnRandom = [&]() { return (float)(RT::Core::XorShift(iSeed) & 0xffffff) / 16777216.0f; };
+
+			RT::Core::Ray rtCameraRay = GetCameraRay(rtSceneAABB, (uint32_t)i, iSide);
+			RT::Math::float4 rtResult;
+			TraceRay(rtScene, TraversalWide, false, rtCameraRay, rtResult);
+			RT::Math::float3 rtPoint = (rtResult.x != rtCameraRay.TMax) ? (rtCameraRay.Origin + rtResult.x * rtCameraRay.Direction) : rtCenter;
+			RT::Math::float3 rtLightPoint = rtLight + RT::Math::float3(0.0f, 0.0f, (fnRandom() - 0.5f) * 0.1f * rtExtent.z);
+
+			//the ray ends right before the light, the start is moved away from the surface by TMin
+			RT::Math::float3 rtToLight = rtLightPoint - rtPoint;
+			float fDistance = RT::Math::length(rtToLight);
+			rtRays[i].Origin = rtPoint;
+			rtRays[i].Direction = rtToLight / fDistance;
+			rtRays[i].TMin = 1e-3f * std::max(fDistance, 1.0f);
+			rtRays[i].TMax = fDistance * 0.999f;
+		}
+	});
+}
+
+//visibility rays: random pairs of points inside the scene bounds (like the connections of a bidirectional path tracer)
+static void GenerateVisibilityRays(const RT::Core::AABB& rtSceneAABB, std::vector<RT::Core::Ray>& rtRays)
+{
+	const RT::Math::float3 rtExtent = rtSceneAABB.Max - rtSceneAABB.Min;
+	uint32_t iSeed = 0x2545f491;
+	auto fnRandom = [&]() { return (float)(RT::Core::XorShift(iSeed) & 0xffffff) / 16777216.0f; };
+
+	for (RT::Core::Ray& rtRay : rtRays)
+	{
+		RT::Math::float3 rtStart = rtSceneAABB.Min + RT::Math::float3(fnRandom(), fnRandom(), fnRandom()) * rtExtent;
+		RT::Math::float3 rtEnd = rtSceneAABB.Min + RT::Math::float3(fnRandom(), fnRandom(), fnRandom()) * rtExtent;
+		float fDistance = std::max(RT::Math::length(rtEnd - rtStart), 1e-3f);
+		rtRay.Origin = rtStart;
+		rtRay.Direction = (rtEnd - rtStart) / fDistance;
+		rtRay.TMin = 0.0f;
+		rtRay.TMax = fDistance;
+	}
+}
+
+//axis-parallel rays: visibility rays, whose end points differ only in one or two coordinates (the infinite inverse directions of the slab tests)
+static void GenerateAxisRays(const RT::Core::AABB& rtSceneAABB, std::vector<RT::Core::Ray>& rtRays)
+{
+	const RT::Math::float3 rtExtent = rtSceneAABB.Max - rtSceneAABB.Min;
+	uint32_t iSeed = 0x5851f42d;
+	auto fnRandom = [&]() { return (float)(RT::Core::XorShift(iSeed) & 0xffffff) / 16777216.0f; };
+
+	for (RT::Core::Ray& rtRay : rtRays)
+	{
+		//the set bits of the mask (1 to 6) are the coordinates, in which the end point differs from the start point
+		uint32_t iAxisMask = 1 + (RT::Core::XorShift(iSeed) % 6);
+		RT::Math::float3 rtStart = rtSceneAABB.Min + RT::Math::float3(fnRandom(), fnRandom(), fnRandom()) * rtExtent;
+		RT::Math::float3 rtEnd = rtSceneAABB.Min + RT::Math::float3(fnRandom(), fnRandom(), fnRandom()) * rtExtent;
+		rtEnd = RT::Math::float3((iAxisMask & 1) ? rtEnd.x : rtStart.x, (iAxisMask & 2) ? rtEnd.y : rtStart.y, (iAxisMask & 4) ? rtEnd.z : rtStart.z);
+		float fDistance = RT::Math::length(rtEnd - rtStart);
+		rtRay.Origin = rtStart;
+		rtRay.Direction = (fDistance > 0.0f) ? ((rtEnd - rtStart) / fDistance) : RT::Math::float3(1.0f, 0.0f, 0.0f);
+		rtRay.TMin = 0.0f;
+		rtRay.TMax = std::max(fDistance, 1e-3f);
+	}
+}
+
+
+
+static void PrintUsage()
+{
+	std::cout << "Usage: OcclusionBenchmark [OBJ file or grid size of the generated height field] [number of rays in thousands]\n";
+}
+
+//returns false, if the argument isn't a whole number from iMin to iMax
+static bool ParseArgument(const char* sArgument, uint32_t iMin, uint32_t iMax, uint32_t& iValue)
+{
+	const char* pEnd = sArgument + std::strlen(sArgument);
+	std::from_chars_result stdResult = std::from_chars(sArgument, pEnd, iValue);
+	return (stdResult.ec == std::errc()) && (stdResult.ptr == pEnd) && (iValue >= iMin) && (iValue <= iMax);
+}
+
+
+
+int main(int argc, char** argv)
+{
+	RT::Core::MeshInfo rtMesh{};
+	uint32_t iGridSize = 192; // the lbvh is slow to traverse, like in TraversalBenchmark
+	uint32_t iNumKiloRays = 64; // fewer rays than in TraversalBenchmark, every traversal runs twice
+	const bool bLoadFile = (argc > 1) && (std::filesystem::exists(argv[1]));
+	if (((argc > 1) && (!bLoadFile) && (!(ParseArgument(argv[1], 1, 0xfffe, iGridSize)))) ||
+		((argc > 2) && (!(ParseArgument(argv[2], 1, 0x3fffff, iNumKiloRays)))))
+	{
+		std::cout << "Invalid arguments\n\n";
+		PrintUsage();
+		return 1;
+	}
+
+	if (bLoadFile)
+	{
+		rtMesh = RT::Core::LoadMeshFromFile(argv[1]);
+		if (!(rtMesh.Indices))
+		{
+			std::cout << "Error loading " << argv[1] << "\n";
+			return 1;
+		}
+	}
+	else
+	{
+		rtMesh = GenerateHeightField(iGridSize);
+	}
+	const uint32_t iNumRays = iNumKiloRays << 10;
+
+	//the lbvh of the gpu path (binary) and the SAH bvh collapsed to a BVH8 (wide)
+	BenchmarkScene rtScene;
+	std::vector<RT::Core::AABB> rtSAHBVH;
+	std::vector<RT::Core::IntersectionTriangle> rtSAHTriangles;
+	std::vector<RT::Math::uint2> rtMortonCodes;
+	std::vector<RT::Math::uint2> rtTempMortonCodes;
+	RT::Core::GenerateMortonCodes(rtMesh, rtMesh.SceneAABB, rtMortonCodes);
+	RT::Core::SortMortonCodes(rtMortonCodes, rtTempMortonCodes);
+	if ((!(RT::Core::BuildLBVH(rtMesh, rtMortonCodes, rtScene.BVH))) || (!(RT::Core::BuildSAHBVH(rtMesh, rtSAHBVH))))
+	{
+		std::cout << "Error building the bvh\n";
+		return 1;
+	}
+	if ((!(RT::Core::BuildTriangleStream(rtMesh, rtScene.BVH, rtScene.Triangles))) || (!(RT::Core::BuildTriangleStream(rtMesh, rtSAHBVH, rtSAHTriangles))) ||
+		(!(RT::Core::BuildWideBVH<8>(rtSAHBVH, rtSAHTriangles, rtScene.WideBVH, rtScene.WideTriangles))))
+	{
+		std::cout << "Error building the triangle stream\n";
+		return 1;
+	}
+	RT::Core::BuildSkipLinks(rtScene.BVH, rtScene.SkipLinks);
+
+	std::vector<RT::Core::Ray> rtRays[3] = { std::vector<RT::Core::Ray>(iNumRays), std::vector<RT::Core::Ray>(iNumRays), std::vector<RT::Core::Ray>(iNumRays) };
+	GenerateShadowRays(rtScene, rtMesh.SceneAABB, rtRays[0]);
+	GenerateVisibilityRays(rtMesh.SceneAABB, rtRays[1]);
+	GenerateAxisRays(rtMesh.SceneAABB, rtRays[2]);
+
+	std::cout << "\nOcclusion queries, " << RT::Core::GetThreadCount() << " threads, " << (rtMesh.IndexCount / 3) << " triangles, " << iNumRays << " rays\n";
+	std::cout << "closest hit traces the rays like the bounces, any hit stops at the first hit (TraceOcclusionRays)\n\n";
+	std::cout << std::setw(16) << "traversal" << std::setw(12) << "rays" << std::setw(10) << "visible" << std::setw(18) << "closest hit (ms)" <<
+		std::setw(10) << "Mrays/s" << std::setw(14) << "any hit (ms)" << std::setw(10) << "Mrays/s" << std::setw(10) << "speedup" << std::setw(8) << "equal" << "\n";
+
+	const char* sTraversalNames[3] = { "lbvh ordered", "lbvh stackless", "sah bvh8" };
+	const char* sRayNames[3] = { "shadow", "visibility", "axis" };
+	std::vector<uint32_t> iVisibility[2];
+	std::vector<uint32_t> iReferenceVisibility[3]; // the masks of the first traversal, which all others have to match
+	auto fnRaysPerSecond = [](uint32_t iNumRays, double dTime) { return (dTime > 0.0) ? ((double)iNumRays / (dTime * 1000.0)) : 0.0; };
+	bool bAllEqual = true;
+	for (uint32_t iTraversal = 0; iTraversal < 3; iTraversal++)
+	{
+		for (uint32_t iRays = 0; iRays < 3; iRays++)
+		{
+			double dClosestHitTime = TraceVisibility(rtScene, (TraversalType)iTraversal, false, rtRays[iRays], iVisibility[0]);
+			double dAnyHitTime = TraceVisibility(rtScene, (TraversalType)iTraversal, true, rtRays[iRays], iVisibility[1]);
+
+			//both find a hit between TMin and TMax or none, so the masks have to be the same (also for all traversals, as the trees contain the same triangles)
+			if (iTraversal == 0) iReferenceVisibility[iRays] = iVisibility[0];
+			bool bEqual = (iVisibility[0] == iVisibility[1]) && (iVisibility[0] == iReferenceVisibility[iRays]);
+			bAllEqual = bAllEqual && bEqual;
+			uint64_t iNumVisible = 0;
+			for (uint32_t iMask : iVisibility[1])
+			{
+				iNumVisible += (uint64_t)std::popcount(iMask);
+			}
+
+			std::cout << std::setw(16) << sTraversalNames[iTraversal] << std::setw(12) << sRayNames[iRays] << std::setw(9) << std::fixed <<
+				std::setprecision(1) << (100.0 * (double)iNumVisible / (double)iNumRays) << "%" << std::setw(18) << std::setprecision(2) << dClosestHitTime <<
+				std::setw(10) << fnRaysPerSecond(iNumRays, dClosestHitTime) << std::setw(14) << dAnyHitTime << std::setw(10) << fnRaysPerSecond(iNumRays, dAnyHitTime) <<
+				std::setw(9) << ((dAnyHitTime > 0.0) ? (dClosestHitTime / dAnyHitTime) : 0.0) << "x" << std::setw(8) << (bEqual ? "yes" : "NO") << "\n";
+		}
+	}
+
+	FreeMesh(rtMesh);
+
+	std::cout << "\n" << (bAllEqual ? "The occlusion queries match the closest hits\n" : "The occlusion queries differ from the closest hits\n");
+	return bAllEqual ? 0 : 1;
+}
\ No newline at end of file
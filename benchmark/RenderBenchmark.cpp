@@ -0,0 +1,526 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <charconv>
+#include <string>
+#include <vector>
+
+#include "DefaultSettings.h"
+#include "CPU/CPURaytracer.h"
+#include "Core/MeshLoader.h"
+#include "Core/BVH.h"
+#include "Core/WideBVH.h"
+#include "Core/Intersection.h"
+#include "Core/Parallel.h"
+#include "Core/Random.h"
+
+#include "BenchmarkScene.h"
+
+
+
+//the version of the report, it has to be increased whenever a value is renamed or measured differently, so old reports aren't compared with new ones
+const uint32_t REPORT_VERSION = 2; // 2: the bytes of a binary bvh are those of its reachable nodes, the allocated arrays are reported separately
+const uint32_t TRAVERSAL_RAYS_X = 512; // the primary rays of the traversal statistics, independent of the resolution of the settings
+const uint32_t TRAVERSAL_RAYS_Y = 288;
+
+
+//a minimal json writer for the report, the values are written in the order of the calls
+class JSONWriter
+{
+private:
+
+	std::ostringstream m_stdText;
+	std::vector<bool> m_bFirstValue; // one entry per open object or array
+
+
+	void BeginValue(const std::string& sName)
+	{
+		if (!(m_bFirstValue.empty()))
+		{
+			m_stdText << (m_bFirstValue.back() ? "\n" : ",\n") << std::string(m_bFirstValue.size(), '\t');
+			m_bFirstValue.back() = false;
+		}
+		if (!(sName.empty())) m_stdText << Quote(sName) << ": ";
+	}
+
+	static std::string Quote(const std::string& sText)
+	{
+		std::string sQuoted = "\"";
+		for (char c : sText)
+		{
+			if ((c == '"') || (c == '\\')) sQuoted += '\\';
+			sQuoted += ((unsigned char)c < 0x20) ? ' ' : c;
+		}
+		return sQuoted + "\"";
+	}
+
+
+public:
+
+	void BeginObject(const std::string& sName = "") { BeginValue(sName); m_stdText << "{"; m_bFirstValue.push_back(true); };
+	void BeginArray(const std::string& sName) { BeginValue(sName); m_stdText << "["; m_bFirstValue.push_back(true); };
+	void EndObject() { m_bFirstValue.pop_back(); m_stdText << "\n" << std::string(m_bFirstValue.size(), '\t') << "}"; };
+	void EndArray() { m_bFirstValue.pop_back(); m_stdText << "\n" << std::string(m_bFirstValue.size(), '\t') << "]"; };
+
+	void Value(const std::string& sName, const std::string& sValue) { BeginValue(sName); m_stdText << Quote(sValue); };
+	void Value(const std::string& sName, const char* sValue) { Value(sName, std::string(sValue)); };
+	void Value(const std::string& sName, bool bValue) { BeginValue(sName); m_stdText << (bValue ? "true" : "false"); };
+	void Value(const std::string& sName, uint64_t iValue) { BeginValue(sName); m_stdText << iValue; };
+	void Value(const std::string& sName, uint32_t iValue) { Value(sName, (uint64_t)iValue); };
+	void Value(const std::string& sName, double dValue)
+	{
+		BeginValue(sName);
+		if (std::isfinite(dValue)) m_stdText << std::setprecision(9) << dValue;
+		else m_stdText << "null";
+	};
+
+	bool Save(const std::string& sFileName)
+	{
+		std::ofstream stdFile(sFileName, std::ios::binary);
+		stdFile << m_stdText.str() << "\n";
+		return stdFile.good();
+	};
+
+};
+
+
+//the traversal statistics of a binary bvh
+struct TraversalStats
+{
+	double PrimaryNodeTests; // per ray
+	double PrimaryTriangleTests;
+	double SecondaryNodeTests;
+	double SecondaryTriangleTests;
+	uint64_t NumSecondaryRays;
+};
+
+//a binary bvh with its build times
+struct BinaryBVH
+{
+	const char* Name;
+	std::vector<RT::Core::AABB> Nodes;
+	std::vector<RT::Core::IntersectionTriangle> Triangles;
+	std::vector<uint32_t> SkipLinks;
+	double BuildSeconds;
+	double TriangleStreamSeconds;
+	RT::Core::BVHStats Stats;
+	TraversalStats Traversal;
+};
+
+
+static double GetSeconds(std::chrono::steady_clock::time_point stdStartTime)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - stdStartTime).count();
+}
+
+
+//every asset is seen from the same direction relative to its bounds, so the report doesn't depend on the camera of Settings.h
+static RT::Core::CameraSettings FrameScene(const RT::Core::AABB& rtSceneAABB, const RT::Core::CameraSettings& rtDefaultCamera)
+{
+	RT::Math::float3 rtCenter = 0.5f * (rtSceneAABB.Min + rtSceneAABB.Max);
+	float fRadius = std::max(0.5f * RT::Math::length(rtSceneAABB.Max - rtSceneAABB.Min), 1e-3f);
+	float fDistance = fRadius / std::sin(0.5f * rtDefaultCamera.VerticalFOV);
+
+	RT::Core::CameraSettings rtCamera = rtDefaultCamera;
+	rtCamera.Position = rtCenter + RT::Math::normalize(RT::Math::float3(-0.6f, 0.4f, -0.7f)) * fDistance;
+	rtCamera.FocusPoint = rtCenter;
+	rtCamera.UpDirection = RT::Math::float3(0.0f, 1.0f, 0.0f);
+	rtCamera.NearZ = std::min(rtDefaultCamera.NearZ, 0.01f * fDistance);
+	rtCamera.FarZ = std::max(rtDefaultCamera.FarZ, 4.0f * fDistance);
+	return rtCamera;
+}
+
+//one pinhole ray through the center of every pixel of a TRAVERSAL_RAYS_X x TRAVERSAL_RAYS_Y grid (left-handed like XMMatrixLookAtLH)
+static void GenerateCameraRays(const RT::Core::CameraSettings& rtCamera, std::vector<RT::Core::Ray>& rtRays)
+{
+	RT::Math::float3 rtForward = RT::Math::normalize(rtCamera.FocusPoint - rtCamera.Position);
+	RT::Math::float3 rtRight = RT::Math::normalize(RT::Math::cross(rtCamera.UpDirection, rtForward));
+	RT::Math::float3 rtUp = RT::Math::cross(rtForward, rtRight);
+	float fTanHalfFOV = std::tan(0.5f * rtCamera.VerticalFOV);
+	float fAspectRatio = (float)TRAVERSAL_RAYS_X / (float)TRAVERSAL_RAYS_Y;
+
+	rtRays.resize(TRAVERSAL_RAYS_X * TRAVERSAL_RAYS_Y);
+	for (uint32_t i = 0; i < (uint32_t)rtRays.size(); i++)
+	{
+		float fX = (((float)(i % TRAVERSAL_RAYS_X) + 0.5f) / (float)TRAVERSAL_RAYS_X * 2.0f - 1.0f) * fTanHalfFOV * fAspectRatio;
+		float fY = (1.0f - ((float)(i / TRAVERSAL_RAYS_X) + 0.5f) / (float)TRAVERSAL_RAYS_Y * 2.0f) * fTanHalfFOV;
+		rtRays[i].Origin = rtCamera.Position;
+		rtRays[i].Direction = RT::Math::normalize(rtForward + rtRight * fX + rtUp * fY);
+		rtRays[i].TMin = 0.0f;
+		rtRays[i].TMax = 1e30f;
+	}
+}
+
+//the closest hit of every ray with the traversal of the settings, returns the node and triangle tests summed over all rays
+static RT::Core::TraversalCounters TraceRays(const BinaryBVH& rtBVH, bool bStackless, const std::vector<RT::Core::Ray>& rtRays,
+	std::vector<RT::Math::float4>& rtResults)
+{
+	std::vector<RT::Core::TraversalCounters> rtThreadCounters(RT::Core::GetThreadCount(), RT::Core::TraversalCounters{});
+	rtResults.resize(rtRays.size());
+	RT::Core::ParallelFor(rtRays.size(), 1024, [&](uint64_t iBegin, uint64_t iEnd, unsigned int iThread)
+	{
+		for (uint64_t i = iBegin; i < iEnd; i++)
+		{
+			RT::Core::Index iHitIndex = 0;
+			rtResults[i] = RT::Math::float4(rtRays[i].TMax, 0.0f, 0.0f, 0.0f);
+			if (bStackless)
+			{
+				RT::Core::TraverseBVHStackless(rtBVH.Nodes.data(), rtBVH.SkipLinks.data(), rtBVH.Triangles.data(), rtRays[i], rtResults[i], iHitIndex,
+					&rtThreadCounters[iThread]);
+			}
+			else
+			{
+				RT::Core::TraverseBVH(rtBVH.Nodes.data(), rtBVH.Triangles.data(), rtRays[i], rtResults[i], iHitIndex, &rtThreadCounters[iThread]);
+			}
+		}
+	});
+
+	RT::Core::TraversalCounters rtCounters{};
+	for (const RT::Core::TraversalCounters& rtThreadCounter : rtThreadCounters)
+	{
+		rtCounters.NumNodeTests += rtThreadCounter.NumNodeTests;
+		rtCounters.NumTriangleTests += rtThreadCounter.NumTriangleTests;
+	}
+	return rtCounters;
+}
+
+//the primary rays and one secondary ray in a random direction from every primary hit (like a diffuse bounce, but without the material)
+static TraversalStats MeasureTraversal(const BinaryBVH& rtBVH, bool bStackless, const std::vector<RT::Core::Ray>& rtPrimaryRays, float fSceneRadius)
+{
+	TraversalStats rtStats{};
+	std::vector<RT::Math::float4> rtResults;
+	RT::Core::TraversalCounters rtCounters = TraceRays(rtBVH, bStackless, rtPrimaryRays, rtResults);
+	rtStats.PrimaryNodeTests = (double)rtCounters.NumNodeTests / (double)rtPrimaryRays.size();
+	rtStats.PrimaryTriangleTests = (double)rtCounters.NumTriangleTests / (double)rtPrimaryRays.size();
+
+	std::vector<RT::Core::Ray> rtSecondaryRays;
+	uint32_t iSeed = 0x2545f491;
+	for (size_t i = 0; i < rtPrimaryRays.size(); i++)
+	{
+		if (rtResults[i].x == rtPrimaryRays[i].TMax) continue;
+		RT::Math::float3 rtDirection;
+		do
+		{
+			rtDirection = RT::Math::float3(RT::Core::Random(iSeed), RT::Core::Random(iSeed), RT::Core::Random(iSeed)) * 2.0f - RT::Math::float3(1.0f);
+		} while ((RT::Math::dot(rtDirection, rtDirection) > 1.0f) || (RT::Math::dot(rtDirection, rtDirection) < 1e-6f));
+
+		RT::Core::Ray rtRay = rtPrimaryRays[i];
+		rtRay.Origin = rtRay.Origin + rtRay.Direction * rtResults[i].x;
+		rtRay.Direction = RT::Math::normalize(rtDirection);
+		rtRay.TMin = 1e-4f * fSceneRadius; // the hit triangle itself is skipped
+		rtRay.TMax = 1e30f;
+		rtSecondaryRays.push_back(rtRay);
+	}
+
+	rtStats.NumSecondaryRays = rtSecondaryRays.size();
+	if (!(rtSecondaryRays.empty()))
+	{
+		rtCounters = TraceRays(rtBVH, bStackless, rtSecondaryRays, rtResults);
+		rtStats.SecondaryNodeTests = (double)rtCounters.NumNodeTests / (double)rtSecondaryRays.size();
+		rtStats.SecondaryTriangleTests = (double)rtCounters.NumTriangleTests / (double)rtSecondaryRays.size();
+	}
+	return rtStats;
+}
+
+
+static void WriteSettings(JSONWriter& rtReport, const RT::Core::RenderSettings& rtSettings)
+{
+	rtReport.BeginObject("settings");
+	rtReport.Value("width", rtSettings.Width);
+	rtReport.Value("height", rtSettings.Height);
+	rtReport.Value("samples", rtSettings.MaxSamples);
+	rtReport.Value("rays_per_pixel", (uint32_t)RT::GraphicsAPI::CPU::MAX_RAYS_PER_PIXEL);
+	rtReport.Value("render_tile_size", (uint32_t)RT::GraphicsAPI::CPU::RENDER_TILE_SIZE);
+	rtReport.Value("max_ray_depth", rtSettings.MaxRayDepth);
+	rtReport.Value("russian_roulette_depth", rtSettings.RussianRouletteDepth);
+	rtReport.Value("sampler", rtSettings.Sampler);
+	rtReport.Value("light_sampling", rtSettings.UseLightSampling);
+	rtReport.Value("seed", rtSettings.Seed);
+	rtReport.Value("bvh", rtSettings.UseBVH);
+	rtReport.Value("sah_bvh", rtSettings.UseSAHBVH);
+	rtReport.Value("bvh_width", RT::GraphicsAPI::CPU::BVH_WIDTH);
+	rtReport.Value("stackless_bvh", rtSettings.UseStacklessBVH);
+	rtReport.Value("persistent_threads", rtSettings.UsePersistentThreads);
+	rtReport.Value("ray_binning", rtSettings.UseRayBinning);
+	rtReport.EndObject();
+}
+
+
+//load, build and render a single asset and add it to the report
+static bool BenchmarkScene(const std::string& sFileName, const RT::Core::RenderSettings& rtDefaultSettings, JSONWriter& rtReport)
+{
+	std::cout << "\n" << sFileName << "\n";
+
+	//the loading
+	RT::Core::MeshLoadTimings rtLoadTimings{};
+	RT::Core::MeshInfo rtMesh = RT::Core::LoadMeshFromFile(sFileName, &rtLoadTimings);
+	if (!(rtMesh.Indices))
+	{
+		std::cout << "Error loading " << sFileName << "\n";
+		return false;
+	}
+	const double dLoadSeconds = rtLoadTimings.Parsing + rtLoadTimings.Triangles + rtLoadTimings.Welding + rtLoadTimings.SceneBounds +
+		rtLoadTimings.Normals + rtLoadTimings.Tangents;
+	const uint64_t iSceneBytes = rtMesh.VertexCount * sizeof(RT::Core::Vertex) + rtMesh.IndexCount * sizeof(RT::Core::Index) +
+		rtMesh.MaterialCount * sizeof(RT::Core::PBRMaterial);
+
+	//both binary trees: the lbvh of the gpu path and the SAH bvh, which the cpu builds for both backends
+	BinaryBVH rtBVHs[2] = {};
+	rtBVHs[0].Name = "lbvh";
+	rtBVHs[1].Name = "sah";
+	auto stdStartTime = std::chrono::steady_clock::now();
+	std::vector<RT::Math::uint2> rtMortonCodes;
+	std::vector<RT::Math::uint2> rtTempMortonCodes;
+	RT::Core::GenerateMortonCodes(rtMesh, rtMesh.SceneAABB, rtMortonCodes);
+	RT::Core::SortMortonCodes(rtMortonCodes, rtTempMortonCodes);
+	bool bBuilt = RT::Core::BuildLBVH(rtMesh, rtMortonCodes, rtBVHs[0].Nodes);
+	rtBVHs[0].BuildSeconds = GetSeconds(stdStartTime);
+	stdStartTime = std::chrono::steady_clock::now();
+	bBuilt = bBuilt && RT::Core::BuildSAHBVH(rtMesh, rtBVHs[1].Nodes);
+	rtBVHs[1].BuildSeconds = GetSeconds(stdStartTime);
+	for (BinaryBVH& rtBVH : rtBVHs)
+	{
+		stdStartTime = std::chrono::steady_clock::now();
+		bBuilt = bBuilt && RT::Core::BuildTriangleStream(rtMesh, rtBVH.Nodes, rtBVH.Triangles);
+		rtBVH.TriangleStreamSeconds = GetSeconds(stdStartTime);
+		RT::Core::BuildSkipLinks(rtBVH.Nodes, rtBVH.SkipLinks);
+		rtBVH.Stats = RT::Core::GetBVHStats(rtBVH.Nodes);
+	}
+
+	//the wide bvh of RT_BVH_WIDTH is collapsed from the SAH bvh
+	const uint32_t iWideWidth = RT::GraphicsAPI::CPU::WIDE_BVH_WIDTH;
+	std::vector<RT::Core::WideBVHNode<iWideWidth>> rtWideBVH;
+	std::vector<RT::Core::IntersectionTriangle> rtWideTriangles;
+	stdStartTime = std::chrono::steady_clock::now();
+	bBuilt = bBuilt && RT::Core::BuildWideBVH<iWideWidth>(rtBVHs[1].Nodes, rtBVHs[1].Triangles, rtWideBVH, rtWideTriangles);
+	double dWideBuildSeconds = GetSeconds(stdStartTime);
+	if (!bBuilt)
+	{
+		std::cout << "Error building the bvh\n";
+		FreeMesh(rtMesh);
+		return false;
+	}
+
+	//the traversal statistics with the traversal of the settings (the wide traversal doesn't count its tests)
+	RT::Core::RenderSettings rtSettings = rtDefaultSettings;
+	rtSettings.Camera = FrameScene(rtMesh.SceneAABB, rtDefaultSettings.Camera);
+	const float fSceneRadius = std::max(0.5f * RT::Math::length(rtMesh.SceneAABB.Max - rtMesh.SceneAABB.Min), 1e-3f);
+	std::vector<RT::Core::Ray> rtPrimaryRays;
+	GenerateCameraRays(rtSettings.Camera, rtPrimaryRays);
+	for (BinaryBVH& rtBVH : rtBVHs)
+	{
+		rtBVH.Traversal = MeasureTraversal(rtBVH, rtSettings.UseStacklessBVH, rtPrimaryRays, fSceneRadius);
+	}
+
+	//the rendering with the cpu backend, the first iteration builds the bvh of the settings again
+	//the raytracer owns the mesh from here on and frees it in Release, only the counts of rtMesh are used afterwards
+	RT::GraphicsAPI::CPU::RaytracerPipeline rtTracer;
+	if (!(rtTracer.Initialize(rtMesh, rtSettings)))
+	{
+		std::cout << "Error initializing the cpu raytracer\n";
+		rtTracer.Release();
+		return false;
+	}
+	stdStartTime = std::chrono::steady_clock::now();
+	while (rtTracer.GetNumSamples() < rtSettings.MaxSamples)
+	{
+		if (!(rtTracer.Render()))
+		{
+			std::cout << "Error while rendering\n";
+			rtTracer.Release();
+			return false;
+		}
+	}
+	const double dRenderSeconds = GetSeconds(stdStartTime);
+
+	//bounce 0 are the camera rays, the intersection time excludes the shading and the shadow rays
+	uint64_t iRays[2] = {};
+	double dIntersectionSeconds[2] = {};
+	const std::vector<RT::GraphicsAPI::CPU::BounceStats>& rtBounceStats = rtTracer.GetBounceStats();
+	for (size_t i = 0; i < rtBounceStats.size(); i++)
+	{
+		iRays[(i == 0) ? 0 : 1] += rtBounceStats[i].NumRays;
+		dIntersectionSeconds[(i == 0) ? 0 : 1] += rtBounceStats[i].Seconds;
+	}
+	auto fnRaysPerSecond = [](uint64_t iNumRays, double dSeconds) { return (dSeconds > 0.0) ? ((double)iNumRays / dSeconds) : 0.0; };
+	const uint64_t iRenderBytes = rtTracer.GetMemoryFootprint();
+	const uint32_t iNumSamples = rtTracer.GetNumSamples();
+	const char* sRenderedBVH = (!rtSettings.UseBVH) ? "none" : ((!rtSettings.UseSAHBVH) ? "lbvh" : ((RT::GraphicsAPI::CPU::BVH_WIDTH > 2) ? "sah_wide" : "sah"));
+	rtTracer.Release();
+
+	//the console summary
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << (rtMesh.IndexCount / 3) << " triangles, loaded in " << (dLoadSeconds * 1000.0) << " ms\n";
+	std::cout << std::setw(10) << "bvh" << std::setw(12) << "build (ms)" << std::setw(10) << "nodes" << std::setw(8) << "depth" << std::setw(10) << "SAH cost" <<
+		std::setw(16) << "primary tests" << std::setw(18) << "secondary tests" << "\n";
+	for (const BinaryBVH& rtBVH : rtBVHs)
+	{
+		std::cout << std::setw(10) << rtBVH.Name << std::setw(12) << ((rtBVH.BuildSeconds + rtBVH.TriangleStreamSeconds) * 1000.0) << std::setw(10) <<
+			rtBVH.Stats.NumNodes << std::setw(8) << rtBVH.Stats.MaxDepth << std::setw(10) << rtBVH.Stats.SAHCost << std::setw(9) <<
+			rtBVH.Traversal.PrimaryNodeTests << " / " << std::setw(4) << std::setprecision(1) << rtBVH.Traversal.PrimaryTriangleTests << std::setw(11) <<
+			std::setprecision(2) << rtBVH.Traversal.SecondaryNodeTests << " / " << std::setw(4) << std::setprecision(1) << rtBVH.Traversal.SecondaryTriangleTests <<
+			std::setprecision(2) << "\n";
+	}
+	std::cout << "render (" << sRenderedBVH << "): " << iNumSamples << " samples in " << dRenderSeconds << " s, primary " <<
+		(fnRaysPerSecond(iRays[0], dIntersectionSeconds[0]) * 1e-6) << " Mrays/s, secondary " << (fnRaysPerSecond(iRays[1], dIntersectionSeconds[1]) * 1e-6) <<
+		" Mrays/s, " << ((double)(iSceneBytes + iRenderBytes) / (1024.0 * 1024.0)) << " MiB\n";
+
+	//the report
+	rtReport.BeginObject();
+	rtReport.Value("file", std::filesystem::path(sFileName).generic_string());
+	rtReport.Value("triangles", rtMesh.IndexCount / 3);
+	rtReport.Value("vertices", rtMesh.VertexCount);
+	rtReport.Value("materials", rtMesh.MaterialCount);
+
+	rtReport.BeginObject("load_seconds");
+	rtReport.Value("parsing", rtLoadTimings.Parsing);
+	rtReport.Value("triangles", rtLoadTimings.Triangles);
+	rtReport.Value("welding", rtLoadTimings.Welding);
+	rtReport.Value("scene_bounds", rtLoadTimings.SceneBounds);
+	rtReport.Value("normals", rtLoadTimings.Normals);
+	rtReport.Value("tangents", rtLoadTimings.Tangents);
+	rtReport.Value("total", dLoadSeconds);
+	rtReport.EndObject();
+
+	rtReport.BeginArray("bvh");
+	for (const BinaryBVH& rtBVH : rtBVHs)
+	{
+		rtReport.BeginObject();
+		rtReport.Value("name", rtBVH.Name);
+		rtReport.Value("build_seconds", rtBVH.BuildSeconds);
+		rtReport.Value("triangle_stream_seconds", rtBVH.TriangleStreamSeconds);
+		rtReport.Value("nodes", rtBVH.Stats.NumNodes);
+		rtReport.Value("leaves", rtBVH.Stats.NumLeaves);
+		rtReport.Value("depth", rtBVH.Stats.MaxDepth);
+		rtReport.Value("sah_cost", (double)rtBVH.Stats.SAHCost);
+		//the node array of the lbvh has room for twice the nodes, so the footprint counts only the nodes, which are reachable from the trunk (and their skip links)
+		rtReport.Value("bytes", (uint64_t)rtBVH.Stats.NumNodes * (sizeof(RT::Core::AABB) + sizeof(uint32_t)) +
+			(uint64_t)(rtBVH.Triangles.size() * sizeof(RT::Core::IntersectionTriangle)));
+		rtReport.Value("allocated_bytes", (uint64_t)(rtBVH.Nodes.size() * sizeof(RT::Core::AABB) + rtBVH.Triangles.size() * sizeof(RT::Core::IntersectionTriangle) +
+			rtBVH.SkipLinks.size() * sizeof(uint32_t)));
+		rtReport.Value("primary_node_tests_per_ray", rtBVH.Traversal.PrimaryNodeTests);
+		rtReport.Value("primary_triangle_tests_per_ray", rtBVH.Traversal.PrimaryTriangleTests);
+		rtReport.Value("secondary_rays", rtBVH.Traversal.NumSecondaryRays);
+		rtReport.Value("secondary_node_tests_per_ray", rtBVH.Traversal.SecondaryNodeTests);
+		rtReport.Value("secondary_triangle_tests_per_ray", rtBVH.Traversal.SecondaryTriangleTests);
+		rtReport.EndObject();
+	}
+	rtReport.BeginObject();
+	rtReport.Value("name", "sah_wide");
+	rtReport.Value("width", iWideWidth);
+	rtReport.Value("build_seconds", dWideBuildSeconds); // the collapse of the SAH bvh and its triangle stream
+	rtReport.Value("nodes", (uint64_t)rtWideBVH.size());
+	rtReport.Value("bytes", (uint64_t)(rtWideBVH.size() * sizeof(RT::Core::WideBVHNode<iWideWidth>) + rtWideTriangles.size() * sizeof(RT::Core::IntersectionTriangle)));
+	rtReport.EndObject();
+	rtReport.EndArray();
+
+	rtReport.BeginObject("render");
+	rtReport.Value("bvh", sRenderedBVH);
+	rtReport.Value("samples", iNumSamples);
+	rtReport.Value("seconds", dRenderSeconds); // including the bvh build of the first iteration
+	rtReport.Value("samples_per_second", (dRenderSeconds > 0.0) ? ((double)iNumSamples / dRenderSeconds) : 0.0);
+	rtReport.Value("primary_rays", iRays[0]);
+	rtReport.Value("primary_rays_per_second", fnRaysPerSecond(iRays[0], dIntersectionSeconds[0]));
+	rtReport.Value("secondary_rays", iRays[1]);
+	rtReport.Value("secondary_rays_per_second", fnRaysPerSecond(iRays[1], dIntersectionSeconds[1]));
+	rtReport.Value("rays_per_second", fnRaysPerSecond(iRays[0] + iRays[1], dRenderSeconds)); // all stages of the pipeline
+	rtReport.EndObject();
+
+	rtReport.BeginObject("memory_bytes");
+	rtReport.Value("scene", iSceneBytes);
+	rtReport.Value("render", iRenderBytes); // the buffers of the pipeline and its bvh
+	rtReport.Value("total", iSceneBytes + iRenderBytes);
+	rtReport.EndObject();
+	rtReport.EndObject();
+
+	return true;
+}
+
+
+
+static void PrintUsage()
+{
+	std::cout << "Usage: RenderBenchmark [assets folder or OBJ file] [samples per pixel] [report file]\n";
+}
+
+//returns false, if the argument isn't a whole number from iMin to iMax
+static bool ParseArgument(const char* sArgument, uint32_t iMin, uint32_t iMax, uint32_t& iValue)
+{
+	const char* pEnd = sArgument + std::strlen(sArgument);
+	std::from_chars_result stdResult = std::from_chars(sArgument, pEnd, iValue);
+	return (stdResult.ec == std::errc()) && (stdResult.ptr == pEnd) && (iValue >= iMin) && (iValue <= iMax);
+}
+
+
+
+int main(int argc, char** argv)
+{
+	std::string sAssets = (argc > 1) ? argv[1] : "assets";
+	uint32_t iNumSamples = 4;
+	std::string sReportFileName = (argc > 3) ? argv[3] : "RenderBenchmark.json";
+	if ((argc > 2) && (!(ParseArgument(argv[2], 1, 0xffff, iNumSamples))))
+	{
+		std::cout << "Invalid number of samples " << argv[2] << "\n\n";
+		PrintUsage();
+		return 1;
+	}
+
+	std::vector<std::string> sSceneFiles;
+	if (std::filesystem::is_directory(sAssets))
+	{
+		for (const std::filesystem::directory_entry& stdEntry : std::filesystem::directory_iterator(sAssets))
+		{
+			if (stdEntry.is_regular_file() && (stdEntry.path().extension() == ".obj")) sSceneFiles.push_back(stdEntry.path().string());
+		}
+		std::sort(sSceneFiles.begin(), sSceneFiles.end()); // the same order on every system
+	}
+	else if (std::filesystem::exists(sAssets))
+	{
+		sSceneFiles.push_back(sAssets);
+	}
+	if (sSceneFiles.empty())
+	{
+		std::cout << "No OBJ files found in " << sAssets << "\n";
+		return 1;
+	}
+
+	//the settings of Settings.h with a fixed number of samples (no adaptive sampling and no time limit), so every run does the same work
+	RT::Core::RenderSettings rtSettings = RT::Core::GetDefaultRenderSettings();
+	rtSettings.MaxSamples = iNumSamples;
+	rtSettings.MaxSeconds = 1e30f;
+	rtSettings.AdaptiveErrorThreshold = 0.0f;
+
+	std::cout << "\nRender benchmark, CPU backend, " << RT::Core::GetThreadCount() << " threads, " << rtSettings.Width << "x" << rtSettings.Height << ", " <<
+		iNumSamples << " samples per pixel\n";
+	std::cout << "the tests are the average node / triangle tests per ray of the binary bvhs\n";
+
+	JSONWriter rtReport;
+	rtReport.BeginObject();
+	rtReport.Value("benchmark", "RenderBenchmark");
+	rtReport.Value("version", REPORT_VERSION);
+	rtReport.Value("backend", "CPU");
+	rtReport.Value("threads", (uint32_t)RT::Core::GetThreadCount());
+	WriteSettings(rtReport, rtSettings);
+	rtReport.BeginArray("scenes");
+	bool bAllRendered = true;
+	for (const std::string& sSceneFile : sSceneFiles)
+	{
+		bAllRendered = BenchmarkScene(sSceneFile, rtSettings, rtReport) && bAllRendered;
+	}
+	rtReport.EndArray();
+	rtReport.EndObject();
+
+	if (!(rtReport.Save(sReportFileName)))
+	{
+		std::cout << "Error writing " << sReportFileName << "\n";
+		return 1;
+	}
+	std::cout << "\nThe report was written to " << sReportFileName << "\n";
+	return bAllRendered ? 0 : 1;
+}
\ No newline at end of file
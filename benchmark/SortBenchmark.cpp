@@ -0,0 +1,99 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <charconv>
+#include <string>
+#include <vector>
+
+#include "Core/RadixSort.h"
+#include "Core/Parallel.h"
+#include "Core/Random.h"
+
+
+
+//fill the keys with random 30 bit codes (like the morton codes), the value of a key is its original position
+static void GenerateKeys(std::vector<RT::Math::uint2>& rtKeys, uint64_t iNumKeys, uint32_t iSeed)
+{
+	rtKeys.resize(iNumKeys);
+	for (uint64_t i = 0; i < iNumKeys; i++)
+	{
+		rtKeys[i] = { RT::Core::XorShift(iSeed) & 0x3fffffff, (uint32_t)i };
+	}
+}
+
+//the result of a stable sort is unique: the keys have to be in order and equal keys have to keep their original order
+static bool ValidateKeys(const std::vector<RT::Math::uint2>& rtKeys)
+{
+	std::vector<bool> bSeen(rtKeys.size(), false);
+	for (uint64_t i = 0; i < rtKeys.size(); i++)
+	{
+		if ((rtKeys[i].y >= rtKeys.size()) || bSeen[rtKeys[i].y]) return false;
+		bSeen[rtKeys[i].y] = true;
+
+		if (i == 0) continue;
+		if (rtKeys[i - 1].x > rtKeys[i].x) return false;
+		if ((rtKeys[i - 1].x == rtKeys[i].x) && (rtKeys[i - 1].y > rtKeys[i].y)) return false;
+	}
+	return true;
+}
+
+
+
+static void PrintUsage()
+{
+	std::cout << "Usage: SortBenchmark [maximum number of keys in millions] [repetitions]\n";
+}
+
+//returns false, if the argument isn't a whole number from iMin to iMax
+static bool ParseArgument(const char* sArgument, uint32_t iMin, uint32_t iMax, uint32_t& iValue)
+{
+	const char* pEnd = sArgument + std::strlen(sArgument);
+	std::from_chars_result stdResult = std::from_chars(sArgument, pEnd, iValue);
+	return (stdResult.ec == std::errc()) && (stdResult.ptr == pEnd) && (iValue >= iMin) && (iValue <= iMax);
+}
+
+
+
+int main(int argc, char** argv)
+{
+	uint32_t iMaxKeys = 64;
+	uint32_t iRepetitions = 3;
+	if (((argc > 1) && (!(ParseArgument(argv[1], 1, 4096, iMaxKeys)))) || ((argc > 2) && (!(ParseArgument(argv[2], 1, 0xffff, iRepetitions)))))
+	{
+		std::cout << "Invalid arguments\n\n";
+		PrintUsage();
+		return 1;
+	}
+
+	std::cout << "Onesweep radix sort, " << RT::Core::GetThreadCount() << " threads, tiles of " << RT::Core::RADIX_SORT_TILE_SIZE << " keys\n\n";
+	std::cout << std::setw(12) << "keys" << std::setw(14) << "time (ms)" << std::setw(16) << "Mkeys/s" << std::setw(10) << "valid" << "\n";
+
+	bool bAllValid = true;
+	std::vector<RT::Math::uint2> rtKeys;
+	std::vector<RT::Math::uint2> rtTempKeys;
+	for (uint64_t iNumKeys = 1 << 20; iNumKeys <= ((uint64_t)iMaxKeys << 20); iNumKeys *= 2)
+	{
+		//keep the fastest run
+		double dBestTime = 1e30;
+		bool bValid = true;
+		for (uint32_t i = 0; i < iRepetitions; i++)
+		{
+			GenerateKeys(rtKeys, iNumKeys, 0x9e3779b9 + i);
+
+			auto stdStartTime = std::chrono::high_resolution_clock::now();
+			RT::Core::RadixSortOnesweep(rtKeys, rtTempKeys);
+			auto stdEndTime = std::chrono::high_resolution_clock::now();
+
+			dBestTime = std::min(dBestTime, std::chrono::duration<double, std::milli>(stdEndTime - stdStartTime).count());
+			bValid = bValid && ValidateKeys(rtKeys);
+		}
+		bAllValid = bAllValid && bValid;
+
+		std::cout << std::setw(12) << iNumKeys << std::setw(14) << std::fixed << std::setprecision(2) << dBestTime <<
+			std::setw(16) << ((double)iNumKeys / (dBestTime * 1000.0)) << std::setw(10) << (bValid ? "yes" : "NO") << "\n";
+	}
+
+	std::cout << "\n" << (bAllValid ? "All sorts are valid\n" : "At least one sort is invalid\n");
+	return bAllValid ? 0 : 1;
+}
\ No newline at end of file
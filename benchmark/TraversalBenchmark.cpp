@@ -0,0 +1,247 @@
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <charconv>
+#include <string>
+#include <vector>
+
+#include "Core/MeshLoader.h"
+#include "Core/BVH.h"
+#include "Core/WideBVH.h"
+#include "Core/Intersection.h"
+#include "Core/Parallel.h"
+#include "Core/Random.h"
+
+#include "BenchmarkScene.h"
+
+
+
+//incoherent rays: random origins inside the scene bounds and random directions (like the diffuse bounces)
+static void GenerateRandomRays(const RT::Core::AABB& rtSceneAABB, std::vector<RT::Core::Ray>& rtRays)
+{
+	const RT::Math::float3 rtExtent = rtSceneAABB.Max - rtSceneAABB.Min;
+	uint32_t iSeed = 0x2545f491;
+	auto fnRandom = [&]() { return (float)(RT::Core::XorShift(iSeed) & 0xffffff) / 16777216.0f; };
+
+	for (RT::Core::Ray& rtRay : rtRays)
+	{
+		rtRay.Origin = rtSceneAABB.Min + RT::Math::float3(fnRandom(), fnRandom(), fnRandom()) * rtExtent;
+		rtRay.Direction = RT::Math::normalize(RT::Math::float3(fnRandom() - 0.5f, fnRandom() - 0.5f, fnRandom() - 0.5f));
+		rtRay.TMin = 0.0f;
+		rtRay.TMax = 1e30f;
+	}
+}
+
+//axis-parallel rays: random origins inside the scene bounds and directions with one or two zero components (the infinite inverse directions of the slab tests)
+static void GenerateAxisRays(const RT::Core::AABB& rtSceneAABB, std::vector<RT::Core::Ray>& rtRays)
+{
+	const RT::Math::float3 rtExtent = rtSceneAABB.Max - rtSceneAABB.Min;
+	uint32_t iSeed = 0x5851f42d;
+	auto fnRandom = [&]() { return (float)(RT::Core::XorShift(iSeed) & 0xffffff) / 16777216.0f; };
+	auto fnComponent = [&]() { float fValue = fnRandom() - 0.5f; return (fValue < 0.0f) ? (fValue - 0.01f) : (fValue + 0.01f); };
+
+	for (RT::Core::Ray& rtRay : rtRays)
+	{
+		//the set bits of the mask (1 to 6) are the components, which are not zero
+		uint32_t iAxisMask = 1 + (RT::Core::XorShift(iSeed) % 6);
+		RT::Math::float3 rtDirection = RT::Math::float3(fnComponent(), fnComponent(), fnComponent());
+		rtRay.Origin = rtSceneAABB.Min + RT::Math::float3(fnRandom(), fnRandom(), fnRandom()) * rtExtent;
+		rtRay.Direction = RT::Math::normalize(RT::Math::float3((iAxisMask & 1) ? rtDirection.x : 0.0f, (iAxisMask & 2) ? rtDirection.y : 0.0f, (iAxisMask & 4) ? rtDirection.z : 0.0f));
+		rtRay.TMin = 0.0f;
+		rtRay.TMax = 1e30f;
+	}
+}
+
+
+//the closest hit of every ray with the ordered stack traversal or the stackless traversal, returns the time in milliseconds
+//the counters are summed over all rays, if they are given (the timing is measured without them)
+static double TraceRays(const std::vector<RT::Core::AABB>& rtBVH, const std::vector<uint32_t>& iSkipLinks,
+	const std::vector<RT::Core::IntersectionTriangle>& rtTriangles, const std::vector<RT::Core::Ray>& rtRays, bool bStackless,
+	std::vector<RT::Math::float4>& rtResults, std::vector<RT::Core::Index>& iHitIndices, RT::Core::TraversalCounters* rtCounters = nullptr)
+{
+	std::vector<RT::Core::TraversalCounters> rtThreadCounters(RT::Core::GetThreadCount(), RT::Core::TraversalCounters{});
+	auto stdStartTime = std::chrono::high_resolution_clock::now();
+	RT::Core::ParallelFor(rtRays.size(), 1024, [&](uint64_t iBegin, uint64_t iEnd, unsigned int iThread)
+	{
+		RT::Core::TraversalCounters* rtCurrentCounters = rtCounters ? &rtThreadCounters[iThread] : nullptr;
+		for (uint64_t i = iBegin; i < iEnd; i++)
+		{
+			rtResults[i] = RT::Math::float4(rtRays[i].TMax, 0.0f, 0.0f, 0.0f);
+			iHitIndices[i] = 0;
+			if (bStackless)
+			{
+				RT::Core::TraverseBVHStackless(rtBVH.data(), iSkipLinks.data(), rtTriangles.data(), rtRays[i], rtResults[i], iHitIndices[i], rtCurrentCounters);
+			}
+			else
+			{
+				RT::Core::TraverseBVH(rtBVH.data(), rtTriangles.data(), rtRays[i], rtResults[i], iHitIndices[i], rtCurrentCounters);
+			}
+		}
+	});
+	double dTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - stdStartTime).count();
+
+	if (rtCounters)
+	{
+		*rtCounters = RT::Core::TraversalCounters{};
+		for (const RT::Core::TraversalCounters& rtThreadCounter : rtThreadCounters)
+		{
+			rtCounters->NumNodeTests += rtThreadCounter.NumNodeTests;
+			rtCounters->NumTriangleTests += rtThreadCounter.NumTriangleTests;
+		}
+	}
+	return dTime;
+}
+
+
+
+static void PrintUsage()
+{
+	std::cout << "Usage: TraversalBenchmark [OBJ file or grid size of the generated height field] [number of rays in thousands]\n";
+}
+
+//returns false, if the argument isn't a whole number from iMin to iMax
+static bool ParseArgument(const char* sArgument, uint32_t iMin, uint32_t iMax, uint32_t& iValue)
+{
+	const char* pEnd = sArgument + std::strlen(sArgument);
+	std::from_chars_result stdResult = std::from_chars(sArgument, pEnd, iValue);
+	return (stdResult.ec == std::errc()) && (stdResult.ptr == pEnd) && (iValue >= iMin) && (iValue <= iMax);
+}
+
+
+
+int main(int argc, char** argv)
+{
+	RT::Core::MeshInfo rtMesh{};
+	uint32_t iGridSize = 192; // the lbvh is slow to traverse, so the default scene is smaller than in the other benchmarks
+	uint32_t iNumKiloRays = 256;
+	const bool bLoadFile = (argc > 1) && (std::filesystem::exists(argv[1]));
+	if (((argc > 1) && (!bLoadFile) && (!(ParseArgument(argv[1], 1, 0xfffe, iGridSize)))) ||
+		((argc > 2) && (!(ParseArgument(argv[2], 1, 0x3fffff, iNumKiloRays)))))
+	{
+		std::cout << "Invalid arguments\n\n";
+		PrintUsage();
+		return 1;
+	}
+
+	if (bLoadFile)
+	{
+		rtMesh = RT::Core::LoadMeshFromFile(argv[1]);
+		if (!(rtMesh.Indices))
+		{
+			std::cout << "Error loading " << argv[1] << "\n";
+			return 1;
+		}
+	}
+	else
+	{
+		rtMesh = GenerateHeightField(iGridSize);
+	}
+	const uint32_t iNumRays = iNumKiloRays << 10;
+
+	//both binary trees: the lbvh of the gpu path and the SAH bvh
+	std::vector<RT::Core::AABB> rtBVHs[2];
+	std::vector<RT::Core::IntersectionTriangle> rtTriangles[2];
+	std::vector<uint32_t> iSkipLinks[2];
+	std::vector<RT::Math::uint2> rtMortonCodes;
+	std::vector<RT::Math::uint2> rtTempMortonCodes;
+	RT::Core::GenerateMortonCodes(rtMesh, rtMesh.SceneAABB, rtMortonCodes);
+	RT::Core::SortMortonCodes(rtMortonCodes, rtTempMortonCodes);
+	if ((!(RT::Core::BuildLBVH(rtMesh, rtMortonCodes, rtBVHs[0]))) || (!(RT::Core::BuildSAHBVH(rtMesh, rtBVHs[1]))))
+	{
+		std::cout << "Error building the bvh\n";
+		return 1;
+	}
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		if (!(RT::Core::BuildTriangleStream(rtMesh, rtBVHs[i], rtTriangles[i])))
+		{
+			std::cout << "Error building the triangle stream\n";
+			return 1;
+		}
+		RT::Core::BuildSkipLinks(rtBVHs[i], iSkipLinks[i]);
+	}
+
+	//the BVH8 of the SAH bvh isn't timed here, its closest hits are only checked against the binary traversals
+	std::vector<RT::Core::WideBVHNode<8>> rtWideBVH;
+	std::vector<RT::Core::IntersectionTriangle> rtWideTriangles;
+	if (!(RT::Core::BuildWideBVH<8>(rtBVHs[1], rtTriangles[1], rtWideBVH, rtWideTriangles)))
+	{
+		std::cout << "Error building the wide bvh\n";
+		return 1;
+	}
+
+	std::vector<RT::Core::Ray> rtRays[3] = { std::vector<RT::Core::Ray>(iNumRays), std::vector<RT::Core::Ray>(iNumRays), std::vector<RT::Core::Ray>(iNumRays) };
+	GenerateCameraRays(rtMesh.SceneAABB, rtRays[0]);
+	GenerateRandomRays(rtMesh.SceneAABB, rtRays[1]);
+	GenerateAxisRays(rtMesh.SceneAABB, rtRays[2]);
+
+	//the ordered traversal keeps BVH_STACK_SIZE (the same on the gpu) entries of a node and its entry distance per ray, the stackless traversal only the current node
+	std::cout << "\nBinary bvh traversal, " << RT::Core::GetThreadCount() << " threads, " << (rtMesh.IndexCount / 3) << " triangles, " << iNumRays << " rays\n";
+	std::cout << "traversal state per ray: " << (RT::Core::BVH_STACK_SIZE * 8) << " bytes with the ordered stack, 4 bytes with skip links\n";
+	std::cout << "the node and triangle tests are the averages per ray\n\n";
+	std::cout << std::setw(8) << "bvh" << std::setw(10) << "rays" << std::setw(16) << "ordered (ms)" << std::setw(10) << "Mrays/s" <<
+		std::setw(8) << "nodes" << std::setw(12) << "triangles" << std::setw(18) << "stackless (ms)" << std::setw(10) << "Mrays/s" <<
+		std::setw(8) << "nodes" << std::setw(12) << "triangles" << std::setw(10) << "equal" << "\n";
+
+	const char* sBVHNames[2] = { "lbvh", "sah" };
+	const char* sRayNames[3] = { "camera", "random", "axis" };
+	std::vector<RT::Math::float4> rtResults[2] = { std::vector<RT::Math::float4>(iNumRays), std::vector<RT::Math::float4>(iNumRays) };
+	std::vector<RT::Core::Index> iHitIndices[2] = { std::vector<RT::Core::Index>(iNumRays), std::vector<RT::Core::Index>(iNumRays) };
+	auto fnRaysPerSecond = [](uint32_t iNumRays, double dTime) { return (dTime > 0.0) ? ((double)iNumRays / (dTime * 1000.0)) : 0.0; };
+	bool bAllEqual = true;
+	for (uint32_t iBVH = 0; iBVH < 2; iBVH++)
+	{
+		for (uint32_t iRays = 0; iRays < 3; iRays++)
+		{
+			RT::Core::TraversalCounters rtCounters[2] = {};
+			double dOrderedTime = TraceRays(rtBVHs[iBVH], iSkipLinks[iBVH], rtTriangles[iBVH], rtRays[iRays], false, rtResults[0], iHitIndices[0]);
+			double dStacklessTime = TraceRays(rtBVHs[iBVH], iSkipLinks[iBVH], rtTriangles[iBVH], rtRays[iRays], true, rtResults[1], iHitIndices[1]);
+			TraceRays(rtBVHs[iBVH], iSkipLinks[iBVH], rtTriangles[iBVH], rtRays[iRays], false, rtResults[0], iHitIndices[0], &rtCounters[0]);
+			TraceRays(rtBVHs[iBVH], iSkipLinks[iBVH], rtTriangles[iBVH], rtRays[iRays], true, rtResults[1], iHitIndices[1], &rtCounters[1]);
+
+			//the traversals test the triangles in a different order, so only the distances have to match
+			//(overlapping triangles can be hit at almost the same distance, so the first one found can differ in the last bits)
+			bool bEqual = true;
+			for (uint32_t i = 0; i < iNumRays; i++)
+			{
+				float fDistance = std::max(std::abs(rtResults[0][i].x), 1.0f);
+				bEqual = bEqual && (std::abs(rtResults[0][i].x - rtResults[1][i].x) <= 1e-5f * fDistance);
+			}
+
+			//the BVH8 has the same leaves as the SAH bvh, so it has to find the same distances (its quantized bounds only add node visits)
+			if (iBVH == 1)
+			{
+				RT::Core::ParallelFor(iNumRays, 1024, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+				{
+					for (uint64_t i = iBegin; i < iEnd; i++)
+					{
+						rtResults[1][i] = RT::Math::float4(rtRays[iRays][i].TMax, 0.0f, 0.0f, 0.0f);
+						RT::Core::TraverseWideBVH<false>(rtWideBVH.data(), rtWideTriangles.data(), rtRays[iRays][i], rtResults[1][i], iHitIndices[1][i]);
+					}
+				});
+				for (uint32_t i = 0; i < iNumRays; i++)
+				{
+					float fDistance = std::max(std::abs(rtResults[0][i].x), 1.0f);
+					bEqual = bEqual && (std::abs(rtResults[0][i].x - rtResults[1][i].x) <= 1e-5f * fDistance);
+				}
+			}
+			bAllEqual = bAllEqual && bEqual;
+
+			std::cout << std::setw(8) << sBVHNames[iBVH] << std::setw(10) << sRayNames[iRays] << std::setw(16) << std::fixed << std::setprecision(2) <<
+				dOrderedTime << std::setw(10) << fnRaysPerSecond(iNumRays, dOrderedTime) <<
+				std::setw(8) << std::setprecision(1) << ((double)rtCounters[0].NumNodeTests / (double)iNumRays) <<
+				std::setw(12) << ((double)rtCounters[0].NumTriangleTests / (double)iNumRays) << std::setw(18) << std::setprecision(2) << dStacklessTime <<
+				std::setw(10) << fnRaysPerSecond(iNumRays, dStacklessTime) <<
+				std::setw(8) << std::setprecision(1) << ((double)rtCounters[1].NumNodeTests / (double)iNumRays) <<
+				std::setw(12) << ((double)rtCounters[1].NumTriangleTests / (double)iNumRays) << std::setw(10) << (bEqual ? "yes" : "NO") << "\n";
+		}
+	}
+
+	FreeMesh(rtMesh);
+
+	std::cout << "\n" << (bAllEqual ? "All traversals find the same hits\n" : "The traversals find different hits\n");
+	return bAllEqual ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <charconv>
+#include <string>
+#include <vector>
+
+#include "Core/MeshLoader.h"
+#include "Core/BVH.h"
+#include "Core/WideBVH.h"
+#include "Core/Intersection.h"
+#include "Core/RayQueue.h"
+#include "Core/Parallel.h"
+#include "Core/Random.h"
+
+#include "BenchmarkScene.h"
+
+
+
+//the scene and the rays, which are shared by all schedulers
+struct WavefrontScene
+{
+	RT::Core::MeshInfo Mesh;
+	std::vector<RT::Core::WideBVHNode<8>> BVH;
+	std::vector<RT::Core::IntersectionTriangle> Triangles;
+	float NormalOffset;
+};
+
+//trace one ray and let it bounce diffusely off the geometric normal, a ray, which missed, doesn't change (like in CS_TraceRays.hlsl)
+static bool TraceRay(const WavefrontScene& rtScene, RT::Core::Ray& rtRay, uint32_t iRayIndex, uint32_t iBounce)
+{
+	RT::Math::float4 rtResult = RT::Math::float4(rtRay.TMax, 0.0f, 0.0f, 0.0f);
+	RT::Core::Index iHitIndex = 0;
+	RT::Core::TraverseWideBVH(rtScene.BVH.data(), rtScene.Triangles.data(), rtRay, rtResult, iHitIndex);
+	if (rtResult.x == rtRay.TMax) return false;
+
+	const RT::Core::MeshInfo& rtMesh = rtScene.Mesh;
+	const RT::Math::float3& rtVertex1 = rtMesh.Vertices[rtMesh.Indices[iHitIndex]].Position;
+	const RT::Math::float3& rtVertex2 = rtMesh.Vertices[rtMesh.Indices[iHitIndex + 1]].Position;
+	const RT::Math::float3& rtVertex3 = rtMesh.Vertices[rtMesh.Indices[iHitIndex + 2]].Position;
+	RT::Math::float3 rtNormal = RT::Math::normalize(RT::Math::cross(rtVertex2 - rtVertex1, rtVertex3 - rtVertex1));
+	if (RT::Math::dot(rtNormal, rtRay.Direction) > 0.0f) rtNormal = -rtNormal;
+
+	//the same random numbers for a ray and a bounce in all schedulers
+	RT::Math::uint3 rtSeed = RT::Core::InitializeSeed(iRayIndex, RT::Math::uint3(iBounce, iBounce * 7919u, iBounce * 104729u));
+	rtRay.Origin = rtRay.Origin + rtRay.Direction * rtResult.x + rtNormal * rtScene.NormalOffset;
+	rtRay.Direction = RT::Core::RotatedRandomDirection(rtSeed, rtNormal);
+	return true;
+}
+
+
+
+static void PrintUsage()
+{
+	std::cout << "Usage: WavefrontBenchmark [OBJ file or grid size of the generated height field] [number of rays in thousands] [bounces]\n";
+}
+
+//returns false, if the argument isn't a whole number from iMin to iMax
+static bool ParseArgument(const char* sArgument, uint32_t iMin, uint32_t iMax, uint32_t& iValue)
+{
+	const char* pEnd = sArgument + std::strlen(sArgument);
+	std::from_chars_result stdResult = std::from_chars(sArgument, pEnd, iValue);
+	return (stdResult.ec == std::errc()) && (stdResult.ptr == pEnd) && (iValue >= iMin) && (iValue <= iMax);
+}
+
+
+
+int main(int argc, char** argv)
+{
+	WavefrontScene rtScene{};
+	uint32_t iGridSize = 384;
+	uint32_t iNumKiloRays = 256;
+	uint32_t iNumBounces = 8;
+	const bool bLoadFile = (argc > 1) && (std::filesystem::exists(argv[1]));
+	if (((argc > 1) && (!bLoadFile) && (!(ParseArgument(argv[1], 1, 0xfffe, iGridSize)))) ||
+		((argc > 2) && (!(ParseArgument(argv[2], 1, 0x3fffff, iNumKiloRays)))) ||
+		((argc > 3) && (!(ParseArgument(argv[3], 1, 0xffff, iNumBounces)))))
+	{
+		std::cout << "Invalid arguments\n\n";
+		PrintUsage();
+		return 1;
+	}
+
+	if (bLoadFile)
+	{
+		rtScene.Mesh = RT::Core::LoadMeshFromFile(argv[1]);
+		if (!(rtScene.Mesh.Indices))
+		{
+			std::cout << "Error loading " << argv[1] << "\n";
+			return 1;
+		}
+	}
+	else
+	{
+		rtScene.Mesh = GenerateHeightField(iGridSize);
+	}
+	const uint32_t iNumRays = iNumKiloRays << 10;
+
+	//the scene: the SAH bvh collapsed into a bvh with 8 children per node
+	std::vector<RT::Core::AABB> rtBVH;
+	std::vector<RT::Core::IntersectionTriangle> rtBinaryTriangles;
+	if ((!(RT::Core::BuildSAHBVH(rtScene.Mesh, rtBVH))) || (!(RT::Core::BuildTriangleStream(rtScene.Mesh, rtBVH, rtBinaryTriangles))) ||
+		(!(RT::Core::BuildWideBVH<8>(rtBVH, rtBinaryTriangles, rtScene.BVH, rtScene.Triangles))))
+	{
+		std::cout << "Error building the bvh\n";
+		return 1;
+	}
+	rtScene.NormalOffset = 1e-4f * RT::Math::length(rtScene.Mesh.SceneAABB.Max - rtScene.Mesh.SceneAABB.Min);
+
+	std::vector<RT::Core::Ray> rtRays(iNumRays);
+	std::vector<uint32_t> iLiveRays[3];
+	std::vector<double> dTimes[3];
+	std::vector<double> dBinningTimes;
+
+	//full: every bounce traces all rays, even the ones, which missed before (the old dispatch over MAX_RAYS)
+	GenerateCameraRays(rtScene.Mesh.SceneAABB, rtRays); // the camera rays of BenchmarkScene.h
+	for (uint32_t iBounce = 0; iBounce < iNumBounces; iBounce++)
+	{
+		std::vector<uint32_t> iHits(RT::Core::GetThreadCount(), 0);
+		auto stdStartTime = std::chrono::high_resolution_clock::now();
+		RT::Core::ParallelFor(iNumRays, 1024, [&](uint64_t iBegin, uint64_t iEnd, unsigned int iThread)
+		{
+			uint32_t iNumHits = 0;
+			for (uint64_t i = iBegin; i < iEnd; i++)
+			{
+				iNumHits += TraceRay(rtScene, rtRays[i], (uint32_t)i, iBounce) ? 1 : 0;
+			}
+			iHits[iThread] += iNumHits;
+		});
+		auto stdEndTime = std::chrono::high_resolution_clock::now();
+
+		uint32_t iNumHits = 0;
+		for (uint32_t iThreadHits : iHits) iNumHits += iThreadHits;
+		iLiveRays[0].push_back(iNumHits);
+		dTimes[0].push_back(std::chrono::duration<double, std::milli>(stdEndTime - stdStartTime).count());
+	}
+
+	//the camera rays form a square image, the bins use the pixels of the rays like the raytracer
+	const uint32_t iSide = (uint32_t)std::sqrt((double)iNumRays);
+	const RT::Math::uint2 rtScreenSize = RT::Math::uint2(iSide, (iNumRays + iSide - 1) / iSide);
+	std::vector<uint32_t> iRayPixels(iNumRays);
+	for (uint32_t i = 0; i < iNumRays; i++)
+	{
+		iRayPixels[i] = ((i % iSide) << 16) | (i / iSide);
+	}
+
+	//compacted: only the rays in the queue are traced, the survivors are compacted into the queue of the next bounce
+	//binned: the same, but the queue of every bounce after the first is sorted by the bins of the rays (coherent instead of incoherent traversal)
+	std::vector<uint32_t> iRayQueue(iNumRays);
+	std::vector<uint32_t> iNextRayQueue(iNumRays);
+	std::vector<uint8_t> iSurvivors(iNumRays);
+	std::vector<RT::Math::uint2> rtBins;
+	std::vector<RT::Math::uint2> rtTempBins;
+	for (uint32_t iSchedule = 1; iSchedule < 3; iSchedule++)
+	{
+		GenerateCameraRays(rtScene.Mesh.SceneAABB, rtRays);
+		for (uint32_t i = 0; i < iNumRays; i++)
+		{
+			iRayQueue[i] = i;
+		}
+		uint32_t iNumQueuedRays = iNumRays;
+		for (uint32_t iBounce = 0; iBounce < iNumBounces; iBounce++)
+		{
+			auto stdStartTime = std::chrono::high_resolution_clock::now();
+			if ((iSchedule == 2) && (iBounce > 0))
+			{
+				RT::Core::BinRayQueue(iRayQueue.data(), iNumQueuedRays, rtRays.data(), iRayPixels.data(), rtScreenSize, rtBins, rtTempBins);
+				dBinningTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - stdStartTime).count());
+			}
+			else if (iSchedule == 2)
+			{
+				dBinningTimes.push_back(0.0);
+			}
+
+			RT::Core::ParallelFor(iNumQueuedRays, 1024, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+			{
+				for (uint64_t i = iBegin; i < iEnd; i++)
+				{
+					iSurvivors[i] = TraceRay(rtScene, rtRays[iRayQueue[i]], iRayQueue[i], iBounce) ? 1 : 0;
+				}
+			});
+			iNumQueuedRays = RT::Core::CompactRayQueue(iRayQueue.data(), iSurvivors.data(), iNumQueuedRays, iNextRayQueue.data());
+			iRayQueue.swap(iNextRayQueue);
+			auto stdEndTime = std::chrono::high_resolution_clock::now();
+
+			iLiveRays[iSchedule].push_back(iNumQueuedRays);
+			dTimes[iSchedule].push_back(std::chrono::duration<double, std::milli>(stdEndTime - stdStartTime).count());
+		}
+	}
+
+	//the rays per second count the rays, which are live at the start of the bounce, the binned time includes the binning
+	std::cout << "\nWavefront path tracing, " << RT::Core::GetThreadCount() << " threads, " << (rtScene.Mesh.IndexCount / 3) << " triangles, " <<
+		iNumRays << " camera rays\n\n";
+	std::cout << std::setw(8) << "bounce" << std::setw(12) << "live rays" << std::setw(12) << "full (ms)" << std::setw(12) << "Mrays/s" <<
+		std::setw(18) << "compacted (ms)" << std::setw(12) << "Mrays/s" << std::setw(15) << "binned (ms)" << std::setw(12) << "Mrays/s" <<
+		std::setw(16) << "binning (ms)" << std::setw(10) << "equal" << "\n";
+
+	auto fnRaysPerSecond = [](uint32_t iNumRays, double dTime) { return (dTime > 0.0) ? ((double)iNumRays / (dTime * 1000.0)) : 0.0; };
+	bool bAllEqual = true;
+	double dTotalTimes[3] = { 0.0, 0.0, 0.0 };
+	double dTotalBinningTime = 0.0;
+	uint32_t iNumLiveRays = iNumRays;
+	for (uint32_t i = 0; i < iNumBounces; i++)
+	{
+		bool bEqual = (iLiveRays[0][i] == iLiveRays[1][i]) && (iLiveRays[0][i] == iLiveRays[2][i]);
+		bAllEqual = bAllEqual && bEqual;
+		dTotalTimes[0] += dTimes[0][i];
+		dTotalTimes[1] += dTimes[1][i];
+		dTotalTimes[2] += dTimes[2][i];
+		dTotalBinningTime += dBinningTimes[i];
+
+		std::cout << std::setw(8) << i << std::setw(12) << iNumLiveRays << std::setw(12) << std::fixed << std::setprecision(2) << dTimes[0][i] <<
+			std::setw(12) << fnRaysPerSecond(iNumLiveRays, dTimes[0][i]) << std::setw(18) << dTimes[1][i] <<
+			std::setw(12) << fnRaysPerSecond(iNumLiveRays, dTimes[1][i]) << std::setw(15) << dTimes[2][i] <<
+			std::setw(12) << fnRaysPerSecond(iNumLiveRays, dTimes[2][i]) << std::setw(16) << dBinningTimes[i] << std::setw(10) << (bEqual ? "yes" : "NO") << "\n";
+		iNumLiveRays = iLiveRays[1][i];
+	}
+	std::cout << std::setw(20) << "total" << std::setw(12) << dTotalTimes[0] << std::setw(30) << dTotalTimes[1] << std::setw(27) << dTotalTimes[2] <<
+		std::setw(28) << dTotalBinningTime << "\n";
+
+	FreeMesh(rtScene.Mesh);
+
+	std::cout << "\n" << (bAllEqual ? "All schedulers trace the same rays\n" : "The schedulers trace different rays\n");
+	return bAllEqual ? 0 : 1;
+}
\ No newline at end of file
@@ -3,24 +3,22 @@ workspace "GPURaytracer"
 
     configurations { "Debug", "Release" }
     platforms { "x64", "x86" }
+    startproject "GPURaytracer"
 
 
-project "GPURaytracer"
+project "RaytracerCore"
 
-    kind "ConsoleApp"
+    kind "StaticLib"
     language "C++"
     cppdialect "C++20"
     systemversion "latest"
     targetdir ("bin/%{cfg.buildcfg}/%{cfg.platform}")
-    objdir ("bin/%{cfg.buildcfg}/%{cfg.platform}/intermediate")
+    objdir ("bin/%{cfg.buildcfg}/%{cfg.platform}/intermediate/RaytracerCore")
 
     files
     {
-        "src/**.h",
-        "src/**.cpp",
-        "shader/**.hlsli",
-        "shader/**.hlsl",
-        "lib/**.lib"
+        "src/Core/**.h",
+        "src/Core/**.cpp"
     }
 
     includedirs
@@ -29,16 +27,136 @@ project "GPURaytracer"
         "include"
     }
 
-    libdirs
+
+    -- configure different build configurations and architectures
+    filter "configurations:Debug"
+        defines { "_DEBUG" }
+        symbols "On"
+    filter "configurations:Release"
+        defines { "NDEBUG" }
+        optimize "On"
+
+    filter "platforms:x64"
+        defines { "x64" }
+    filter "platforms:x86"
+        defines { "x86" }
+
+
+-- the d3d12 raytracer is only available on windows
+if os.istarget("windows") then
+
+    project "GPURaytracer"
+
+        filter {} -- reset the filter of the previous project
+
+        kind "ConsoleApp"
+        language "C++"
+        cppdialect "C++20"
+        systemversion "latest"
+        targetdir ("bin/%{cfg.buildcfg}/%{cfg.platform}")
+        objdir ("bin/%{cfg.buildcfg}/%{cfg.platform}/intermediate")
+
+        files
+        {
+            "src/**.h",
+            "src/**.cpp",
+            "shader/**.hlsli",
+            "shader/**.hlsl",
+            "lib/**.lib"
+        }
+
+        removefiles
+        {
+            "src/Core/**",
+            "src/CPU/**"
+        }
+
+        includedirs
+        {
+            "src",
+            "include"
+        }
+
+        libdirs
+        {
+            "lib/%{cfg.platform}"
+        }
+
+        links
+        {
+            "RaytracerCore",
+            "GLFW/glfw3.lib",
+            "dxgi.lib",
+            "d3d12.lib"
+        }
+
+        defines
+        {
+            "_CONSOLE"
+        }
+
+
+        -- configure different build configurations and architectures
+        filter "configurations:Debug"
+            defines { "_DEBUG" }
+            symbols "On"
+        filter "configurations:Release"
+            defines { "NDEBUG" }
+            optimize "On"
+
+        filter "platforms:x64"
+            defines { "x64" }
+        filter "platforms:x86"
+            defines { "x86" }
+
+        --filter {} -- reset the filter
+
+        -- configure shader compiler
+        filter "files:**.hlsl"
+            shadermodel "6.0"
+            shaderobjectfileoutput("%{file.directory}/shaderbin/%{file.basename}.cso")
+        filter "files:**CS_*.hlsl"
+            shadertype "Compute"
+        filter "files:**VS_*.hlsl"
+            shadertype "Vertex"
+        filter "files:**PS_*.hlsl"
+            shadertype "Pixel"
+        filter "files:**CS_Intersection.hlsl"
+            flags "ExcludeFromBuild"
+        filter "files:*.hlsli"
+            flags "ExcludeFromBuild"
+
+end
+
+
+project "RaytracerCPU"
+
+    filter {} -- reset the filter of the previous project
+
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++20"
+    systemversion "latest"
+    targetdir ("bin/%{cfg.buildcfg}/%{cfg.platform}")
+    objdir ("bin/%{cfg.buildcfg}/%{cfg.platform}/intermediate/RaytracerCPU")
+
+    files
+    {
+        "src/Settings.h",
+        "src/DefaultSettings.h",
+        "src/CPU/**.h",
+        "src/CPU/**.cpp"
+    }
+
+    includedirs
     {
-        "lib/%{cfg.platform}"
+        "src",
+        "include"
     }
 
     links
     {
-        "GLFW/glfw3.lib",
-        "dxgi.lib",
-        "d3d12.lib"
+        "RaytracerCore"
     }
 
     defines
@@ -60,19 +178,67 @@ project "GPURaytracer"
     filter "platforms:x86"
         defines { "x86" }
 
-    --filter {} -- reset the filter
-
-    -- configure shader compiler
-    filter "files:**.hlsl"
-        shadermodel "6.0"
-        shaderobjectfileoutput("%{file.directory}/shaderbin/%{file.basename}.cso")
-    filter "files:**CS_*.hlsl"
-        shadertype "Compute"
-    filter "files:**VS_*.hlsl"
-        shadertype "Vertex"
-    filter "files:**PS_*.hlsl"
-        shadertype "Pixel"
-    filter "files:**CS_Intersection.hlsl"
-        flags "ExcludeFromBuild"
-    filter "files:*.hlsli"
-        flags "ExcludeFromBuild"
\ No newline at end of file
+    filter "system:linux"
+        links { "pthread" }
+
+-- the benchmarks are small console programs, which only use the core library (the render benchmark also renders with the cpu backend)
+for _, sBenchmarkName in ipairs({ "SortBenchmark", "LoaderBenchmark", "WavefrontBenchmark", "TraversalBenchmark", "OcclusionBenchmark", "RenderBenchmark" }) do
+
+    project(sBenchmarkName)
+
+        filter {} -- reset the filter of the previous project
+
+        kind "ConsoleApp"
+        language "C++"
+        cppdialect "C++20"
+        systemversion "latest"
+        targetdir ("bin/%{cfg.buildcfg}/%{cfg.platform}")
+        objdir ("bin/%{cfg.buildcfg}/%{cfg.platform}/intermediate/" .. sBenchmarkName)
+
+        files
+        {
+            "benchmark/" .. sBenchmarkName .. ".cpp",
+            "benchmark/BenchmarkScene.h" -- the height field and the camera rays of the traversal benchmarks
+        }
+        if sBenchmarkName == "RenderBenchmark" then
+            files
+            {
+                "src/CPU/CPURaytracer.h",
+                "src/CPU/CPURaytracer.cpp"
+            }
+        end
+
+        includedirs
+        {
+            "src",
+            "include"
+        }
+
+        links
+        {
+            "RaytracerCore"
+        }
+
+        defines
+        {
+            "_CONSOLE"
+        }
+
+
+        -- configure different build configurations and architectures
+        filter "configurations:Debug"
+            defines { "_DEBUG" }
+            symbols "On"
+        filter "configurations:Release"
+            defines { "NDEBUG" }
+            optimize "On"
+
+        filter "platforms:x64"
+            defines { "x64" }
+        filter "platforms:x86"
+            defines { "x86" }
+
+        filter "system:linux"
+            links { "pthread" }
+
+end
\ No newline at end of file
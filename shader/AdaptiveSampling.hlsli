@@ -0,0 +1,44 @@
+#pragma once
+
+
+//adaptive sampling: every pixel tracks the mean and the variance of the luminance of its samples, a tile of pixels stops getting new camera rays,
+//when all its pixels have enough samples and their error estimate is below a threshold
+#define ADAPTIVE_TILE_SIZE 16 // = the thread groups of CS_GenerateFinalImage.hlsl and CS_CameraRayGeneration.hlsl
+
+
+
+//the moments of a pixel are updated with Welford's algorithm, one sample is the average of the rays of the pixel in one pass
+//x: the number of samples, y: the mean luminance, z: the sum of the squared differences from the mean (M2), w: the error estimate of SampleError
+//the standard error of the mean luminance, scaled by the slope of the tone mapping (x / (1 + x)), so the error is measured in the displayed image
+float SampleError(float4 Moments)
+{
+	if (Moments.x < 2.0f)
+	{
+		return 1.0f; // a single sample doesn't have a variance, so it counts as the largest displayed error
+	}
+	
+	float VarianceOfMean = Moments.z / (Moments.x * (Moments.x - 1.0f));
+	float ToneMappingSlope = rcp((1.0f + Moments.y) * (1.0f + Moments.y));
+	return sqrt(VarianceOfMean) * ToneMappingSlope;
+}
+
+
+//add the luminance of a new sample to the moments of a pixel (the same weights as Luminance in LightSampling.hlsli)
+float4 AddSample(float4 Moments, float3 Color)
+{
+	float SampleLuminance = dot(Color, float3(0.2126f, 0.7152f, 0.0722f));
+	float4 NewMoments = Moments;
+	NewMoments.x += 1.0f;
+	float Delta = SampleLuminance - Moments.y;
+	NewMoments.y += Delta / NewMoments.x;
+	NewMoments.z += Delta * (SampleLuminance - NewMoments.y);
+	NewMoments.w = SampleError(NewMoments);
+	return NewMoments;
+}
+
+
+//a pixel needs more samples, until it has the minimum number of samples and its error is below the threshold (an error threshold of 0.0f never stops)
+bool NeedsMoreSamples(float4 Moments, float ErrorThreshold, uint MinSamples)
+{
+	return (Moments.x < float(MinSamples)) || (Moments.w >= ErrorThreshold);
+}
\ No newline at end of file
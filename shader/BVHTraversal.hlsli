@@ -0,0 +1,318 @@
+#pragma once
+
+#include "../src/Settings.h" //for RT_USE_BVH, RT_USE_SAH_BVH, RT_BVH_WIDTH and RT_USE_STACKLESS_BVH
+
+#include "Raytracer.hlsli"
+
+
+#define USE_WIDE_BVH (RT_USE_BVH && RT_USE_SAH_BVH && (RT_BVH_WIDTH > 2)) //the SAH BVH is collapsed on the CPU, the morton code BVH is always binary
+#define WIDE_BVH_INNER_CHILD 0x80
+#define WIDE_BVH_RANK_MASK 0x1f
+#define WIDE_BVH_TRIANGLE_COUNT_SHIFT 5
+#define WIDE_BVH_STACK_SIZE 32 //like WIDE_BVH_STACK_SIZE in WideBVH.h
+#define BVH_STACK_SIZE 32 //one entry per level, both binary trees have at most LBVH_MAX_DEPTH (= BVH_MAX_DEPTH) levels (see BVH.h)
+#define USE_STACKLESS_BVH (RT_USE_BVH && RT_USE_STACKLESS_BVH && (!USE_WIDE_BVH))
+
+
+//the bvh of BuildBVH, which is shared by all passes, which trace rays (CS_TraceRays.hlsl and CS_TraceOcclusionRays.hlsl)
+#if USE_WIDE_BVH
+//the same layout as Core::WideBVHNode<RT_BVH_WIDTH> in WideBVH.h, 4 of the 8 bit values are packed into every uint
+//the quantized bounds of the child i on the axis a are in the byte (a * RT_BVH_WIDTH + i)
+struct WideBVHNode
+{
+	float3 Origin;
+	uint Exponents;
+	uint ChildBaseIndex;
+	uint TriangleBaseIndex;
+	uint Meta[RT_BVH_WIDTH / 4];
+	uint QuantizedMin[3 * RT_BVH_WIDTH / 4];
+	uint QuantizedMax[3 * RT_BVH_WIDTH / 4];
+};
+
+RWStructuredBuffer<WideBVHNode> BoundingVolumeHierarchy : register(u6, space0);
+#else
+RWStructuredBuffer<AABB> BoundingVolumeHierarchy : register(u6, space0);
+#endif
+RWStructuredBuffer<IntersectionTriangle> Triangles : register(u7, space0); // in the order of the bvh leaves
+RWStructuredBuffer<uint> SkipLinks : register(u16, space0); // the node after the subtree of every node of the binary bvh (CS_BVHBuildSkipLinks.hlsl)
+
+
+
+//a fast ray-triangle intersection algorithm, providing a lot of speed and small memory usage
+//the original paper: https://cadxfem.org/inf/Fast%20MinimumStorage%20RayTriangle%20Intersection.pdf
+float4 Intersect(Ray TestRay, IntersectionTriangle TestTriangle)
+{
+	//first define all the needed variables
+	float3 Result, Edge1, Edge2, tVec, pVec, qVec;
+	float Determinant, InverseDeterminant;
+	float TriangleIsClockwise;
+
+	//the edges are precomputed in the triangle stream
+	Edge1 = TestTriangle.Edge1;
+	Edge2 = TestTriangle.Edge2;
+	tVec = TestRay.Origin - TestTriangle.Vertex1;
+
+	//secondly, compute all the cross products
+	pVec = cross(TestRay.Direction, Edge2);
+	qVec = cross(tVec, Edge1);
+	
+	//calculate the determinant and its inverse
+	Determinant = dot(Edge1, pVec);
+	InverseDeterminant = (abs(Determinant) < EPSILON) ? 0.0f : 1.0f / Determinant;
+	TriangleIsClockwise = round(abs(Determinant) * InverseDeterminant); // 1 = clockwise; 0 = parallel to ray; -1 = counterclockwise
+
+	//calculate the result
+	Result.x = dot(Edge2, qVec); //the parameter 't' from the equation of a ray (O + t * R)
+	Result.y = dot(tVec, pVec); // 'u', one barycentric coordinate
+	Result.z = dot(TestRay.Direction, qVec); // 'v', the other barycentric coordinate
+	Result *= InverseDeterminant; // if InverseDeterminant is 0, the next check will fail
+	
+	//final check, if the ray intersects the triangle
+	Result = any(bool4(Result.x < EPSILON, Result.y < 0.0f, Result.z < 0.0f, Result.y + Result.z > 1.0f)) ? float3(-1.0f, -1.0f, -1.0f) : Result;
+
+	return float4(Result, TriangleIsClockwise);
+}
+
+
+//based on: https://jacco.ompf2.com/2022/04/18/how-to-build-a-bvh-part-2-faster-rays/
+float IntersectAABB(Ray TestRay, AABB TestAABB)
+{
+	float3 t1 = (TestAABB.Min - TestRay.Origin) / TestRay.Direction;
+	float3 t2 = (TestAABB.Max - TestRay.Origin) / TestRay.Direction;
+	
+	float3 tMinVals = min(t1, t2);
+	float3 tMaxVals = max(t1, t2);
+	float tMin = max(tMinVals.x, max(tMinVals.y, tMinVals.z));
+	float tMax = min(tMaxVals.x, min(tMaxVals.y, tMaxVals.z));
+	
+	if ((tMax < tMin) || (tMax <= 0) || (tMax < TestRay.TMin) || (tMin > TestRay.TMax))
+	{
+		tMin = 1e30f;
+	}
+	
+	return tMin;
+}
+
+
+#if USE_WIDE_BVH
+//the inverse ray direction of the wide slab test, the components, which are (almost) zero, keep their sign, but get the magnitude MIN_DIRECTION_COMPONENT,
+//so an axis-parallel ray gets huge finite distances instead of inf, which would give 0 * inf = NaN for a child bound in the plane of the ray origin
+#define MIN_DIRECTION_COMPONENT 1e-20f
+float3 GetInverseDirection(float3 Direction)
+{
+	float3 SafeDirection = (abs(Direction) < MIN_DIRECTION_COMPONENT) ? asfloat((asuint(Direction) & 0x80000000) | asuint(MIN_DIRECTION_COMPONENT)) : Direction;
+	return 1.0f / SafeDirection;
+}
+
+//the slab test against all children of a wide node, returns a bit for every child, which is hit closer than ClosestT
+uint IntersectWideNode(WideBVHNode Node, Ray TestRay, float3 InverseDirection, float ClosestT)
+{
+	//the child bounds are Origin + Quantized * Scale, so the distances are (Origin + Quantized * Scale - RayOrigin) * InverseDirection like in IntersectAABB
+	//(the bounds are subtracted before the multiplication, so a bound in the plane of the ray origin gives 0 and not a sum of two huge distances)
+	float3 Scale = asfloat(((uint3(Node.Exponents, Node.Exponents >> 8, Node.Exponents >> 16)) & 0xff) << 23);
+	float3 Offset = Node.Origin - TestRay.Origin;
+	uint HitMask = 0;
+	
+	[unroll]
+	for (uint i = 0; i < RT_BVH_WIDTH; i++)
+	{
+		uint Word = i / 4;
+		uint Shift = (i % 4) * 8;
+		uint Meta = (Node.Meta[Word] >> Shift) & 0xff;
+		float3 QuantizedMin = float3((uint3(Node.QuantizedMin[Word], Node.QuantizedMin[Word + RT_BVH_WIDTH / 4], Node.QuantizedMin[Word + RT_BVH_WIDTH / 2]) >> Shift) & 0xff);
+		float3 QuantizedMax = float3((uint3(Node.QuantizedMax[Word], Node.QuantizedMax[Word + RT_BVH_WIDTH / 4], Node.QuantizedMax[Word + RT_BVH_WIDTH / 2]) >> Shift) & 0xff);
+		
+		float3 t1 = mad(QuantizedMin, Scale, Offset) * InverseDirection;
+		float3 t2 = mad(QuantizedMax, Scale, Offset) * InverseDirection;
+		float3 tMinVals = min(t1, t2);
+		float3 tMaxVals = max(t1, t2);
+		float tMin = max(TestRay.TMin, max(tMinVals.x, max(tMinVals.y, tMinVals.z)));
+		float tMax = min(ClosestT, min(tMaxVals.x, min(tMaxVals.y, tMaxVals.z)));
+		
+		//the same conditions as IntersectAABB
+		bool Hit = (Meta != 0) && (tMin <= tMax) && (tMax > 0.0f) && (tMin < ClosestT);
+		HitMask |= Hit ? (1u << i) : 0;
+	}
+	
+	return HitMask;
+}
+#endif
+
+
+//test a triangle of the triangle stream, HitIndex is the position of the closest triangle in the index buffer
+void CheckIntersection(Ray CurrentRay, uint CurrentTriangle, inout float4 Result, inout uint HitIndex)
+{
+	IntersectionTriangle TestTriangle = Triangles[CurrentTriangle];
+	float4 CurrentResult = Intersect(CurrentRay, TestTriangle);
+	bool UseNewResult = (CurrentRay.TMin <= CurrentResult.x) && (CurrentRay.TMax > CurrentResult.x) && (CurrentResult.x < Result.x);
+	Result = UseNewResult ? CurrentResult : Result;
+	HitIndex = UseNewResult ? TestTriangle.FirstIndex : HitIndex;
+}
+
+
+
+//find the closest hit of a ray between TMin and Result.x (Result.x starts at TMax), HitIndex is the position of its triangle in the index buffer
+//with AnyHit, the traversal stops at the first hit, which is all an occlusion query needs (the hit doesn't have to be the closest one)
+void TraverseBVH(Ray CurrentRay, uint NumTriangles, bool AnyHit, inout float4 Result, inout uint HitIndex)
+{
+#if !RT_USE_BVH //no use of BVH
+	
+	for (uint i = 0; i < NumTriangles; i++)
+	{
+		CheckIntersection(CurrentRay, i, Result, HitIndex);
+		if (AnyHit && (Result.x < CurrentRay.TMax))
+		{
+			return;
+		}
+	}
+	
+#elif USE_WIDE_BVH //use the wide BVH
+	
+	//the stack stores groups of nodes (the first node and a bit mask of the nodes, which are still to visit), so it needs one entry per level
+	float3 InverseDirection = GetInverseDirection(CurrentRay.Direction);
+	uint2 Groups[WIDE_BVH_STACK_SIZE];
+	uint NumGroups = 0;
+	uint2 CurrentGroup = uint2(0, 1); // the trunk
+	
+	while (true)
+	{
+		if (CurrentGroup.y == 0)
+		{
+			if (NumGroups == 0)
+			{
+				break;
+			}
+			NumGroups--;
+			CurrentGroup = Groups[NumGroups];
+		}
+		
+		//take the next node out of the group
+		uint NodeIndex = CurrentGroup.x + firstbitlow(CurrentGroup.y);
+		CurrentGroup.y &= CurrentGroup.y - 1;
+		if (CurrentGroup.y != 0)
+		{
+			Groups[NumGroups] = CurrentGroup;
+			NumGroups++;
+		}
+		
+		//test the triangles of the hit leaves right away and collect the hit inner children
+		WideBVHNode Node = BoundingVolumeHierarchy[NodeIndex];
+		uint HitChildren = IntersectWideNode(Node, CurrentRay, InverseDirection, Result.x);
+		uint InnerChildren = 0;
+		while (HitChildren != 0)
+		{
+			uint Child = firstbitlow(HitChildren);
+			HitChildren &= HitChildren - 1;
+			uint Meta = (Node.Meta[Child / 4] >> ((Child % 4) * 8)) & 0xff;
+			if (Meta & WIDE_BVH_INNER_CHILD)
+			{
+				InnerChildren |= 1u << (Meta & WIDE_BVH_RANK_MASK);
+			}
+			else
+			{
+				uint FirstTriangle = Node.TriangleBaseIndex + (Meta & ((1u << WIDE_BVH_TRIANGLE_COUNT_SHIFT) - 1));
+				uint NumLeafTriangles = Meta >> WIDE_BVH_TRIANGLE_COUNT_SHIFT;
+				for (uint j = 0; j < NumLeafTriangles; j++)
+				{
+					CheckIntersection(CurrentRay, FirstTriangle + j, Result, HitIndex);
+				}
+				if (AnyHit && (Result.x < CurrentRay.TMax))
+				{
+					return;
+				}
+			}
+		}
+		CurrentGroup = uint2(Node.ChildBaseIndex, InnerChildren);
+	}
+	
+#elif USE_STACKLESS_BVH //use BVH without a stack
+	
+	//a hit inner node continues with its left child, a missed node or a leaf continues with its skip link, so no stack is needed
+	uint NodeIndex = 0;
+	while (NodeIndex != 0xffffffff)
+	{
+		AABB CurrentAABB = BoundingVolumeHierarchy[NodeIndex];
+		float CurrentResult = IntersectAABB(CurrentRay, CurrentAABB);
+		uint NextIndex = SkipLinks[NodeIndex];
+		if ((CurrentResult != 1e30f) && (CurrentResult < Result.x))
+		{
+			if (CurrentAABB.Padding.x & 0x80000000)
+			{
+				CheckIntersection(CurrentRay, CurrentAABB.Padding.x & 0x7fffffff, Result, HitIndex);
+				if (CurrentAABB.Padding.y != 0xffffffff)
+				{
+					CheckIntersection(CurrentRay, CurrentAABB.Padding.y & 0x7fffffff, Result, HitIndex);
+				}
+				if (AnyHit && (Result.x < CurrentRay.TMax))
+				{
+					return;
+				}
+			}
+			else
+			{
+				NextIndex = CurrentAABB.Padding.x;
+			}
+		}
+		NodeIndex = NextIndex;
+	}
+	
+#else //use BVH
+	
+	//front-to-back: both children of a node are tested at once, the near child is visited first and the far child is pushed with its entry distance,
+	//entries behind the closest hit are skipped when they are popped (one entry per level, so the stack of BVH_STACK_SIZE entries is never full)
+	uint2 Stack[BVH_STACK_SIZE]; // x: the node, y: the entry distance
+	uint NumEntries = 0;
+	uint NodeIndex = (IntersectAABB(CurrentRay, BoundingVolumeHierarchy[0]) != 1e30f) ? 0 : 0xffffffff;
+	
+	while (true)
+	{
+		//continue with the nearest pushed node, which starts before the closest hit
+		while ((NodeIndex == 0xffffffff) && (NumEntries > 0))
+		{
+			NumEntries--;
+			if (asfloat(Stack[NumEntries].y) < Result.x)
+			{
+				NodeIndex = Stack[NumEntries].x;
+			}
+		}
+		if (NodeIndex == 0xffffffff)
+		{
+			break;
+		}
+		
+		AABB CurrentAABB = BoundingVolumeHierarchy[NodeIndex];
+		if (CurrentAABB.Padding.x & 0x80000000)
+		{
+			CheckIntersection(CurrentRay, CurrentAABB.Padding.x & 0x7fffffff, Result, HitIndex);
+			if (CurrentAABB.Padding.y != 0xffffffff)
+			{
+				CheckIntersection(CurrentRay, CurrentAABB.Padding.y & 0x7fffffff, Result, HitIndex);
+			}
+			if (AnyHit && (Result.x < CurrentRay.TMax))
+			{
+				return;
+			}
+			NodeIndex = 0xffffffff;
+			continue;
+		}
+		
+		float LeftResult = IntersectAABB(CurrentRay, BoundingVolumeHierarchy[CurrentAABB.Padding.x]);
+		float RightResult = (CurrentAABB.Padding.y != 0xffffffff) ? IntersectAABB(CurrentRay, BoundingVolumeHierarchy[CurrentAABB.Padding.y]) : 1e30f;
+		bool HitLeft = (LeftResult != 1e30f) && (LeftResult < Result.x);
+		bool HitRight = (RightResult != 1e30f) && (RightResult < Result.x);
+		
+		if (HitLeft && HitRight)
+		{
+			bool LeftFirst = (LeftResult <= RightResult);
+			NodeIndex = LeftFirst ? CurrentAABB.Padding.x : CurrentAABB.Padding.y;
+			Stack[NumEntries] = LeftFirst ? uint2(CurrentAABB.Padding.y, asuint(RightResult)) : uint2(CurrentAABB.Padding.x, asuint(LeftResult));
+			NumEntries++;
+		}
+		else
+		{
+			NodeIndex = HitLeft ? CurrentAABB.Padding.x : (HitRight ? CurrentAABB.Padding.y : 0xffffffff);
+		}
+	}
+	
+#endif
+}
\ No newline at end of file
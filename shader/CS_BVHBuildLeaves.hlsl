@@ -22,6 +22,7 @@ StructuredBuffer<Index> Indices : register(t0, space0);
 StructuredBuffer<Vertex> Vertices : register(t1, space0);
 RWStructuredBuffer<uint4> MortonCodes : register(u5, space0);
 RWStructuredBuffer<AABB> BoundingVolumeHierarchy : register(u6, space0);
+RWStructuredBuffer<IntersectionTriangle> Triangles : register(u7, space0);
 
 
 
@@ -44,20 +45,37 @@ void main(CSInput Input)
 		//get the minimum and maximum positions
 		float3 Minimum = float3(1e30f, 1e30f, 1e30f);
 		float3 Maximum = float3(-1e30f, -1e30f, -1e30f);
+		float3 Positions[6];
 		
 		[unroll]
 		for (uint i = 0; i < Iterations; i++)
 		{
-			Vertex CurrentVertex = Vertices[Indices[CurrentIndices[i / 3] + (i % 3)]];
-			Minimum = min(Minimum, CurrentVertex.Position);
-			Maximum = max(Maximum, CurrentVertex.Position);
+			Positions[i] = Vertices[Indices[CurrentIndices[i / 3] + (i % 3)]].Position;
+			Minimum = min(Minimum, Positions[i]);
+			Maximum = max(Maximum, Positions[i]);
+		}
+		
+		//the triangles of the leaves are stored in the triangle stream in morton order (this is also the depth-first order of the leaves)
+		uint FirstTriangle = 2 * Input.GlobalThreadID.x;
+		
+		[unroll]
+		for (uint j = 0; j < Iterations / 3; j++)
+		{
+			IntersectionTriangle CurrentTriangle;
+			CurrentTriangle.Vertex1 = Positions[3 * j];
+			CurrentTriangle.FirstIndex = CurrentIndices[j];
+			CurrentTriangle.Edge1 = Positions[3 * j + 1] - Positions[3 * j];
+			CurrentTriangle.Padding1 = 0.0f;
+			CurrentTriangle.Edge2 = Positions[3 * j + 2] - Positions[3 * j];
+			CurrentTriangle.Padding2 = 0.0f;
+			Triangles[FirstTriangle + j] = CurrentTriangle;
 		}
 		
 		AABB FinalAABB;
 		FinalAABB.Min = Minimum;
 		FinalAABB.Max = Maximum;
-		FinalAABB.Padding.x = CurrentIndices[0] | 0x80000000;
-		FinalAABB.Padding.y = CurrentIndices[1] | 0x80000000;
+		FinalAABB.Padding.x = FirstTriangle | 0x80000000;
+		FinalAABB.Padding.y = (Iterations == 6) ? ((FirstTriangle + 1) | 0x80000000) : 0xffffffff;
 		
 		BoundingVolumeHierarchy[Input.GlobalThreadID.x + 1] = FinalAABB;
 	}
@@ -0,0 +1,54 @@
+#include "Raytracer.hlsli"
+
+
+#define GROUPSIZE_X 256
+#define GROUPSIZE_Y 1
+#define GROUPSIZE_Z 1
+
+
+struct BVHInfo
+{
+	uint NumChildren;
+	uint PreviousIndex;
+	uint CurrentIndex;
+	uint Padding;
+};
+
+
+//shader resources and UAVs
+ConstantBuffer<BVHInfo> InfoBuffer : register(b0, space0);
+RWStructuredBuffer<AABB> BoundingVolumeHierarchy : register(u6, space0);
+RWStructuredBuffer<uint> SkipLinks : register(u16, space0);
+
+
+
+//the same info buffers as CS_BVHBuild.hlsl, but dispatched top-down: every thread is a node of the level at CurrentIndex, whose skip link is already known,
+//and writes the skip links of its children (the left child continues with its sibling, the right child with the skip link of the parent)
+[numthreads(GROUPSIZE_X, GROUPSIZE_Y, GROUPSIZE_Z)]
+void main(CSInput Input)
+{
+	if (Input.GlobalThreadID.x < ((InfoBuffer.NumChildren + 1) / 2))
+	{
+		uint ParentIndex = InfoBuffer.CurrentIndex + Input.GlobalThreadID.x;
+		AABB Parent = BoundingVolumeHierarchy[ParentIndex];
+		uint ParentSkipLink = 0xffffffff; // the trunk ends the traversal
+		if (ParentIndex != 0)
+		{
+			ParentSkipLink = SkipLinks[ParentIndex];
+		}
+		else
+		{
+			SkipLinks[0] = 0xffffffff;
+		}
+		
+		if (Parent.Padding.y != 0xffffffff)
+		{
+			SkipLinks[Parent.Padding.x] = Parent.Padding.y;
+			SkipLinks[Parent.Padding.y] = ParentSkipLink;
+		}
+		else
+		{
+			SkipLinks[Parent.Padding.x] = ParentSkipLink;
+		}
+	}
+}
\ No newline at end of file
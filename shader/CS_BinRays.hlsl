@@ -0,0 +1,79 @@
+#include "Raytracer.hlsli"
+#include "TraceRays.hlsli"
+
+
+#define GROUPSIZE_X 256
+#define GROUPSIZE_Y 1
+#define GROUPSIZE_Z 1
+
+#define SORT_HISTOGRAM_BUFFER_SIZE 1028 // the histograms and tile counters of the 4 sort passes (see Sort.hlsli)
+#define RAY_BIN_DIRECTION_BITS 16 // these values have to match the ones in Core/RayQueue.h
+#define RAY_BIN_INVALID_KEY 0xffffffff
+
+
+//shader resources and UAVs
+ConstantBuffer<TraceRaysInfo> InfoBuffer : register(b0, space0);
+RWStructuredBuffer<Ray> Rays : register(u0, space0);
+RWStructuredBuffer<uint4> RayPixels : register(u2, space0);
+RWStructuredBuffer<uint> RayQueue : register(u8, space0); // the indices of the live rays
+RWStructuredBuffer<uint> RayQueueState : register(u10, space0);
+RWStructuredBuffer<uint4> RayBins : register(u14, space0);
+RWStructuredBuffer<uint> GlobalHistograms : register(u15, space0);
+
+
+
+uint2 GetRayPixel(uint RayIndex)
+{
+	uint2 Position;
+	uint4 SavedValue = RayPixels[RayIndex >> 2]; // = RayIndex / 4
+	
+	SavedValue.xy = (RayIndex % 2) ? SavedValue.yw : SavedValue.xz;
+	SavedValue.x = ((RayIndex % 4) < 2) ? SavedValue.x : SavedValue.y;
+	Position = uint2(SavedValue.x >> 16, SavedValue.x & 0xffff);
+	
+	return Position;
+}
+
+//the bin of a ray (the same key as Core::GetRayBinKey): 4 bits for the screen tile (2 horizontal and 2 vertical) above
+//16 bits for the direction (8 bits per axis of its octahedral mapping), based on the ray binning of Battlefield V
+uint GetRayBinKey(float3 Direction, uint2 Pixel)
+{
+	//the octahedral mapping of the direction to [-1, 1]^2
+	float Length = abs(Direction.x) + abs(Direction.y) + abs(Direction.z);
+	float2 Octahedral = (Length > 0.0f) ? (Direction.xy / Length) : float2(0.0f, 0.0f);
+	if (Direction.z < 0.0f)
+	{
+		Octahedral = (1.0f - abs(Octahedral.yx)) * ((Octahedral >= 0.0f) ? 1.0f : -1.0f);
+	}
+	uint2 Quantized = (uint2)clamp((Octahedral * 0.5f + 0.5f) * 256.0f, 0.0f, 255.0f);
+	
+	uint2 Tile = min(Pixel * 4 / (uint2)max(InfoBuffer.ScreenDimensions, 1), 3);
+	
+	return (((Tile.y << 2) | Tile.x) << RAY_BIN_DIRECTION_BITS) | (Quantized.y << 8) | Quantized.x;
+}
+
+
+
+//write the bin key of every ray in the queue for the radix sort, the empty slots get the biggest key, so they are sorted behind the rays
+[numthreads(GROUPSIZE_X, GROUPSIZE_Y, GROUPSIZE_Z)]
+void main(CSInput Input)
+{
+	//reset the histograms of the sort
+	if (Input.GlobalThreadID.x < SORT_HISTOGRAM_BUFFER_SIZE)
+	{
+		GlobalHistograms[Input.GlobalThreadID.x] = 0;
+	}
+	
+	if (all(Input.GlobalThreadID.x < InfoBuffer.NumRays))
+	{
+		uint4 Bin = uint4(RAY_BIN_INVALID_KEY, 0, 0, 0);
+		if (Input.GlobalThreadID.x < RayQueueState[RAY_QUEUE_LIVE_COUNT])
+		{
+			uint RayIndex = RayQueue[Input.GlobalThreadID.x];
+			Bin.x = GetRayBinKey(Rays[RayIndex].Direction, GetRayPixel(RayIndex));
+			Bin.y = RayIndex;
+		}
+		
+		RayBins[Input.GlobalThreadID.x] = Bin;
+	}
+}
\ No newline at end of file
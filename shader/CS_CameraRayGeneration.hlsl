@@ -1,6 +1,8 @@
 
 #include "Raytracer.hlsli"
 #include "Random.hlsli"
+#include "Sampler.hlsli" //the pixel sampler of the settings (PERMUTATION_SAMPLER)
+#include "AdaptiveSampling.hlsli"
 
 
 #define GROUPSIZE_X 16
@@ -17,6 +19,10 @@ struct RayGenInfo
 	float DOFSampleSpread;
 	uint MaxRayPerPixel;
 	uint3 RNGSeed;
+	uint2 TileOffset; // the first pixel of the current render tile
+	uint2 TileSize; // the size of every render tile, the ray slots are ordered by the position of their pixel in the tile
+	uint SampleIndex; // the number of camera passes before this one, ray i of a pixel is the sample SampleIndex * MaxRayPerPixel + i of the pixel
+	uint ImageSeed; // the seed of the settings, it scrambles the sobol points and moves the blue noise mask
 };
 
 
@@ -25,6 +31,9 @@ ConstantBuffer<RayGenInfo> InfoBuffer : register(b0, space0);
 RWStructuredBuffer<Ray> GeneratedRays : register(u0, space0);
 RWStructuredBuffer<Ray> OldRays : register(u1, space0); // here, TMin represents the t value in R = t * Direction + Origin, TMax is the Index of the ray in the pixel
 RWStructuredBuffer<uint4> RayPixels : register(u2, space0);
+RWStructuredBuffer<float4> ScatteredLight : register(u3, space0);
+RWStructuredBuffer<float4> EmittedLight : register(u4, space0);
+RWStructuredBuffer<uint> ConvergedTiles : register(u5, space0); // the tiles, which the adaptive sampling stopped (written by CS_GenerateFinalImage.hlsl)
 
 
 
@@ -53,13 +62,26 @@ void SetRayPixel(uint RayIndex, uint2 Position)
 
 
 
+//every thread is one pixel of the render tile, every thread group is one tile of the adaptive sampling
 [numthreads(GROUPSIZE_X, GROUPSIZE_Y, GROUPSIZE_Z)]
 void main(CSInput Input)
 {
-	if (all(Input.GlobalThreadID.xy < InfoBuffer.ScreenDimensions))
+	if (all(Input.GlobalThreadID.xy < InfoBuffer.TileSize))
 	{
+		uint2 Pixel = InfoBuffer.TileOffset + Input.GlobalThreadID.xy;
+		uint FirstRay = mad(Input.GlobalThreadID.y, InfoBuffer.TileSize.x, Input.GlobalThreadID.x) * InfoBuffer.MaxRayPerPixel;
+		
+		//the slots of the pixels outside of the image and the rays of a converged tile get a negative TMax,
+		//so CS_TraceRays skips them like the paths, which were terminated by the russian roulette
+		uint NumTilesX = (uint(InfoBuffer.ScreenDimensions.x) + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE;
+		bool Converged = any(Pixel >= uint2(InfoBuffer.ScreenDimensions));
+		if (!Converged)
+		{
+			Converged = (ConvergedTiles[mad(NumTilesX, Pixel.y / ADAPTIVE_TILE_SIZE, Pixel.x / ADAPTIVE_TILE_SIZE)] != 0);
+		}
+		
 		//initialize the random number generation seed
-		uint3 RNGSeed = Input.GlobalThreadID.xxx;
+		uint3 RNGSeed = Pixel.xxx;
 		RNGSeed *= RNGSeed + 17;
 		XorShift(RNGSeed);
 		RNGSeed += InfoBuffer.RNGSeed;
@@ -71,10 +93,13 @@ void main(CSInput Input)
 		{
 			//get the normalized device coordinates (NDC)
 			float2 InvScreenSize = rcp(float2(InfoBuffer.ScreenDimensions));
-			float2 ScreenCoords = float2(Input.GlobalThreadID.xy) * InvScreenSize;
+			float2 ScreenCoords = float2(Pixel) * InvScreenSize;
 			float2 NDC = -2.0f * float2(ScreenCoords.x, ScreenCoords.y) + 1.0f;
-			float2 NearNDC = NDC + (Random(RNGSeed.xy) - 0.5f) * InvScreenSize * InfoBuffer.DOFSampleSpread; //for depth of field
-			float2 FarNDC = NDC + (Random(RNGSeed.xy) - 0.5f) * InvScreenSize * InfoBuffer.AASampleSpread; //for anti-aliasing
+			Sampler PixelSampler = InitializeSampler(Pixel, InfoBuffer.SampleIndex * InfoBuffer.MaxRayPerPixel + i, RNGSeed, InfoBuffer.ImageSeed);
+			float4 CameraSample = SampleDimensions(PixelSampler, SAMPLER_CAMERA_DIMENSIONS);
+			RNGSeed = PixelSampler.RNGSeed; // the xorshift generator continues with the next ray of the pixel
+			float2 NearNDC = NDC + (CameraSample.zw - 0.5f) * InvScreenSize * InfoBuffer.DOFSampleSpread; //for depth of field
+			float2 FarNDC = NDC + (CameraSample.xy - 0.5f) * InvScreenSize * InfoBuffer.AASampleSpread; //for anti-aliasing
 		
 			float4x4 InverseViewProjection = mul(InfoBuffer.InverseProjection, InfoBuffer.InverseView);
 		
@@ -86,16 +111,19 @@ void main(CSInput Input)
 			RayInfo.Direction = normalize(FarPoint.xyz - NearPoint.xyz);
 			RayInfo.Origin = NearPoint.xyz + mul(InfoBuffer.InverseView, float4(0.0f, 0.0f, 0.0f, 1.0f)).xyz;
 			RayInfo.TMin = 0.0f;
-			RayInfo.TMax = length(FarPoint.xyz);
+			RayInfo.TMax = Converged ? -1.0f : length(FarPoint.xyz);
 			OldRayInfo.Direction = float3(0.0f, 0.0f, 0.0f);
 			OldRayInfo.Origin = float3(0.0f, 0.0f, 0.0f);
 			OldRayInfo.TMin = 0.0f;
 			OldRayInfo.TMax = asfloat(i);
 		
-			uint FlattenedIndex = mad(Input.GlobalThreadID.y, InfoBuffer.ScreenDimensions.x, Input.GlobalThreadID.x) * InfoBuffer.MaxRayPerPixel + i;
+			//the slots were used by another tile before, so a camera ray, which misses, starts without light
+			uint FlattenedIndex = FirstRay + i;
 			GeneratedRays[FlattenedIndex] = RayInfo;
 			OldRays[FlattenedIndex] = OldRayInfo;
-			SetRayPixel(FlattenedIndex, Input.GlobalThreadID.xy);
+			SetRayPixel(FlattenedIndex, Pixel);
+			ScatteredLight[FlattenedIndex] = float4(1.0f, 1.0f, 1.0f, 0.0f);
+			EmittedLight[FlattenedIndex] = float4(0.0f, 0.0f, 0.0f, 0.0f);
 		}
 	}
 }
\ No newline at end of file
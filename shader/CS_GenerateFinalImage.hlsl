@@ -1,6 +1,7 @@
 
 #include "Raytracer.hlsli"
 #include "Random.hlsli"
+#include "AdaptiveSampling.hlsli"
 
 
 #define GROUPSIZE_X 16
@@ -12,7 +13,12 @@ struct ImageGenerationInfo
 {
 	int2 ScreenDimensions;
 	uint MaxRaysPerPixel;
-	uint NumSamples;
+	uint NumSamples; // the highest bit is set, if the samples of this pass are added to the result
+	float ErrorThreshold; // the adaptive sampling stops a tile, when the error of all its pixels is below this threshold (never at 0.0f)
+	uint MinSamples;
+	uint2 TileOffset; // the first pixel of the current render tile
+	uint2 TileSize; // the size of every render tile, the ray slots are ordered by the position of their pixel in the tile
+	uint2 Padding;
 };
 
 
@@ -22,40 +28,81 @@ RWStructuredBuffer<float4> ScatteredLight : register(u3, space0);
 RWStructuredBuffer<float4> EmittedLight : register(u4, space0);
 RWStructuredBuffer<float4> ResultBuffer : register(u5, space0);
 RWTexture2D<float4> OutputTexture : register(u6, space0);
+RWStructuredBuffer<float4> SampleMoments : register(u7, space0); // the moments of the luminance of every pixel (see AdaptiveSampling.hlsli)
+RWStructuredBuffer<uint> ConvergedTiles : register(u8, space0); // 1 for every tile, which doesn't get new samples anymore
 
 
+groupshared uint ActivePixels; // the pixels of this tile, which need more samples
 
+
+
+//every thread is one pixel of the render tile, every thread group is one tile of the adaptive sampling (the render tiles are aligned to them)
 [numthreads(GROUPSIZE_X, GROUPSIZE_Y, GROUPSIZE_Z)]
 void main(CSInput Input)
 {
-	if (all(Input.GlobalThreadID.xy < InfoBuffer.ScreenDimensions))
+	bool ApplyResults = ((InfoBuffer.NumSamples & 0x80000000) > 0);
+	uint2 Pixel = InfoBuffer.TileOffset + Input.GlobalThreadID.xy;
+	uint NumTilesX = (uint(InfoBuffer.ScreenDimensions.x) + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE;
+	uint TileIndex = mad(NumTilesX, InfoBuffer.TileOffset.y / ADAPTIVE_TILE_SIZE + Input.GroupID.y, InfoBuffer.TileOffset.x / ADAPTIVE_TILE_SIZE + Input.GroupID.x);
+	bool InsideImage = all(Pixel < uint2(InfoBuffer.ScreenDimensions)) && all(Input.GlobalThreadID.xy < InfoBuffer.TileSize);
+	
+	//a converged tile didn't get camera rays in this pass, the groups of a render tile at the border of the image can be completely outside of it
+	bool Converged = true;
+	if (all(InfoBuffer.TileOffset + Input.GroupID.xy * ADAPTIVE_TILE_SIZE < uint2(InfoBuffer.ScreenDimensions)))
+	{
+		Converged = (ConvergedTiles[TileIndex] != 0);
+	}
+	if (Input.GroupThreadIndex == 0)
+	{
+		ActivePixels = 0;
+	}
+	GroupMemoryBarrierWithGroupSync();
+	
+	if (InsideImage)
 	{
-		uint ResultBufferIndex = mad(InfoBuffer.ScreenDimensions.x, Input.GlobalThreadID.y, Input.GlobalThreadID.x);
+		uint ResultBufferIndex = mad(InfoBuffer.ScreenDimensions.x, Pixel.y, Pixel.x);
 		float4 TotalColor = ResultBuffer[ResultBufferIndex];
-		float4 NewColor = float4(0.0f, 0.0f, 0.0f, 0.0f);
+		float4 Moments = SampleMoments[ResultBufferIndex];
+		float4 DisplayedColor = TotalColor;
 		
-		uint Index = ResultBufferIndex * InfoBuffer.MaxRaysPerPixel;
-		for (uint i = 0; i < InfoBuffer.MaxRaysPerPixel; i++)
+		if (!Converged)
 		{
-			//add up all results that contribute to this pixel
-			NewColor += EmittedLight[Index + i];
-		}
-		
-		//average with the new color
-		NewColor /= float(InfoBuffer.MaxRaysPerPixel);
-		uint NumSamples = InfoBuffer.NumSamples & 0x7fffffff;
-		float InverseNumSamples = rcp(float(NumSamples));
-		float4 DisplayedColor = (float(NumSamples - 1) * InverseNumSamples) * TotalColor + InverseNumSamples * NewColor;
-		if ((InfoBuffer.NumSamples & 0x80000000) > 0)
-		{
-			TotalColor = DisplayedColor;
+			float4 NewColor = float4(0.0f, 0.0f, 0.0f, 0.0f);
+			uint Index = mad(Input.GlobalThreadID.y, InfoBuffer.TileSize.x, Input.GlobalThreadID.x) * InfoBuffer.MaxRaysPerPixel; // the ray slots of the pixel
+			for (uint i = 0; i < InfoBuffer.MaxRaysPerPixel; i++)
+			{
+				//add up all results that contribute to this pixel
+				NewColor += EmittedLight[Index + i];
+			}
+			
+			//average with the new color, every pixel counts its own samples
+			NewColor /= float(InfoBuffer.MaxRaysPerPixel);
+			float InverseNumSamples = rcp(Moments.x + 1.0f);
+			DisplayedColor = (Moments.x * InverseNumSamples) * TotalColor + InverseNumSamples * NewColor;
+			if (ApplyResults)
+			{
+				TotalColor = DisplayedColor;
+				Moments = AddSample(Moments, NewColor.xyz);
+				if (NeedsMoreSamples(Moments, InfoBuffer.ErrorThreshold, InfoBuffer.MinSamples))
+				{
+					InterlockedAdd(ActivePixels, 1);
+				}
+			}
 		}
 		
 		//if (length(NewColor.xyz) > 100.0f)
 		//	DisplayedColor = float4(0.0f, 0.0f, 0.0f, 0.0f);
 		//OutputTexture[Input.GlobalThreadID.xy] = NewColor;
 		//OutputTexture[Input.GlobalThreadID.xy] = DisplayedColor;
-		OutputTexture[Input.GlobalThreadID.xy] = DisplayedColor / (1.0f + DisplayedColor); // basic tone mapping
+		OutputTexture[Pixel] = DisplayedColor / (1.0f + DisplayedColor); // basic tone mapping
 		ResultBuffer[ResultBufferIndex] = TotalColor;
+		SampleMoments[ResultBufferIndex] = Moments;
+	}
+	
+	//the camera rays of the next pass skip the tile, once all its pixels are converged
+	GroupMemoryBarrierWithGroupSync();
+	if (ApplyResults && (!Converged) && (Input.GroupThreadIndex == 0))
+	{
+		ConvergedTiles[TileIndex] = (ActivePixels == 0) ? 1 : 0;
 	}
 }
\ No newline at end of file
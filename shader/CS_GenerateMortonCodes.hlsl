@@ -6,6 +6,8 @@
 #define GROUPSIZE_Y 1
 #define GROUPSIZE_Z 1
 
+#define SORT_HISTOGRAM_BUFFER_SIZE 1028 // the histograms and tile counters of the 4 sort passes (see Sort.hlsli)
+
 
 struct MortonCodeInfo
 {
@@ -21,7 +23,7 @@ ConstantBuffer<MortonCodeInfo> InfoBuffer : register(b0, space0);
 StructuredBuffer<Index> Indices : register(t0, space0);
 StructuredBuffer<Vertex> Vertices : register(t1, space0);
 RWStructuredBuffer<uint4> MortonCodes : register(u5, space0);
-RWStructuredBuffer<uint4> CodeFrequencies : register(u7, space0);
+RWStructuredBuffer<uint> GlobalHistograms : register(u7, space0);
 
 
 
@@ -70,8 +72,9 @@ void main(CSInput Input)
 		//MortonCodes[Input.GlobalThreadID.x] = uint4(100000 * uint(abs(InfoBuffer.SceneMin.z)), 100000, 100000, 100000);
 	}
 	
-	if (Input.GlobalThreadID.x < 256)
+	//reset the histograms for the sorting
+	if (Input.GlobalThreadID.x < SORT_HISTOGRAM_BUFFER_SIZE)
 	{
-		CodeFrequencies[Input.GlobalThreadID.x].x = 0;
+		GlobalHistograms[Input.GlobalThreadID.x] = 0;
 	}
 }
\ No newline at end of file
@@ -33,6 +33,9 @@ Exclusive parallel sum + some magic
 -->
 look up table
 
+Implemented in CS_BinRays.hlsl: the direction uses the octahedral mapping instead of longitude and latitude,
+the bins are sorted with the onesweep radix sort instead of the atomic counting
+
 
 */
 
@@ -0,0 +1,75 @@
+#include "Raytracer.hlsli"
+#include "TraceRays.hlsli"
+
+
+#define GROUPSIZE_X 256
+#define GROUPSIZE_Y 1
+#define GROUPSIZE_Z 1
+
+#define TRACE_RAYS_GROUPSIZE_X 256 // GROUPSIZE_X in CS_TraceRays.hlsl, CS_SortHits.hlsl and CS_ShadeHits.hlsl
+
+
+//shader resources and UAVs
+ConstantBuffer<TraceRaysInfo> InfoBuffer : register(b0, space0);
+RWStructuredBuffer<uint> RayQueueState : register(u0, space0);
+RWStructuredBuffer<uint> RayQueueArguments : register(u1, space0); // the arguments of the indirect dispatches
+RWStructuredBuffer<uint> MaterialQueues : register(u2, space0); // the hit counts of the materials, followed by the next free slot of every material
+
+
+groupshared uint IntermediateBuffer[GROUPSIZE_X];
+
+
+
+//the appended rays become the queue of the sorting, the shading and the next bounce: the dispatches get one thread per live ray
+//the exclusive prefix sum over the hit counts gives the first slot of every material in the shading queue (the counts start again at 0)
+[numthreads(GROUPSIZE_X, GROUPSIZE_Y, GROUPSIZE_Z)]
+void main(CSInput Input)
+{
+	uint MaterialOffset = 0;
+	for (uint FirstMaterial = 0; FirstMaterial < InfoBuffer.NumMaterials; FirstMaterial += GROUPSIZE_X)
+	{
+		uint MaterialID = FirstMaterial + Input.GroupThreadID.x;
+		uint Count = (MaterialID < InfoBuffer.NumMaterials) ? MaterialQueues[MaterialID] : 0;
+		IntermediateBuffer[Input.GroupThreadID.x] = Count;
+		
+		[unroll]
+		for (uint i = 0; i < 8; i++)
+		{
+			GroupMemoryBarrierWithGroupSync();
+			
+			uint Exp2i = 1 << i;
+			uint CurrentValue = 0;
+			if (Input.GroupThreadID.x >= Exp2i)
+			{
+				CurrentValue = IntermediateBuffer[Input.GroupThreadID.x - Exp2i];
+			}
+			
+			GroupMemoryBarrierWithGroupSync();
+			
+			IntermediateBuffer[Input.GroupThreadID.x] += CurrentValue;
+		}
+		
+		GroupMemoryBarrierWithGroupSync();
+		
+		if (MaterialID < InfoBuffer.NumMaterials)
+		{
+			MaterialQueues[InfoBuffer.NumMaterials + MaterialID] = MaterialOffset + IntermediateBuffer[Input.GroupThreadID.x] - Count;
+			MaterialQueues[MaterialID] = 0;
+		}
+		MaterialOffset += IntermediateBuffer[GROUPSIZE_X - 1];
+		
+		GroupMemoryBarrierWithGroupSync();
+	}
+	
+	if (Input.GroupThreadID.x == 0)
+	{
+		uint NumRays = RayQueueState[RAY_QUEUE_APPEND_COUNTER];
+		
+		RayQueueArguments[0] = (NumRays + TRACE_RAYS_GROUPSIZE_X - 1) / TRACE_RAYS_GROUPSIZE_X;
+		RayQueueArguments[1] = 1;
+		RayQueueArguments[2] = 1;
+		RayQueueState[RAY_QUEUE_LIVE_COUNT] = NumRays;
+		RayQueueState[RAY_QUEUE_APPEND_COUNTER] = 0;
+		RayQueueState[RAY_QUEUE_WORK_COUNTER] = 0;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "Raytracer.hlsli"
+#include "TraceRays.hlsli"
+
+
+#define GROUPSIZE_X 256
+#define GROUPSIZE_Y 1
+#define GROUPSIZE_Z 1
+
+
+//shader resources and UAVs
+ConstantBuffer<TraceRaysInfo> InfoBuffer : register(b0, space0);
+RWStructuredBuffer<float4> EmittedLight : register(u4, space0);
+RWStructuredBuffer<uint> RayQueueState : register(u10, space0);
+RWStructuredBuffer<Ray> ShadowRays : register(u17, space0); // the shadow ray of every entry of the shading queue, TMax is negative without one
+RWStructuredBuffer<uint> ShadowRayVisibility : register(u18, space0); // the result of CS_TraceOcclusionRays.hlsl, one bit per shadow ray
+RWStructuredBuffer<float4> ShadowLight : register(u19, space0); // the light, which a shadow ray adds to the pixel slot asuint(w), if it isn't occluded
+
+
+
+//add the light of the shadow rays of CS_ShadeHits.hlsl, which reached their light, every shadow ray belongs to another pixel slot
+[numthreads(GROUPSIZE_X, GROUPSIZE_Y, GROUPSIZE_Z)]
+void main(CSInput Input)
+{
+	uint ShadowRayIndex = Input.GlobalThreadID.x;
+	if (ShadowRayIndex < RayQueueState[RAY_QUEUE_LIVE_COUNT])
+	{
+		float4 Light = ShadowLight[ShadowRayIndex];
+		bool Visible = ((ShadowRayVisibility[ShadowRayIndex / 32] >> (ShadowRayIndex % 32)) & 1) != 0;
+		if (Visible && any(Light.xyz > 0.0f))
+		{
+			uint Index = asuint(Light.w);
+			EmittedLight[Index] += float4(Light.xyz, 0.0f);
+		}
+		
+		//the occlusion query traces all slots, so this one stays empty, until the shading writes a new shadow ray to it
+		ShadowRays[ShadowRayIndex].TMax = -1.0f;
+	}
+}
\ No newline at end of file
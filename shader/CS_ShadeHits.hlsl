@@ -0,0 +1,193 @@
+
+#include "PerRayShading.hlsli"
+#include "Raytracer.hlsli"
+#include "Random.hlsli"
+#include "Sampler.hlsli" //the pixel sampler of the settings (PERMUTATION_SAMPLER)
+#include "TraceRays.hlsli"
+#include "LightSampling.hlsli" //the emissive triangles (t5)
+
+
+#define GROUPSIZE_X 256
+#define GROUPSIZE_Y 1
+#define GROUPSIZE_Z 1
+
+#define SHADOW_RAY_EPSILON 1e-3f // the shadow rays end a bit before the light, so they don't hit the sampled triangle itself
+
+
+//shader resources and UAVs
+ConstantBuffer<TraceRaysInfo> InfoBuffer : register(b0, space0);
+StructuredBuffer<Index> Indices : register(t0, space0);
+StructuredBuffer<Vertex> Vertices : register(t1, space0);
+RWStructuredBuffer<Ray> Rays : register(u0, space0);
+RWStructuredBuffer<Ray> OldRays : register(u1, space0); // here, TMin represents the t value in R = t * Direction + Origin
+RWStructuredBuffer<uint4> RayPixels : register(u2, space0);
+RWStructuredBuffer<float4> ScatteredLight : register(u3, space0);
+RWStructuredBuffer<float4> EmittedLight : register(u4, space0);
+RWStructuredBuffer<uint> RayQueueState : register(u10, space0);
+RWStructuredBuffer<RayHit> Hits : register(u11, space0);
+RWStructuredBuffer<uint> ShadingQueue : register(u13, space0); // the hits of this bounce sorted by material
+RWStructuredBuffer<Ray> ShadowRays : register(u17, space0); // the shadow ray of every entry of the shading queue, TMax is negative without one
+RWStructuredBuffer<float4> ShadowLight : register(u19, space0); // the light, which a shadow ray adds to the pixel slot asuint(w), if it isn't occluded
+
+
+
+uint2 GetRayPixel(uint RayIndex)
+{
+	uint2 Position;
+	uint4 SavedValue = RayPixels[RayIndex >> 2]; // = RayIndex / 4
+	
+	SavedValue.xy = (RayIndex % 2) ? SavedValue.yw : SavedValue.xz;
+	SavedValue.x = ((RayIndex % 4) < 2) ? SavedValue.x : SavedValue.y;
+	Position = uint2(SavedValue.x >> 16, SavedValue.x & 0xffff);
+	
+	return Position;
+}
+
+
+float1 Interpolate(float1 Attr1, float1 Attr2, float1 Attr3, float2 Barycentrics)
+{
+	return Attr1 * (1.0f - Barycentrics.x - Barycentrics.y) + Attr2 * (Barycentrics.x) + Attr3 * (Barycentrics.y);
+}
+float2 Interpolate(float2 Attr1, float2 Attr2, float2 Attr3, float2 Barycentrics)
+{
+	return Attr1 * (1.0f - Barycentrics.x - Barycentrics.y) + Attr2 * (Barycentrics.x) + Attr3 * (Barycentrics.y);
+}
+float3 Interpolate(float3 Attr1, float3 Attr2, float3 Attr3, float2 Barycentrics)
+{
+	return Attr1 * (1.0f - Barycentrics.x - Barycentrics.y) + Attr2 * (Barycentrics.x) + Attr3 * (Barycentrics.y);
+}
+float4 Interpolate(float4 Attr1, float4 Attr2, float4 Attr3, float2 Barycentrics)
+{
+	return Attr1 * (1.0f - Barycentrics.x - Barycentrics.y) + Attr2 * (Barycentrics.x) + Attr3 * (Barycentrics.y);
+}
+
+
+
+//shade the hits of CS_TraceRays.hlsl, the threads of a wave mostly work on the same material, because the queue is sorted by material
+[numthreads(GROUPSIZE_X, GROUPSIZE_Y, GROUPSIZE_Z)]
+void main(CSInput Input)
+{
+	if (all(Input.GlobalThreadID.x < RayQueueState[RAY_QUEUE_LIVE_COUNT]))
+	{
+		uint RayIndex = ShadingQueue[Input.GlobalThreadID.x];
+		RayHit Hit = Hits[RayIndex];
+		Ray CurrentRay = Rays[RayIndex];
+		Ray OldRay = OldRays[RayIndex];
+		
+		uint2 Pixel = GetRayPixel(RayIndex);
+		uint OffsetInPixel = asuint(OldRay.TMax);
+		uint Index = RayIndex; // the light of a path stays in the slot of its camera ray
+		
+		float4 Scattered = ScatteredLight[Index];
+		float4 Emitted = EmittedLight[Index];
+		
+		//only the closest hit reads the full vertices
+		Vertex Vertex1 = Vertices[Indices[Hit.HitIndex]];
+		Vertex Vertex2 = Vertices[Indices[Hit.HitIndex + 1]];
+		Vertex Vertex3 = Vertices[Indices[Hit.HitIndex + 2]];
+		
+		//initialize the random number generation seed and the sampler of the path
+		uint3 RNGSeed = RayIndex.xxx;
+		RNGSeed *= RNGSeed + 17;
+		XorShift(RNGSeed);
+		RNGSeed += InfoBuffer.RNGSeed;
+		Sampler PathSampler = InitializeSampler(Pixel, InfoBuffer.SampleIndex * InfoBuffer.MaxRaysPerPixel + OffsetInPixel, RNGSeed, InfoBuffer.ImageSeed);
+		uint DimensionGroup = InfoBuffer.Bounce * SAMPLER_DIMENSIONS_PER_BOUNCE;
+		
+		//generate an input for our shader function
+		ShaderInput ShadingInput;
+		ShadingInput.Clockwiseability = Hit.Result.w;
+		ShadingInput.TextureUV = Interpolate(Vertex1.UV, Vertex2.UV, Vertex3.UV, Hit.Result.yz);
+		ShadingInput.Normal = normalize(Interpolate(Vertex1.Normal, Vertex2.Normal, Vertex3.Normal, Hit.Result.yz)); // the sampling needs a normalized frame
+		ShadingInput.Tangent = Interpolate(Vertex1.Tangent, Vertex2.Tangent, Vertex3.Tangent, Hit.Result.yz);
+		ShadingInput.OldRayDirection = CurrentRay.Direction;
+		ShadingInput.MaterialID = Vertex1.MaterialID;
+		
+		bool FirstRay = (dot(OldRay.Direction, OldRay.Direction) == 0.0f); //this indicates it being the first rays for which we have to reset those values
+		if (FirstRay)
+		{
+			Scattered.xyz = float3(1.0f, 1.0f, 1.0f);
+			Emitted.xyz = float3(0.0f, 0.0f, 0.0f);
+		}
+		PBRMaterialProperties CurrentMaterial = LoadMaterial(ShadingInput.MaterialID, ShadingInput.TextureUV);
+		float4 BSDFSample = SampleDimensions(PathSampler, DimensionGroup + SAMPLER_BSDF_DIMENSIONS);
+		ShadingInput.NewRayDirection = SampleBRDF(BSDFSample.xyz, -CurrentRay.Direction, ShadingInput.Normal, CurrentMaterial);
+		float3 HitPoint = CurrentRay.Origin + CurrentRay.Direction * Hit.Result.x;
+		
+		//the light of this hit could also be found by the shadow ray of the last hit, so it is weighted by the pdfs of both (Scattered.w is the pdf of the last bounce)
+		float EmissionWeight = 1.0f;
+		Ray ShadowRay = (Ray)0;
+		float3 ShadowRayLight = ZERO.xyz;
+		ShadowRay.TMax = -1.0f;
+		if (InfoBuffer.NumLights > 0) // 0, if the light sampling is disabled in the settings
+		{
+			if (!FirstRay)
+			{
+				float3 GeometricNormal = normalize(cross(Vertex2.Position - Vertex1.Position, Vertex3.Position - Vertex1.Position));
+				float HitLuminance = Luminance(PBRMaterials[ShadingInput.MaterialID].Emissive);
+				float HitPDF = LightPDF(HitLuminance, InfoBuffer.InverseLightPower, Hit.Result.x * Hit.Result.x, abs(dot(GeometricNormal, CurrentRay.Direction)));
+				EmissionWeight = PowerHeuristic(Scattered.w, HitPDF);
+			}
+			
+			//next-event estimation: pick a light by its power and a point on it
+			float4 LightSample = SampleDimensions(PathSampler, DimensionGroup + SAMPLER_LIGHT_DIMENSIONS);
+			EmissiveTriangle Light = EmissiveTriangles[SelectLight(InfoBuffer.NumLights, LightSample.xy)];
+			float2 LightBarycentrics = PointOnTriangle(LightSample.zw);
+			float3 ToLight = Light.Vertex1 + Light.Edge1 * LightBarycentrics.x + Light.Edge2 * LightBarycentrics.y - HitPoint;
+			float DistanceSquared = dot(ToLight, ToLight);
+			float Distance = sqrt(DistanceSquared);
+			float3 L = ToLight / max(Distance, EPSILON);
+			
+			//the emission at this point (the power of the light only contains the emissive color of the material)
+			Vertex LightVertex1 = Vertices[Indices[Light.FirstIndex]];
+			Vertex LightVertex2 = Vertices[Indices[Light.FirstIndex + 1]];
+			Vertex LightVertex3 = Vertices[Indices[Light.FirstIndex + 2]];
+			PBRMaterialProperties LightMaterial = PBRMaterials[LightVertex1.MaterialID];
+			float2 LightUV = Interpolate(LightVertex1.UV, LightVertex2.UV, LightVertex3.UV, LightBarycentrics);
+			float3 LightEmission = LightMaterial.Emissive * SampleTexture(TextureIDs[LightMaterial.EmissiveTextureID], LightUV);
+			
+			float LightCosine = abs(dot(normalize(cross(Light.Edge1, Light.Edge2)), L));
+			float SamplePDF = LightPDF(Luminance(LightMaterial.Emissive), InfoBuffer.InverseLightPower, DistanceSquared, LightCosine);
+			float NdotL = dot(ShadingInput.Normal, L);
+			if ((SamplePDF > 0.0f) && (NdotL > 0.0f))
+			{
+				//the rays of the last bounce aren't traced, so they can't find the light and the shadow ray gets the full weight
+				float LightWeight = InfoBuffer.LastBounce ? 1.0f : PowerHeuristic(SamplePDF, BRDFSamplePDF(-CurrentRay.Direction, L, ShadingInput.Normal, CurrentMaterial));
+				ShadowRayLight = Scattered.xyz * CosineWeightedBRDF(-CurrentRay.Direction, L, ShadingInput.Normal, CurrentMaterial) * LightEmission * (LightWeight / SamplePDF);
+				ShadowRay.Origin = HitPoint;
+				ShadowRay.Direction = L;
+				ShadowRay.TMin = CurrentRay.TMin;
+				ShadowRay.TMax = Distance * (1.0f - SHADOW_RAY_EPSILON);
+			}
+		}
+		ShadowRays[Input.GlobalThreadID.x] = ShadowRay;
+		ShadowLight[Input.GlobalThreadID.x] = float4(ShadowRayLight, asfloat(Index));
+		
+		ShaderOutput Output = Shader(ShadingInput, CurrentMaterial, Scattered.xyz, Emitted.xyz, EmissionWeight);
+		Scattered.xyz = Output.Scattered;
+		Scattered.w = Output.PDF;
+		Emitted.xyz = Output.Emitted;
+		
+		//russian roulette: after RussianRouletteDepth rays, a path with a low throughput is likely terminated, the survivors make up for the terminated paths
+		bool Terminated = false;
+		if (InfoBuffer.Bounce + 1 >= InfoBuffer.RussianRouletteDepth)
+		{
+			float Survival = SurvivalProbability(Scattered.xyz);
+			Terminated = (BSDFSample.w >= Survival);
+			Scattered.xyz /= Terminated ? 1.0f : Survival;
+		}
+		
+		//generate a new ray (a terminated path gets a negative TMax, so CS_TraceRays drops it from the queue)
+		Ray NewRay;
+		NewRay.Direction = ShadingInput.NewRayDirection;
+		NewRay.Origin = HitPoint;
+		NewRay.TMin = CurrentRay.TMin;
+		NewRay.TMax = Terminated ? -1.0f : CurrentRay.TMax;
+		CurrentRay.TMax = OldRay.TMax;
+		Rays[RayIndex] = NewRay;
+		OldRays[RayIndex] = CurrentRay;
+		
+		ScatteredLight[Index] = Scattered;
+		EmittedLight[Index] = Emitted;
+	}
+}
\ No newline at end of file
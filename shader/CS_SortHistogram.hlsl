@@ -0,0 +1,59 @@
+
+#include "Sort.hlsli"
+
+
+#define GROUPSIZE_X 256
+#define GROUPSIZE_Y 1
+#define GROUPSIZE_Z 1
+
+
+//shader resources and UAVs
+ConstantBuffer<SortInfo> InfoBuffer : register(b0, space0);
+RWStructuredBuffer<uint4> MortonCodes : register(u5, space0);
+RWStructuredBuffer<uint> GlobalHistograms : register(u7, space0);
+RWStructuredBuffer<uint> PartitionStatus : register(u8, space0);
+
+
+groupshared uint TileHistograms[SORT_RADIX * SORT_NUM_PASSES];
+
+
+
+//count the digits of all sort passes at once, every group handles one tile
+[numthreads(GROUPSIZE_X, GROUPSIZE_Y, GROUPSIZE_Z)]
+void main(CSInput Input)
+{
+	//reset the histograms and the look-back status of this tile
+	[unroll]
+	for (uint i = 0; i < SORT_NUM_PASSES; i++)
+	{
+		TileHistograms[i * SORT_RADIX + Input.GroupThreadID.x] = 0;
+		PartitionStatus[(i * InfoBuffer.NumTiles + Input.GroupID.x) * SORT_RADIX + Input.GroupThreadID.x] = SORT_FLAG_NOT_READY;
+	}
+	
+	GroupMemoryBarrierWithGroupSync();
+	
+	uint TileStart = Input.GroupID.x * SORT_TILE_SIZE;
+	[unroll]
+	for (uint j = 0; j < SORT_KEYS_PER_THREAD; j++)
+	{
+		uint ElementIndex = TileStart + j * GROUPSIZE_X + Input.GroupThreadID.x;
+		if (ElementIndex < InfoBuffer.NumElements)
+		{
+			uint Key = MortonCodes[ElementIndex].x;
+			[unroll]
+			for (uint i = 0; i < SORT_NUM_PASSES; i++)
+			{
+				InterlockedAdd(TileHistograms[i * SORT_RADIX + ((Key >> (8 * i)) & 0xff)], 1);
+			}
+		}
+	}
+	
+	GroupMemoryBarrierWithGroupSync();
+	
+	//add the tile histograms to the global ones
+	[unroll]
+	for (uint k = 0; k < SORT_NUM_PASSES; k++)
+	{
+		InterlockedAdd(GlobalHistograms[k * SORT_RADIX + Input.GroupThreadID.x], TileHistograms[k * SORT_RADIX + Input.GroupThreadID.x]);
+	}
+}
\ No newline at end of file
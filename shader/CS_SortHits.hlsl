@@ -0,0 +1,48 @@
+#include "Raytracer.hlsli"
+#include "TraceRays.hlsli"
+
+
+#define GROUPSIZE_X 256
+#define GROUPSIZE_Y 1
+#define GROUPSIZE_Z 1
+
+
+//shader resources and UAVs
+ConstantBuffer<TraceRaysInfo> InfoBuffer : register(b0, space0);
+RWStructuredBuffer<uint> NextRayQueue : register(u9, space0); // the hits of this bounce
+RWStructuredBuffer<uint> RayQueueState : register(u10, space0);
+RWStructuredBuffer<RayHit> Hits : register(u11, space0);
+RWStructuredBuffer<uint> MaterialQueues : register(u12, space0); // the hit counts of the materials, followed by the next free slot of every material
+RWStructuredBuffer<uint> ShadingQueue : register(u13, space0);
+
+
+
+//the scatter of the counting sort: every hit is moved into the range of its material in the shading queue
+//(CS_PrepareRayQueue.hlsl already turned the hit counts into the first slot of every material)
+[numthreads(GROUPSIZE_X, GROUPSIZE_Y, GROUPSIZE_Z)]
+void main(CSInput Input)
+{
+	if (all(Input.GlobalThreadID.x < RayQueueState[RAY_QUEUE_LIVE_COUNT]))
+	{
+		uint RayIndex = NextRayQueue[Input.GlobalThreadID.x];
+		uint MaterialID = Hits[RayIndex].MaterialID;
+		
+		//neighbouring rays often hit the same material, then the whole wave needs only one atomic
+		uint Slot = 0;
+		if (WaveActiveAllEqual(MaterialID))
+		{
+			uint NumLanes = WaveActiveCountBits(true);
+			if (WaveIsFirstLane())
+			{
+				InterlockedAdd(MaterialQueues[InfoBuffer.NumMaterials + MaterialID], NumLanes, Slot);
+			}
+			Slot = WaveReadLaneFirst(Slot) + WavePrefixCountBits(true);
+		}
+		else
+		{
+			InterlockedAdd(MaterialQueues[InfoBuffer.NumMaterials + MaterialID], 1, Slot);
+		}
+		
+		ShadingQueue[Slot] = RayIndex;
+	}
+}
\ No newline at end of file
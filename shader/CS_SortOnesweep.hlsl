@@ -0,0 +1,169 @@
+
+#include "Sort.hlsli"
+
+
+#define GROUPSIZE_X 256
+#define GROUPSIZE_Y 1
+#define GROUPSIZE_Z 1
+
+
+//shader resources and UAVs
+ConstantBuffer<SortInfo> InfoBuffer : register(b0, space0);
+RWStructuredBuffer<uint4> SourceMortonCodes : register(u5, space0);
+RWStructuredBuffer<uint4> TargetMortonCodes : register(u6, space0);
+globallycoherent RWStructuredBuffer<uint> GlobalHistograms : register(u7, space0);
+globallycoherent RWStructuredBuffer<uint> PartitionStatus : register(u8, space0);
+
+
+groupshared uint TileIndex;
+groupshared uint DigitMasks[SORT_RADIX * (GROUPSIZE_X / 32)]; // one bit per thread for every digit
+groupshared uint DigitCounts[SORT_RADIX];
+groupshared uint DigitOffsets[SORT_RADIX]; // the offsets of the digits in this tile
+groupshared uint GlobalDigitOffsets[SORT_RADIX]; // the offsets of the digits of this tile in the output buffer
+groupshared uint2 SortedKeys[SORT_TILE_SIZE];
+
+
+
+//one pass of the onesweep radix sort: rank the keys of a tile, get the offsets of the previous tiles with a decoupled look-back and scatter the keys
+[numthreads(GROUPSIZE_X, GROUPSIZE_Y, GROUPSIZE_Z)]
+void main(CSInput Input)
+{
+	uint ThreadIndex = Input.GroupThreadID.x;
+	
+	//the tiles are numbered in the order in which the groups start, so every previous tile is already being processed (needed for the look-back)
+	if (ThreadIndex == 0)
+	{
+		InterlockedAdd(GlobalHistograms[SORT_TILE_COUNTER_OFFSET + InfoBuffer.SortPassIndex], 1, TileIndex);
+	}
+	DigitCounts[ThreadIndex] = 0;
+	[unroll]
+	for (uint i = 0; i < GROUPSIZE_X / 32; i++)
+	{
+		DigitMasks[ThreadIndex * (GROUPSIZE_X / 32) + i] = 0;
+	}
+	
+	GroupMemoryBarrierWithGroupSync();
+	
+	
+	//rank the keys: a key's rank is the number of keys with the same digit in front of it, which keeps the sort stable
+	uint Shift = 8 * InfoBuffer.SortPassIndex;
+	uint TileStart = TileIndex * SORT_TILE_SIZE;
+	uint NumTileElements = min(SORT_TILE_SIZE, InfoBuffer.NumElements - TileStart);
+	uint2 Keys[SORT_KEYS_PER_THREAD];
+	uint Ranks[SORT_KEYS_PER_THREAD];
+	
+	[unroll]
+	for (uint j = 0; j < SORT_KEYS_PER_THREAD; j++)
+	{
+		uint LocalIndex = j * GROUPSIZE_X + ThreadIndex;
+		bool IsValid = LocalIndex < NumTileElements;
+		Keys[j] = IsValid ? SourceMortonCodes[TileStart + LocalIndex].xy : uint2(0, 0);
+		uint Digit = (Keys[j].x >> Shift) & 0xff;
+		uint MaskIndex = Digit * (GROUPSIZE_X / 32) + (ThreadIndex / 32);
+		
+		if (IsValid)
+		{
+			InterlockedOr(DigitMasks[MaskIndex], 1u << (ThreadIndex & 31));
+		}
+		
+		GroupMemoryBarrierWithGroupSync();
+		
+		//the keys of the previous rounds and of the threads with a lower index
+		uint Rank = DigitCounts[Digit] + countbits(DigitMasks[MaskIndex] & ((1u << (ThreadIndex & 31)) - 1));
+		for (uint k = Digit * (GROUPSIZE_X / 32); k < MaskIndex; k++)
+		{
+			Rank += countbits(DigitMasks[k]);
+		}
+		Ranks[j] = Rank;
+		
+		GroupMemoryBarrierWithGroupSync();
+		
+		//every thread updates the count of one digit for the next round
+		uint Count = 0;
+		[unroll]
+		for (uint l = 0; l < GROUPSIZE_X / 32; l++)
+		{
+			Count += countbits(DigitMasks[ThreadIndex * (GROUPSIZE_X / 32) + l]);
+			DigitMasks[ThreadIndex * (GROUPSIZE_X / 32) + l] = 0;
+		}
+		DigitCounts[ThreadIndex] += Count;
+		
+		GroupMemoryBarrierWithGroupSync();
+	}
+	
+	
+	//publish the digit counts of this tile, the first tile already knows its inclusive counts
+	uint TileCount = DigitCounts[ThreadIndex];
+	uint StatusIndex = (InfoBuffer.SortPassIndex * InfoBuffer.NumTiles + TileIndex) * SORT_RADIX + ThreadIndex;
+	uint PreviousStatus;
+	InterlockedExchange(PartitionStatus[StatusIndex], ((TileIndex == 0) ? SORT_FLAG_INCLUSIVE : SORT_FLAG_AGGREGATE) | TileCount, PreviousStatus);
+	
+	//the offsets of the digits in this tile
+	DigitOffsets[ThreadIndex] = TileCount;
+	[unroll]
+	for (uint m = 0; m < 8; m++)
+	{
+		GroupMemoryBarrierWithGroupSync();
+		
+		uint Exp2m = 1 << m;
+		uint CurrentValue = 0;
+		if (ThreadIndex >= Exp2m)
+		{
+			CurrentValue = DigitOffsets[ThreadIndex - Exp2m];
+		}
+		
+		GroupMemoryBarrierWithGroupSync();
+		
+		DigitOffsets[ThreadIndex] += CurrentValue;
+	}
+	GroupMemoryBarrierWithGroupSync();
+	DigitOffsets[ThreadIndex] -= TileCount;
+	
+	//the decoupled look-back: add up the counts of the previous tiles until a tile with an inclusive count is found
+	uint PreviousCount = 0;
+	if (TileIndex > 0)
+	{
+		uint LookBackTile = TileIndex - 1;
+		[allow_uav_condition]
+		while (true)
+		{
+			uint Status;
+			InterlockedOr(PartitionStatus[(InfoBuffer.SortPassIndex * InfoBuffer.NumTiles + LookBackTile) * SORT_RADIX + ThreadIndex], 0, Status);
+			if ((Status & SORT_FLAG_MASK) == SORT_FLAG_NOT_READY) continue; // wait for the previous tile
+			
+			PreviousCount += Status & SORT_VALUE_MASK;
+			if ((Status & SORT_FLAG_MASK) == SORT_FLAG_INCLUSIVE) break;
+			LookBackTile--;
+		}
+		
+		InterlockedExchange(PartitionStatus[StatusIndex], SORT_FLAG_INCLUSIVE | (PreviousCount + TileCount), PreviousStatus);
+	}
+	GlobalDigitOffsets[ThreadIndex] = GlobalHistograms[InfoBuffer.SortPassIndex * SORT_RADIX + ThreadIndex] + PreviousCount;
+	
+	GroupMemoryBarrierWithGroupSync();
+	
+	
+	//sort the keys of the tile in shared memory, so the writes to the output buffer are coalesced
+	[unroll]
+	for (uint n = 0; n < SORT_KEYS_PER_THREAD; n++)
+	{
+		if ((n * GROUPSIZE_X + ThreadIndex) < NumTileElements)
+		{
+			SortedKeys[DigitOffsets[(Keys[n].x >> Shift) & 0xff] + Ranks[n]] = Keys[n];
+		}
+	}
+	
+	GroupMemoryBarrierWithGroupSync();
+	
+	[unroll]
+	for (uint o = 0; o < SORT_KEYS_PER_THREAD; o++)
+	{
+		uint LocalIndex = o * GROUPSIZE_X + ThreadIndex;
+		if (LocalIndex < NumTileElements)
+		{
+			uint2 Key = SortedKeys[LocalIndex];
+			uint Digit = (Key.x >> Shift) & 0xff;
+			TargetMortonCodes[GlobalDigitOffsets[Digit] + LocalIndex - DigitOffsets[Digit]] = uint4(Key, 0, 0);
+		}
+	}
+}
\ No newline at end of file
@@ -9,26 +9,21 @@
 
 //shader resources and UAVs
 ConstantBuffer<SortInfo> InfoBuffer : register(b0, space0);
-RWStructuredBuffer<uint4> CodeFrequencies : register(u7, space0);
+RWStructuredBuffer<uint> GlobalHistograms : register(u7, space0);
 
 
-groupshared uint IntermediateBuffer[256];
+groupshared uint IntermediateBuffer[SORT_RADIX];
 
 
 
 //prefix sum based on: https://developer.nvidia.com/gpugems/gpugems3/part-vi-gpu-computing/chapter-39-parallel-prefix-sum-scan-cuda
+//every group turns the histogram of one sort pass into the offsets of the digits (an exclusive prefix sum)
 [numthreads(GROUPSIZE_X, GROUPSIZE_Y, GROUPSIZE_Z)]
 void main(CSInput Input)
 {
-	[branch]
-	if (Input.GlobalThreadID.x == 0)
-	{
-		IntermediateBuffer[Input.GlobalThreadID.x] = 0;
-	}
-	else
-	{
-		IntermediateBuffer[Input.GlobalThreadID.x] = CodeFrequencies[Input.GlobalThreadID.x - 1].x;
-	}
+	uint HistogramIndex = Input.GroupID.x * SORT_RADIX + Input.GroupThreadID.x;
+	uint Count = GlobalHistograms[HistogramIndex];
+	IntermediateBuffer[Input.GroupThreadID.x] = Count;
 	
 	[unroll]
 	for (uint i = 0; i < 8; i++)
@@ -37,20 +32,15 @@ void main(CSInput Input)
 		
 		uint Exp2i = 1 << i;
 		uint CurrentValue = 0;
-		if (Input.GlobalThreadID.x > Exp2i)
+		if (Input.GroupThreadID.x >= Exp2i)
 		{
-			CurrentValue = IntermediateBuffer[Input.GlobalThreadID.x - Exp2i];
+			CurrentValue = IntermediateBuffer[Input.GroupThreadID.x - Exp2i];
 		}
 		
 		GroupMemoryBarrierWithGroupSync();
 		
-		if (Input.GlobalThreadID.x > Exp2i)
-		{
-			InterlockedAdd(IntermediateBuffer[Input.GlobalThreadID.x], CurrentValue);
-		}
+		IntermediateBuffer[Input.GroupThreadID.x] += CurrentValue;
 	}
 	
-	GroupMemoryBarrierWithGroupSync();
-	
-	CodeFrequencies[Input.GlobalThreadID.x].y = IntermediateBuffer[Input.GlobalThreadID.x];
+	GlobalHistograms[HistogramIndex] = IntermediateBuffer[Input.GroupThreadID.x] - Count;
 }
\ No newline at end of file
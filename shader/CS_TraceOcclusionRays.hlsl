@@ -0,0 +1,56 @@
+
+#include "Raytracer.hlsli"
+#include "TraceRays.hlsli"
+#include "BVHTraversal.hlsli" //the bvh resources (u6, u7 and u16) and the traversal
+
+
+#define GROUPSIZE_X 256
+#define GROUPSIZE_Y 1
+#define GROUPSIZE_Z 1
+
+
+//shader resources and UAVs
+ConstantBuffer<TraceOcclusionRaysInfo> InfoBuffer : register(b0, space0);
+RWStructuredBuffer<Ray> OcclusionRays : register(u17, space0); // the shadow and visibility rays, TMax is the distance to the light or the other point
+RWStructuredBuffer<uint> Visibility : register(u18, space0); // bit (i % 32) of the uint i / 32 is set, if nothing is hit between TMin and TMax of the ray i
+
+
+
+//the occlusion query: the traversal stops at the first hit and there is no hit, material or shading work, only one bit per ray is written
+[numthreads(GROUPSIZE_X, GROUPSIZE_Y, GROUPSIZE_Z)]
+void main(CSInput Input)
+{
+	uint RayIndex = Input.GlobalThreadID.x;
+	bool Visible = false;
+	if (RayIndex < InfoBuffer.NumRays)
+	{
+		Ray CurrentRay = OcclusionRays[RayIndex];
+		float4 Result = float4(CurrentRay.TMax, 0.0f, 0.0f, 0.0f);
+		uint HitIndex = 0;
+		TraverseBVH(CurrentRay, InfoBuffer.NumTriangles, true, Result, HitIndex);
+		Visible = (Result.x == CurrentRay.TMax);
+	}
+	
+	//the lanes of a wave are consecutive threads of the group, so with at least 32 lanes the ballot contains whole uints of the bit mask,
+	//smaller waves set or clear their bits with atomics (the bit mask isn't cleared between the queries)
+	if (WaveGetLaneCount() >= 32)
+	{
+		uint4 VisibleLanes = WaveActiveBallot(Visible);
+		uint LaneIndex = WaveGetLaneIndex();
+		if (((LaneIndex % 32) == 0) && (RayIndex < InfoBuffer.NumRays))
+		{
+			Visibility[RayIndex / 32] = VisibleLanes[LaneIndex / 32];
+		}
+	}
+	else if (RayIndex < InfoBuffer.NumRays)
+	{
+		if (Visible)
+		{
+			InterlockedOr(Visibility[RayIndex / 32], 1u << (RayIndex % 32));
+		}
+		else
+		{
+			InterlockedAnd(Visibility[RayIndex / 32], ~(1u << (RayIndex % 32)));
+		}
+	}
+}
\ No newline at end of file
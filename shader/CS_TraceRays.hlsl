@@ -1,9 +1,9 @@
 
-#include "../src/Settings.h" //for RT_USE_BVH
+#include "../src/Settings.h" //for RT_USE_PERSISTENT_THREADS
 
-#include "PerRayShading.hlsli"
 #include "Raytracer.hlsli"
-#include "Random.hlsli"
+#include "TraceRays.hlsli"
+#include "BVHTraversal.hlsli" //the bvh resources (u6, u7 and u16) and the traversal
 
 
 #define GROUPSIZE_X 256
@@ -11,136 +11,76 @@
 #define GROUPSIZE_Z 1
 
 
-struct TraceRaysInfo
-{
-	int2 ScreenDimensions;
-	uint NumIndices;
-	uint NumRays;
-	uint MaxRaysPerPixel;
-	uint3 RNGSeed;
-};
-
-struct Triangle
-{
-	float3 Vertex1;
-	float3 Vertex2;
-	float3 Vertex3;
-};
-
-
 //shader resources and UAVs
 ConstantBuffer<TraceRaysInfo> InfoBuffer : register(b0, space0);
 StructuredBuffer<Index> Indices : register(t0, space0);
 StructuredBuffer<Vertex> Vertices : register(t1, space0);
 RWStructuredBuffer<Ray> Rays : register(u0, space0);
-RWStructuredBuffer<Ray> OldRays : register(u1, space0); // here, TMin represents the t value in R = t * Direction + Origin
-RWStructuredBuffer<uint4> RayPixels : register(u2, space0);
-RWStructuredBuffer<float4> ScatteredLight : register(u3, space0);
-RWStructuredBuffer<float4> EmittedLight : register(u4, space0);
-RWStructuredBuffer<AABB> BoundingVolumeHierarchy : register(u6, space0);
+RWStructuredBuffer<uint> RayQueue : register(u8, space0); // the indices of the live rays
+RWStructuredBuffer<uint> NextRayQueue : register(u9, space0); // the rays, which hit something, are appended for the next bounce
+RWStructuredBuffer<uint> RayQueueState : register(u10, space0);
+RWStructuredBuffer<RayHit> Hits : register(u11, space0);
+RWStructuredBuffer<uint> MaterialQueues : register(u12, space0); // the number of hits of every material
+RWStructuredBuffer<uint4> RayBins : register(u14, space0); // the rays of the queue sorted by their bins (x: the bin key, y: the ray)
 
 
 
-//a fast ray-triangle intersection algorithm, providing a lot of speed and small memory usage
-//the original paper: https://cadxfem.org/inf/Fast%20MinimumStorage%20RayTriangle%20Intersection.pdf
-float4 Intersect(Ray TestRay, Triangle TestTriangle)
+//the ray of a slot in the queue of this bounce
+uint GetQueuedRay(uint QueueIndex)
 {
-	//first define all the needed variables
-	float3 Result, Edge1, Edge2, tVec, pVec, qVec;
-	float Determinant, InverseDeterminant;
-	float TriangleIsClockwise;
-
-	//compute some nescessary vectors
-	Edge1 = TestTriangle.Vertex2 - TestTriangle.Vertex1;
-	Edge2 = TestTriangle.Vertex3 - TestTriangle.Vertex1;
-	tVec = TestRay.Origin - TestTriangle.Vertex1;
-
-	//secondly, compute all the cross products
-	pVec = cross(TestRay.Direction, Edge2);
-	qVec = cross(tVec, Edge1);
-	
-	//calculate the determinant and its inverse
-	Determinant = dot(Edge1, pVec);
-	InverseDeterminant = (abs(Determinant) < EPSILON) ? 0.0f : 1.0f / Determinant;
-	TriangleIsClockwise = round(abs(Determinant) * InverseDeterminant); // 1 = clockwise; 0 = parallel to ray; -1 = counterclockwise
-
-	//calculate the result
-	Result.x = dot(Edge2, qVec); //the parameter 't' from the equation of a ray (O + t * R)
-	Result.y = dot(tVec, pVec); // 'u', one barycentric coordinate
-	Result.z = dot(TestRay.Direction, qVec); // 'v', the other barycentric coordinate
-	Result *= InverseDeterminant; // if InverseDeterminant is 0, the next check will fail
-	
-	//final check, if the ray intersects the triangle
-	Result = any(bool4(Result.x < EPSILON, Result.y < 0.0f, Result.z < 0.0f, Result.y + Result.z > 1.0f)) ? float3(-1.0f, -1.0f, -1.0f) : Result;
-
-	return float4(Result, TriangleIsClockwise);
+	if (InfoBuffer.UseRayQueue == 0)
+	{
+		return QueueIndex;
+	}
+	return (InfoBuffer.UseRayBins != 0) ? RayBins[QueueIndex].y : RayQueue[QueueIndex];
 }
 
-
-//based on: https://jacco.ompf2.com/2022/04/18/how-to-build-a-bvh-part-2-faster-rays/
-float IntersectAABB(Ray TestRay, AABB TestAABB)
+//find the closest hit of a ray, the return value tells whether the ray continues with the next bounce
+bool TraceRay(uint RayIndex)
 {
-	float3 t1 = (TestAABB.Min - TestRay.Origin) / TestRay.Direction;
-	float3 t2 = (TestAABB.Max - TestRay.Origin) / TestRay.Direction;
-	
-	float3 tMinVals = min(t1, t2);
-	float3 tMaxVals = max(t1, t2);
-	float tMin = max(tMinVals.x, max(tMinVals.y, tMinVals.z));
-	float tMax = min(tMaxVals.x, min(tMaxVals.y, tMaxVals.z));
+	Ray CurrentRay = Rays[RayIndex];
+	float4 Result = float4(CurrentRay.TMax, 0.0f, 0.0f, 0.0f);
+	uint HitIndex = 0;
 	
-	if ((tMax < tMin) || (tMax <= 0) || (tMax < TestRay.TMin) || (tMin > TestRay.TMax))
+	//a path, which was terminated by the russian roulette, leaves the queue like a miss
+	if (CurrentRay.TMax < 0.0f)
 	{
-		tMin = 1e30f;
+		return false;
 	}
 	
-	return tMin;
-}
-
-
-void CheckIntersection(Ray CurrentRay, uint CurrentIndex, inout float4 Result, inout uint3 CurrentIndices)
-{
-	Index Index1 = Indices[CurrentIndex];
-	Index Index2 = Indices[CurrentIndex + 1];
-	Index Index3 = Indices[CurrentIndex + 2];
-	Triangle CurrentTriangle;
-	CurrentTriangle.Vertex1 = Vertices[Index1].Position;
-	CurrentTriangle.Vertex2 = Vertices[Index2].Position;
-	CurrentTriangle.Vertex3 = Vertices[Index3].Position;
-	float4 CurrentResult = Intersect(CurrentRay, CurrentTriangle);
-	bool UseNewResult = (CurrentRay.TMin <= CurrentResult.x) && (CurrentRay.TMax > CurrentResult.x) && (CurrentResult.x < Result.x);
-	Result = UseNewResult ? CurrentResult : Result;
-	CurrentIndices = UseNewResult ? uint3(Index1, Index2, Index3) : CurrentIndices;
-}
-
-
-uint2 GetRayPixel(uint RayIndex)
-{
-	uint2 Position;
-	uint4 SavedValue = RayPixels[RayIndex >> 2]; // = RayIndex / 4
+	TraverseBVH(CurrentRay, InfoBuffer.NumTriangles, false, Result, HitIndex);
 	
-	SavedValue.xy = (RayIndex % 2) ? SavedValue.yw : SavedValue.xz;
-	SavedValue.x = ((RayIndex % 4) < 2) ? SavedValue.x : SavedValue.y;
-	Position = uint2(SavedValue.x >> 16, SavedValue.x & 0xffff);
+	if (Result.x != CurrentRay.TMax)
+	{
+		//only the material of the closest hit is read here, the shading happens in CS_ShadeHits.hlsl after the hits are sorted by material
+		RayHit Hit;
+		Hit.Result = Result;
+		Hit.HitIndex = HitIndex;
+		Hit.MaterialID = min(Vertices[Indices[HitIndex]].MaterialID, InfoBuffer.NumMaterials - 1);
+		Hit.Padding = uint2(0, 0);
+		Hits[RayIndex] = Hit;
+		InterlockedAdd(MaterialQueues[Hit.MaterialID], 1);
+		return true;
+	}
 	
-	return Position;
+	return false;
 }
 
-
-float1 Interpolate(float1 Attr1, float1 Attr2, float1 Attr3, float2 Barycentrics)
-{
-	return Attr1 * (1.0f - Barycentrics.x - Barycentrics.y) + Attr2 * (Barycentrics.x) + Attr3 * (Barycentrics.y);
-}
-float2 Interpolate(float2 Attr1, float2 Attr2, float2 Attr3, float2 Barycentrics)
-{
-	return Attr1 * (1.0f - Barycentrics.x - Barycentrics.y) + Attr2 * (Barycentrics.x) + Attr3 * (Barycentrics.y);
-}
-float3 Interpolate(float3 Attr1, float3 Attr2, float3 Attr3, float2 Barycentrics)
+//a ray, which missed, keeps its light and doesn't change anymore, so only the hits are appended to the queue of the next bounce
+//the prefix sum over the wave gives every survivor its slot, so there is only one atomic per wave
+void AppendSurvivor(bool Survives, uint RayIndex)
 {
-	return Attr1 * (1.0f - Barycentrics.x - Barycentrics.y) + Attr2 * (Barycentrics.x) + Attr3 * (Barycentrics.y);
-}
-float4 Interpolate(float4 Attr1, float4 Attr2, float4 Attr3, float2 Barycentrics)
-{
-	return Attr1 * (1.0f - Barycentrics.x - Barycentrics.y) + Attr2 * (Barycentrics.x) + Attr3 * (Barycentrics.y);
+	uint NumSurvivors = WaveActiveCountBits(Survives);
+	uint FirstSlot = 0;
+	if (WaveIsFirstLane() && (NumSurvivors > 0))
+	{
+		InterlockedAdd(RayQueueState[RAY_QUEUE_APPEND_COUNTER], NumSurvivors, FirstSlot);
+	}
+	FirstSlot = WaveReadLaneFirst(FirstSlot);
+	if (Survives)
+	{
+		NextRayQueue[FirstSlot + WavePrefixCountBits(Survives)] = RayIndex;
+	}
 }
 
 
@@ -148,146 +88,48 @@ float4 Interpolate(float4 Attr1, float4 Attr2, float4 Attr3, float2 Barycentrics
 [numthreads(GROUPSIZE_X, GROUPSIZE_Y, GROUPSIZE_Z)]
 void main(CSInput Input)
 {
-	if (all(Input.GlobalThreadID.x < InfoBuffer.NumRays))
+	//after the camera rays, only the live rays in the queue are traced
+	uint NumRays = (InfoBuffer.UseRayQueue != 0) ? RayQueueState[RAY_QUEUE_LIVE_COUNT] : InfoBuffer.NumRays;
+	
+#if RT_USE_PERSISTENT_THREADS
+	
+	//persistent threads: a fixed number of groups, whose waves fetch batches of rays from the global work counter until the queue is empty,
+	//so a wave with a long running lane only delays its own next batch instead of keeping a whole group of finished threads alive
+	while (true)
 	{
-		Ray CurrentRay = Rays[Input.GlobalThreadID.x];
-		Ray OldRay = OldRays[Input.GlobalThreadID.x];
-		float4 Result = float4(CurrentRay.TMax, 0.0f, 0.0f, 0.0f);
-		uint3 CurrentIndices = uint3(0, 0, 0);
-		
-#if !RT_USE_BVH //no use of BVH
-		
-		for (uint i = 0; i < InfoBuffer.NumIndices; i += 3)
+		uint FirstQueueIndex = 0;
+		if (WaveIsFirstLane())
 		{
-			Index Index1 = Indices[i];
-			Index Index2 = Indices[i + 1];
-			Index Index3 = Indices[i + 2];
-			Triangle CurrentTriangle;
-			CurrentTriangle.Vertex1 = Vertices[Index1].Position;
-			CurrentTriangle.Vertex2 = Vertices[Index2].Position;
-			CurrentTriangle.Vertex3 = Vertices[Index3].Position;
-			float4 CurrentResult = Intersect(CurrentRay, CurrentTriangle);
-			bool UseNewResult = (CurrentRay.TMin <= CurrentResult.x);
-			UseNewResult = UseNewResult && (CurrentRay.TMax > CurrentResult.x);
-			UseNewResult = UseNewResult && (CurrentResult.x < Result.x);
-			Result = UseNewResult ? CurrentResult : Result;
-			CurrentIndices = UseNewResult ? uint3(Index1, Index2, Index3) : CurrentIndices;
+			InterlockedAdd(RayQueueState[RAY_QUEUE_WORK_COUNTER], WaveGetLaneCount(), FirstQueueIndex);
 		}
-		
-#else //use BVH
-		
-		uint AABBIndices[48];
-		uint NumAABBs = 0;
-		
-		AABB TrunkAABB = BoundingVolumeHierarchy[0];
-		
-		if (IntersectAABB(CurrentRay, TrunkAABB) != 1e30f)
+		FirstQueueIndex = WaveReadLaneFirst(FirstQueueIndex);
+		if (FirstQueueIndex >= NumRays)
 		{
-			AABBIndices[0] = TrunkAABB.Padding.y;
-			AABBIndices[1] = TrunkAABB.Padding.x;
-			NumAABBs = 2;
+			break;
 		}
 		
-		while (NumAABBs > 0)
+		uint QueueIndex = FirstQueueIndex + WaveGetLaneIndex();
+		uint RayIndex = 0;
+		bool Survives = false;
+		if (QueueIndex < NumRays)
 		{
-			AABB CurrentAABB = BoundingVolumeHierarchy[AABBIndices[NumAABBs - 1]];
-			float CurrentResult = IntersectAABB(CurrentRay, CurrentAABB);
-			bool RemoveTestedAABBs = false;
-			if ((CurrentResult != 1e30f) && (CurrentResult < Result.x))
-			{
-				AABBIndices[NumAABBs - 1] |= 0x80000000; //indicate that the current AABB was tested for intersection
-				if (CurrentAABB.Padding.x & 0x80000000)
-				{
-					CheckIntersection(CurrentRay, CurrentAABB.Padding.x & 0x7fffffff, Result, CurrentIndices);
-					if (CurrentAABB.Padding.y != 0xffffffff)
-					{
-						CheckIntersection(CurrentRay, CurrentAABB.Padding.y & 0x7fffffff, Result, CurrentIndices);
-					}
-					RemoveTestedAABBs = true;
-				}
-				else
-				{
-					if (CurrentAABB.Padding.y == 0xffffffff)
-					{
-						AABBIndices[NumAABBs] = CurrentAABB.Padding.x;
-						NumAABBs++;
-					}
-					else
-					{
-						AABBIndices[NumAABBs] = CurrentAABB.Padding.y;
-						AABBIndices[NumAABBs + 1] = CurrentAABB.Padding.x;
-						NumAABBs += 2;
-					}
-
-				}
-			}
-			else
-			{
-				RemoveTestedAABBs = true;
-			}
-			
-			if (RemoveTestedAABBs)
-			{
-				NumAABBs--;
-				while ((NumAABBs > 0) && (AABBIndices[NumAABBs - 1] & 0x80000000))
-				{
-					NumAABBs--;
-				}
-			}
+			RayIndex = GetQueuedRay(QueueIndex);
+			Survives = TraceRay(RayIndex);
 		}
-		
-#endif
-		
-		uint2 Pixel = GetRayPixel(Input.GlobalThreadID.x);
-		uint OffsetInPixel = asuint(OldRay.TMax);
-		uint Index = mad(InfoBuffer.ScreenDimensions.x, Pixel.y, Pixel.x) * InfoBuffer.MaxRaysPerPixel + OffsetInPixel;
-		
-		float4 Scattered = ScatteredLight[Index];
-		float4 Emitted = EmittedLight[Index];
-		
-		if (Result.x != CurrentRay.TMax)
-		{
-			Vertex Vertex1 = Vertices[CurrentIndices.x];
-			Vertex Vertex2 = Vertices[CurrentIndices.y];
-			Vertex Vertex3 = Vertices[CurrentIndices.z];
-			
-			//initialize the random number generation seed
-			uint3 RNGSeed = Input.GlobalThreadID.xxx;
-			RNGSeed *= RNGSeed + 17;
-			XorShift(RNGSeed);
-			RNGSeed += InfoBuffer.RNGSeed;
-			
-			//generate an input for our shader function
-			ShaderInput ShadingInput;
-			ShadingInput.Clockwiseability = Result.w;
-			ShadingInput.TextureUV = Interpolate(Vertex1.UV, Vertex2.UV, Vertex3.UV, Result.yz);
-			ShadingInput.Normal = Interpolate(Vertex1.Normal, Vertex2.Normal, Vertex3.Normal, Result.yz);
-			ShadingInput.Tangent = Interpolate(Vertex1.Tangent, Vertex2.Tangent, Vertex3.Tangent, Result.yz);
-			ShadingInput.OldRayDirection = CurrentRay.Direction;
-			ShadingInput.NewRayDirection = RotatedRandomDirection(RNGSeed, ShadingInput.Normal); //todo: add brdf importance sampling or quasi monte carlo integration
-			ShadingInput.MaterialID = Vertex1.MaterialID;
-			
-			if (dot(OldRay.Direction, OldRay.Direction) == 0.0f) //this indicates it being the first rays for which we have to reset those values
-			{
-				Scattered.xyz = float3(1.0f, 1.0f, 1.0f);
-				Emitted.xyz = float3(0.0f, 0.0f, 0.0f);
-			}
-			ShaderOutput Output = Shader(ShadingInput, Scattered.xyz, Emitted.xyz);
-			Scattered.xyz = Output.Scattered;
-			Emitted.xyz = Output.Emitted;
-			
-			//generate a new ray
-			Ray NewRay;
-			NewRay.Direction = ShadingInput.NewRayDirection;
-			NewRay.Origin = CurrentRay.Origin + CurrentRay.Direction * Result.x;
-			NewRay.TMin = CurrentRay.TMin;
-			NewRay.TMax = CurrentRay.TMax;
-			CurrentRay.TMax = OldRay.TMax;
-			Rays[Input.GlobalThreadID.x] = NewRay;
-			OldRays[Input.GlobalThreadID.x] = CurrentRay;
-		}
-		
-		ScatteredLight[Index] = Scattered;
-		EmittedLight[Index] = Emitted;
+		AppendSurvivor(Survives, RayIndex);
 	}
+	
+#else
+	
+	//every thread works on one ray
+	uint RayIndex = 0;
+	bool Survives = false;
+	if (all(Input.GlobalThreadID.x < NumRays))
+	{
+		RayIndex = GetQueuedRay(Input.GlobalThreadID.x);
+		Survives = TraceRay(RayIndex);
+	}
+	AppendSurvivor(Survives, RayIndex);
+	
+#endif
 }
\ No newline at end of file
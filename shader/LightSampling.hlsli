@@ -0,0 +1,59 @@
+#pragma once
+
+
+//the light list for next-event estimation: every triangle with an emissive material is a light, which is picked with the probability of its power
+//a light of the alias table, the light i is picked, if a random number is below AliasProbability, otherwise its alias is picked
+struct EmissiveTriangle
+{
+	float3 Vertex1;
+	uint FirstIndex; // the position of the triangle in the index buffer
+	float3 Edge1; // = Vertex2 - Vertex1
+	float AliasProbability;
+	float3 Edge2; // = Vertex3 - Vertex1
+	uint Alias;
+};
+
+
+StructuredBuffer<EmissiveTriangle> EmissiveTriangles : register(t5, space0);
+
+
+
+//the brightness of an emissive color, which weights the lights
+float Luminance(float3 Color)
+{
+	return dot(Color, float3(0.2126f, 0.7152f, 0.0722f));
+}
+
+
+//picks a light with the probability of its power in constant time
+uint SelectLight(uint NumLights, float2 RandomNumbers)
+{
+	uint Light = min(uint(RandomNumbers.x * float(NumLights)), NumLights - 1);
+	EmissiveTriangle CurrentLight = EmissiveTriangles[Light];
+	return (RandomNumbers.y < CurrentLight.AliasProbability) ? Light : CurrentLight.Alias;
+}
+
+
+//a uniformly distributed point on a triangle, returned as the barycentric coordinates of the second and the third vertex
+float2 PointOnTriangle(float2 RandomNumbers)
+{
+	float SqrtRandom = sqrt(RandomNumbers.x);
+	return float2(SqrtRandom * (1.0f - RandomNumbers.y), SqrtRandom * RandomNumbers.y);
+}
+
+
+//the solid angle pdf of reaching a point of a light, either by sampling the light list or by a bsdf sample, which hits it:
+//the power of the triangle over the total power, divided by its area and converted from area to solid angle
+//(luminance * area / total power) * (1 / area) * (distance^2 / cos) = luminance * distance^2 / (total power * cos)
+float LightPDF(float LightLuminance, float InverseTotalPower, float DistanceSquared, float LightCosine)
+{
+	return (LightCosine > 1e-6f) ? (LightLuminance * InverseTotalPower * DistanceSquared / LightCosine) : 0.0f;
+}
+
+
+//the power heuristic of multiple importance sampling: the weight of a sample with the pdf PDF1, which could also be taken with the pdf PDF2
+float PowerHeuristic(float PDF1, float PDF2)
+{
+	float SquaredPDF1 = PDF1 * PDF1;
+	return (PDF1 > 0.0f) ? (SquaredPDF1 / (SquaredPDF1 + PDF2 * PDF2)) : 0.0f;
+}
\ No newline at end of file
@@ -1,4 +1,7 @@
 
+#include "Random.hlsli"
+
+
 #define EPSILON 1e-6f
 #define PI 3.141592654f
 #define ZERO float4(0.0f, 0.0f, 0.0f, 0.0f)
@@ -21,6 +24,7 @@ struct ShaderOutput
 {
 	float3 Scattered;
 	float3 Emitted;
+	float PDF; // the pdf of NewRayDirection, which weights the emission of the next hit
 };
 
 
@@ -134,23 +138,24 @@ float3 RefractedColor(float Roughness, float Metallic, float3 Albedo, float Ndot
 
 
 
-//the main shading function
-ShaderOutput Shader(ShaderInput Input, float3 ScatteredLight, float3 EmittedLight)
+//load the material properties at one specific point
+PBRMaterialProperties LoadMaterial(uint MaterialID, float2 TextureUV)
+{
+	PBRMaterialProperties CurrentMaterial = PBRMaterials[MaterialID];
+	CurrentMaterial.Albedo *= SampleTexture(TextureIDs[CurrentMaterial.AlbedoTextureID], TextureUV);
+	CurrentMaterial.Roughness *= SampleTexture(TextureIDs[CurrentMaterial.RoughnessTextureID], TextureUV).x;
+	CurrentMaterial.F0Color *= SampleTexture(TextureIDs[CurrentMaterial.F0TextureID], TextureUV);
+	CurrentMaterial.Metallic *= SampleTexture(TextureIDs[CurrentMaterial.MetallicTextureID], TextureUV).x;
+	CurrentMaterial.Emissive *= SampleTexture(TextureIDs[CurrentMaterial.EmissiveTextureID], TextureUV);
+	return CurrentMaterial;
+}
+
+
+//the brdf times NdotL for the direction L, which is the light arriving from L, that is reflected towards V
+float3 CosineWeightedBRDF(float3 V, float3 L, float3 N, PBRMaterialProperties CurrentMaterial)
 {
-	//get some direction vectors and the distance to the target point
-	float3 V = -(Input.OldRayDirection);
-	float3 L = Input.NewRayDirection;
-	float3 N = Input.Normal;
 	float3 H = normalize(V + L); //both V and L are already normalized
 	
-	//load the material properties at one specific point
-	PBRMaterialProperties CurrentMaterial = PBRMaterials[Input.MaterialID];
-	CurrentMaterial.Albedo *= SampleTexture(TextureIDs[CurrentMaterial.AlbedoTextureID], Input.TextureUV);
-	CurrentMaterial.Roughness *= SampleTexture(TextureIDs[CurrentMaterial.RoughnessTextureID], Input.TextureUV).x;
-	CurrentMaterial.F0Color *= SampleTexture(TextureIDs[CurrentMaterial.F0TextureID], Input.TextureUV);
-	CurrentMaterial.Metallic *= SampleTexture(TextureIDs[CurrentMaterial.MetallicTextureID], Input.TextureUV).x;
-	CurrentMaterial.Emissive *= SampleTexture(TextureIDs[CurrentMaterial.EmissiveTextureID], Input.TextureUV);
-	
 	//get some needed dot products for further calculations
 	float VdotH = saturate(dot(V, H));
 	float NdotH = saturate(dot(N, H));
@@ -160,9 +165,123 @@ ShaderOutput Shader(ShaderInput Input, float3 ScatteredLight, float3 EmittedLigh
 	
 	float3 Fr = ReflectedColor(CurrentMaterial.Roughness, CurrentMaterial.F0Color, NdotL, NdotV, NdotH, VdotH);
 	float3 Fd = RefractedColor(CurrentMaterial.Roughness, CurrentMaterial.Metallic, CurrentMaterial.Albedo, NdotL, NdotV, VdotH, LdotV);
+	return max(ZERO.xyz, (Fr + Fd) * NdotL);
+}
+
+
+
+//brdf importance sampling: the specular lobe is sampled with the visible normals of GGX, the diffuse lobe with cosine weighted directions
+//the probability of sampling the specular lobe, estimated from the fresnel term at NdotV and the albedo of the diffuse lobe
+float SpecularProbability(float3 V, float3 N, PBRMaterialProperties CurrentMaterial)
+{
+	float NdotV = dot(N, V);
+	if (NdotV <= 0.0f) return 0.0f; // the visible normals only exist above the surface
+	
+	float ScalingFactor = pow(1.0f - NdotV, 5.0f);
+	float3 F = CurrentMaterial.F0Color + ScalingFactor - CurrentMaterial.F0Color * ScalingFactor;
+	float SpecularWeight = dot(F, float3(0.2126f, 0.7152f, 0.0722f));
+	float DiffuseWeight = dot(CurrentMaterial.Albedo, float3(0.2126f, 0.7152f, 0.0722f)) * saturate(1.0f - CurrentMaterial.Metallic);
+	
+	//both lobes keep some samples, so neither of them gets a tiny pdf, where the estimate is only roughly right
+	return (DiffuseWeight > 0.0f) ? clamp(SpecularWeight / (SpecularWeight + DiffuseWeight), 0.1f, 0.9f) : 1.0f;
+}
+
+
+//the alpha of the sampled distribution, a perfect mirror can't be sampled with a pdf
+float SamplingAlpha(float Roughness)
+{
+	return max(Roughness * Roughness, 1e-3f);
+}
+
+
+//the solid angle pdf of a direction, which is reflected at a visible normal of GGX: G1(V) * D(H) / (4 * NdotV)
+float GGXVisibleNormalPDF(float Alpha, float NdotV, float NdotH)
+{
+	float a2 = Alpha * Alpha;
+	float NdotH2 = NdotH * NdotH;
+	float SqrtDenominator = NdotH2 * a2 - NdotH2 + 1.0f;
+	float D = a2 / (PI * SqrtDenominator * SqrtDenominator);
+	
+	//G1(V) = 2 * NdotV / (NdotV + sqrt(a2 + (1 - a2) * NdotV^2)), the NdotV is cancelled out
+	return D / (2.0f * (NdotV + sqrt(a2 + (1.0f - a2) * NdotV * NdotV)));
+}
+
 
+//reflect V at a normal of the visible normals of GGX, from "Sampling the GGX Distribution of Visible Normals" (Heitz 2018)
+float3 SampleGGXVisibleNormal(float2 RandomNumbers, float3 V, float3 N, float Alpha)
+{
+	//transform V into the space, where N is the z axis, and stretch it, so the distribution becomes a hemisphere
+	float3 Perpendicular1, Perpendicular2;
+	PerpendicularDirections(N, Perpendicular1, Perpendicular2);
+	float3 LocalV = float3(dot(V, Perpendicular1), dot(V, Perpendicular2), dot(V, N));
+	float3 Vh = normalize(float3(Alpha * LocalV.xy, LocalV.z));
+	
+	float LengthSquared = dot(Vh.xy, Vh.xy);
+	float3 T1 = (LengthSquared > 0.0f) ? (float3(-Vh.y, Vh.x, 0.0f) * rsqrt(LengthSquared)) : float3(1.0f, 0.0f, 0.0f);
+	float3 T2 = cross(Vh, T1);
+	
+	//a point on the disk, which is projected onto the visible half of the hemisphere
+	float r = sqrt(RandomNumbers.x);
+	float phi = 6.2831853f * RandomNumbers.y;
+	float t1 = r * cos(phi);
+	float t2 = r * sin(phi);
+	float s = 0.5f * (1.0f + Vh.z);
+	t2 = (1.0f - s) * sqrt(1.0f - t1 * t1) + s * t2;
+	
+	//unstretch the normal and transform it back
+	float3 Nh = t1 * T1 + t2 * T2 + sqrt(max(0.0f, 1.0f - t1 * t1 - t2 * t2)) * Vh;
+	float3 LocalH = normalize(float3(Alpha * Nh.xy, max(0.0f, Nh.z)));
+	float3 H = (LocalH.x * Perpendicular1) + (LocalH.y * Perpendicular2) + (LocalH.z * N);
+	return reflect(-V, H);
+}
+
+
+//pick one of the lobes with the first random number and sample a direction L for it with the other two, V and N have to be normalized
+float3 SampleBRDF(float3 RandomNumbers, float3 V, float3 N, PBRMaterialProperties CurrentMaterial)
+{
+	if (RandomNumbers.x < SpecularProbability(V, N, CurrentMaterial))
+	{
+		return SampleGGXVisibleNormal(RandomNumbers.yz, V, N, SamplingAlpha(CurrentMaterial.Roughness));
+	}
+	return RotatedRandomDirection(RandomNumbers.yz, N);
+}
+
+
+//the solid angle pdf of SampleBRDF for the direction L, which both lobes could have sampled
+float BRDFSamplePDF(float3 V, float3 L, float3 N, PBRMaterialProperties CurrentMaterial)
+{
+	float SpecularPDF = 0.0f;
+	float NdotV = dot(N, V);
+	float SpecularChance = SpecularProbability(V, N, CurrentMaterial);
+	if (SpecularChance > 0.0f)
+	{
+		float3 H = normalize(V + L);
+		float NdotH = dot(N, H);
+		SpecularPDF = (NdotH > 0.0f) ? GGXVisibleNormalPDF(SamplingAlpha(CurrentMaterial.Roughness), NdotV, NdotH) : 0.0f; // no normal of GGX points below the surface
+	}
+	return lerp(RotatedRandomDirectionPDF(dot(N, L)), SpecularPDF, SpecularChance);
+}
+
+
+//russian roulette: the probability, that a path with this throughput continues, the surviving paths are divided by it, so the estimate stays unbiased
+float SurvivalProbability(float3 Throughput)
+{
+	return saturate(max(Throughput.x, max(Throughput.y, Throughput.z)));
+}
+
+
+
+//the main shading function, the material is loaded by the caller
+//the emission is scaled by EmissionWeight, the weight of multiple importance sampling, if the lights are also sampled directly
+ShaderOutput Shader(ShaderInput Input, PBRMaterialProperties CurrentMaterial, float3 ScatteredLight, float3 EmittedLight, float EmissionWeight)
+{
+	//get some direction vectors
+	float3 V = -(Input.OldRayDirection);
+	float3 L = Input.NewRayDirection;
+	float3 N = Input.Normal;
+	
 	/*
-	S: scattered light on one ray = (Fr + Fd) * NdotL
+	S: scattered light on one ray = (Fr + Fd) * NdotL / pdf, the pdf of the sampled direction L (see SampleBRDF)
 	E: emitted light on one ray = CurrentMaterial.Emissive
 	N: number of rays / ray depth
 	
@@ -180,10 +299,14 @@ ShaderOutput Shader(ShaderInput Input, float3 ScatteredLight, float3 EmittedLigh
 	
 	S = S * S_N
 	E = E + S * E_N+1
+	
+	with light sampling, E_N+1 is split between the hit of this ray (weighted by EmissionWeight)
+	and the shadow ray of the last hit, which CS_ResolveShadowRays.hlsl adds to E
 	*/
 	ShaderOutput Output;
-	Output.Scattered = ScatteredLight * max(ZERO.xyz, (Fr + Fd) * NdotL);
-	Output.Emitted = max(ZERO.xyz, ScatteredLight * CurrentMaterial.Emissive) + EmittedLight;
+	Output.PDF = BRDFSamplePDF(V, L, N, CurrentMaterial);
+	Output.Scattered = ScatteredLight * CosineWeightedBRDF(V, L, N, CurrentMaterial) / max(Output.PDF, EPSILON);
+	Output.Emitted = max(ZERO.xyz, ScatteredLight * CurrentMaterial.Emissive) * EmissionWeight + EmittedLight;
 	//Output.Scattered = ScatteredLight * max(ZERO.xyz, (Fd) * 1.0f);
 	//Output.Scattered = ZERO.xyz;
 	//Output.Emitted = abs(Input.NewRayDirection);
@@ -1,3 +1,6 @@
+#pragma once
+
+
 
 //implements a basic xorshift algorithm for pseudo random numbers: http://www.jstatsoft.org/v08/i14/paper
 uint1 XorShift(inout uint1 Seed)
@@ -97,15 +100,19 @@ float4 RandomGaussian(inout uint4 Seed, float4 Mean, float4 Deviation, float4 In
 
 //functions for returning a point on a hemisphere
 //uniform point sampling on a hemisphere, courtesy of https://raytracing.github.io/books/RayTracingTheRestOfYourLife.html
-float3 PointOnHemisphere(inout uint3 Seed)
+float3 PointOnHemisphere(float2 RandomNumber)
 {
-	float3 RandomNumber = Random(Seed);
 	float y = sqrt(1.0f - RandomNumber.y);
 	float r = sqrt(RandomNumber.y);
 	float phi = 6.2831853f * RandomNumber.x;
 	return float3(cos(phi) * r, y, sin(phi) * r);
 }
-float3 RotatedRandomDirection(inout uint3 Seed, float3 Normal)
+float3 PointOnHemisphere(inout uint3 Seed)
+{
+	return PointOnHemisphere(Random(Seed).xy);
+}
+//two directions, which are perpendicular to the normal and to each other
+void PerpendicularDirections(float3 Normal, out float3 Perpendicular1, out float3 Perpendicular2)
 {
 	//this is always perpendicular to the normal since
 	// dot(Normal, Perpendicular1)
@@ -115,12 +122,27 @@ float3 RotatedRandomDirection(inout uint3 Seed, float3 Normal)
 	// == (Normal.x * Normal.z) - (Normal.x * Normal.z)
 	// == 0.0f
 	// --> "Perpendicular1" is always perpendicular to "Normal" 
-	float3 Perpendicular1 = normalize(float3(-Normal.z, 0.0f, Normal.x));
+	Perpendicular1 = normalize(float3(-Normal.z, 0.0f, Normal.x));
 	if (all(Normal.zx == float2(0.0f, 0.0f))) //if the normal points straight up or down the code above generates an unusable vector
 		Perpendicular1 = float3(1.0f, 0.0f, 0.0f);
-	float3 Perpendicular2 = normalize(cross(Normal, Perpendicular1));
+	Perpendicular2 = normalize(cross(Normal, Perpendicular1));
 	Perpendicular1 = normalize(cross(Normal, Perpendicular2));
+}
+float3 RotatedRandomDirection(float2 RandomNumbers, float3 Normal)
+{
+	float3 Perpendicular1, Perpendicular2;
+	PerpendicularDirections(Normal, Perpendicular1, Perpendicular2);
 	
-	float3 BasePoint = PointOnHemisphere(Seed);
+	float3 BasePoint = PointOnHemisphere(RandomNumbers);
 	return (BasePoint.x * Perpendicular1) + (BasePoint.y * Normal) + (BasePoint.z * Perpendicular2);
+}
+float3 RotatedRandomDirection(inout uint3 Seed, float3 Normal)
+{
+	return RotatedRandomDirection(Random(Seed).xy, Normal);
+}
+
+//the solid angle pdf of RotatedRandomDirection, the points on the hemisphere are cosine weighted
+float RotatedRandomDirectionPDF(float NdotL)
+{
+	return saturate(NdotL) * 0.318309886f; // = NdotL / PI
 }
\ No newline at end of file
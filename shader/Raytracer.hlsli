@@ -3,6 +3,11 @@
 
 #define EPSILON 1e-6f
 
+//the uints of the ray queue state buffer (CS_TraceRays.hlsl and CS_PrepareRayQueue.hlsl)
+#define RAY_QUEUE_LIVE_COUNT 0 // the number of rays in the current queue
+#define RAY_QUEUE_APPEND_COUNTER 1 // the number of rays, which were appended to the next queue
+#define RAY_QUEUE_WORK_COUNTER 2 // the next slot of the queue, which is fetched by the persistent threads
+
 
 struct CSInput
 {
@@ -31,6 +36,17 @@ struct Vertex
 	uint MaterialID;
 };
 
+//the intersection-only copy of a triangle, stored in the order of the bvh leaves
+struct IntersectionTriangle
+{
+	float3 Vertex1;
+	uint FirstIndex; // the position of the triangle in the index buffer
+	float3 Edge1; // = Vertex2 - Vertex1
+	float Padding1;
+	float3 Edge2; // = Vertex3 - Vertex1
+	float Padding2;
+};
+
 
 struct AABB
 {
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "../src/Settings.h" //for RT_SAMPLER
+#include "Random.hlsli"
+
+
+//the sampler of the camera rays and the shading: every random number is indexed by the pixel, the sample index in this pixel and its dimension
+//RT_SAMPLER 0: the xorshift white noise of Random.hlsli, the pixel, sample and dimension are ignored
+//RT_SAMPLER 1: owen scrambled sobol points, which are scrambled with another seed for every pixel ("Practical Hash-based Owen Scrambling", Burley 2020)
+//RT_SAMPLER 2: the same scrambled sobol points for all pixels, which are shifted by a blue noise mask, so the error is distributed as blue noise over the image
+//              ("Blue-noise Dithered Sampling", Georgiev and Fajardo 2016)
+#define SAMPLER_XORSHIFT 0
+#define SAMPLER_SOBOL 1
+#define SAMPLER_BLUE_NOISE_SOBOL 2
+
+//the sampler can be changed at runtime, so every shader with a sampler is also compiled once per sampler (shader/permutations), which sets PERMUTATION_SAMPLER
+#ifndef PERMUTATION_SAMPLER
+#define PERMUTATION_SAMPLER RT_SAMPLER
+#endif
+
+//the dimensions are taken in groups of 4, the sobol points are only well distributed in the first 4 dimensions, so every group is scrambled with another seed
+#define SAMPLER_CAMERA_DIMENSIONS 0 // anti-aliasing (xy) and depth of field (zw)
+#define SAMPLER_BSDF_DIMENSIONS 1 // the lobe (x) and the direction (yz) of the bounced ray of a hit and the russian roulette (w)
+#define SAMPLER_LIGHT_DIMENSIONS 2 // the light (xy) and the point on it (zw) of the shadow ray of a hit
+#define SAMPLER_DIMENSIONS_PER_BOUNCE 2 // the bsdf and light groups of bounce i are 1 + 2 * i and 2 + 2 * i
+
+
+
+//the direction numbers of the first 4 dimensions of the sobol sequence (the first one is the van der Corput sequence)
+static const uint SobolDirections[128] =
+{
+	0x80000000, 0x40000000, 0x20000000, 0x10000000, 0x08000000, 0x04000000, 0x02000000, 0x01000000,
+	0x00800000, 0x00400000, 0x00200000, 0x00100000, 0x00080000, 0x00040000, 0x00020000, 0x00010000,
+	0x00008000, 0x00004000, 0x00002000, 0x00001000, 0x00000800, 0x00000400, 0x00000200, 0x00000100,
+	0x00000080, 0x00000040, 0x00000020, 0x00000010, 0x00000008, 0x00000004, 0x00000002, 0x00000001,
+
+	0x80000000, 0xc0000000, 0xa0000000, 0xf0000000, 0x88000000, 0xcc000000, 0xaa000000, 0xff000000,
+	0x80800000, 0xc0c00000, 0xa0a00000, 0xf0f00000, 0x88880000, 0xcccc0000, 0xaaaa0000, 0xffff0000,
+	0x80008000, 0xc000c000, 0xa000a000, 0xf000f000, 0x88008800, 0xcc00cc00, 0xaa00aa00, 0xff00ff00,
+	0x80808080, 0xc0c0c0c0, 0xa0a0a0a0, 0xf0f0f0f0, 0x88888888, 0xcccccccc, 0xaaaaaaaa, 0xffffffff,
+
+	0x80000000, 0xc0000000, 0x60000000, 0x90000000, 0xe8000000, 0x5c000000, 0x8e000000, 0xc5000000,
+	0x68800000, 0x9cc00000, 0xee600000, 0x55900000, 0x80680000, 0xc09c0000, 0x60ee0000, 0x90550000,
+	0xe8808000, 0x5cc0c000, 0x8e606000, 0xc5909000, 0x6868e800, 0x9c9c5c00, 0xeeee8e00, 0x5555c500,
+	0x8000e880, 0xc0005cc0, 0x60008e60, 0x9000c590, 0xe8006868, 0x5c009c9c, 0x8e00eeee, 0xc5005555,
+
+	0x80000000, 0xc0000000, 0x20000000, 0x50000000, 0xf8000000, 0x74000000, 0xa2000000, 0x93000000,
+	0xd8800000, 0x25400000, 0x59e00000, 0xe6d00000, 0x78080000, 0xb40c0000, 0x82020000, 0xc3050000,
+	0x208f8000, 0x51474000, 0xfbea2000, 0x75d93000, 0xa0858800, 0x914e5400, 0xdbe79e00, 0x25db6d00,
+	0x58800080, 0xe54000c0, 0x79e00020, 0xb6d00050, 0x800800f8, 0xc00c0074, 0x200200a2, 0x50050093
+};
+
+
+struct Sampler
+{
+	uint3 RNGSeed; // the state of the xorshift generator (RT_SAMPLER 0)
+	uint PixelSeed; // scrambles the sobol points of the pixel and depends on the image seed, it is the same for all pixels with the blue noise mask
+	uint SampleIndex; // the index of this sample in the sequence of the pixel
+	uint2 Pixel;
+};
+
+
+
+//a well mixing integer hash ("lowbias32" by Chris Wellons)
+uint Hash(uint Value)
+{
+	Value ^= Value >> 16;
+	Value *= 0x7feb352du;
+	Value ^= Value >> 15;
+	Value *= 0x846ca68bu;
+	Value ^= Value >> 16;
+	return Value;
+}
+
+
+//the sobol point with the given index in one of the first 4 dimensions, as a 32 bit fixed point number
+uint Sobol(uint Index, uint Dimension)
+{
+	uint Result = 0;
+	for (uint Bit = 0; Index != 0; Bit++, Index >>= 1)
+	{
+		Result ^= (Index & 1) ? SobolDirections[Dimension * 32 + Bit] : 0;
+	}
+	return Result;
+}
+
+
+//an owen scrambling of the bits of a fixed point number: every bit is flipped depending on the bits above it (the hash of Laine and Karras works on the reversed bits)
+uint NestedUniformScramble(uint Value, uint Seed)
+{
+	Value = reversebits(Value);
+	Value += Seed;
+	Value ^= Value * 0x6c50b47cu;
+	Value ^= Value * 0xb82f1e52u;
+	Value ^= Value * 0xc7afe638u;
+	Value ^= Value * 0x8d22f6e6u;
+	return reversebits(Value);
+}
+
+
+//4 dimensions of the shuffled and scrambled sobol sequence: the index is scrambled as well, so every seed visits the points in another order
+float4 ScrambledSobol(uint Index, uint Seed)
+{
+	Index = NestedUniformScramble(Index, Seed);
+	uint4 Point;
+	for (uint i = 0; i < 4; i++)
+	{
+		Point[i] = NestedUniformScramble(Sobol(Index, i), Hash(Seed + i));
+	}
+	return float4(Point >> 8) * 5.9604645e-8f; // = 2^-24, the 24 upper bits fit exactly into a float below 1.0
+}
+
+
+//a procedural blue noise mask (the R2 dither of Roberts), every dimension weights the pixel coordinates differently, so the shifts of the dimensions aren't correlated
+//(the seed moves the mask, so different image seeds give different images)
+float4 BlueNoiseShift(uint2 Pixel, uint DimensionGroup, uint Seed)
+{
+	Pixel += uint2(Hash(DimensionGroup ^ Seed), Hash((DimensionGroup + 0x9e3779b9u) ^ Seed)) & 0xffff;
+	uint2 Weights = uint2(0xc13fa9a9u, 0x91e10da6u); // = 2^32 / the plastic number and 2^32 / the plastic number^2
+	uint4 Shift = uint4(Pixel.x * Weights.x + Pixel.y * Weights.y, Pixel.x * Weights.y + Pixel.y * Weights.x,
+		Pixel.x * Weights.x - Pixel.y * Weights.y, Pixel.y * Weights.x - Pixel.x * Weights.y); // the fractional part wraps around for free
+	return float4(Shift >> 8) * 5.9604645e-8f;
+}
+
+
+
+//the sampler of the sample SampleIndex of a pixel (RNGSeed is the seed of the xorshift generator, ImageSeed the seed of the settings)
+Sampler InitializeSampler(uint2 Pixel, uint SampleIndex, uint3 RNGSeed, uint ImageSeed)
+{
+	Sampler NewSampler;
+	NewSampler.RNGSeed = RNGSeed;
+	NewSampler.PixelSeed = (PERMUTATION_SAMPLER == SAMPLER_BLUE_NOISE_SOBOL) ? Hash(ImageSeed) : Hash(Pixel.x ^ Hash(Pixel.y ^ Hash(ImageSeed)));
+	NewSampler.SampleIndex = SampleIndex;
+	NewSampler.Pixel = Pixel;
+	return NewSampler;
+}
+
+
+//4 random numbers between 0 and 1 of one group of dimensions
+float4 SampleDimensions(inout Sampler CurrentSampler, uint DimensionGroup)
+{
+#if PERMUTATION_SAMPLER == SAMPLER_XORSHIFT
+	return float4(Random(CurrentSampler.RNGSeed), Random(CurrentSampler.RNGSeed.xy).x);
+#else
+	float4 Point = ScrambledSobol(CurrentSampler.SampleIndex, Hash(CurrentSampler.PixelSeed ^ Hash(DimensionGroup)));
+#if PERMUTATION_SAMPLER == SAMPLER_BLUE_NOISE_SOBOL
+	Point = frac(Point + BlueNoiseShift(CurrentSampler.Pixel, DimensionGroup, CurrentSampler.PixelSeed));
+#endif
+	return Point;
+#endif
+}
\ No newline at end of file
@@ -1,4 +1,3 @@
-
 struct CSInput
 {
 	uint3 GroupID : SV_GroupID;
@@ -11,4 +10,22 @@ struct SortInfo
 {
 	uint NumElements;
 	uint SortPassIndex;
-};
\ No newline at end of file
+	uint NumTiles;
+	uint Padding;
+};
+
+
+//the onesweep radix sort (https://arxiv.org/abs/2206.01784) sorts 8 bits per pass, every group sorts a tile of 2048 keys
+//these values have to match the ones in Core/RadixSort.h
+#define SORT_RADIX 256
+#define SORT_NUM_PASSES 4
+#define SORT_KEYS_PER_THREAD 8
+#define SORT_TILE_SIZE (SORT_RADIX * SORT_KEYS_PER_THREAD)
+#define SORT_TILE_COUNTER_OFFSET (SORT_RADIX * SORT_NUM_PASSES) // the tile counters of the passes are stored after the histograms
+
+//the look-back status of a digit in a tile: the flag in the upper 2 bits, the number of keys in the lower 30 bits
+#define SORT_FLAG_NOT_READY 0x00000000
+#define SORT_FLAG_AGGREGATE 0x40000000 // only the keys of this tile are counted
+#define SORT_FLAG_INCLUSIVE 0x80000000 // the keys of this tile and of all previous tiles are counted
+#define SORT_FLAG_MASK 0xc0000000
+#define SORT_VALUE_MASK 0x3fffffff
\ No newline at end of file
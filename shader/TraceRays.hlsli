@@ -0,0 +1,39 @@
+#pragma once
+
+
+//the info of the passes, which trace and shade the rays (CS_BinRays.hlsl, CS_TraceRays.hlsl, CS_PrepareRayQueue.hlsl, CS_SortHits.hlsl and CS_ShadeHits.hlsl)
+struct TraceRaysInfo
+{
+	int2 ScreenDimensions;
+	uint NumTriangles;
+	uint NumRays;
+	uint MaxRaysPerPixel;
+	uint3 RNGSeed;
+	uint UseRayQueue; // 0 for the camera rays, which are all traced, otherwise only the rays in RayQueue are traced
+	uint NumMaterials; // the number of material queues, bigger material ids use the last one
+	uint UseRayBins; // 1, if the rays of the queue are traced in the order of RayBins
+	uint NumLights; // the number of emissive triangles (see LightSampling.hlsli)
+	float InverseLightPower; // 1 / the summed power of the emissive triangles
+	uint LastBounce; // 1, if the rays of this bounce aren't traced anymore, so the shadow rays get the full weight
+	uint SampleIndex; // the number of camera passes before the current one, a ray is the sample SampleIndex * MaxRaysPerPixel + its slot in the pixel
+	uint Bounce; // 0 for the camera rays, selects the dimensions of the sampler
+	uint RussianRouletteDepth; // the paths are terminated randomly from this number of rays on
+	uint ImageSeed; // the seed of the settings, it scrambles the sobol points and moves the blue noise mask
+};
+
+//the closest hit of a ray, which CS_TraceRays.hlsl passes to CS_ShadeHits.hlsl (indexed by the ray index)
+struct RayHit
+{
+	float4 Result; // t, the barycentric coordinates and the orientation of the triangle
+	uint HitIndex; // the position of the triangle in the index buffer
+	uint MaterialID; // the material queue of the hit
+	uint2 Padding;
+};
+
+//the info of the occlusion queries (CS_TraceOcclusionRays.hlsl)
+struct TraceOcclusionRaysInfo
+{
+	uint NumRays;
+	uint NumTriangles;
+	uint2 Padding;
+};
\ No newline at end of file
@@ -0,0 +1,4 @@
+
+//CS_CameraRayGeneration.hlsl with the pixel sampler 2, the pipeline uses it, when the sampler of the settings differs from RT_SAMPLER
+#define PERMUTATION_SAMPLER 2
+#include "../CS_CameraRayGeneration.hlsl"
\ No newline at end of file
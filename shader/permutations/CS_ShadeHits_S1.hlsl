@@ -0,0 +1,4 @@
+
+//CS_ShadeHits.hlsl with the pixel sampler 1, the pipeline uses it, when the sampler of the settings differs from RT_SAMPLER
+#define PERMUTATION_SAMPLER 1
+#include "../CS_ShadeHits.hlsl"
\ No newline at end of file
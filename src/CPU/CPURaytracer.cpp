@@ -0,0 +1,1231 @@
+//include-files
+#include "CPURaytracer.h"
+
+#include "Core/Parallel.h"
+#include "Core/ImageOutput.h"
+#include "Core/Random.h"
+#include "Core/Sampler.h"
+#include "Core/RayQueue.h"
+#include "Core/PerRayShading.h"
+#include "Core/AdaptiveSampling.h"
+
+#include <chrono>
+#include <algorithm>
+
+
+
+namespace RT::GraphicsAPI::CPU
+{
+
+	//the shared cpu code of the core library
+	using namespace Core;
+
+	//every stage with random numbers gets its own generator, which is derived from the seed of the render and the stage
+	static void SeedPRNG(std::mt19937& stdPRNG, uint32_t iSeed, uint32_t iStage)
+	{
+		std::seed_seq stdSeedSequence{ iSeed, iStage };
+		stdPRNG.seed(stdSeedSequence);
+	}
+
+
+
+	//the camera ray generator class
+	//class constructor
+	CameraRayGen::CameraRayGen() :
+		//initialize the class variables
+		m_rtBuffers(nullptr),
+		m_rtInfoData(),
+		m_rtTiles(),
+		m_iSampler(0),
+		m_stdPRNG()
+	{
+
+	}
+
+	//destructor: uninitializes all our pointers
+	CameraRayGen::~CameraRayGen()
+	{
+
+	}
+
+
+
+	//public class functions
+	bool CameraRayGen::Initialize(RaytracerBuffers* rtBuffers, const RenderSettings& rtSettings)
+	{
+		if (!rtBuffers) return false;
+		m_rtBuffers = rtBuffers;
+		m_rtTiles = GetRenderTiles(rtSettings.Width, rtSettings.Height);
+		m_iSampler = rtSettings.Sampler;
+		SeedPRNG(m_stdPRNG, rtSettings.Seed, 0);
+
+		//the shader sees the inverse matrices, so we don't need the transposes of the gpu path here
+		const Core::CameraSettings& rtCameraData = rtSettings.Camera;
+		float fAspectRatio = (float)rtSettings.Width / (float)rtSettings.Height;
+		m_rtInfoData.InverseProjection = Math::Inverse(Math::PerspectiveFovLH(rtCameraData.VerticalFOV, fAspectRatio, rtCameraData.NearZ, rtCameraData.FarZ));
+		m_rtInfoData.InverseView = Math::Inverse(Math::LookAtLH(rtCameraData.Position, rtCameraData.FocusPoint, rtCameraData.UpDirection));
+		m_rtInfoData.ScreenSize.x = rtSettings.Width;
+		m_rtInfoData.ScreenSize.y = rtSettings.Height;
+		m_rtInfoData.AASampleSpread = rtSettings.AASampleSpread;
+		m_rtInfoData.DOFSampleSpread = rtSettings.DOFSampleSpread;
+		m_rtInfoData.MaxRaysPerPixel = MAX_RAYS_PER_PIXEL;
+		m_rtInfoData.RNGSeed = { 0, 0, 0 };
+		m_rtInfoData.TileOffset = Math::uint2(0, 0);
+		m_rtInfoData.TileSize = Math::uint2(m_rtTiles.TileWidth, m_rtTiles.TileHeight);
+		m_rtInfoData.SampleIndex = 0;
+		m_rtInfoData.ImageSeed = rtSettings.Seed;
+
+		return true;
+	}
+
+
+	//generate the camera rays of the render tile iTile (CS_CameraRayGeneration.hlsl)
+	bool CameraRayGen::Render(uint32_t iTile)
+	{
+		if (iTile >= m_rtTiles.NumTiles) return false;
+
+		//update the info data
+		m_rtInfoData.RNGSeed.x = m_stdPRNG();
+		m_rtInfoData.RNGSeed.y = m_stdPRNG();
+		m_rtInfoData.RNGSeed.z = m_stdPRNG();
+		m_rtInfoData.TileOffset = GetRenderTileOffset(m_rtTiles, iTile);
+
+		const CameraRayGenInfo& rtInfo = m_rtInfoData;
+		RaytracerBuffers* rtBuffers = m_rtBuffers;
+		Math::float4x4 rtInverseViewProjection = Math::mul(rtInfo.InverseProjection, rtInfo.InverseView);
+		Math::float3 rtOriginOffset = Math::mul(rtInfo.InverseView, Math::float4(0.0f, 0.0f, 0.0f, 1.0f)).xyz();
+
+		uint32_t iNumTilesX = ((uint32_t)rtInfo.ScreenSize.x + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE;
+
+		//one row of pixels of the render tile per work item
+		Core::ParallelFor((uint64_t)rtInfo.TileSize.y, 1, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint32_t iTileY = (uint32_t)iBegin; iTileY < (uint32_t)iEnd; iTileY++)
+			{
+				for (uint32_t iTileX = 0; iTileX < rtInfo.TileSize.x; iTileX++)
+				{
+					uint32_t x = rtInfo.TileOffset.x + iTileX;
+					uint32_t y = rtInfo.TileOffset.y + iTileY;
+					uint32_t iFirstRay = (iTileY * rtInfo.TileSize.x + iTileX) * rtInfo.MaxRaysPerPixel;
+
+					//the slots of the pixels outside of the image and the rays of a converged tile get a negative TMax,
+					//so they aren't queued, like the paths, which were terminated by the russian roulette
+					bool bInsideImage = (x < (uint32_t)rtInfo.ScreenSize.x) && (y < (uint32_t)rtInfo.ScreenSize.y);
+					bool bConverged = (!bInsideImage) || (rtBuffers->ConvergedTiles[(y / ADAPTIVE_TILE_SIZE) * iNumTilesX + x / ADAPTIVE_TILE_SIZE] != 0);
+
+					//initialize the random number generation seed (the shaders use the x component of the pixel)
+					Math::uint3 rtRNGSeed = InitializeSeed(x, rtInfo.RNGSeed);
+
+					for (uint32_t i = 0; i < rtInfo.MaxRaysPerPixel; i++)
+					{
+						//get the normalized device coordinates (NDC)
+						Math::float2 rtInvScreenSize = Math::float2(Math::rcp((float)rtInfo.ScreenSize.x), Math::rcp((float)rtInfo.ScreenSize.y));
+						Math::float2 rtScreenCoords = Math::float2((float)x, (float)y) * rtInvScreenSize;
+						Math::float2 rtNDC = -2.0f * rtScreenCoords + 1.0f;
+
+						Sampler rtPixelSampler = InitializeSampler(m_iSampler, Math::uint2(x, y), rtInfo.SampleIndex * rtInfo.MaxRaysPerPixel + i, rtRNGSeed, rtInfo.ImageSeed);
+						Math::float4 rtCameraSample = SampleDimensions(m_iSampler, rtPixelSampler, SAMPLER_CAMERA_DIMENSIONS);
+						rtRNGSeed = rtPixelSampler.RNGSeed; // the xorshift generator continues with the next ray of the pixel
+						Math::float2 rtNearNDC = rtNDC + (rtCameraSample.zw() - 0.5f) * rtInvScreenSize * rtInfo.DOFSampleSpread; //for depth of field
+						Math::float2 rtFarNDC = rtNDC + (rtCameraSample.xy() - 0.5f) * rtInvScreenSize * rtInfo.AASampleSpread; //for anti-aliasing
+
+						Math::float4 rtNearPoint = Math::mul(Math::float4(rtNearNDC, 0.0f, 1.0f), rtInverseViewProjection);
+						Math::float4 rtFarPoint = Math::mul(Math::float4(rtFarNDC, 1.0f, 1.0f), rtInverseViewProjection);
+						rtNearPoint = rtNearPoint / rtNearPoint.w;
+						rtFarPoint = rtFarPoint / rtFarPoint.w;
+
+						Ray rtRay;
+						rtRay.Direction = Math::normalize(rtFarPoint.xyz() - rtNearPoint.xyz());
+						rtRay.Origin = rtNearPoint.xyz() + rtOriginOffset;
+						rtRay.TMin = 0.0f;
+						rtRay.TMax = bConverged ? -1.0f : Math::length(rtFarPoint.xyz());
+
+						Ray rtOldRay;
+						rtOldRay.Direction = Math::float3(0.0f, 0.0f, 0.0f);
+						rtOldRay.Origin = Math::float3(0.0f, 0.0f, 0.0f);
+						rtOldRay.TMin = 0.0f;
+						rtOldRay.TMax = Math::asfloat(i);
+
+						//the slots were used by another tile before, so a camera ray, which misses, starts without light
+						uint32_t iFlattenedIndex = iFirstRay + i;
+						rtBuffers->Rays[iFlattenedIndex] = rtRay;
+						rtBuffers->OldRays[iFlattenedIndex] = rtOldRay;
+						rtBuffers->RayPixels[iFlattenedIndex] = (x << 16) | (y & 0xffff);
+						rtBuffers->ScatteredLight[iFlattenedIndex] = Math::float4(1.0f, 1.0f, 1.0f, 0.0f);
+						rtBuffers->EmittedLight[iFlattenedIndex] = Math::float4(0.0f);
+					}
+				}
+			}
+		});
+		if (iTile == m_rtTiles.NumTiles - 1) m_rtInfoData.SampleIndex++; // the next camera rays are the next samples of the pixels
+
+		return true;
+	}
+
+
+
+	//the sorting class
+	//class constructor
+	SortPrimitives::SortPrimitives() :
+		//initialize the class variables
+		m_rtMortonCodeInfoData(),
+		m_rtMortonCodes(),
+		m_rtTempMortonCodes()
+	{
+
+	}
+
+	//destructor: uninitializes all our pointers
+	SortPrimitives::~SortPrimitives()
+	{
+
+	}
+
+
+
+	//public class functions
+	bool SortPrimitives::Initialize(uint32_t iNumPrimitives, AABB rtSceneAABB)
+	{
+		m_rtMortonCodes.resize(iNumPrimitives);
+		m_rtTempMortonCodes.resize(iNumPrimitives);
+
+		m_rtMortonCodeInfoData.SceneMin = Math::float4(rtSceneAABB.Min, 0.0f);
+		m_rtMortonCodeInfoData.SceneMax = Math::float4(rtSceneAABB.Max, 0.0f);
+		m_rtMortonCodeInfoData.NumPrimitives = iNumPrimitives;
+
+		return true;
+	}
+
+
+	//generate the morton codes and sort them (CS_GenerateMortonCodes.hlsl and the CS_Sort*.hlsl passes)
+	bool SortPrimitives::Sort(const MeshInfo& rtMesh)
+	{
+		const MortonCodeInfo& rtInfo = m_rtMortonCodeInfoData;
+		if (rtMesh.IndexCount / 3 < rtInfo.NumPrimitives) return false;
+
+		//generate the morton codes and sort them with 4 stable passes over 8 bits each, just like the gpu does
+		AABB rtSceneAABB{};
+		rtSceneAABB.Min = rtInfo.SceneMin.xyz();
+		rtSceneAABB.Max = rtInfo.SceneMax.xyz();
+		Core::GenerateMortonCodes(rtMesh, rtSceneAABB, m_rtMortonCodes);
+		m_rtMortonCodes.resize(rtInfo.NumPrimitives);
+		Core::SortMortonCodes(m_rtMortonCodes, m_rtTempMortonCodes);
+
+		return true;
+	}
+
+
+
+	//the bvh building class
+	//class constructor
+	BuildBVH::BuildBVH() :
+		//initialize the class variables
+		m_iNumPrimitives(0),
+		m_rtBVH(),
+		m_rtWideBVH(),
+		m_rtTriangles(),
+		m_iSkipLinks(),
+		m_bUseStacklessBVH(false)
+	{
+
+	}
+
+	//destructor: uninitializes all our pointers
+	BuildBVH::~BuildBVH()
+	{
+
+	}
+
+
+
+	//public class functions
+	bool BuildBVH::Initialize(uint32_t iNumPrimitives, const RenderSettings& rtSettings)
+	{
+		m_iNumPrimitives = iNumPrimitives;
+		m_bUseStacklessBVH = rtSettings.UseStacklessBVH;
+		m_rtBVH.reserve(std::max<uint32_t>(iNumPrimitives * 4, 4));
+		m_rtTriangles.reserve(iNumPrimitives);
+
+		return true;
+	}
+
+
+	//build the tree from the sorted morton codes (CS_BVHBuildLeaves.hlsl and CS_BVHBuild.hlsl)
+	bool BuildBVH::Build(const MeshInfo& rtMesh, const std::vector<Math::uint2>& rtMortonCodes)
+	{
+		if (rtMesh.IndexCount / 3 != m_iNumPrimitives) return false;
+		if (!(Core::BuildLBVH(rtMesh, rtMortonCodes, m_rtBVH))) return false;
+		if (!(Core::BuildTriangleStream(rtMesh, m_rtBVH, m_rtTriangles))) return false;
+		if (m_bUseStacklessBVH) Core::BuildSkipLinks(m_rtBVH, m_iSkipLinks);
+		return true;
+	}
+
+
+	//build the tree with the surface area heuristic, this doesn't need the morton codes
+	bool BuildBVH::BuildSAH(const MeshInfo& rtMesh)
+	{
+		if (rtMesh.IndexCount / 3 != m_iNumPrimitives) return false;
+
+		//the scene cache can already contain the tree (with the same width) and its triangle stream
+		if ((rtMesh.Cache) && (rtMesh.Cache->GetBVHWidth() == BVH_WIDTH))
+		{
+			std::span<const AABB> rtCachedBVH = rtMesh.Cache->GetBVH();
+			std::span<const WideBVHNode> rtCachedWideBVH = rtMesh.Cache->GetWideBVH<WIDE_BVH_WIDTH>();
+			if ((!(rtCachedBVH.empty())) || (!(rtCachedWideBVH.empty())))
+			{
+				m_rtBVH.assign(rtCachedBVH.begin(), rtCachedBVH.end());
+				m_rtWideBVH.assign(rtCachedWideBVH.begin(), rtCachedWideBVH.end());
+				m_rtTriangles.assign(rtMesh.Cache->GetTriangles().begin(), rtMesh.Cache->GetTriangles().end());
+				if (m_bUseStacklessBVH) Core::BuildSkipLinks(m_rtBVH, m_iSkipLinks);
+				return true;
+			}
+		}
+		if (!(Core::BuildSAHBVH(rtMesh, m_rtBVH))) return false;
+		if (!(Core::BuildTriangleStream(rtMesh, m_rtBVH, m_rtTriangles))) return false;
+
+		//collapse the binary tree, the wide leaves get their own triangle stream
+		if (BVH_WIDTH > 2)
+		{
+			std::vector<IntersectionTriangle> rtWideTriangles;
+			if (!(Core::BuildWideBVH<WIDE_BVH_WIDTH>(m_rtBVH, m_rtTriangles, m_rtWideBVH, rtWideTriangles))) return false;
+			m_rtTriangles.swap(rtWideTriangles);
+			m_rtBVH.clear();
+		}
+		if (m_bUseStacklessBVH) Core::BuildSkipLinks(m_rtBVH, m_iSkipLinks);
+		return true;
+	}
+
+
+	//only store the triangle stream (in the order of the index buffer) for tracing without a bvh
+	bool BuildBVH::BuildTriangles(const MeshInfo& rtMesh)
+	{
+		if (rtMesh.IndexCount / 3 != m_iNumPrimitives) return false;
+		m_rtBVH.clear();
+		m_rtWideBVH.clear();
+		m_iSkipLinks.clear();
+		return Core::BuildTriangleStream(rtMesh, m_rtBVH, m_rtTriangles);
+	}
+
+
+
+	//the ray tracing class
+	//class constructor
+	TraceRays::TraceRays() :
+		//initialize the class variables
+		m_rtBuffers(nullptr),
+		m_rtMesh(),
+		m_rtTextures(nullptr),
+		m_rtInfoData(),
+		m_rtSettings(),
+		m_stdPRNG(),
+		m_iRayQueue(),
+		m_iNextRayQueue(),
+		m_iSurvivors(),
+		m_iNumQueuedRays(0),
+		m_rtHits(),
+		m_iHitMaterials(),
+		m_iShadingQueue(),
+		m_iMaterialOffsets(),
+		m_rtMaterialStats(),
+		m_iNumMaterials(0),
+		m_rtRayBins(),
+		m_rtTempRayBins(),
+		m_rtThreadPool(nullptr),
+		m_rtIntersectionStats(),
+		m_rtShadowRays(),
+		m_rtShadowLight(),
+		m_rtTraceShadowRays(nullptr)
+	{
+
+	}
+
+	//destructor: uninitializes all our pointers
+	TraceRays::~TraceRays()
+	{
+
+	}
+
+
+
+	//private class functions
+	//find the closest hit of a single ray, this is the body of CS_TraceRays.hlsl, the return value tells whether the ray continues with the next bounce
+	bool TraceRays::IntersectRay(uint32_t iRayIndex, const AABB* rtBVH, const uint32_t* iSkipLinks, const WideBVHNode* rtWideBVH,
+		const IntersectionTriangle* rtTriangles)
+	{
+		const Ray& rtCurrentRay = m_rtBuffers->Rays[iRayIndex];
+		Math::float4 rtResult = Math::float4(rtCurrentRay.TMax, 0.0f, 0.0f, 0.0f);
+		Index iHitIndex = 0;
+
+		if (rtWideBVH) //use the wide BVH
+		{
+			TraverseWideBVH(rtWideBVH, rtTriangles, rtCurrentRay, rtResult, iHitIndex);
+		}
+		else if (!rtBVH) //no use of BVH
+		{
+			for (uint32_t i = 0; i < m_rtInfoData.NumTriangles; i++)
+			{
+				CheckIntersection(rtTriangles, rtCurrentRay, i, rtResult, iHitIndex);
+			}
+		}
+		else if (iSkipLinks) //use BVH without a stack
+		{
+			TraverseBVHStackless(rtBVH, iSkipLinks, rtTriangles, rtCurrentRay, rtResult, iHitIndex);
+		}
+		else //use BVH
+		{
+			TraverseBVH(rtBVH, rtTriangles, rtCurrentRay, rtResult, iHitIndex);
+		}
+
+		//a ray, which missed, keeps its light and doesn't change anymore, so it can leave the queue
+		bool bHit = (rtResult.x != rtCurrentRay.TMax);
+		if (bHit)
+		{
+			m_rtHits[iRayIndex].Result = rtResult;
+			m_rtHits[iRayIndex].HitIndex = iHitIndex;
+			m_iHitMaterials[iRayIndex] = m_rtMesh.Vertices[m_rtMesh.Indices[iHitIndex]].MaterialID;
+		}
+
+		return bHit;
+	}
+
+	//shade the hit of the ray at iQueueIndex in the shading queue, this is the body of CS_ShadeHits.hlsl
+	void TraceRays::ShadeRay(uint32_t iQueueIndex)
+	{
+		uint32_t iRayIndex = m_iShadingQueue[iQueueIndex];
+		Ray rtCurrentRay = m_rtBuffers->Rays[iRayIndex];
+		Ray rtOldRay = m_rtBuffers->OldRays[iRayIndex];
+		Math::float4 rtResult = m_rtHits[iRayIndex].Result;
+		Index iHitIndex = m_rtHits[iRayIndex].HitIndex;
+
+		//get the pixel and the slot of the ray in this pixel (the light of a path stays in the slot of its camera ray)
+		uint32_t iPixel = m_rtBuffers->RayPixels[iRayIndex];
+		uint32_t iOffsetInPixel = Math::asuint(rtOldRay.TMax);
+		uint32_t iIndex = iRayIndex;
+
+		Math::float4 rtScattered = m_rtBuffers->ScatteredLight[iIndex];
+		Math::float4 rtEmitted = m_rtBuffers->EmittedLight[iIndex];
+
+		//only the closest hit reads the full vertices
+		const Vertex& rtVertex1 = m_rtMesh.Vertices[m_rtMesh.Indices[iHitIndex]];
+		const Vertex& rtVertex2 = m_rtMesh.Vertices[m_rtMesh.Indices[iHitIndex + 1]];
+		const Vertex& rtVertex3 = m_rtMesh.Vertices[m_rtMesh.Indices[iHitIndex + 2]];
+
+		//initialize the random number generation seed and the sampler of the path
+		Math::uint3 rtRNGSeed = InitializeSeed(iRayIndex, m_rtInfoData.RNGSeed);
+		Sampler rtPathSampler = InitializeSampler(m_rtSettings.Sampler, Math::uint2(iPixel >> 16, iPixel & 0xffff), m_rtInfoData.SampleIndex * m_rtInfoData.MaxRaysPerPixel + iOffsetInPixel, rtRNGSeed, m_rtInfoData.ImageSeed);
+		uint32_t iDimensionGroup = m_rtInfoData.Bounce * SAMPLER_DIMENSIONS_PER_BOUNCE;
+
+		//generate an input for our shader function
+		ShaderInput rtShadingInput;
+		rtShadingInput.Clockwiseability = rtResult.w;
+		rtShadingInput.TextureUV = Interpolate(rtVertex1.UV, rtVertex2.UV, rtVertex3.UV, rtResult.y, rtResult.z);
+		rtShadingInput.Normal = Math::normalize(Interpolate(rtVertex1.Normal, rtVertex2.Normal, rtVertex3.Normal, rtResult.y, rtResult.z)); // the sampling needs a normalized frame
+		rtShadingInput.Tangent = Interpolate(rtVertex1.Tangent, rtVertex2.Tangent, rtVertex3.Tangent, rtResult.y, rtResult.z);
+		rtShadingInput.OldRayDirection = rtCurrentRay.Direction;
+		rtShadingInput.MaterialID = rtVertex1.MaterialID;
+
+		bool bFirstRay = (Math::dot(rtOldRay.Direction, rtOldRay.Direction) == 0.0f); //this indicates it being the first rays for which we have to reset those values
+		if (bFirstRay)
+		{
+			rtScattered = Math::float4(1.0f, 1.0f, 1.0f, rtScattered.w);
+			rtEmitted = Math::float4(0.0f, 0.0f, 0.0f, rtEmitted.w);
+		}
+
+		//load the material properties at this specific point
+		PBRMaterialProperties rtMaterial{};
+		if (rtShadingInput.MaterialID < m_rtMesh.MaterialCount)
+		{
+			const PBRMaterial& rtSourceMaterial = m_rtMesh.Materials[rtShadingInput.MaterialID];
+			rtMaterial.Albedo = rtSourceMaterial.Albedo * m_rtTextures->SampleTexture(rtSourceMaterial.AlbedoTextureID, rtShadingInput.TextureUV);
+			rtMaterial.Roughness = rtSourceMaterial.Roughness * m_rtTextures->SampleTexture(rtSourceMaterial.RoughnessTextureID, rtShadingInput.TextureUV).x;
+			rtMaterial.F0Color = rtSourceMaterial.F0Color * m_rtTextures->SampleTexture(rtSourceMaterial.F0TextureID, rtShadingInput.TextureUV);
+			rtMaterial.Metallic = rtSourceMaterial.Metallic * m_rtTextures->SampleTexture(rtSourceMaterial.MetallicTextureID, rtShadingInput.TextureUV).x;
+			rtMaterial.Emissive = rtSourceMaterial.Emissive * m_rtTextures->SampleTexture(rtSourceMaterial.EmissiveTextureID, rtShadingInput.TextureUV);
+		}
+		Math::float4 rtBSDFSample = SampleDimensions(m_rtSettings.Sampler, rtPathSampler, iDimensionGroup + SAMPLER_BSDF_DIMENSIONS);
+		rtShadingInput.NewRayDirection = SampleBRDF(rtBSDFSample.xyz(), -(rtCurrentRay.Direction), rtShadingInput.Normal, rtMaterial);
+		Math::float3 rtHitPoint = rtCurrentRay.Origin + rtCurrentRay.Direction * rtResult.x;
+
+		//the light of this hit could also be found by the shadow ray of the last hit, so it is weighted by the pdfs of both (ScatteredLight.w is the pdf of the last bounce)
+		float fEmissionWeight = 1.0f;
+		Ray rtShadowRay{};
+		Math::float3 rtShadowRayLight = Math::float3(0.0f);
+		rtShadowRay.TMax = -1.0f;
+		if (m_rtInfoData.NumLights > 0)
+		{
+			if ((!bFirstRay) && (rtShadingInput.MaterialID < m_rtMesh.MaterialCount))
+			{
+				Math::float3 rtGeometricNormal = Math::normalize(Math::cross(rtVertex2.Position - rtVertex1.Position, rtVertex3.Position - rtVertex1.Position));
+				float fHitLuminance = Luminance(m_rtMesh.Materials[rtShadingInput.MaterialID].Emissive);
+				float fHitPDF = LightPDF(fHitLuminance, m_rtInfoData.InverseLightPower, rtResult.x * rtResult.x, std::fabs(Math::dot(rtGeometricNormal, rtCurrentRay.Direction)));
+				fEmissionWeight = PowerHeuristic(rtScattered.w, fHitPDF);
+			}
+
+			//next-event estimation: pick a light by its power and a point on it
+			Math::float4 rtLightSample = SampleDimensions(m_rtSettings.Sampler, rtPathSampler, iDimensionGroup + SAMPLER_LIGHT_DIMENSIONS);
+			const std::vector<EmissiveTriangle>& rtLights = m_rtMesh.Lights->Triangles;
+			const EmissiveTriangle& rtLight = rtLights[SelectLight(rtLights.data(), m_rtInfoData.NumLights, rtLightSample.x, rtLightSample.y)];
+			Math::float2 rtLightBarycentrics = PointOnTriangle(rtLightSample.z, rtLightSample.w);
+			Math::float3 rtToLight = rtLight.Vertex1 + rtLight.Edge1 * rtLightBarycentrics.x + rtLight.Edge2 * rtLightBarycentrics.y - rtHitPoint;
+			float fDistanceSquared = Math::dot(rtToLight, rtToLight);
+			float fDistance = std::sqrt(fDistanceSquared);
+			Math::float3 L = rtToLight / std::max(fDistance, SHADING_EPSILON);
+
+			//the emission at this point (the power of the light only contains the emissive color of the material)
+			const Vertex& rtLightVertex1 = m_rtMesh.Vertices[m_rtMesh.Indices[rtLight.FirstIndex]];
+			const Vertex& rtLightVertex2 = m_rtMesh.Vertices[m_rtMesh.Indices[rtLight.FirstIndex + 1]];
+			const Vertex& rtLightVertex3 = m_rtMesh.Vertices[m_rtMesh.Indices[rtLight.FirstIndex + 2]];
+			const PBRMaterial& rtLightMaterial = m_rtMesh.Materials[rtLightVertex1.MaterialID];
+			Math::float2 rtLightUV = Interpolate(rtLightVertex1.UV, rtLightVertex2.UV, rtLightVertex3.UV, rtLightBarycentrics.x, rtLightBarycentrics.y);
+			Math::float3 rtLightEmission = rtLightMaterial.Emissive * m_rtTextures->SampleTexture(rtLightMaterial.EmissiveTextureID, rtLightUV);
+
+			float fLightCosine = std::fabs(Math::dot(Math::normalize(Math::cross(rtLight.Edge1, rtLight.Edge2)), L));
+			float fSamplePDF = LightPDF(Luminance(rtLightMaterial.Emissive), m_rtInfoData.InverseLightPower, fDistanceSquared, fLightCosine);
+			float fNdotL = Math::dot(rtShadingInput.Normal, L);
+			if ((fSamplePDF > 0.0f) && (fNdotL > 0.0f))
+			{
+				//the rays of the last bounce aren't traced, so they can't find the light and the shadow ray gets the full weight
+				float fLightWeight = m_rtInfoData.LastBounce ? 1.0f : PowerHeuristic(fSamplePDF, BRDFSamplePDF(-(rtCurrentRay.Direction), L, rtShadingInput.Normal, rtMaterial));
+				rtShadowRayLight = rtScattered.xyz() * CosineWeightedBRDF(-(rtCurrentRay.Direction), L, rtShadingInput.Normal, rtMaterial) * rtLightEmission * (fLightWeight / fSamplePDF);
+				rtShadowRay.Origin = rtHitPoint;
+				rtShadowRay.Direction = L;
+				rtShadowRay.TMin = rtCurrentRay.TMin;
+				rtShadowRay.TMax = fDistance * (1.0f - SHADOW_RAY_EPSILON);
+			}
+		}
+		m_rtShadowRays[iQueueIndex] = rtShadowRay;
+		m_rtShadowLight[iQueueIndex] = Math::float4(rtShadowRayLight, Math::asfloat(iIndex));
+
+		ShaderOutput rtOutput = Shader(rtShadingInput, rtMaterial, rtScattered.xyz(), rtEmitted.xyz(), fEmissionWeight);
+		rtScattered = Math::float4(rtOutput.Scattered, rtOutput.PDF);
+		rtEmitted = Math::float4(rtOutput.Emitted, rtEmitted.w);
+
+		//russian roulette: after RussianRouletteDepth rays, a path with a low throughput is likely terminated, the survivors make up for the terminated paths
+		bool bTerminated = false;
+		if (m_rtInfoData.Bounce + 1 >= m_rtInfoData.RussianRouletteDepth)
+		{
+			float fSurvival = SurvivalProbability(rtScattered.xyz());
+			bTerminated = (rtBSDFSample.w >= fSurvival);
+			if (!bTerminated) rtScattered = Math::float4(rtScattered.xyz() / fSurvival, rtScattered.w);
+		}
+
+		//generate a new ray (a terminated path gets a negative TMax and leaves the queue after the shading)
+		Ray rtNewRay;
+		rtNewRay.Direction = rtShadingInput.NewRayDirection;
+		rtNewRay.Origin = rtHitPoint;
+		rtNewRay.TMin = rtCurrentRay.TMin;
+		rtNewRay.TMax = bTerminated ? -1.0f : rtCurrentRay.TMax;
+		rtCurrentRay.TMax = rtOldRay.TMax;
+		m_rtBuffers->Rays[iRayIndex] = rtNewRay;
+		m_rtBuffers->OldRays[iRayIndex] = rtCurrentRay;
+
+		m_rtBuffers->ScatteredLight[iIndex] = rtScattered;
+		m_rtBuffers->EmittedLight[iIndex] = rtEmitted;
+	}
+
+
+
+	//public class functions
+	bool TraceRays::Initialize(RaytracerBuffers* rtBuffers, MeshInfo rtMeshData, const RenderSettings& rtSettings)
+	{
+		if (!rtBuffers) return false;
+		m_rtBuffers = rtBuffers;
+		m_rtMesh = rtMeshData;
+		m_rtSettings = rtSettings;
+		SeedPRNG(m_stdPRNG, rtSettings.Seed, 1);
+
+		//create the texture atlas (the scene cache already contains the packed textures)
+		m_rtTextures = new TextureAtlasData();
+		if (!m_rtTextures) return false;
+		if (rtMeshData.Cache)
+		{
+			rtMeshData.Cache->GetTextureAtlas(m_rtTextures);
+		}
+		else
+		{
+			for (uint64_t i = 1; i < rtMeshData.TextureNameCount; i++)
+			{
+				uint32_t iTextureID = 0; //we don't use this, since the textures are sorted by index
+				if (!(m_rtTextures->AddTexture(&iTextureID, LoadTextureFromFile(rtMeshData.TextureNames[i])))) return false;
+			}
+		}
+
+		//store the info data
+		m_rtInfoData.ScreenDimensions.x = rtSettings.Width;
+		m_rtInfoData.ScreenDimensions.y = rtSettings.Height;
+		m_rtInfoData.NumTriangles = (uint32_t)(m_rtMesh.IndexCount / 3);
+		m_rtInfoData.NumRays = GetRenderTiles(rtSettings.Width, rtSettings.Height).MaxRays;
+		m_rtInfoData.MaxRaysPerPixel = MAX_RAYS_PER_PIXEL;
+		m_rtInfoData.RNGSeed = { 0, 0, 0 };
+
+		//the emissive triangles (a mesh, which was put together by hand, doesn't have a light list yet)
+		if (!(m_rtMesh.Lights)) m_rtMesh.Lights = BuildLightList(m_rtMesh);
+		m_rtInfoData.NumLights = rtSettings.UseLightSampling ? (uint32_t)m_rtMesh.Lights->Triangles.size() : 0;
+		m_rtInfoData.InverseLightPower = (m_rtMesh.Lights->TotalPower > 0.0f) ? (1.0f / m_rtMesh.Lights->TotalPower) : 0.0f;
+		m_rtInfoData.LastBounce = 0;
+		m_rtInfoData.SampleIndex = 0;
+		m_rtInfoData.Bounce = 0;
+		m_rtInfoData.RussianRouletteDepth = rtSettings.RussianRouletteDepth;
+		m_rtInfoData.ImageSeed = rtSettings.Seed;
+
+		//the ray queues
+		m_iRayQueue.resize(m_rtInfoData.NumRays);
+		m_iNextRayQueue.resize(m_rtInfoData.NumRays);
+		m_iSurvivors.resize(m_rtInfoData.NumRays);
+		m_iNumQueuedRays = 0;
+
+		//the hits and the material queues (at least one for meshes without materials)
+		m_iNumMaterials = (m_rtMesh.MaterialCount > 0) ? (uint32_t)m_rtMesh.MaterialCount : 1;
+		m_rtHits.resize(m_rtInfoData.NumRays);
+		m_iHitMaterials.resize(m_rtInfoData.NumRays);
+		m_iShadingQueue.resize(m_rtInfoData.NumRays);
+		m_iMaterialOffsets.resize(m_iNumMaterials + 1, 0);
+		m_rtMaterialStats.resize(m_iNumMaterials);
+		m_rtRayBins.reserve(m_rtInfoData.NumRays);
+		m_rtTempRayBins.reserve(m_rtInfoData.NumRays);
+
+		//the shadow rays of the shading are traced by an occlusion query
+		m_rtShadowRays.resize(m_rtInfoData.NumRays);
+		m_rtShadowLight.resize(m_rtInfoData.NumRays);
+		m_rtTraceShadowRays = new TraceOcclusionRays();
+		if (!m_rtTraceShadowRays) return false;
+		if (!(m_rtTraceShadowRays->Initialize(m_rtInfoData.NumRays, m_rtInfoData.NumTriangles))) return false;
+
+		//the workers for the intersection are started once and wait for the bounces
+		if (m_rtSettings.UsePersistentThreads)
+		{
+			m_rtThreadPool = new Core::ThreadPool();
+			if (!m_rtThreadPool) return false;
+		}
+
+		return true;
+	}
+
+
+	//trace the rays in the queue once: the hits are sorted by material and shaded in this order, the rays, which hit something, are compacted into the queue of the next bounce
+	//new camera rays (bNewRays) restart the queue with all rays, with light sampling every hit also traces a shadow ray (bLastBounce: the bounced rays aren't traced anymore)
+	//the pass also ends, when the queue is empty, because all paths missed or were terminated by the russian roulette (bLastTile: the pass of the last render tile completes a sample)
+	bool TraceRays::Render(const std::vector<AABB>& rtBVH, const std::vector<uint32_t>& iSkipLinks, const std::vector<WideBVHNode>& rtWideBVH,
+		const std::vector<IntersectionTriangle>& rtTriangles, bool bNewRays, bool bLastBounce, bool bLastTile)
+	{
+		if (rtTriangles.size() < m_rtInfoData.NumTriangles) return false;
+
+		//update the info data
+		m_rtInfoData.RNGSeed.x = m_stdPRNG();
+		m_rtInfoData.RNGSeed.y = m_stdPRNG();
+		m_rtInfoData.RNGSeed.z = m_stdPRNG();
+		m_rtInfoData.LastBounce = bLastBounce ? 1 : 0;
+		m_rtInfoData.Bounce = bNewRays ? 0 : (m_rtInfoData.Bounce + 1);
+
+		const AABB* rtBVHData = rtBVH.empty() ? nullptr : rtBVH.data();
+		const uint32_t* iSkipLinkData = (iSkipLinks.size() == rtBVH.size()) && (!(iSkipLinks.empty())) ? iSkipLinks.data() : nullptr;
+		const WideBVHNode* rtWideBVHData = rtWideBVH.empty() ? nullptr : rtWideBVH.data();
+		if (bNewRays)
+		{
+			//the camera rays of the tiles, which the adaptive sampling stopped, have a negative TMax
+			m_iNumQueuedRays = 0;
+			for (uint32_t i = 0; i < m_rtInfoData.NumRays; i++)
+			{
+				if (m_rtBuffers->Rays[i].TMax >= 0.0f)
+				{
+					m_iRayQueue[m_iNumQueuedRays++] = i;
+				}
+			}
+		}
+		else if (m_rtSettings.UseRayBinning)
+		{
+			//the camera rays are coherent already, the bounced rays are traced in the order of their bins
+			Math::uint2 rtScreenSize = Math::uint2((uint32_t)m_rtInfoData.ScreenDimensions.x, (uint32_t)m_rtInfoData.ScreenDimensions.y);
+			Core::BinRayQueue(m_iRayQueue.data(), m_iNumQueuedRays, m_rtBuffers->Rays.data(), m_rtBuffers->RayPixels.data(), rtScreenSize,
+				m_rtRayBins, m_rtTempRayBins);
+		}
+
+		//the intersection
+		auto fnIntersect = [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t i = iBegin; i < iEnd; i++)
+			{
+				m_iSurvivors[i] = IntersectRay(m_iRayQueue[i], rtBVHData, iSkipLinkData, rtWideBVHData, rtTriangles.data()) ? 1 : 0;
+			}
+		};
+
+		Core::ThreadPoolStats rtStats{};
+		if (m_rtSettings.UsePersistentThreads)
+		{
+			//the workers of the pool fetch small batches and steal from each other, like the persistent thread groups on the gpu
+			m_rtThreadPool->ParallelFor(m_iNumQueuedRays, RAY_BATCH_SIZE, fnIntersect, &rtStats);
+		}
+		else
+		{
+			//the same timings for the fixed chunks of ParallelFor
+			unsigned int iNumThreads = Core::GetThreadCount();
+			std::vector<double> dFinishTimes(iNumThreads, 0.0);
+			std::vector<double> dBusyTimes(iNumThreads, 0.0);
+			auto stdStartTime = std::chrono::steady_clock::now();
+			Core::ParallelFor(m_iNumQueuedRays, 1024, [&](uint64_t iBegin, uint64_t iEnd, unsigned int iThread)
+			{
+				double dBegin = std::chrono::duration<double>(std::chrono::steady_clock::now() - stdStartTime).count();
+				fnIntersect(iBegin, iEnd, iThread);
+				dFinishTimes[iThread] = std::chrono::duration<double>(std::chrono::steady_clock::now() - stdStartTime).count();
+				dBusyTimes[iThread] += dFinishTimes[iThread] - dBegin;
+			});
+			rtStats.WallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - stdStartTime).count();
+
+			//threads without a chunk finish right away
+			double dFirstFinish = rtStats.WallSeconds;
+			double dBusySeconds = 0.0;
+			for (unsigned int i = 0; i < iNumThreads; i++)
+			{
+				dFirstFinish = std::min(dFirstFinish, dFinishTimes[i]);
+				dBusySeconds += dBusyTimes[i];
+			}
+			rtStats.TailSeconds = rtStats.WallSeconds - dFirstFinish;
+			rtStats.IdleSeconds = std::max(rtStats.WallSeconds * (double)iNumThreads - dBusySeconds, 0.0);
+		}
+		m_rtIntersectionStats.NumRays = m_iNumQueuedRays;
+		m_rtIntersectionStats.Seconds = rtStats.WallSeconds;
+		m_rtIntersectionStats.TailSeconds = rtStats.TailSeconds;
+		m_rtIntersectionStats.IdleSeconds = rtStats.IdleSeconds;
+		m_rtIntersectionStats.NumSteals = rtStats.NumSteals;
+
+		//the queue of the next bounce only contains the rays, which hit something
+		m_iNumQueuedRays = Core::CompactRayQueue(m_iRayQueue.data(), m_iSurvivors.data(), m_iNumQueuedRays, m_iNextRayQueue.data());
+		m_iRayQueue.swap(m_iNextRayQueue);
+
+		//bucket the hits by material
+		Core::SortRayQueueByMaterial(m_iRayQueue.data(), m_iHitMaterials.data(), m_iNumQueuedRays, m_iNumMaterials,
+			m_iMaterialOffsets.data(), m_iShadingQueue.data());
+
+		//the shading: every batch only contains hits of one material, the batches of all materials are distributed over the threads
+		const uint32_t iBatchSize = 256;
+		std::vector<Math::uint2> rtBatches; // x: the first entry in the shading queue, y: the material
+		for (uint32_t m = 0; m < m_iNumMaterials; m++)
+		{
+			for (uint32_t i = m_iMaterialOffsets[m]; i < m_iMaterialOffsets[m + 1]; i += iBatchSize)
+			{
+				rtBatches.push_back(Math::uint2(i, m));
+			}
+		}
+
+		std::vector<double> dBatchSeconds(rtBatches.size(), 0.0);
+		Core::ParallelFor(rtBatches.size(), 4, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t iBatch = iBegin; iBatch < iEnd; iBatch++)
+			{
+				auto stdStartTime = std::chrono::steady_clock::now();
+				uint32_t iLast = std::min(rtBatches[iBatch].x + iBatchSize, m_iMaterialOffsets[rtBatches[iBatch].y + 1]);
+				for (uint32_t i = rtBatches[iBatch].x; i < iLast; i++)
+				{
+					ShadeRay(i);
+				}
+				dBatchSeconds[iBatch] = std::chrono::duration<double>(std::chrono::steady_clock::now() - stdStartTime).count();
+			}
+		});
+
+		for (uint32_t m = 0; m < m_iNumMaterials; m++)
+		{
+			m_rtMaterialStats[m].NumHits = m_iMaterialOffsets[m + 1] - m_iMaterialOffsets[m];
+			m_rtMaterialStats[m].Seconds = 0.0;
+		}
+		for (uint64_t iBatch = 0; iBatch < rtBatches.size(); iBatch++)
+		{
+			m_rtMaterialStats[rtBatches[iBatch].y].Seconds += dBatchSeconds[iBatch];
+		}
+
+		//trace the shadow rays and add the light of the visible ones (CS_ResolveShadowRays.hlsl), every shadow ray belongs to another pixel slot
+		if (m_rtInfoData.NumLights > 0)
+		{
+			if (!(m_rtTraceShadowRays->Render(rtBVH, iSkipLinks, rtWideBVH, rtTriangles, m_rtShadowRays.data(), m_iNumQueuedRays))) return false;
+			Core::ParallelFor(m_iNumQueuedRays, 4096, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+			{
+				for (uint64_t i = iBegin; i < iEnd; i++)
+				{
+					const Math::float4& rtLight = m_rtShadowLight[i];
+					if (m_rtTraceShadowRays->IsVisible((uint32_t)i) && ((rtLight.x > 0.0f) || (rtLight.y > 0.0f) || (rtLight.z > 0.0f)))
+					{
+						m_rtBuffers->EmittedLight[Math::asuint(rtLight.w)] += Math::float4(rtLight.xyz(), 0.0f);
+					}
+				}
+			});
+		}
+
+		//the paths, which were terminated by the russian roulette, leave the queue right away (CS_TraceRays.hlsl drops them at the next bounce), so an empty queue ends the pass
+		if (m_rtInfoData.Bounce + 1 >= m_rtInfoData.RussianRouletteDepth)
+		{
+			Core::ParallelFor(m_iNumQueuedRays, 4096, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+			{
+				for (uint64_t i = iBegin; i < iEnd; i++)
+				{
+					m_iSurvivors[i] = (m_rtBuffers->Rays[m_iRayQueue[i]].TMax >= 0.0f) ? 1 : 0;
+				}
+			});
+			m_iNumQueuedRays = Core::CompactRayQueue(m_iRayQueue.data(), m_iSurvivors.data(), m_iNumQueuedRays, m_iNextRayQueue.data());
+			m_iRayQueue.swap(m_iNextRayQueue);
+		}
+		if (bLastTile && (bLastBounce || (m_iNumQueuedRays == 0))) m_rtInfoData.SampleIndex++; // the next camera rays are the next samples of the pixels
+
+		return true;
+	}
+
+
+	void TraceRays::Release()
+	{
+		//the ray tracer owns the mesh data, like the gpu path does after uploading it (the arrays of a scene cache are freed with the cache)
+		if (!(m_rtMesh.Cache))
+		{
+			delete[] m_rtMesh.Indices;
+			delete[] m_rtMesh.Vertices;
+			delete[] m_rtMesh.Materials;
+		}
+		delete[] m_rtMesh.TextureNames;
+		m_rtMesh = MeshInfo{};
+
+		if (m_rtTextures)
+		{
+			delete m_rtTextures;
+			m_rtTextures = nullptr;
+		}
+
+		if (m_rtThreadPool)
+		{
+			delete m_rtThreadPool;
+			m_rtThreadPool = nullptr;
+		}
+
+		if (m_rtTraceShadowRays)
+		{
+			delete m_rtTraceShadowRays;
+			m_rtTraceShadowRays = nullptr;
+		}
+	}
+
+
+
+	//the occlusion query class
+	//class constructor
+	TraceOcclusionRays::TraceOcclusionRays() :
+		//initialize the class variables
+		m_iNumTriangles(0),
+		m_iMaxRays(0),
+		m_iVisibility()
+	{
+
+	}
+
+	//destructor: uninitializes all our pointers
+	TraceOcclusionRays::~TraceOcclusionRays()
+	{
+
+	}
+
+
+
+	//private class functions
+	//the any-hit query of a single ray, this is the body of CS_TraceOcclusionRays.hlsl: the traversal stops at the first hit between TMin and TMax
+	//and there is no hit index, material or shading work
+	bool TraceOcclusionRays::IsOccluded(const Ray& rtRay, const AABB* rtBVH, const uint32_t* iSkipLinks, const WideBVHNode* rtWideBVH,
+		const IntersectionTriangle* rtTriangles)
+	{
+		Math::float4 rtResult = Math::float4(rtRay.TMax, 0.0f, 0.0f, 0.0f);
+		Index iHitIndex = 0;
+
+		if (rtWideBVH) //use the wide BVH
+		{
+			TraverseWideBVH<true>(rtWideBVH, rtTriangles, rtRay, rtResult, iHitIndex);
+		}
+		else if (!rtBVH) //no use of BVH
+		{
+			for (uint32_t i = 0; (i < m_iNumTriangles) && (rtResult.x == rtRay.TMax); i++)
+			{
+				CheckIntersection(rtTriangles, rtRay, i, rtResult, iHitIndex);
+			}
+		}
+		else if (iSkipLinks) //use BVH without a stack
+		{
+			TraverseBVHStackless<true>(rtBVH, iSkipLinks, rtTriangles, rtRay, rtResult, iHitIndex);
+		}
+		else //use BVH
+		{
+			TraverseBVH<true>(rtBVH, rtTriangles, rtRay, rtResult, iHitIndex);
+		}
+
+		return rtResult.x != rtRay.TMax;
+	}
+
+
+
+	//public class functions
+	bool TraceOcclusionRays::Initialize(uint32_t iMaxRays, uint32_t iNumTriangles)
+	{
+		m_iNumTriangles = iNumTriangles;
+		m_iMaxRays = iMaxRays;
+		m_iVisibility.assign((iMaxRays + 31) / 32, 0);
+
+		return true;
+	}
+
+
+	//test a batch of rays for occlusion with the bvh of BuildBVH, the result is one bit per ray in the visibility mask
+	bool TraceOcclusionRays::Render(const std::vector<AABB>& rtBVH, const std::vector<uint32_t>& iSkipLinks, const std::vector<WideBVHNode>& rtWideBVH,
+		const std::vector<IntersectionTriangle>& rtTriangles, const Ray* rtRays, uint32_t iNumRays)
+	{
+		if (iNumRays > m_iMaxRays) return false;
+		if (rtTriangles.size() < m_iNumTriangles) return false;
+
+		const AABB* rtBVHData = rtBVH.empty() ? nullptr : rtBVH.data();
+		const uint32_t* iSkipLinkData = (iSkipLinks.size() == rtBVH.size()) && (!(iSkipLinks.empty())) ? iSkipLinks.data() : nullptr;
+		const WideBVHNode* rtWideBVHData = rtWideBVH.empty() ? nullptr : rtWideBVH.data();
+
+		//the threads work on whole uints of the mask (32 rays each), so they never write the same uint
+		Core::ParallelFor(((uint64_t)iNumRays + 31) / 32, 32, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t iWord = iBegin; iWord < iEnd; iWord++)
+			{
+				uint32_t iMask = 0;
+				uint32_t iFirstRay = (uint32_t)iWord * 32;
+				uint32_t iNumWordRays = std::min(iNumRays - iFirstRay, 32u);
+				for (uint32_t i = 0; i < iNumWordRays; i++)
+				{
+					if (!(IsOccluded(rtRays[iFirstRay + i], rtBVHData, iSkipLinkData, rtWideBVHData, rtTriangles.data()))) iMask |= 1u << i;
+				}
+				m_iVisibility[iWord] = iMask;
+			}
+		});
+
+		return true;
+	}
+
+
+
+	//the final image generation class
+	//class constructor
+	GenerateFinalImage::GenerateFinalImage() :
+		//initialize the class variables
+		m_rtBuffers(nullptr),
+		m_rtInfoData(),
+		m_rtTiles(),
+		m_iNumActiveTiles(0)
+	{
+
+	}
+
+	//destructor: uninitializes all our pointers
+	GenerateFinalImage::~GenerateFinalImage()
+	{
+
+	}
+
+
+
+	//public class functions
+	bool GenerateFinalImage::Initialize(RaytracerBuffers* rtBuffers, const RenderSettings& rtSettings)
+	{
+		if (!rtBuffers) return false;
+		m_rtBuffers = rtBuffers;
+		m_rtTiles = GetRenderTiles(rtSettings.Width, rtSettings.Height);
+
+		//store the info data
+		m_rtInfoData.ScreenDimensions.x = rtSettings.Width;
+		m_rtInfoData.ScreenDimensions.y = rtSettings.Height;
+		m_rtInfoData.MaxRaysPerPixel = MAX_RAYS_PER_PIXEL;
+		m_rtInfoData.NumSamples = 1;
+		m_rtInfoData.ErrorThreshold = rtSettings.AdaptiveErrorThreshold;
+		m_rtInfoData.MinSamples = rtSettings.AdaptiveMinSamples;
+		m_rtInfoData.TileOffset = Math::uint2(0, 0);
+		m_rtInfoData.TileSize = Math::uint2(m_rtTiles.TileWidth, m_rtTiles.TileHeight);
+		m_iNumActiveTiles = (uint32_t)rtBuffers->ConvergedTiles.size();
+
+		return true;
+	}
+
+
+	//accumulate the samples of the render tile iTile and generate the displayed image (CS_GenerateFinalImage.hlsl)
+	//every work item is one tile of the adaptive sampling, like the thread groups of the shader
+	bool GenerateFinalImage::Render(uint32_t iTile, bool bApplyResults)
+	{
+		if (iTile >= m_rtTiles.NumTiles) return false;
+
+		//update the info data (a sample is complete, when the last render tile was added)
+		if (bApplyResults)
+		{
+			m_rtInfoData.NumSamples |= 0x80000000;
+			if (iTile == m_rtTiles.NumTiles - 1) m_rtInfoData.NumSamples++;
+		}
+		else
+		{
+			m_rtInfoData.NumSamples &= 0x7fffffff;
+		}
+		m_rtInfoData.TileOffset = GetRenderTileOffset(m_rtTiles, iTile);
+
+		const GenerateFinalImageInfo& rtInfo = m_rtInfoData;
+		RaytracerBuffers* rtBuffers = m_rtBuffers;
+		bool bApply = ((rtInfo.NumSamples & 0x80000000) > 0);
+		uint32_t iWidth = (uint32_t)rtInfo.ScreenDimensions.x;
+		uint32_t iHeight = (uint32_t)rtInfo.ScreenDimensions.y;
+		uint32_t iNumTilesX = (iWidth + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE;
+
+		//the tiles of the adaptive sampling, which are covered by the render tile
+		uint32_t iTileWidth = std::min(rtInfo.TileSize.x, iWidth - rtInfo.TileOffset.x);
+		uint32_t iTileHeight = std::min(rtInfo.TileSize.y, iHeight - rtInfo.TileOffset.y);
+		uint32_t iNumRenderTilesX = (iTileWidth + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE;
+		uint32_t iNumRenderTilesY = (iTileHeight + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE;
+		Core::ParallelFor((uint64_t)iNumRenderTilesX * iNumRenderTilesY, 1, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t iGroupIndex = iBegin; iGroupIndex < iEnd; iGroupIndex++)
+			{
+				uint32_t iTileX = rtInfo.TileOffset.x + (uint32_t)(iGroupIndex % iNumRenderTilesX) * ADAPTIVE_TILE_SIZE;
+				uint32_t iTileY = rtInfo.TileOffset.y + (uint32_t)(iGroupIndex / iNumRenderTilesX) * ADAPTIVE_TILE_SIZE;
+				uint32_t iTileIndex = (iTileY / ADAPTIVE_TILE_SIZE) * iNumTilesX + iTileX / ADAPTIVE_TILE_SIZE;
+				bool bConverged = (rtBuffers->ConvergedTiles[iTileIndex] != 0); // a converged tile didn't get camera rays in this pass
+				uint32_t iActivePixels = 0; // the pixels of this tile, which need more samples
+				for (uint32_t y = iTileY; y < std::min(iTileY + ADAPTIVE_TILE_SIZE, iHeight); y++)
+				{
+					for (uint32_t x = iTileX; x < std::min(iTileX + ADAPTIVE_TILE_SIZE, iWidth); x++)
+					{
+						uint64_t iResultBufferIndex = (uint64_t)y * iWidth + x;
+						Math::float4 rtTotalColor = rtBuffers->ResultBuffer[iResultBufferIndex];
+						Math::float4 rtMoments = rtBuffers->SampleMoments[iResultBufferIndex];
+						Math::float4 rtDisplayedColor = rtTotalColor;
+
+						if (!bConverged)
+						{
+							//add up all results that contribute to this pixel (its ray slots are at its position in the render tile)
+							Math::float4 rtNewColor = Math::float4(0.0f);
+							uint64_t iIndex = ((uint64_t)(y - rtInfo.TileOffset.y) * rtInfo.TileSize.x + (x - rtInfo.TileOffset.x)) * rtInfo.MaxRaysPerPixel;
+							for (uint32_t i = 0; i < rtInfo.MaxRaysPerPixel; i++)
+							{
+								rtNewColor += rtBuffers->EmittedLight[iIndex + i];
+							}
+
+							//average with the new color, every pixel counts its own samples
+							rtNewColor /= (float)rtInfo.MaxRaysPerPixel;
+							float fInverseNumSamples = Math::rcp(rtMoments.x + 1.0f);
+							rtDisplayedColor = (rtMoments.x * fInverseNumSamples) * rtTotalColor + fInverseNumSamples * rtNewColor;
+							if (bApply)
+							{
+								rtTotalColor = rtDisplayedColor;
+								rtMoments = AddSample(rtMoments, rtNewColor.xyz());
+								if (NeedsMoreSamples(rtMoments, rtInfo.ErrorThreshold, rtInfo.MinSamples)) iActivePixels++;
+							}
+						}
+
+						rtBuffers->OutputTexture[iResultBufferIndex] = rtDisplayedColor / (1.0f + rtDisplayedColor); // basic tone mapping
+						rtBuffers->ResultBuffer[iResultBufferIndex] = rtTotalColor;
+						rtBuffers->SampleMoments[iResultBufferIndex] = rtMoments;
+					}
+				}
+
+				//the camera rays of the next pass skip the tile, once all its pixels are converged
+				if (bApply && (!bConverged))
+				{
+					rtBuffers->ConvergedTiles[iTileIndex] = (iActivePixels == 0) ? 1 : 0;
+				}
+			}
+		});
+
+		if (bApply)
+		{
+			m_iNumActiveTiles = (uint32_t)std::count(rtBuffers->ConvergedTiles.begin(), rtBuffers->ConvergedTiles.end(), 0u);
+		}
+
+		return true;
+	}
+
+
+
+	//the raytracer pipeline class
+	//class constructor
+	RaytracerPipeline::RaytracerPipeline() :
+		//initialize the class variables
+		m_rtBuffers(nullptr),
+		m_rtCameraRayGen(nullptr),
+		m_rtSortPrimitives(nullptr),
+		m_rtBuildBVH(nullptr),
+		m_rtTraceRays(nullptr),
+		m_rtImageGeneration(nullptr),
+		m_rtMeshData(),
+		m_rtSettings(),
+		m_rtTiles(),
+		m_rtMaterialStats(),
+		m_rtBounceStats(),
+		m_bBuildBVH(true),
+		m_iIteration(0),
+		m_iTile(0)
+	{
+
+	}
+
+	//destructor: uninitializes all our pointers
+	RaytracerPipeline::~RaytracerPipeline()
+	{
+
+	}
+
+
+
+	//public class functions
+	bool RaytracerPipeline::Initialize(MeshInfo rtMeshData, const RenderSettings& rtSettings)
+	{
+		if ((!(rtMeshData.Indices)) || (!(rtMeshData.Vertices))) return false;
+		if ((rtSettings.Width == 0) || (rtSettings.Height == 0) || (rtSettings.Width > 0xffff) || (rtSettings.Height > 0xffff)) return false; // the ray pixels store 16 bit coordinates
+		if ((rtSettings.MaxRayDepth == 0) || (rtSettings.Sampler > SAMPLER_BLUE_NOISE_SOBOL)) return false;
+		m_rtMeshData = rtMeshData;
+		m_rtSettings = rtSettings;
+		m_rtTiles = GetRenderTiles(rtSettings.Width, rtSettings.Height);
+		m_rtBounceStats.assign(rtSettings.MaxRayDepth, BounceStats{});
+		uint64_t iNumPixels = (uint64_t)rtSettings.Width * rtSettings.Height;
+
+		//create the buffers, which are shared between all stages (zero initialized, like the gpu buffers)
+		m_rtBuffers = new RaytracerBuffers();
+		if (!m_rtBuffers) return false;
+		m_rtBuffers->Rays.resize(m_rtTiles.MaxRays, Ray{});
+		m_rtBuffers->OldRays.resize(m_rtTiles.MaxRays, Ray{});
+		m_rtBuffers->RayPixels.resize(m_rtTiles.MaxRays, 0);
+		m_rtBuffers->ScatteredLight.resize(m_rtTiles.MaxRays);
+		m_rtBuffers->EmittedLight.resize(m_rtTiles.MaxRays);
+		m_rtBuffers->ResultBuffer.resize(iNumPixels);
+		m_rtBuffers->OutputTexture.resize(iNumPixels);
+		m_rtBuffers->SampleMoments.resize(iNumPixels);
+		m_rtBuffers->ConvergedTiles.resize(((rtSettings.Width + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE) *
+			((rtSettings.Height + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE), 0);
+
+		m_rtCameraRayGen = new CameraRayGen();
+		if (!(m_rtCameraRayGen->Initialize(m_rtBuffers, rtSettings))) return false;
+
+		m_rtSortPrimitives = new SortPrimitives();
+		if (!(m_rtSortPrimitives->Initialize((uint32_t)(rtMeshData.IndexCount / 3), rtMeshData.SceneAABB))) return false;
+
+		m_rtBuildBVH = new BuildBVH();
+		if (!(m_rtBuildBVH->Initialize((uint32_t)(rtMeshData.IndexCount / 3), rtSettings))) return false;
+
+		m_rtTraceRays = new TraceRays();
+		if (!(m_rtTraceRays->Initialize(m_rtBuffers, rtMeshData, rtSettings))) return false;
+
+		m_rtImageGeneration = new GenerateFinalImage();
+		if (!(m_rtImageGeneration->Initialize(m_rtBuffers, rtSettings))) return false;
+
+		return true;
+	}
+
+
+	//render a single iteration, the same order of stages as the gpu pipeline
+	bool RaytracerPipeline::Render()
+	{
+		//building the bvh and the triangle stream (only once)
+		if (m_bBuildBVH)
+		{
+			if (!(m_rtSettings.UseBVH))
+			{
+				if (!(m_rtBuildBVH->BuildTriangles(m_rtMeshData))) return false;
+			}
+			else if (m_rtSettings.UseSAHBVH)
+			{
+				if (!(m_rtBuildBVH->BuildSAH(m_rtMeshData))) return false;
+			}
+			else
+			{
+				if (!(m_rtSortPrimitives->Sort(m_rtMeshData))) return false;
+				if (!(m_rtBuildBVH->Build(m_rtMeshData, m_rtSortPrimitives->GetMortonCodes()))) return false;
+			}
+			m_bBuildBVH = false;
+		}
+
+		//camera ray generation
+		//only generate rays from the camera on the first iteration, every pass renders one tile of the image
+		if (m_iIteration == 0)
+		{
+			if (!(m_rtCameraRayGen->Render(m_iTile))) return false;
+		}
+
+		//if we reached the maximum number of iterations, we start again from the camera
+		bool bNewRays = (m_iIteration == 0);
+		uint32_t iBounce = m_iIteration;
+		m_iIteration++;
+		if (m_iIteration == m_rtSettings.MaxRayDepth) m_iIteration = 0;
+		bool bLastBounce = (m_iIteration == 0);
+
+		//the ray tracing of the live rays (without a bvh, both bvhs are empty)
+		if (!(m_rtTraceRays->Render(m_rtBuildBVH->GetBVH(), m_rtBuildBVH->GetSkipLinks(), m_rtBuildBVH->GetWideBVH(), m_rtBuildBVH->GetTriangles(),
+			bNewRays, bLastBounce, m_iTile == m_rtTiles.NumTiles - 1))) return false;
+
+		//sum up the shading work of the material queues
+		const std::vector<MaterialShadingStats>& rtMaterialStats = m_rtTraceRays->GetMaterialStats();
+		m_rtMaterialStats.resize(rtMaterialStats.size(), MaterialShadingStats{});
+		for (uint64_t i = 0; i < rtMaterialStats.size(); i++)
+		{
+			m_rtMaterialStats[i].NumHits += rtMaterialStats[i].NumHits;
+			m_rtMaterialStats[i].Seconds += rtMaterialStats[i].Seconds;
+		}
+
+		//and the scheduling of the intersection per bounce
+		const BounceStats& rtIntersectionStats = m_rtTraceRays->GetIntersectionStats();
+		m_rtBounceStats[iBounce].NumRays += rtIntersectionStats.NumRays;
+		m_rtBounceStats[iBounce].Seconds += rtIntersectionStats.Seconds;
+		m_rtBounceStats[iBounce].TailSeconds += rtIntersectionStats.TailSeconds;
+		m_rtBounceStats[iBounce].IdleSeconds += rtIntersectionStats.IdleSeconds;
+		m_rtBounceStats[iBounce].NumSteals += rtIntersectionStats.NumSteals;
+
+		//the pass ends early, when all paths missed or were terminated, so the next camera rays start right away instead of tracing empty bounces
+		if (m_rtTraceRays->GetNumQueuedRays() == 0) m_iIteration = 0;
+
+		//the pass to generate the final image, the next pass continues with the next tile
+		if (!(m_rtImageGeneration->Render(m_iTile, m_iIteration == 0))) return false;
+		if (m_iIteration == 0) m_iTile = (m_iTile + 1) % m_rtTiles.NumTiles;
+
+		return true;
+	}
+
+
+	//write the last generated image to a file (the linear colors for hdr files and the tone mapped colors for all others)
+	bool RaytracerPipeline::SaveImage(const std::string& sFileName)
+	{
+		if (!m_rtBuffers) return false;
+		const std::vector<Math::float4>& rtPixels = Core::IsHDRImageFile(sFileName) ? m_rtBuffers->ResultBuffer : m_rtBuffers->OutputTexture;
+		return Core::SaveImage(sFileName, m_rtSettings.Width, m_rtSettings.Height, rtPixels.data());
+	}
+
+
+	//the bytes of the buffers, which are shared between the stages, and of the acceleration structure (after the first iteration)
+	uint64_t RaytracerPipeline::GetMemoryFootprint()
+	{
+		auto fnBytes = [](const auto& stdVector) { return (uint64_t)stdVector.capacity() * sizeof(stdVector[0]); };
+		uint64_t iBytes = 0;
+		if (m_rtBuffers)
+		{
+			iBytes += fnBytes(m_rtBuffers->Rays) + fnBytes(m_rtBuffers->OldRays) + fnBytes(m_rtBuffers->RayPixels);
+			iBytes += fnBytes(m_rtBuffers->ScatteredLight) + fnBytes(m_rtBuffers->EmittedLight);
+			iBytes += fnBytes(m_rtBuffers->ResultBuffer) + fnBytes(m_rtBuffers->OutputTexture);
+			iBytes += fnBytes(m_rtBuffers->SampleMoments) + fnBytes(m_rtBuffers->ConvergedTiles);
+		}
+		if (m_rtBuildBVH)
+		{
+			iBytes += fnBytes(m_rtBuildBVH->GetBVH()) + fnBytes(m_rtBuildBVH->GetWideBVH());
+			iBytes += fnBytes(m_rtBuildBVH->GetTriangles()) + fnBytes(m_rtBuildBVH->GetSkipLinks());
+		}
+		return iBytes;
+	}
+
+
+	void RaytracerPipeline::Release()
+	{
+		if (m_rtTraceRays)
+		{
+			m_rtTraceRays->Release();
+			delete m_rtTraceRays;
+			m_rtTraceRays = nullptr;
+		}
+		m_rtMeshData = MeshInfo{};
+
+		delete m_rtCameraRayGen;
+		delete m_rtSortPrimitives;
+		delete m_rtBuildBVH;
+		delete m_rtImageGeneration;
+		delete m_rtBuffers;
+		m_rtCameraRayGen = nullptr;
+		m_rtSortPrimitives = nullptr;
+		m_rtBuildBVH = nullptr;
+		m_rtImageGeneration = nullptr;
+		m_rtBuffers = nullptr;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,430 @@
+#pragma once
+
+#include <random>
+#include <vector>
+#include <string>
+
+#include "Settings.h"
+#include "DefaultSettings.h"
+#include "Core/Math.h"
+#include "Core/MeshLoader.h"
+#include "Core/BVH.h"
+#include "Core/WideBVH.h"
+#include "Core/Intersection.h"
+#include "Core/Textures.h"
+#include "Core/SceneCache.h"
+#include "Core/Lights.h"
+#include "Core/ThreadPool.h"
+#include "Core/RaytracerBackend.h"
+
+
+
+//the cpu backend: mirrors the compute shaders of the d3d12 pipeline stage by stage, so a frame can be rendered without any gpu
+namespace RT::GraphicsAPI::CPU
+{
+	//global constants (the same values as in RaytracerPipeline.h), the other properties of Settings.h are read at runtime (see Core::RenderSettings)
+	const unsigned int MAX_RAYS_PER_PIXEL = RT_MAX_RAYS_PER_PIXEL;
+	const unsigned int RENDER_TILE_SIZE = RT_RENDER_TILE_SIZE;
+	const uint32_t BVH_WIDTH = RT_BVH_WIDTH; // the width of the SAH bvh, which is collapsed, if it is wider than 2, the morton code bvh stays binary
+	const uint32_t WIDE_BVH_WIDTH = (RT_BVH_WIDTH == 4) ? 4 : 8;
+	const uint32_t RAY_BATCH_SIZE = 64; // the number of rays, which a thread of the thread pool fetches at once
+	const float SHADOW_RAY_EPSILON = 1e-3f; // the shadow rays end a bit before the light, so they don't hit the sampled triangle itself (as in CS_ShadeHits.hlsl)
+
+	static_assert((RT_BVH_WIDTH == 2) || (RT_BVH_WIDTH == 4) || (RT_BVH_WIDTH == 8), "RT_BVH_WIDTH has to be 2, 4 or 8");
+	static_assert((RT_SAMPLER >= 0) && (RT_SAMPLER <= 2), "RT_SAMPLER has to be 0, 1 or 2");
+	static_assert((RT_RENDER_TILE_SIZE % 16) == 0, "RT_RENDER_TILE_SIZE has to be a multiple of 16 (the tiles of the adaptive sampling)");
+
+
+	using Core::Ray;
+	using Core::RenderSettings;
+	using Core::GetDefaultRenderSettings;
+	using Core::TextureAtlasData;
+	typedef Core::WideBVHNode<WIDE_BVH_WIDTH> WideBVHNode;
+
+
+	//the render tiles of an image, the cpu raytracer chooses the resolution at runtime
+	struct RenderTiles
+	{
+		uint32_t TileWidth;
+		uint32_t TileHeight;
+		uint32_t NumTilesX;
+		uint32_t NumTiles;
+		uint32_t MaxRays; // the ray slots of one render tile, which are reused for every tile
+	};
+
+	inline RenderTiles GetRenderTiles(uint32_t iWidth, uint32_t iHeight)
+	{
+		RenderTiles rtTiles{};
+		rtTiles.TileWidth = ((RENDER_TILE_SIZE == 0) || (RENDER_TILE_SIZE > iWidth)) ? iWidth : RENDER_TILE_SIZE;
+		rtTiles.TileHeight = ((RENDER_TILE_SIZE == 0) || (RENDER_TILE_SIZE > iHeight)) ? iHeight : RENDER_TILE_SIZE;
+		rtTiles.NumTilesX = (iWidth + rtTiles.TileWidth - 1) / rtTiles.TileWidth;
+		rtTiles.NumTiles = rtTiles.NumTilesX * ((iHeight + rtTiles.TileHeight - 1) / rtTiles.TileHeight);
+		rtTiles.MaxRays = rtTiles.TileWidth * rtTiles.TileHeight * MAX_RAYS_PER_PIXEL;
+		return rtTiles;
+	}
+
+	//the first pixel of a render tile, the tiles are rendered row by row
+	inline Math::uint2 GetRenderTileOffset(const RenderTiles& rtTiles, uint32_t iTile)
+	{
+		return Math::uint2((iTile % rtTiles.NumTilesX) * rtTiles.TileWidth, (iTile / rtTiles.NumTilesX) * rtTiles.TileHeight);
+	}
+
+
+	//the cpu counterpart of the uav descriptor heap: the buffers, which are shared between the stages
+	struct RaytracerBuffers
+	{
+		std::vector<Ray> Rays; // the ray slots of a pixel are at its position in the current render tile
+		std::vector<Ray> OldRays; // here, TMin represents the t value in R = t * Direction + Origin, TMax is the Index of the ray in the pixel
+		std::vector<uint32_t> RayPixels; // (x << 16) | y, the same packing as the shaders use
+		std::vector<Math::float4> ScatteredLight; // indexed by the ray slot
+		std::vector<Math::float4> EmittedLight;
+		std::vector<Math::float4> ResultBuffer;
+		std::vector<Math::float4> OutputTexture;
+		std::vector<Math::float4> SampleMoments; // the moments of the luminance of every pixel (see Core/AdaptiveSampling.h)
+		std::vector<uint32_t> ConvergedTiles; // 1 for every tile of ADAPTIVE_TILE_SIZE^2 pixels, which doesn't get new camera rays anymore
+	};
+
+
+	//the camera ray generation modules
+	struct CameraRayGenInfo
+	{
+		Math::float4x4 InverseView;
+		Math::float4x4 InverseProjection;
+		Math::int2 ScreenSize;
+		float AASampleSpread;
+		float DOFSampleSpread;
+		uint32_t MaxRaysPerPixel;
+		Math::uint3 RNGSeed;
+		Math::uint2 TileOffset; // the first pixel of the current render tile
+		Math::uint2 TileSize; // the size of every render tile, the ray slots are ordered by the position of their pixel in the tile
+		uint32_t SampleIndex; // the number of camera passes before this one, ray i of a pixel is the sample SampleIndex * MaxRaysPerPixel + i of the pixel
+		uint32_t ImageSeed; // the seed of the settings, it scrambles the sobol points and moves the blue noise mask
+	};
+
+
+	class CameraRayGen
+	{
+	private:
+
+		//private member variables
+		RaytracerBuffers* m_rtBuffers;
+		CameraRayGenInfo m_rtInfoData;
+		RenderTiles m_rtTiles;
+		uint32_t m_iSampler; // the kind of sampler (see Core/Sampler.h)
+		std::mt19937 m_stdPRNG;
+
+
+	public: // = usable outside of the class
+
+		//constructor and destructor
+		CameraRayGen();
+		~CameraRayGen();
+
+
+		//public class functions
+		bool Initialize(RaytracerBuffers* rtBuffers, const RenderSettings& rtSettings);
+		bool Render(uint32_t iTile);
+
+	};
+
+
+	//the sorting modules
+	struct MortonCodeInfo
+	{
+		Math::float4 SceneMin;
+		Math::float4 SceneMax;
+		uint32_t NumPrimitives;
+	};
+
+	class SortPrimitives
+	{
+	private:
+
+		//private member variables
+		MortonCodeInfo m_rtMortonCodeInfoData;
+		std::vector<Math::uint2> m_rtMortonCodes; // x: the morton code, y: the index of the first vertex index of the triangle
+		std::vector<Math::uint2> m_rtTempMortonCodes;
+
+
+	public: // = usable outside of the class
+
+		//constructor and destructor
+		SortPrimitives();
+		~SortPrimitives();
+
+
+		//public class functions
+		bool Initialize(uint32_t iNumPrimitives, AABB rtSceneAABB);
+		bool Sort(const MeshInfo& rtMesh);
+
+
+		//helper functions
+		const std::vector<Math::uint2>& GetMortonCodes() { return m_rtMortonCodes; };
+
+	};
+
+
+	//the BVH building
+	class BuildBVH
+	{
+	private:
+
+		//private member variables
+		uint32_t m_iNumPrimitives;
+		std::vector<AABB> m_rtBVH;
+		std::vector<WideBVHNode> m_rtWideBVH; // replaces m_rtBVH, if the SAH bvh is wider than 2
+		std::vector<IntersectionTriangle> m_rtTriangles; // in the order of the bvh leaves
+		std::vector<uint32_t> m_iSkipLinks; // one per node of m_rtBVH, if the stackless traversal is used
+		bool m_bUseStacklessBVH;
+
+
+	public: // = usable outside of the class
+
+		//constructor and destructor
+		BuildBVH();
+		~BuildBVH();
+
+
+		//public class functions
+		bool Initialize(uint32_t iNumPrimitives, const RenderSettings& rtSettings);
+		bool Build(const MeshInfo& rtMesh, const std::vector<Math::uint2>& rtMortonCodes);
+		bool BuildSAH(const MeshInfo& rtMesh);
+		bool BuildTriangles(const MeshInfo& rtMesh);
+
+
+		//helper functions
+		const std::vector<AABB>& GetBVH() { return m_rtBVH; };
+		const std::vector<WideBVHNode>& GetWideBVH() { return m_rtWideBVH; };
+		const std::vector<IntersectionTriangle>& GetTriangles() { return m_rtTriangles; };
+		const std::vector<uint32_t>& GetSkipLinks() { return m_iSkipLinks; };
+
+	};
+
+
+	//the ray tracing modules
+	struct TraceRaysInfo
+	{
+		Math::int2 ScreenDimensions;
+		uint32_t NumTriangles;
+		uint32_t NumRays;
+		uint32_t MaxRaysPerPixel;
+		Math::uint3 RNGSeed;
+		uint32_t NumLights;
+		float InverseLightPower;
+		uint32_t LastBounce;
+		uint32_t SampleIndex; // the number of camera passes before the current one
+		uint32_t Bounce; // 0 for the camera rays, selects the dimensions of the sampler
+		uint32_t RussianRouletteDepth; // the paths are terminated randomly from this number of rays on
+		uint32_t ImageSeed; // the seed of the settings, it scrambles the sobol points and moves the blue noise mask
+	};
+
+	//the closest hit of a ray, written by the intersection and read by the shading (the "RayHit" struct in TraceRays.hlsli)
+	struct RayHit
+	{
+		Math::float4 Result;
+		Index HitIndex;
+	};
+
+	//the work of one material queue in the last iteration
+	struct MaterialShadingStats
+	{
+		uint64_t NumHits;
+		double Seconds; // summed over all threads
+	};
+
+	//the scheduling of the intersection of one bounce
+	struct BounceStats
+	{
+		uint64_t NumRays;
+		double Seconds;
+		double TailSeconds; // from the first thread running out of rays until the last thread finished
+		double IdleSeconds; // summed over all threads
+		uint64_t NumSteals;
+	};
+
+	class TraceOcclusionRays;
+
+	class TraceRays
+	{
+	private:
+
+		//private member variables
+		RaytracerBuffers* m_rtBuffers;
+		MeshInfo m_rtMesh;
+		TextureAtlasData* m_rtTextures;
+		TraceRaysInfo m_rtInfoData;
+		RenderSettings m_rtSettings; // the sampler, the persistent threads and the ray binning
+		std::mt19937 m_stdPRNG;
+		std::vector<uint32_t> m_iRayQueue; // the indices of the live rays, only the first m_iNumQueuedRays entries are used
+		std::vector<uint32_t> m_iNextRayQueue;
+		std::vector<uint8_t> m_iSurvivors; // 1 for every queue entry, whose ray hit something and continues with the next bounce
+		uint32_t m_iNumQueuedRays;
+		std::vector<RayHit> m_rtHits; // indexed by the ray
+		std::vector<uint32_t> m_iHitMaterials; // the material queue of the hit of every ray
+		std::vector<uint32_t> m_iShadingQueue; // the rays of m_iRayQueue sorted by the material of their hit
+		std::vector<uint32_t> m_iMaterialOffsets; // the first entry of every material in m_iShadingQueue, followed by the number of hits
+		std::vector<MaterialShadingStats> m_rtMaterialStats;
+		uint32_t m_iNumMaterials;
+		std::vector<Math::uint2> m_rtRayBins; // x: the bin key, y: the ray
+		std::vector<Math::uint2> m_rtTempRayBins;
+		Core::ThreadPool* m_rtThreadPool;
+		BounceStats m_rtIntersectionStats;
+		std::vector<Ray> m_rtShadowRays; // the shadow ray of every entry of the shading queue, TMax is negative without one
+		std::vector<Math::float4> m_rtShadowLight; // the light, which a shadow ray adds to the pixel slot asuint(w), if it isn't occluded
+		TraceOcclusionRays* m_rtTraceShadowRays;
+
+
+		//private functions
+		bool IntersectRay(uint32_t iRayIndex, const AABB* rtBVH, const uint32_t* iSkipLinks, const WideBVHNode* rtWideBVH, const IntersectionTriangle* rtTriangles);
+		void ShadeRay(uint32_t iQueueIndex);
+
+
+	public: // = usable outside of the class
+
+		//constructor and destructor
+		TraceRays();
+		~TraceRays();
+
+
+		//public class functions
+		bool Initialize(RaytracerBuffers* rtBuffers, MeshInfo rtMeshData, const RenderSettings& rtSettings);
+		bool Render(const std::vector<AABB>& rtBVH, const std::vector<uint32_t>& iSkipLinks, const std::vector<WideBVHNode>& rtWideBVH,
+			const std::vector<IntersectionTriangle>& rtTriangles, bool bNewRays, bool bLastBounce, bool bLastTile);
+		void Release();
+
+
+		//helper functions
+		uint32_t GetNumQueuedRays() { return m_iNumQueuedRays; };
+		const uint32_t* GetShadingQueue() { return m_iShadingQueue.data(); };
+		const uint32_t* GetMaterialOffsets() { return m_iMaterialOffsets.data(); };
+		const std::vector<MaterialShadingStats>& GetMaterialStats() { return m_rtMaterialStats; };
+		const BounceStats& GetIntersectionStats() { return m_rtIntersectionStats; };
+
+	};
+
+
+	//the occlusion queries for shadow and visibility rays
+	class TraceOcclusionRays
+	{
+	private:
+
+		//private member variables
+		uint32_t m_iNumTriangles;
+		uint32_t m_iMaxRays;
+		std::vector<uint32_t> m_iVisibility; // bit (i % 32) of the uint i / 32 is set, if nothing is hit between TMin and TMax of the ray i
+
+
+		//private functions
+		bool IsOccluded(const Ray& rtRay, const AABB* rtBVH, const uint32_t* iSkipLinks, const WideBVHNode* rtWideBVH, const IntersectionTriangle* rtTriangles);
+
+
+	public: // = usable outside of the class
+
+		//constructor and destructor
+		TraceOcclusionRays();
+		~TraceOcclusionRays();
+
+
+		//public class functions
+		bool Initialize(uint32_t iMaxRays, uint32_t iNumTriangles);
+		bool Render(const std::vector<AABB>& rtBVH, const std::vector<uint32_t>& iSkipLinks, const std::vector<WideBVHNode>& rtWideBVH,
+			const std::vector<IntersectionTriangle>& rtTriangles, const Ray* rtRays, uint32_t iNumRays);
+
+
+		//helper functions
+		const uint32_t* GetVisibility() { return m_iVisibility.data(); };
+		bool IsVisible(uint32_t iRayIndex) { return (m_iVisibility[iRayIndex / 32] >> (iRayIndex % 32)) & 1; };
+
+	};
+
+
+	//the final image generation
+	struct GenerateFinalImageInfo
+	{
+		Math::int2 ScreenDimensions;
+		uint32_t MaxRaysPerPixel;
+		uint32_t NumSamples; // the highest bit is set, if the samples of this pass are added to the result
+		float ErrorThreshold; // the adaptive sampling stops a tile, when the error of all its pixels is below this threshold (never at 0.0f)
+		uint32_t MinSamples;
+		Math::uint2 TileOffset; // the first pixel of the current render tile
+		Math::uint2 TileSize;
+	};
+
+	class GenerateFinalImage
+	{
+	private:
+
+		//private member variables
+		RaytracerBuffers* m_rtBuffers;
+		GenerateFinalImageInfo m_rtInfoData;
+		RenderTiles m_rtTiles;
+		uint32_t m_iNumActiveTiles; // the tiles, which still get camera rays
+
+
+	public: // = usable outside of the class
+
+		//constructor and destructor
+		GenerateFinalImage();
+		~GenerateFinalImage();
+
+
+		//public class functions
+		bool Initialize(RaytracerBuffers* rtBuffers, const RenderSettings& rtSettings);
+		bool Render(uint32_t iTile, bool bApplyResults = false);
+
+
+		//helper functions
+		uint32_t GetNumSamples() { return (m_rtInfoData.NumSamples & 0x7fffffff) - 1; };
+		uint32_t GetNumActiveTiles() { return m_iNumActiveTiles; };
+
+	};
+
+
+
+	//the raytracer pipeline, which combines all the classes from above
+	class RaytracerPipeline : public Core::RaytracerBackend
+	{
+	private:
+
+		//private member variables
+		RaytracerBuffers*	m_rtBuffers;
+		CameraRayGen*		m_rtCameraRayGen;
+		SortPrimitives*		m_rtSortPrimitives;
+		BuildBVH*			m_rtBuildBVH;
+		TraceRays*			m_rtTraceRays;
+		GenerateFinalImage*	m_rtImageGeneration;
+		MeshInfo			m_rtMeshData;
+		RenderSettings		m_rtSettings;
+		RenderTiles			m_rtTiles;
+		std::vector<MaterialShadingStats>	m_rtMaterialStats;
+		std::vector<BounceStats>			m_rtBounceStats;
+		bool				m_bBuildBVH;
+		unsigned int		m_iIteration;
+		unsigned int		m_iTile; // the render tile of the current pass
+
+
+	public: // = usable outside of the class
+
+		//constructor and destructor
+		RaytracerPipeline();
+		~RaytracerPipeline();
+
+
+		//public class functions
+		bool Initialize(MeshInfo rtMeshData, const RenderSettings& rtSettings = GetDefaultRenderSettings());
+		bool Render() override;
+		bool SaveImage(const std::string& sFileName); // the file type is chosen by the extension, .pfm and .exr store the linear colors, .ppm and .png the tone mapped ones
+		uint64_t GetMemoryFootprint(); // the bytes of the shared buffers and of the bvh
+		void Release();
+
+
+		//helper functions
+		uint32_t GetNumSamples() override { return m_rtImageGeneration ? m_rtImageGeneration->GetNumSamples() : 0; };
+		bool IsConverged() override { return m_rtImageGeneration && (m_rtImageGeneration->GetNumActiveTiles() == 0); };
+		uint32_t GetNumActiveTiles() { return m_rtImageGeneration ? m_rtImageGeneration->GetNumActiveTiles() : 0; };
+		const char* GetBackendName() override { return "CPU"; };
+		const std::vector<MaterialShadingStats>& GetMaterialStats() { return m_rtMaterialStats; }; // summed over all iterations
+		const std::vector<BounceStats>& GetBounceStats() { return m_rtBounceStats; }; // summed over all iterations, indexed by the bounce
+
+	};
+}
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <filesystem>
+
+#include "Settings.h"
+#include "CPU/CPURaytracer.h"
+#include "Core/Parallel.h"
+#include "Core/SceneCache.h"
+#include "Core/RenderSettings.h"
+
+
+
+//the options of a batch render, which aren't render settings
+struct BatchOptions
+{
+	std::string PNGFileName; // an additional tone mapped image, which isn't written if it's empty
+	bool PrintedUsage;
+};
+
+
+static void PrintUsage()
+{
+	std::cout << "Usage: RaytracerCPU [options]\n"
+		"  --config <file>             read the settings of an ini file (" << RT_SETTINGS_FILENAME << " is read first, if it exists)\n"
+		"  --set <name=value>          change a single setting, e.g. --set pathtracing.max_ray_depth=4 (see settings.example.ini for the names)\n"
+		"  --scene <file>              the scene to render (image.scene)\n"
+		"  --output <file>             the rendered image, .exr and .pfm store the linear colors, .png and .ppm the tone mapped ones (image.output)\n"
+		"  --png <file>                also write the tone mapped image as a png\n"
+		"  --width <pixels>            the width of the image (image.width)\n"
+		"  --height <pixels>           the height of the image (image.height)\n"
+		"  --spp <samples>             the samples per pixel (image.samples)\n"
+		"  --seconds <seconds>         the time limit, a render, which hits it, isn't reproducible (image.seconds)\n"
+		"  --seed <seed>               the seed of all random numbers, the same seed gives the same image (image.seed)\n"
+		"  --camera <px py pz fx fy fz> the position of the camera and the point it looks at (camera.position and camera.focus_point)\n"
+		"  --fov <radians>             the vertical field of view of the camera (camera.fov)\n"
+		"  --help                      print this message\n"
+		"The options are applied in their order, so a later option overrides an earlier one.\n";
+}
+
+//the options, which are shortcuts for a single setting
+static const char* GetSettingOfOption(const std::string& sOption)
+{
+	if (sOption == "--scene") return "image.scene";
+	if (sOption == "--output") return "image.output";
+	if (sOption == "--width") return "image.width";
+	if (sOption == "--height") return "image.height";
+	if (sOption == "--spp") return "image.samples";
+	if (sOption == "--seconds") return "image.seconds";
+	if (sOption == "--seed") return "image.seed";
+	if (sOption == "--fov") return "camera.fov";
+	return nullptr;
+}
+
+//returns false, if the arguments are invalid or the usage was printed
+static bool ParseArguments(int argc, char** argv, RT::Core::RenderSettings& rtSettings, BatchOptions& rtOptions)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string sOption = argv[i];
+		if (sOption == "--help")
+		{
+			PrintUsage();
+			rtOptions.PrintedUsage = true;
+			return false;
+		}
+
+		int iNumValues = (sOption == "--camera") ? 6 : 1;
+		if (i + iNumValues >= argc)
+		{
+			std::cout << "Missing value for " << sOption << "\n\n";
+			PrintUsage();
+			return false;
+		}
+
+		bool bValid = true;
+		const char* sSetting = GetSettingOfOption(sOption);
+		if (sSetting) bValid = RT::Core::SetRenderSetting(rtSettings, sSetting, argv[i + 1]);
+		else if (sOption == "--png") rtOptions.PNGFileName = argv[i + 1];
+		else if (sOption == "--config")
+		{
+			if (!(RT::Core::LoadRenderSettings(argv[i + 1], rtSettings))) return false;
+		}
+		else if (sOption == "--set")
+		{
+			std::string sAssignment = argv[i + 1];
+			size_t iEquals = sAssignment.find('=');
+			bValid = (iEquals != std::string::npos) && RT::Core::SetRenderSetting(rtSettings, sAssignment.substr(0, iEquals), sAssignment.substr(iEquals + 1));
+		}
+		else if (sOption == "--camera")
+		{
+			bValid = RT::Core::SetRenderSetting(rtSettings, "camera.position", std::string(argv[i + 1]) + " " + argv[i + 2] + " " + argv[i + 3]) &&
+				RT::Core::SetRenderSetting(rtSettings, "camera.focus_point", std::string(argv[i + 4]) + " " + argv[i + 5] + " " + argv[i + 6]);
+		}
+		else
+		{
+			std::cout << "Unknown option " << sOption << "\n\n";
+			PrintUsage();
+			return false;
+		}
+
+		if (!bValid)
+		{
+			std::cout << "Invalid value for " << sOption << "\n\n";
+			PrintUsage();
+			return false;
+		}
+		i += iNumValues;
+	}
+
+	return true;
+}
+
+
+
+//the headless entry point: renders the scene on the cpu and writes the image to disk, no window or gpu is needed
+//the settings are the values of Settings.h, which are overridden by the settings file and the arguments of a batch render (see PrintUsage)
+int main(int argc, char** argv)
+{
+	RT::Core::RenderSettings rtSettings = RT::Core::GetDefaultRenderSettings();
+	if (std::filesystem::exists(RT_SETTINGS_FILENAME))
+	{
+		if (!(RT::Core::LoadRenderSettings(RT_SETTINGS_FILENAME, rtSettings))) return 1;
+	}
+	BatchOptions rtOptions{};
+	if (!(ParseArguments(argc, argv, rtSettings, rtOptions))) return rtOptions.PrintedUsage ? 0 : 1;
+
+	RT::GraphicsAPI::CPU::RaytracerPipeline rtTracer = RT::GraphicsAPI::CPU::RaytracerPipeline();
+
+	//the initialization
+	RT::Core::MeshInfo rtScene = rtSettings.UseSceneCache ?
+		RT::Core::LoadScene(rtSettings.SceneFileName, (rtSettings.UseBVH && rtSettings.UseSAHBVH) ? RT::GraphicsAPI::CPU::BVH_WIDTH : 0) :
+		RT::GraphicsAPI::LoadMeshFromFile(rtSettings.SceneFileName);
+	if (!(rtTracer.Initialize(rtScene, rtSettings)))
+	{
+		std::cout << "An error occured during pipeline initialization\n";
+		rtTracer.Release();
+		return 1;
+	}
+	std::cout << "The cpu raytracer pipeline was initialized successfully (" << RT::Core::GetThreadCount() << " threads)\n\n";
+
+	//get a time point to measure the time, that passed since the start of the rendering
+	std::chrono::steady_clock stdClock;
+	auto stdStartTime = stdClock.now();
+	float fElapsedSeconds = 0.0f;
+
+	//the main loop: run until we have enough samples, exceeded the time limit or the adaptive sampling stopped all tiles
+	while ((rtTracer.GetNumSamples() < rtSettings.MaxSamples) && (fElapsedSeconds < rtSettings.MaxSeconds) && (!rtTracer.IsConverged()))
+	{
+		uint32_t iNumSamples = rtTracer.GetNumSamples();
+		if (!rtTracer.Render())
+		{
+			std::cout << "Error while rendering\n";
+			break;
+		}
+
+		auto stdCurrentTime = stdClock.now();
+		fElapsedSeconds = (float)(std::chrono::duration_cast<std::chrono::microseconds>(stdCurrentTime - stdStartTime)).count() * 0.000001f;
+		if (rtTracer.GetNumSamples() != iNumSamples)
+		{
+			std::cout << "\rSamples: " << rtTracer.GetNumSamples() << " / " << rtSettings.MaxSamples << " (" << fElapsedSeconds << " s, " <<
+				rtTracer.GetNumActiveTiles() << " active tiles)   " << std::flush;
+		}
+	}
+	std::cout << "\n\nThe raytracer successfully finished computing the image\n";
+
+	//the shading work of every material queue
+	const std::vector<RT::GraphicsAPI::CPU::MaterialShadingStats>& rtMaterialStats = rtTracer.GetMaterialStats();
+	std::cout << "\n" << std::setw(10) << "material" << std::setw(14) << "hits" << std::setw(14) << "time (ms)" << std::setw(14) << "Mhits/s" << "\n";
+	for (uint64_t i = 0; i < rtMaterialStats.size(); i++)
+	{
+		if (rtMaterialStats[i].NumHits == 0) continue;
+		std::cout << std::setw(10) << i << std::setw(14) << rtMaterialStats[i].NumHits << std::setw(14) << std::fixed << std::setprecision(2) <<
+			(rtMaterialStats[i].Seconds * 1000.0) << std::setw(14) << ((double)rtMaterialStats[i].NumHits / (rtMaterialStats[i].Seconds * 1e6)) << "\n";
+	}
+	std::cout << std::defaultfloat << "\n";
+
+	//the scheduling of the intersection of every bounce
+	const std::vector<RT::GraphicsAPI::CPU::BounceStats>& rtBounceStats = rtTracer.GetBounceStats();
+	std::cout << std::setw(10) << "bounce" << std::setw(14) << "rays" << std::setw(14) << "time (ms)" << std::setw(14) << "tail (ms)" <<
+		std::setw(14) << "idle (%)" << std::setw(14) << "steals" << "\n";
+	unsigned int iNumThreads = RT::Core::GetThreadCount();
+	for (uint64_t i = 0; i < rtBounceStats.size(); i++)
+	{
+		if (rtBounceStats[i].NumRays == 0) continue;
+		std::cout << std::setw(10) << i << std::setw(14) << rtBounceStats[i].NumRays << std::setw(14) << std::fixed << std::setprecision(2) <<
+			(rtBounceStats[i].Seconds * 1000.0) << std::setw(14) << (rtBounceStats[i].TailSeconds * 1000.0) << std::setw(14) <<
+			(100.0 * rtBounceStats[i].IdleSeconds / (rtBounceStats[i].Seconds * (double)iNumThreads)) << std::setw(14) << rtBounceStats[i].NumSteals << "\n";
+	}
+	std::cout << std::defaultfloat << "\n";
+
+	//write the result to disk (and the optional tone mapped png)
+	for (const std::string& sFileName : { rtSettings.OutputFileName, rtOptions.PNGFileName })
+	{
+		if (sFileName.empty()) continue;
+		if (!(rtTracer.SaveImage(sFileName)))
+		{
+			std::cout << "An error occured while writing " << sFileName << "\n";
+			rtTracer.Release();
+			return 1;
+		}
+		std::cout << "The image was written to " << sFileName << "\n";
+	}
+
+	rtTracer.Release();
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Core/Math.h"
+#include "Core/Lights.h"
+
+
+
+//the cpu port of AdaptiveSampling.hlsli, shared by the cpu backends
+namespace RT::Core
+{
+
+	//the pixels of a tile get new samples or stop together (a thread group of CS_GenerateFinalImage.hlsl and CS_CameraRayGeneration.hlsl)
+	const uint32_t ADAPTIVE_TILE_SIZE = 16;
+
+
+	//the moments of a pixel are updated with Welford's algorithm, one sample is the average of the rays of the pixel in one pass
+	//x: the number of samples, y: the mean luminance, z: the sum of the squared differences from the mean (M2), w: the error estimate of SampleError
+	//the standard error of the mean luminance, scaled by the slope of the tone mapping (x / (1 + x)), so the error is measured in the displayed image
+	inline float SampleError(const Math::float4& rtMoments)
+	{
+		if (rtMoments.x < 2.0f) return 1.0f; // a single sample doesn't have a variance, so it counts as the largest displayed error
+		float fVarianceOfMean = rtMoments.z / (rtMoments.x * (rtMoments.x - 1.0f));
+		float fToneMappingSlope = Math::rcp((1.0f + rtMoments.y) * (1.0f + rtMoments.y));
+		return std::sqrt(fVarianceOfMean) * fToneMappingSlope;
+	}
+
+	//add the luminance of a new sample to the moments of a pixel
+	inline Math::float4 AddSample(const Math::float4& rtMoments, const Math::float3& rtColor)
+	{
+		float fLuminance = Luminance(rtColor);
+		Math::float4 rtNewMoments = rtMoments;
+		rtNewMoments.x += 1.0f;
+		float fDelta = fLuminance - rtMoments.y;
+		rtNewMoments.y += fDelta / rtNewMoments.x;
+		rtNewMoments.z += fDelta * (fLuminance - rtNewMoments.y);
+		rtNewMoments.w = SampleError(rtNewMoments);
+		return rtNewMoments;
+	}
+
+	//a pixel needs more samples, until it has the minimum number of samples and its error is below the threshold (an error threshold of 0.0f never stops)
+	inline bool NeedsMoreSamples(const Math::float4& rtMoments, float fErrorThreshold, uint32_t iMinSamples)
+	{
+		return (rtMoments.x < (float)iMinSamples) || (rtMoments.w >= fErrorThreshold);
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,608 @@
+//include-files
+#include "BVH.h"
+#include "Parallel.h"
+#include "RadixSort.h"
+
+#include <atomic>
+#include <algorithm>
+
+
+
+namespace RT::Core
+{
+
+	//make following bitshifts: 0b00000111 --> 0b01001001
+	//based on https://pbr-book.org/3ed-2018/Primitives_and_Intersection_Acceleration/Bounding_Volume_Hierarchies
+	static inline uint32_t LeftShift3(uint32_t iInput)
+	{
+		iInput |= (iInput << 16) & 0x030000ff; // = 0b00000011000000000000000011111111
+		iInput |= (iInput << 8) & 0x0300f00f; // = 0b00000011000000001111000000001111
+		iInput |= (iInput << 4) & 0x030c30c3; // = 0b00000011000011000011000011000011
+		iInput |= (iInput << 2) & 0x09249249; // = 0b00001001001001001001001001001001
+
+		return iInput;
+	}
+
+
+	void GenerateMortonCodes(const MeshInfo& rtMesh, const AABB& rtSceneAABB, std::vector<Math::uint2>& rtMortonCodes)
+	{
+		const uint64_t iNumPrimitives = rtMesh.IndexCount / 3;
+		rtMortonCodes.resize(iNumPrimitives);
+
+		ParallelFor(iNumPrimitives, 4096, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			Math::float3 rtSceneExtent = rtSceneAABB.Max - rtSceneAABB.Min;
+
+			for (uint64_t i = iBegin; i < iEnd; i++)
+			{
+				//get the vertices
+				uint32_t iCurrentIndex = (uint32_t)i * 3;
+				const Math::float3& rtPosition1 = rtMesh.Vertices[rtMesh.Indices[iCurrentIndex]].Position;
+				const Math::float3& rtPosition2 = rtMesh.Vertices[rtMesh.Indices[iCurrentIndex + 1]].Position;
+				const Math::float3& rtPosition3 = rtMesh.Vertices[rtMesh.Indices[iCurrentIndex + 2]].Position;
+
+				//calculate and normalize the centroid of the vertices
+				Math::float3 rtCentroid = 0.333333f * (rtPosition1 + rtPosition2 + rtPosition3);
+				Math::float3 rtNormalizedCentroid = Math::saturate((rtCentroid - rtSceneAABB.Min) / rtSceneExtent) * 1023.0f;
+
+				//generate the morton code
+				uint32_t iMortonCode = (LeftShift3((uint32_t)rtNormalizedCentroid.z) << 2) | (LeftShift3((uint32_t)rtNormalizedCentroid.y) << 1) |
+					LeftShift3((uint32_t)rtNormalizedCentroid.x);
+				rtMortonCodes[i] = { iMortonCode, iCurrentIndex };
+			}
+		});
+	}
+
+
+	void SortMortonCodes(std::vector<Math::uint2>& rtMortonCodes, std::vector<Math::uint2>& rtTempMortonCodes)
+	{
+		RadixSortOnesweep(rtMortonCodes, rtTempMortonCodes);
+	}
+
+
+	bool BuildLBVH(const MeshInfo& rtMesh, const std::vector<Math::uint2>& rtMortonCodes, std::vector<AABB>& rtBVH)
+	{
+		const uint32_t iNumPrimitives = (uint32_t)(rtMesh.IndexCount / 3);
+		if (rtMortonCodes.size() < iNumPrimitives) return false;
+		rtBVH.assign(std::max<uint32_t>(iNumPrimitives * 4, 4), AABB{});
+		if (iNumPrimitives == 0) return true;
+
+		//building the leaves, every leaf contains up to two triangles
+		uint32_t iNumChildren = (iNumPrimitives + 1) / 2;
+		ParallelFor(iNumChildren, 4096, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t i = iBegin; i < iEnd; i++)
+			{
+				uint32_t iCurrentIndices[2];
+				iCurrentIndices[0] = rtMortonCodes[2 * i].y;
+				iCurrentIndices[1] = BVH_INVALID_INDEX;
+
+				uint32_t iIterations = 3;
+				if ((2 * i + 1) < iNumPrimitives)
+				{
+					iIterations = 6;
+					iCurrentIndices[1] = rtMortonCodes[2 * i + 1].y;
+				}
+
+				//get the minimum and maximum positions
+				Math::float3 rtMinimum = Math::float3(1e30f);
+				Math::float3 rtMaximum = Math::float3(-1e30f);
+				for (uint32_t j = 0; j < iIterations; j++)
+				{
+					const Math::float3& rtPosition = rtMesh.Vertices[rtMesh.Indices[iCurrentIndices[j / 3] + (j % 3)]].Position;
+					rtMinimum = Math::min(rtMinimum, rtPosition);
+					rtMaximum = Math::max(rtMaximum, rtPosition);
+				}
+
+				AABB& rtLeaf = rtBVH[i + 1];
+				rtLeaf.Min = rtMinimum;
+				rtLeaf.Max = rtMaximum;
+				rtLeaf.Padding.x = iCurrentIndices[0] | BVH_LEAF_FLAG;
+				rtLeaf.Padding.y = iCurrentIndices[1] | BVH_LEAF_FLAG;
+			}
+		});
+
+		//merge the nodes of the previous level pairwise
+		auto fnBuildLevel = [&](uint32_t iNumLevelChildren, uint32_t iPreviousIndex, uint32_t iCurrentIndex)
+		{
+			ParallelFor((iNumLevelChildren + 1) / 2, 4096, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+			{
+				for (uint64_t i = iBegin; i < iEnd; i++)
+				{
+					uint32_t iIndex1 = 2 * (uint32_t)i + iPreviousIndex;
+					uint32_t iIndex2 = iIndex1 + 1;
+					AABB rtAABB1 = rtBVH[iIndex1];
+					AABB rtAABB2 = rtAABB1;
+					if ((iIndex2 - iPreviousIndex) < iNumLevelChildren)
+					{
+						rtAABB2 = rtBVH[iIndex2];
+					}
+					else
+					{
+						iIndex2 = BVH_INVALID_INDEX;
+					}
+
+					rtAABB1.Min = Math::min(rtAABB1.Min, rtAABB2.Min);
+					rtAABB1.Max = Math::max(rtAABB1.Max, rtAABB2.Max);
+					rtAABB1.Padding.x = iIndex1;
+					rtAABB1.Padding.y = iIndex2;
+					rtBVH[iCurrentIndex + i] = rtAABB1;
+				}
+			});
+		};
+
+		//build the rest of the tree, level by level
+		uint32_t iPreviousIndex = 1;
+		uint32_t iCurrentIndex = iNumChildren + 1;
+		while (iNumChildren > 2)
+		{
+			fnBuildLevel(iNumChildren, iPreviousIndex, iCurrentIndex);
+			iNumChildren = (iNumChildren + 1) / 2;
+			iPreviousIndex = iCurrentIndex;
+			iCurrentIndex += iNumChildren;
+		}
+
+		//construct the trunk
+		fnBuildLevel(iNumChildren, iPreviousIndex, 0);
+
+		return true;
+	}
+
+
+
+	//the binned sah builder
+	const uint32_t SAH_BIN_COUNT = 16;
+	const uint64_t SAH_PARALLEL_SPLIT_THRESHOLD = 65536; // nodes with more primitives are split by all threads together
+
+	struct SAHBin
+	{
+		Math::float3 Min = Math::float3(1e30f);
+		Math::float3 Max = Math::float3(-1e30f);
+		uint32_t Count = 0;
+	};
+
+	//a node, which still has to be written to the bvh, and the range of primitives it contains
+	struct SAHBuildTask
+	{
+		uint32_t NodeIndex;
+		uint32_t Begin;
+		uint32_t End;
+		uint32_t Depth;
+	};
+
+	struct SAHBuildContext
+	{
+		std::vector<AABB> PrimitiveBounds;
+		std::vector<Math::float3> Centroids;
+		std::vector<uint32_t> Primitives; // the primitive indices, which get partitioned in place
+		std::vector<AABB>* BVH;
+		std::atomic<uint32_t> NextNodeIndex;
+	};
+
+
+	static inline float HalfSurfaceArea(const Math::float3& rtMin, const Math::float3& rtMax)
+	{
+		Math::float3 rtExtent = Math::max(rtMax - rtMin, Math::float3(0.0f));
+		return rtExtent.x * rtExtent.y + rtExtent.y * rtExtent.z + rtExtent.z * rtExtent.x;
+	}
+
+	static inline void GrowBin(SAHBin& rtBin, const AABB& rtBounds)
+	{
+		rtBin.Min = Math::min(rtBin.Min, rtBounds.Min);
+		rtBin.Max = Math::max(rtBin.Max, rtBounds.Max);
+		rtBin.Count++;
+	}
+
+	static inline void MergeBin(SAHBin& rtBin, const SAHBin& rtOther)
+	{
+		rtBin.Min = Math::min(rtBin.Min, rtOther.Min);
+		rtBin.Max = Math::max(rtBin.Max, rtOther.Max);
+		rtBin.Count += rtOther.Count;
+	}
+
+
+	//the bounds of the primitives (rtBounds) and of their centroids (rtCentroidBounds) in [iBegin, iEnd)
+	static void ComputeBounds(const SAHBuildContext& rtContext, uint32_t iBegin, uint32_t iEnd, bool bParallel, SAHBin& rtBounds, SAHBin& rtCentroidBounds)
+	{
+		auto fnComputeRange = [&](uint64_t iRangeBegin, uint64_t iRangeEnd, SAHBin& rtRangeBounds, SAHBin& rtRangeCentroidBounds)
+		{
+			for (uint64_t i = iRangeBegin; i < iRangeEnd; i++)
+			{
+				uint32_t iPrimitive = rtContext.Primitives[i];
+				GrowBin(rtRangeBounds, rtContext.PrimitiveBounds[iPrimitive]);
+				rtRangeCentroidBounds.Min = Math::min(rtRangeCentroidBounds.Min, rtContext.Centroids[iPrimitive]);
+				rtRangeCentroidBounds.Max = Math::max(rtRangeCentroidBounds.Max, rtContext.Centroids[iPrimitive]);
+			}
+		};
+
+		rtBounds = SAHBin();
+		rtCentroidBounds = SAHBin();
+		if (!bParallel)
+		{
+			fnComputeRange(iBegin, iEnd, rtBounds, rtCentroidBounds);
+			return;
+		}
+
+		std::vector<SAHBin> rtThreadBounds(GetThreadCount() * 2);
+		ParallelFor(iEnd - iBegin, 16384, [&](uint64_t iRangeBegin, uint64_t iRangeEnd, unsigned int iThreadIndex)
+		{
+			fnComputeRange(iBegin + iRangeBegin, iBegin + iRangeEnd, rtThreadBounds[2 * iThreadIndex], rtThreadBounds[2 * iThreadIndex + 1]);
+		});
+		for (size_t i = 0; i < rtThreadBounds.size(); i += 2)
+		{
+			MergeBin(rtBounds, rtThreadBounds[i]);
+			MergeBin(rtCentroidBounds, rtThreadBounds[i + 1]);
+		}
+	}
+
+
+	//sort the primitives into bins along all three axes and return the index of the first primitive of the right child (or iBegin if no split was found)
+	static uint32_t FindAndApplySAHSplit(SAHBuildContext& rtContext, uint32_t iBegin, uint32_t iEnd, bool bParallel, const SAHBin& rtCentroidBounds)
+	{
+		Math::float3 rtExtent = rtCentroidBounds.Max - rtCentroidBounds.Min;
+		Math::float3 rtScale = Math::float3(0.0f);
+		if (rtExtent.x > 0.0f) rtScale.x = (float)SAH_BIN_COUNT * 0.99999f / rtExtent.x;
+		if (rtExtent.y > 0.0f) rtScale.y = (float)SAH_BIN_COUNT * 0.99999f / rtExtent.y;
+		if (rtExtent.z > 0.0f) rtScale.z = (float)SAH_BIN_COUNT * 0.99999f / rtExtent.z;
+
+		auto fnBinIndex = [&](const Math::float3& rtCentroid, uint32_t iAxis)
+		{
+			const float* fCentroid = &(rtCentroid.x);
+			const float* fMin = &(rtCentroidBounds.Min.x);
+			const float* fScale = &(rtScale.x);
+			return std::min((uint32_t)((fCentroid[iAxis] - fMin[iAxis]) * fScale[iAxis]), SAH_BIN_COUNT - 1);
+		};
+
+		auto fnBinRange = [&](uint64_t iRangeBegin, uint64_t iRangeEnd, SAHBin* rtBins)
+		{
+			for (uint64_t i = iRangeBegin; i < iRangeEnd; i++)
+			{
+				uint32_t iPrimitive = rtContext.Primitives[i];
+				const Math::float3& rtCentroid = rtContext.Centroids[iPrimitive];
+				for (uint32_t iAxis = 0; iAxis < 3; iAxis++)
+				{
+					GrowBin(rtBins[iAxis * SAH_BIN_COUNT + fnBinIndex(rtCentroid, iAxis)], rtContext.PrimitiveBounds[iPrimitive]);
+				}
+			}
+		};
+
+		//fill the bins
+		SAHBin rtBins[3 * SAH_BIN_COUNT];
+		if (bParallel)
+		{
+			std::vector<SAHBin> rtThreadBins(GetThreadCount() * 3 * SAH_BIN_COUNT);
+			ParallelFor(iEnd - iBegin, 16384, [&](uint64_t iRangeBegin, uint64_t iRangeEnd, unsigned int iThreadIndex)
+			{
+				fnBinRange(iBegin + iRangeBegin, iBegin + iRangeEnd, &(rtThreadBins[iThreadIndex * 3 * SAH_BIN_COUNT]));
+			});
+			for (size_t i = 0; i < rtThreadBins.size(); i++)
+			{
+				MergeBin(rtBins[i % (3 * SAH_BIN_COUNT)], rtThreadBins[i]);
+			}
+		}
+		else
+		{
+			fnBinRange(iBegin, iEnd, rtBins);
+		}
+
+		//evaluate the cost of every split plane between two bins: area(left) * count(left) + area(right) * count(right)
+		float fBestCost = 1e30f;
+		uint32_t iBestAxis = 0;
+		uint32_t iBestSplit = 0;
+		for (uint32_t iAxis = 0; iAxis < 3; iAxis++)
+		{
+			const SAHBin* rtAxisBins = &(rtBins[iAxis * SAH_BIN_COUNT]);
+			float fRightCosts[SAH_BIN_COUNT] = {};
+			SAHBin rtRight;
+			for (uint32_t i = SAH_BIN_COUNT - 1; i > 0; i--)
+			{
+				MergeBin(rtRight, rtAxisBins[i]);
+				fRightCosts[i] = (rtRight.Count > 0) ? HalfSurfaceArea(rtRight.Min, rtRight.Max) * (float)rtRight.Count : 1e30f;
+			}
+
+			SAHBin rtLeft;
+			for (uint32_t i = 1; i < SAH_BIN_COUNT; i++)
+			{
+				MergeBin(rtLeft, rtAxisBins[i - 1]);
+				if ((rtLeft.Count == 0) || (fRightCosts[i] == 1e30f)) continue;
+
+				float fCost = HalfSurfaceArea(rtLeft.Min, rtLeft.Max) * (float)rtLeft.Count + fRightCosts[i];
+				if (fCost < fBestCost)
+				{
+					fBestCost = fCost;
+					iBestAxis = iAxis;
+					iBestSplit = i;
+				}
+			}
+		}
+		if (fBestCost == 1e30f) return iBegin; // all centroids are in the same bin
+
+		//move the primitives of the left child to the front
+		auto stdMiddle = std::partition(rtContext.Primitives.begin() + iBegin, rtContext.Primitives.begin() + iEnd, [&](uint32_t iPrimitive)
+		{
+			return fnBinIndex(rtContext.Centroids[iPrimitive], iBestAxis) < iBestSplit;
+		});
+		return (uint32_t)(stdMiddle - rtContext.Primitives.begin());
+	}
+
+
+	//split at the median centroid of the longest axis, which keeps the remaining subtree balanced
+	static uint32_t ApplyMedianSplit(SAHBuildContext& rtContext, uint32_t iBegin, uint32_t iEnd, const SAHBin& rtCentroidBounds)
+	{
+		Math::float3 rtExtent = rtCentroidBounds.Max - rtCentroidBounds.Min;
+		uint32_t iAxis = (rtExtent.x > rtExtent.y) ? ((rtExtent.x > rtExtent.z) ? 0 : 2) : ((rtExtent.y > rtExtent.z) ? 1 : 2);
+
+		//the left child gets the bigger half of the leaves, so the right child never needs more levels
+		uint32_t iNumLeaves = (iEnd - iBegin + 1) / 2;
+		uint32_t iMiddle = iBegin + 2 * ((iNumLeaves + 1) / 2);
+		std::nth_element(rtContext.Primitives.begin() + iBegin, rtContext.Primitives.begin() + iMiddle, rtContext.Primitives.begin() + iEnd,
+			[&](uint32_t iPrimitiveA, uint32_t iPrimitiveB)
+		{
+			return (&(rtContext.Centroids[iPrimitiveA].x))[iAxis] < (&(rtContext.Centroids[iPrimitiveB].x))[iAxis];
+		});
+		return iMiddle;
+	}
+
+
+	//write the node of the task to the bvh, returns the number of child tasks (0 for a leaf, 2 for an inner node)
+	static uint32_t ProcessSAHBuildTask(SAHBuildContext& rtContext, const SAHBuildTask& rtTask, bool bParallel, SAHBuildTask* rtChildTasks)
+	{
+		AABB& rtNode = (*(rtContext.BVH))[rtTask.NodeIndex];
+		uint32_t iCount = rtTask.End - rtTask.Begin;
+
+		SAHBin rtBounds, rtCentroidBounds;
+		ComputeBounds(rtContext, rtTask.Begin, rtTask.End, bParallel, rtBounds, rtCentroidBounds);
+		rtNode.Min = rtBounds.Min;
+		rtNode.Max = rtBounds.Max;
+
+		//a leaf contains up to two triangles, like the leaves of the lbvh
+		if (iCount <= 2)
+		{
+			rtNode.Padding.x = (rtContext.Primitives[rtTask.Begin] * 3) | BVH_LEAF_FLAG;
+			rtNode.Padding.y = (iCount == 2) ? ((rtContext.Primitives[rtTask.Begin + 1] * 3) | BVH_LEAF_FLAG) : BVH_INVALID_INDEX;
+			return 0;
+		}
+
+		//the levels a balanced subtree of this node would need, if they run out we have to stop using the sah
+		uint32_t iRequiredLevels = 0;
+		while ((2u << iRequiredLevels) < iCount) iRequiredLevels++;
+
+		uint32_t iMiddle = rtTask.Begin;
+		if (rtTask.Depth + iRequiredLevels < BVH_MAX_DEPTH)
+		{
+			iMiddle = FindAndApplySAHSplit(rtContext, rtTask.Begin, rtTask.End, bParallel, rtCentroidBounds);
+		}
+		if ((iMiddle == rtTask.Begin) || (iMiddle == rtTask.End))
+		{
+			iMiddle = ApplyMedianSplit(rtContext, rtTask.Begin, rtTask.End, rtCentroidBounds);
+		}
+
+		//the children are stored next to each other
+		uint32_t iChildIndex = rtContext.NextNodeIndex.fetch_add(2);
+		rtNode.Padding.x = iChildIndex;
+		rtNode.Padding.y = iChildIndex + 1;
+		rtChildTasks[0] = { iChildIndex, rtTask.Begin, iMiddle, rtTask.Depth + 1 };
+		rtChildTasks[1] = { iChildIndex + 1, iMiddle, rtTask.End, rtTask.Depth + 1 };
+		return 2;
+	}
+
+	static void BuildSAHSubtree(SAHBuildContext& rtContext, const SAHBuildTask& rtTask)
+	{
+		SAHBuildTask rtChildTasks[2];
+		if (ProcessSAHBuildTask(rtContext, rtTask, false, rtChildTasks) == 0) return;
+		BuildSAHSubtree(rtContext, rtChildTasks[0]);
+		BuildSAHSubtree(rtContext, rtChildTasks[1]);
+	}
+
+
+	bool BuildSAHBVH(const MeshInfo& rtMesh, std::vector<AABB>& rtBVH)
+	{
+		const uint32_t iNumPrimitives = (uint32_t)(rtMesh.IndexCount / 3);
+		rtBVH.assign(std::max<uint32_t>(iNumPrimitives * 4, 4), AABB{});
+		if (iNumPrimitives == 0) return true;
+
+		//get the bounds and centroids of all triangles
+		SAHBuildContext rtContext;
+		rtContext.PrimitiveBounds.resize(iNumPrimitives);
+		rtContext.Centroids.resize(iNumPrimitives);
+		rtContext.Primitives.resize(iNumPrimitives);
+		rtContext.BVH = &rtBVH;
+		ParallelFor(iNumPrimitives, 4096, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t i = iBegin; i < iEnd; i++)
+			{
+				const Math::float3& rtPosition1 = rtMesh.Vertices[rtMesh.Indices[3 * i]].Position;
+				const Math::float3& rtPosition2 = rtMesh.Vertices[rtMesh.Indices[3 * i + 1]].Position;
+				const Math::float3& rtPosition3 = rtMesh.Vertices[rtMesh.Indices[3 * i + 2]].Position;
+
+				AABB& rtBounds = rtContext.PrimitiveBounds[i];
+				rtBounds.Min = Math::min(rtPosition1, Math::min(rtPosition2, rtPosition3));
+				rtBounds.Max = Math::max(rtPosition1, Math::max(rtPosition2, rtPosition3));
+				rtContext.Centroids[i] = 0.5f * (rtBounds.Min + rtBounds.Max);
+				rtContext.Primitives[i] = (uint32_t)i;
+			}
+		});
+
+		//the trunk at index 0 always has to be an inner node, so small meshes get a trunk with a single leaf
+		SAHBuildTask rtRootTask = { 0, 0, iNumPrimitives, 0 };
+		rtContext.NextNodeIndex = 1;
+		if (iNumPrimitives <= 2)
+		{
+			rtRootTask.NodeIndex = rtContext.NextNodeIndex++;
+			rtRootTask.Depth = 1;
+		}
+
+		//split the big nodes one after another with all threads
+		std::vector<SAHBuildTask> rtPendingTasks = { rtRootTask };
+		std::vector<SAHBuildTask> rtSubtreeTasks;
+		while (!rtPendingTasks.empty())
+		{
+			SAHBuildTask rtTask = rtPendingTasks.back();
+			rtPendingTasks.pop_back();
+			if ((rtTask.End - rtTask.Begin) < SAH_PARALLEL_SPLIT_THRESHOLD)
+			{
+				rtSubtreeTasks.push_back(rtTask);
+				continue;
+			}
+
+			SAHBuildTask rtChildTasks[2];
+			uint32_t iNumChildTasks = ProcessSAHBuildTask(rtContext, rtTask, true, rtChildTasks);
+			rtPendingTasks.insert(rtPendingTasks.end(), rtChildTasks, rtChildTasks + iNumChildTasks);
+		}
+
+		//build the remaining subtrees independently of each other
+		ParallelFor(rtSubtreeTasks.size(), 1, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t i = iBegin; i < iEnd; i++)
+			{
+				BuildSAHSubtree(rtContext, rtSubtreeTasks[i]);
+			}
+		});
+
+		//construct the trunk for the single leaf
+		if (rtRootTask.NodeIndex != 0)
+		{
+			rtBVH[0].Min = rtBVH[rtRootTask.NodeIndex].Min;
+			rtBVH[0].Max = rtBVH[rtRootTask.NodeIndex].Max;
+			rtBVH[0].Padding.x = rtRootTask.NodeIndex;
+			rtBVH[0].Padding.y = BVH_INVALID_INDEX;
+		}
+
+		return true;
+	}
+
+
+
+	bool BuildTriangleStream(const MeshInfo& rtMesh, std::vector<AABB>& rtBVH, std::vector<IntersectionTriangle>& rtTriangles)
+	{
+		const uint32_t iNumPrimitives = (uint32_t)(rtMesh.IndexCount / 3);
+		std::vector<Index> rtFirstIndices;
+		rtFirstIndices.reserve(iNumPrimitives);
+
+		if ((rtBVH.empty()) || (iNumPrimitives == 0))
+		{
+			for (uint32_t i = 0; i < iNumPrimitives; i++)
+			{
+				rtFirstIndices.push_back(i * 3);
+			}
+		}
+		else
+		{
+			//visit the leaves depth-first, the left child first (like the traversal does)
+			std::vector<uint32_t> rtNodeStack = { 0 };
+			while ((!rtNodeStack.empty()) && (rtFirstIndices.size() <= iNumPrimitives))
+			{
+				AABB& rtNode = rtBVH[rtNodeStack.back()];
+				rtNodeStack.pop_back();
+				if (rtNode.Padding.x & BVH_LEAF_FLAG)
+				{
+					rtFirstIndices.push_back(rtNode.Padding.x & ~BVH_LEAF_FLAG);
+					rtNode.Padding.x = (uint32_t)(rtFirstIndices.size() - 1) | BVH_LEAF_FLAG;
+					if (rtNode.Padding.y != BVH_INVALID_INDEX)
+					{
+						rtFirstIndices.push_back(rtNode.Padding.y & ~BVH_LEAF_FLAG);
+						rtNode.Padding.y = (uint32_t)(rtFirstIndices.size() - 1) | BVH_LEAF_FLAG;
+					}
+				}
+				else
+				{
+					if (rtNode.Padding.y != BVH_INVALID_INDEX) rtNodeStack.push_back(rtNode.Padding.y);
+					rtNodeStack.push_back(rtNode.Padding.x);
+				}
+			}
+		}
+		if (rtFirstIndices.size() != iNumPrimitives) return false;
+
+		//store the first vertex and the two edges, the intersection test needs nothing else
+		rtTriangles.resize(iNumPrimitives);
+		ParallelFor(iNumPrimitives, 4096, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t i = iBegin; i < iEnd; i++)
+			{
+				Index iFirstIndex = rtFirstIndices[i];
+				const Math::float3& rtPosition1 = rtMesh.Vertices[rtMesh.Indices[iFirstIndex]].Position;
+				const Math::float3& rtPosition2 = rtMesh.Vertices[rtMesh.Indices[iFirstIndex + 1]].Position;
+				const Math::float3& rtPosition3 = rtMesh.Vertices[rtMesh.Indices[iFirstIndex + 2]].Position;
+
+				IntersectionTriangle& rtTriangle = rtTriangles[i];
+				rtTriangle.Vertex1 = rtPosition1;
+				rtTriangle.FirstIndex = iFirstIndex;
+				rtTriangle.Edge1 = rtPosition2 - rtPosition1;
+				rtTriangle.Padding1 = 0.0f;
+				rtTriangle.Edge2 = rtPosition3 - rtPosition1;
+				rtTriangle.Padding2 = 0.0f;
+			}
+		});
+
+		return true;
+	}
+
+
+	void BuildSkipLinks(std::span<const AABB> rtBVH, std::vector<uint32_t>& iSkipLinks)
+	{
+		iSkipLinks.assign(rtBVH.size(), BVH_INVALID_INDEX);
+		if (rtBVH.empty()) return;
+
+		//top-down: the left child continues with its sibling, the right child (or an only child) with the skip link of its parent
+		std::vector<uint32_t> rtNodeStack = { 0 };
+		while (!rtNodeStack.empty())
+		{
+			uint32_t iNode = rtNodeStack.back();
+			rtNodeStack.pop_back();
+			const AABB& rtNode = rtBVH[iNode];
+			if (rtNode.Padding.x & BVH_LEAF_FLAG) continue;
+
+			if (rtNode.Padding.y != BVH_INVALID_INDEX)
+			{
+				iSkipLinks[rtNode.Padding.x] = rtNode.Padding.y;
+				iSkipLinks[rtNode.Padding.y] = iSkipLinks[iNode];
+				rtNodeStack.push_back(rtNode.Padding.y);
+			}
+			else
+			{
+				iSkipLinks[rtNode.Padding.x] = iSkipLinks[iNode];
+			}
+			rtNodeStack.push_back(rtNode.Padding.x);
+		}
+	}
+
+
+	BVHStats GetBVHStats(std::span<const AABB> rtBVH)
+	{
+		BVHStats rtStats{};
+		if (rtBVH.empty()) return rtStats;
+
+		//the probability, that a random ray through the trunk hits a node, is the ratio of their surface areas
+		float fInverseTrunkArea = HalfSurfaceArea(rtBVH[0].Min, rtBVH[0].Max);
+		fInverseTrunkArea = (fInverseTrunkArea > 0.0f) ? (1.0f / fInverseTrunkArea) : 0.0f;
+		double dSAHCost = 1.0; // the test of the trunk
+
+		std::vector<Math::uint2> rtNodeStack = { Math::uint2(0, 1) }; // x: the node, y: its level
+		while (!rtNodeStack.empty())
+		{
+			Math::uint2 rtEntry = rtNodeStack.back();
+			rtNodeStack.pop_back();
+			const AABB& rtNode = rtBVH[rtEntry.x];
+			double dHitProbability = (fInverseTrunkArea > 0.0f) ? (double)(HalfSurfaceArea(rtNode.Min, rtNode.Max) * fInverseTrunkArea) : 1.0;
+			uint32_t iNumChildren = (rtNode.Padding.y != BVH_INVALID_INDEX) ? 2 : 1;
+			rtStats.NumNodes++;
+			rtStats.MaxDepth = std::max(rtStats.MaxDepth, rtEntry.y);
+
+			if (rtNode.Padding.x & BVH_LEAF_FLAG)
+			{
+				rtStats.NumLeaves++;
+				rtStats.NumTriangles += iNumChildren;
+				dSAHCost += dHitProbability * (double)iNumChildren;
+				continue;
+			}
+
+			dSAHCost += dHitProbability * (double)iNumChildren;
+			rtNodeStack.push_back(Math::uint2(rtNode.Padding.x, rtEntry.y + 1));
+			if (iNumChildren == 2) rtNodeStack.push_back(Math::uint2(rtNode.Padding.y, rtEntry.y + 1));
+		}
+
+		rtStats.SAHCost = (float)dSAHCost;
+		return rtStats;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <span>
+
+#include "Core/Math.h"
+#include "Core/MeshLoader.h"
+
+
+
+//the bvh construction on the cpu, it produces the same flattened node array as the gpu path:
+//the trunk is at index 0, a leaf stores (first index of a triangle | 0x80000000) in Padding.x and the second triangle (or 0xffffffff) in Padding.y,
+//an inner node stores the indices of its children in Padding.x and Padding.y (0xffffffff if there is only one child)
+namespace RT::Core
+{
+
+	const uint32_t BVH_LEAF_FLAG = 0x80000000;
+	const uint32_t BVH_INVALID_INDEX = 0xffffffff;
+	const uint32_t LBVH_MAX_DEPTH = 32; // the lbvh is balanced, its (at most 2^31) leaves of two triangles are below at most 31 inner levels
+	const uint32_t BVH_MAX_DEPTH = LBVH_MAX_DEPTH; // the SAH bvh fits into the same traversal stacks (one entry per level) as the lbvh
+
+
+	//the shape of a binary bvh, only the nodes, which are reachable from the trunk, are counted
+	struct BVHStats
+	{
+		uint32_t NumNodes;
+		uint32_t NumLeaves;
+		uint32_t NumTriangles;
+		uint32_t MaxDepth; // the number of levels, a bvh with only the trunk has the depth 1
+		float SAHCost; // the expected node and triangle tests of a ray through the trunk, every child of a hit inner node is tested (like TraverseBVH)
+	};
+
+
+	//the morton codes of the triangle centroids (x: the morton code, y: the index of the first vertex index of the triangle)
+	void GenerateMortonCodes(const MeshInfo& rtMesh, const AABB& rtSceneAABB, std::vector<Math::uint2>& rtMortonCodes);
+
+	//sort the codes with the onesweep radix sort (like the CS_Sort*.hlsl passes), rtTempMortonCodes is used as scratch memory
+	void SortMortonCodes(std::vector<Math::uint2>& rtMortonCodes, std::vector<Math::uint2>& rtTempMortonCodes);
+
+	//build the tree by merging neighbours in morton order (like CS_BVHBuildLeaves.hlsl and CS_BVHBuild.hlsl)
+	bool BuildLBVH(const MeshInfo& rtMesh, const std::vector<Math::uint2>& rtMortonCodes, std::vector<AABB>& rtBVH);
+
+	//build the tree top-down with the binned surface area heuristic (slower to build than the lbvh, but much faster to traverse)
+	//the nodes near the root are split with all threads, the remaining subtrees are built in parallel
+	bool BuildSAHBVH(const MeshInfo& rtMesh, std::vector<AABB>& rtBVH);
+
+	//copy the triangles into the intersection-only stream in the order, in which a depth-first traversal reaches the leaves,
+	//afterwards the leaves store the positions in this stream instead of the positions in the index buffer (the stream is in index order without a bvh)
+	bool BuildTriangleStream(const MeshInfo& rtMesh, std::vector<AABB>& rtBVH, std::vector<IntersectionTriangle>& rtTriangles);
+
+	//the skip link of every node: the node, which the depth-first traversal (left child first) visits after the subtree of the node,
+	//or BVH_INVALID_INDEX after the last subtree, so the traversal needs no stack (like CS_BVHBuildSkipLinks.hlsl)
+	void BuildSkipLinks(std::span<const AABB> rtBVH, std::vector<uint32_t>& iSkipLinks);
+
+	//the statistics of a built bvh (for the benchmarks), a node and a triangle test have the same cost in the SAH cost
+	BVHStats GetBVHStats(std::span<const AABB> rtBVH);
+
+}
\ No newline at end of file
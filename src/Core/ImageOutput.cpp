@@ -0,0 +1,293 @@
+//include-files
+#include "ImageOutput.h"
+
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+
+
+
+namespace RT::Core
+{
+
+	//the same conversion as the DXGI_FORMAT_R8G8B8A8_UNORM_SRGB swapchain, which presents the gpu image
+	static uint8_t LinearToSRGB(float fValue)
+	{
+		fValue = Math::saturate(fValue);
+		fValue = (fValue <= 0.0031308f) ? (fValue * 12.92f) : (1.055f * std::pow(fValue, 1.0f / 2.4f) - 0.055f);
+		return (uint8_t)(fValue * 255.0f + 0.5f);
+	}
+
+
+	bool SaveImagePPM(const std::string& sFileName, uint32_t iWidth, uint32_t iHeight, const Math::float4* rtPixels)
+	{
+		if ((!rtPixels) || (iWidth == 0) || (iHeight == 0)) return false;
+
+		std::ofstream stdFile(sFileName, std::ios::binary);
+		if (!stdFile) return false;
+
+		//convert the pixels row by row, starting at the top of the image
+		std::vector<uint8_t> stdImageData((size_t)iWidth * iHeight * 3);
+		for (size_t i = 0; i < (size_t)iWidth * iHeight; i++)
+		{
+			stdImageData[i * 3] = LinearToSRGB(rtPixels[i].x);
+			stdImageData[i * 3 + 1] = LinearToSRGB(rtPixels[i].y);
+			stdImageData[i * 3 + 2] = LinearToSRGB(rtPixels[i].z);
+		}
+
+		stdFile << "P6\n" << iWidth << " " << iHeight << "\n255\n";
+		stdFile.write((const char*)stdImageData.data(), stdImageData.size());
+
+		return stdFile.good();
+	}
+
+
+
+	//the checksums of the png format
+	static uint32_t CRC32(const uint8_t* pData, size_t iSize, uint32_t iCRC = 0)
+	{
+		iCRC = ~iCRC;
+		for (size_t i = 0; i < iSize; i++)
+		{
+			iCRC ^= pData[i];
+			for (uint32_t j = 0; j < 8; j++) iCRC = (iCRC >> 1) ^ (0xedb88320u & (0u - (iCRC & 1u)));
+		}
+		return ~iCRC;
+	}
+
+	static uint32_t Adler32(const uint8_t* pData, size_t iSize)
+	{
+		uint32_t a = 1;
+		uint32_t b = 0;
+		for (size_t i = 0; i < iSize; i++)
+		{
+			a = (a + pData[i]) % 65521;
+			b = (b + a) % 65521;
+		}
+		return (b << 16) | a;
+	}
+
+	static void WriteBigEndian(std::vector<uint8_t>& stdData, uint32_t iValue)
+	{
+		stdData.push_back((uint8_t)(iValue >> 24));
+		stdData.push_back((uint8_t)(iValue >> 16));
+		stdData.push_back((uint8_t)(iValue >> 8));
+		stdData.push_back((uint8_t)iValue);
+	}
+
+	static void WritePNGChunk(std::ofstream& stdFile, const char* sType, const std::vector<uint8_t>& stdChunkData)
+	{
+		//the length, the type, the data and the checksum of the type and the data
+		std::vector<uint8_t> stdChunk;
+		WriteBigEndian(stdChunk, (uint32_t)stdChunkData.size());
+		stdChunk.insert(stdChunk.end(), sType, sType + 4);
+		stdChunk.insert(stdChunk.end(), stdChunkData.begin(), stdChunkData.end());
+		WriteBigEndian(stdChunk, CRC32(stdChunk.data() + 4, stdChunk.size() - 4));
+		stdFile.write((const char*)stdChunk.data(), stdChunk.size());
+	}
+
+
+	bool SaveImagePNG(const std::string& sFileName, uint32_t iWidth, uint32_t iHeight, const Math::float4* rtPixels)
+	{
+		if ((!rtPixels) || (iWidth == 0) || (iHeight == 0)) return false;
+
+		std::ofstream stdFile(sFileName, std::ios::binary);
+		if (!stdFile) return false;
+
+		//every row starts with the filter type 0 (no filter), followed by the 8 bit sRGB colors
+		size_t iRowSize = (size_t)iWidth * 3 + 1;
+		std::vector<uint8_t> stdImageData(iRowSize * iHeight, 0);
+		for (size_t y = 0; y < iHeight; y++)
+		{
+			for (size_t x = 0; x < iWidth; x++)
+			{
+				const Math::float4& rtPixel = rtPixels[y * iWidth + x];
+				stdImageData[y * iRowSize + 1 + x * 3] = LinearToSRGB(rtPixel.x);
+				stdImageData[y * iRowSize + 1 + x * 3 + 1] = LinearToSRGB(rtPixel.y);
+				stdImageData[y * iRowSize + 1 + x * 3 + 2] = LinearToSRGB(rtPixel.z);
+			}
+		}
+
+		//the zlib stream consists of stored deflate blocks with at most 65535 bytes each
+		std::vector<uint8_t> stdCompressedData = { 0x78, 0x01 };
+		for (size_t iOffset = 0; iOffset < stdImageData.size(); iOffset += 65535)
+		{
+			uint16_t iBlockSize = (uint16_t)std::min(stdImageData.size() - iOffset, (size_t)65535);
+			bool bLastBlock = (iOffset + iBlockSize == stdImageData.size());
+			stdCompressedData.push_back(bLastBlock ? 1 : 0);
+			stdCompressedData.push_back((uint8_t)iBlockSize);
+			stdCompressedData.push_back((uint8_t)(iBlockSize >> 8));
+			stdCompressedData.push_back((uint8_t)~iBlockSize);
+			stdCompressedData.push_back((uint8_t)(((uint16_t)~iBlockSize) >> 8));
+			stdCompressedData.insert(stdCompressedData.end(), stdImageData.begin() + iOffset, stdImageData.begin() + iOffset + iBlockSize);
+			if (bLastBlock) break;
+		}
+		WriteBigEndian(stdCompressedData, Adler32(stdImageData.data(), stdImageData.size()));
+
+		//the header: 8 bit RGB without interlacing
+		std::vector<uint8_t> stdHeader;
+		WriteBigEndian(stdHeader, iWidth);
+		WriteBigEndian(stdHeader, iHeight);
+		stdHeader.insert(stdHeader.end(), { 8, 2, 0, 0, 0 });
+
+		const uint8_t iSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+		stdFile.write((const char*)iSignature, sizeof(iSignature));
+		WritePNGChunk(stdFile, "IHDR", stdHeader);
+		WritePNGChunk(stdFile, "IDAT", stdCompressedData);
+		WritePNGChunk(stdFile, "IEND", std::vector<uint8_t>());
+
+		return stdFile.good();
+	}
+
+
+	bool SaveImagePFM(const std::string& sFileName, uint32_t iWidth, uint32_t iHeight, const Math::float4* rtPixels)
+	{
+		if ((!rtPixels) || (iWidth == 0) || (iHeight == 0)) return false;
+
+		std::ofstream stdFile(sFileName, std::ios::binary);
+		if (!stdFile) return false;
+
+		//the rows start at the bottom of the image, a negative scale means little endian floats
+		std::vector<float> stdImageData((size_t)iWidth * iHeight * 3);
+		for (size_t y = 0; y < iHeight; y++)
+		{
+			for (size_t x = 0; x < iWidth; x++)
+			{
+				const Math::float4& rtPixel = rtPixels[(iHeight - 1 - y) * iWidth + x];
+				size_t iIndex = (y * iWidth + x) * 3;
+				stdImageData[iIndex] = rtPixel.x;
+				stdImageData[iIndex + 1] = rtPixel.y;
+				stdImageData[iIndex + 2] = rtPixel.z;
+			}
+		}
+
+		stdFile << "PF\n" << iWidth << " " << iHeight << "\n-1.0\n";
+		stdFile.write((const char*)stdImageData.data(), stdImageData.size() * sizeof(float));
+
+		return stdFile.good();
+	}
+
+
+	//the values of an exr file are little endian, like the cpus we run on
+	template<typename T>
+	static void WriteLittleEndian(std::vector<uint8_t>& stdData, T Value)
+	{
+		uint8_t iBytes[sizeof(T)];
+		std::memcpy(iBytes, &Value, sizeof(T));
+		stdData.insert(stdData.end(), iBytes, iBytes + sizeof(T));
+	}
+
+	static void WriteEXRAttribute(std::vector<uint8_t>& stdHeader, const char* sName, const char* sType, const std::vector<uint8_t>& stdValue)
+	{
+		stdHeader.insert(stdHeader.end(), sName, sName + std::strlen(sName) + 1);
+		stdHeader.insert(stdHeader.end(), sType, sType + std::strlen(sType) + 1);
+		WriteLittleEndian(stdHeader, (int32_t)stdValue.size());
+		stdHeader.insert(stdHeader.end(), stdValue.begin(), stdValue.end());
+	}
+
+
+	bool SaveImageEXR(const std::string& sFileName, uint32_t iWidth, uint32_t iHeight, const Math::float4* rtPixels)
+	{
+		if ((!rtPixels) || (iWidth == 0) || (iHeight == 0)) return false;
+
+		std::ofstream stdFile(sFileName, std::ios::binary);
+		if (!stdFile) return false;
+
+		//the channels have to be sorted by their names
+		std::vector<uint8_t> stdChannels;
+		for (const char* sChannel : { "B", "G", "R" })
+		{
+			stdChannels.insert(stdChannels.end(), sChannel, sChannel + 2);
+			WriteLittleEndian(stdChannels, (int32_t)2); // FLOAT
+			WriteLittleEndian(stdChannels, (uint32_t)0); // pLinear and the reserved bytes
+			WriteLittleEndian(stdChannels, (int32_t)1); // xSampling
+			WriteLittleEndian(stdChannels, (int32_t)1); // ySampling
+		}
+		stdChannels.push_back(0);
+
+		std::vector<uint8_t> stdWindow;
+		WriteLittleEndian(stdWindow, (int32_t)0);
+		WriteLittleEndian(stdWindow, (int32_t)0);
+		WriteLittleEndian(stdWindow, (int32_t)iWidth - 1);
+		WriteLittleEndian(stdWindow, (int32_t)iHeight - 1);
+
+		std::vector<uint8_t> stdScreenWindowCenter;
+		WriteLittleEndian(stdScreenWindowCenter, 0.0f);
+		WriteLittleEndian(stdScreenWindowCenter, 0.0f);
+
+		std::vector<uint8_t> stdOne;
+		WriteLittleEndian(stdOne, 1.0f);
+
+		//the magic number, the version 2 (single part scanline file) and the required attributes
+		std::vector<uint8_t> stdHeader;
+		WriteLittleEndian(stdHeader, (uint32_t)20000630);
+		WriteLittleEndian(stdHeader, (uint32_t)2);
+		WriteEXRAttribute(stdHeader, "channels", "chlist", stdChannels);
+		WriteEXRAttribute(stdHeader, "compression", "compression", { 0 }); // NO_COMPRESSION
+		WriteEXRAttribute(stdHeader, "dataWindow", "box2i", stdWindow);
+		WriteEXRAttribute(stdHeader, "displayWindow", "box2i", stdWindow);
+		WriteEXRAttribute(stdHeader, "lineOrder", "lineOrder", { 0 }); // INCREASING_Y
+		WriteEXRAttribute(stdHeader, "pixelAspectRatio", "float", stdOne);
+		WriteEXRAttribute(stdHeader, "screenWindowCenter", "v2f", stdScreenWindowCenter);
+		WriteEXRAttribute(stdHeader, "screenWindowWidth", "float", stdOne);
+		stdHeader.push_back(0);
+
+		//the offset table points to the scanline blocks, which follow it
+		uint32_t iLineSize = iWidth * 3 * sizeof(float);
+		uint64_t iFirstLineOffset = stdHeader.size() + (uint64_t)iHeight * sizeof(uint64_t);
+		for (uint32_t y = 0; y < iHeight; y++)
+		{
+			WriteLittleEndian(stdHeader, iFirstLineOffset + (uint64_t)y * (2 * sizeof(int32_t) + iLineSize));
+		}
+		stdFile.write((const char*)stdHeader.data(), stdHeader.size());
+
+		//every scanline is its own block: the y coordinate, the size and the channels one after another
+		std::vector<uint8_t> stdLine;
+		stdLine.reserve(2 * sizeof(int32_t) + iLineSize);
+		for (uint32_t y = 0; y < iHeight; y++)
+		{
+			stdLine.clear();
+			WriteLittleEndian(stdLine, (int32_t)y);
+			WriteLittleEndian(stdLine, (int32_t)iLineSize);
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				for (uint32_t x = 0; x < iWidth; x++)
+				{
+					const Math::float4& rtPixel = rtPixels[(size_t)y * iWidth + x];
+					WriteLittleEndian(stdLine, (c == 0) ? rtPixel.z : ((c == 1) ? rtPixel.y : rtPixel.x));
+				}
+			}
+			stdFile.write((const char*)stdLine.data(), stdLine.size());
+		}
+
+		return stdFile.good();
+	}
+
+
+	static std::string GetFileExtension(const std::string& sFileName)
+	{
+		size_t iDot = sFileName.find_last_of('.');
+		if ((iDot == std::string::npos) || (sFileName.find_first_of("/\\", iDot) != std::string::npos)) return "";
+		std::string sExtension = sFileName.substr(iDot + 1);
+		std::transform(sExtension.begin(), sExtension.end(), sExtension.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+		return sExtension;
+	}
+
+	bool IsHDRImageFile(const std::string& sFileName)
+	{
+		std::string sExtension = GetFileExtension(sFileName);
+		return (sExtension == "pfm") || (sExtension == "exr");
+	}
+
+	bool SaveImage(const std::string& sFileName, uint32_t iWidth, uint32_t iHeight, const Math::float4* rtPixels)
+	{
+		std::string sExtension = GetFileExtension(sFileName);
+		if (sExtension == "png") return SaveImagePNG(sFileName, iWidth, iHeight, rtPixels);
+		if (sExtension == "pfm") return SaveImagePFM(sFileName, iWidth, iHeight, rtPixels);
+		if (sExtension == "exr") return SaveImageEXR(sFileName, iWidth, iHeight, rtPixels);
+		return SaveImagePPM(sFileName, iWidth, iHeight, rtPixels);
+	}
+
+}
\ No newline at end of file
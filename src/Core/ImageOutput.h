@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+
+#include "Core/Math.h"
+
+
+
+namespace RT::Core
+{
+
+	//writes the tone mapped linear colors as an 8 bit sRGB image (binary PPM, which can be opened by most image viewers)
+	bool SaveImagePPM(const std::string& sFileName, uint32_t iWidth, uint32_t iHeight, const Math::float4* rtPixels);
+
+	//writes the tone mapped linear colors as an 8 bit sRGB image (PNG with uncompressed deflate blocks, so we don't need a compression library)
+	bool SaveImagePNG(const std::string& sFileName, uint32_t iWidth, uint32_t iHeight, const Math::float4* rtPixels);
+
+	//writes the linear colors without any conversion as 32 bit floats (PFM, the rows are stored from the bottom to the top of the image)
+	bool SaveImagePFM(const std::string& sFileName, uint32_t iWidth, uint32_t iHeight, const Math::float4* rtPixels);
+
+	//writes the linear colors without any conversion as 32 bit floats (uncompressed scanline OpenEXR)
+	bool SaveImageEXR(const std::string& sFileName, uint32_t iWidth, uint32_t iHeight, const Math::float4* rtPixels);
+
+	//the .pfm and .exr files store linear colors, all other files the tone mapped ones
+	bool IsHDRImageFile(const std::string& sFileName);
+
+	//chooses the file type by the extension of the file name (.ppm, .png, .pfm or .exr)
+	bool SaveImage(const std::string& sFileName, uint32_t iWidth, uint32_t iHeight, const Math::float4* rtPixels);
+
+}
\ No newline at end of file
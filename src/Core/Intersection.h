@@ -0,0 +1,329 @@
+#pragma once
+
+#include "Core/Math.h"
+#include "Core/SIMD.h"
+#include "Core/MeshLoader.h"
+#include "Core/BVH.h"
+#include "Core/WideBVH.h"
+
+#include <bit>
+
+
+
+//the intersection tests and traversals of BVHTraversal.hlsli, shared by the cpu code paths
+namespace RT::Core
+{
+
+	const float INTERSECTION_EPSILON = 1e-6f;
+	const float AABB_MISS = 1e30f;
+	const uint32_t BVH_STACK_SIZE = 32; // like BVH_STACK_SIZE in BVHTraversal.hlsli
+	static_assert((BVH_STACK_SIZE >= BVH_MAX_DEPTH) && (BVH_STACK_SIZE >= LBVH_MAX_DEPTH), "the ordered traversal needs one stack entry per level of both binary trees");
+	const float MIN_DIRECTION_COMPONENT = 1e-20f; // the smallest absolute direction component of the wide slab test (see GetInverseDirection)
+
+
+	//the same layout as the "Ray" struct in Raytracer.hlsli
+	struct Ray
+	{
+		Math::float3 Origin;
+		Math::float3 Direction;
+		float TMin;
+		float TMax;
+	};
+
+	static_assert(sizeof(Ray) == 32, "Ray has to match the layout in Raytracer.hlsli");
+
+
+	//a fast ray-triangle intersection algorithm, returns (t, u, v, clockwise) or -1.0f in xyz on a miss
+	//the original paper: https://cadxfem.org/inf/Fast%20MinimumStorage%20RayTriangle%20Intersection.pdf
+	inline Math::float4 Intersect(const Ray& rtTestRay, const Math::float3& rtVertex1, const Math::float3& rtEdge1, const Math::float3& rtEdge2)
+	{
+		//the edges are precomputed in the triangle stream
+		Math::float3 rtTVec = rtTestRay.Origin - rtVertex1;
+
+		//compute all the cross products
+		Math::float3 rtPVec = Math::cross(rtTestRay.Direction, rtEdge2);
+		Math::float3 rtQVec = Math::cross(rtTVec, rtEdge1);
+
+		//calculate the determinant and its inverse
+		float fDeterminant = Math::dot(rtEdge1, rtPVec);
+		float fInverseDeterminant = (std::fabs(fDeterminant) < INTERSECTION_EPSILON) ? 0.0f : 1.0f / fDeterminant;
+		float fTriangleIsClockwise = std::round(std::fabs(fDeterminant) * fInverseDeterminant); // 1 = clockwise; 0 = parallel to ray; -1 = counterclockwise
+
+		//calculate the result
+		Math::float3 rtResult;
+		rtResult.x = Math::dot(rtEdge2, rtQVec); //the parameter 't' from the equation of a ray (O + t * R)
+		rtResult.y = Math::dot(rtTVec, rtPVec); // 'u', one barycentric coordinate
+		rtResult.z = Math::dot(rtTestRay.Direction, rtQVec); // 'v', the other barycentric coordinate
+		rtResult *= fInverseDeterminant; // if the inverse determinant is 0, the next check will fail
+
+		//final check, if the ray intersects the triangle
+		if ((rtResult.x < INTERSECTION_EPSILON) || (rtResult.y < 0.0f) || (rtResult.z < 0.0f) || (rtResult.y + rtResult.z > 1.0f))
+			rtResult = Math::float3(-1.0f);
+
+		return Math::float4(rtResult, fTriangleIsClockwise);
+	}
+
+
+	//the slab test, returns the entry distance or AABB_MISS
+	//based on: https://jacco.ompf2.com/2022/04/18/how-to-build-a-bvh-part-2-faster-rays/
+	inline float IntersectAABB(const Ray& rtTestRay, const AABB& rtTestAABB)
+	{
+		Math::SIMD::float4v rtOrigin = Math::SIMD::Load(rtTestRay.Origin);
+		Math::SIMD::float4v rtDirection = Math::SIMD::Load(rtTestRay.Direction);
+		Math::SIMD::float4v t1 = (Math::SIMD::Load(rtTestAABB.Min) - rtOrigin) / rtDirection;
+		Math::SIMD::float4v t2 = (Math::SIMD::Load(rtTestAABB.Max) - rtOrigin) / rtDirection;
+
+		float fTMin = Math::SIMD::ReduceMax3(Math::SIMD::Min(t1, t2));
+		float fTMax = Math::SIMD::ReduceMin3(Math::SIMD::Max(t1, t2));
+
+		if ((fTMax < fTMin) || (fTMax <= 0) || (fTMax < rtTestRay.TMin) || (fTMin > rtTestRay.TMax))
+		{
+			fTMin = AABB_MISS;
+		}
+
+		return fTMin;
+	}
+
+
+	//test the triangle at iCurrentTriangle in the triangle stream and keep the closest hit (and the position of its indices in the index buffer)
+	inline void CheckIntersection(const IntersectionTriangle* rtTriangles, const Ray& rtCurrentRay, uint32_t iCurrentTriangle, Math::float4& rtResult, Index& iHitIndex)
+	{
+		const IntersectionTriangle& rtTriangle = rtTriangles[iCurrentTriangle];
+		Math::float4 rtCurrentResult = Intersect(rtCurrentRay, rtTriangle.Vertex1, rtTriangle.Edge1, rtTriangle.Edge2);
+		if ((rtCurrentRay.TMin <= rtCurrentResult.x) && (rtCurrentRay.TMax > rtCurrentResult.x) && (rtCurrentResult.x < rtResult.x))
+		{
+			rtResult = rtCurrentResult;
+			iHitIndex = rtTriangle.FirstIndex;
+		}
+	}
+
+
+	//the simd vector type, which holds one float per child of a wide bvh node
+	template<uint32_t Width>
+	struct WideVector;
+
+	template<>
+	struct WideVector<4>
+	{
+		typedef Math::SIMD::float4v Type;
+		static Type Splat(float fValue) { return Math::SIMD::Splat(fValue); }
+		static Type LoadBytes(const uint8_t* iValues) { return Math::SIMD::LoadBytes(iValues); }
+	};
+
+	template<>
+	struct WideVector<8>
+	{
+		typedef Math::SIMD::float8v Type;
+		static Type Splat(float fValue) { return Math::SIMD::Splat8(fValue); }
+		static Type LoadBytes(const uint8_t* iValues) { return Math::SIMD::LoadBytes8(iValues); }
+	};
+
+
+	//the inverse ray direction of the wide slab test, the components, which are (almost) zero, keep their sign, but get the magnitude MIN_DIRECTION_COMPONENT,
+	//so an axis-parallel ray gets huge finite distances instead of inf, which would give 0 * inf = NaN for a child bound in the plane of the ray origin
+	inline Math::float3 GetInverseDirection(const Math::float3& rtDirection)
+	{
+		auto fnInverse = [](float fValue) { return 1.0f / ((std::abs(fValue) < MIN_DIRECTION_COMPONENT) ? std::copysign(MIN_DIRECTION_COMPONENT, fValue) : fValue); };
+		return Math::float3(fnInverse(rtDirection.x), fnInverse(rtDirection.y), fnInverse(rtDirection.z));
+	}
+
+	//the slab test against all children of a wide node at once, returns a bit for every child slot, which is hit closer than fClosestT
+	template<uint32_t Width>
+	inline uint32_t IntersectWideNode(const WideBVHNode<Width>& rtNode, const Math::float3& rtOrigin, const Math::float3& rtInverseDirection,
+		float fTMin, float fClosestT)
+	{
+		using Vector = WideVector<Width>;
+		typename Vector::Type rtNear = Vector::Splat(fTMin);
+		typename Vector::Type rtFar = Vector::Splat(fClosestT);
+		const float* fNodeOrigin = &rtNode.Origin.x;
+		const float* fRayOrigin = &rtOrigin.x;
+		const float* fInverseDirection = &rtInverseDirection.x;
+
+		uint32_t iValidChildren = 0;
+		for (uint32_t i = 0; i < Width; i++)
+		{
+			iValidChildren |= (rtNode.Meta[i] != 0) ? (1u << i) : 0u;
+		}
+
+		for (uint32_t iAxis = 0; iAxis < 3; iAxis++)
+		{
+			//(Origin + Quantized * Scale - RayOrigin) * InverseDirection like IntersectAABB, the bounds are subtracted before the multiplication,
+			//so a bound, which is exactly in the plane of the ray origin, gives 0 and not a sum of two huge distances
+			typename Vector::Type rtScale = Vector::Splat(GetWideBVHScale(rtNode.Exponents, iAxis));
+			typename Vector::Type rtOffset = Vector::Splat(fNodeOrigin[iAxis] - fRayOrigin[iAxis]);
+			typename Vector::Type rtInverseDirection = Vector::Splat(fInverseDirection[iAxis]);
+			typename Vector::Type t1 = (Vector::LoadBytes(rtNode.QuantizedMin[iAxis]) * rtScale + rtOffset) * rtInverseDirection;
+			typename Vector::Type t2 = (Vector::LoadBytes(rtNode.QuantizedMax[iAxis]) * rtScale + rtOffset) * rtInverseDirection;
+			rtNear = Math::SIMD::Max(rtNear, Math::SIMD::Min(t1, t2));
+			rtFar = Math::SIMD::Min(rtFar, Math::SIMD::Max(t1, t2));
+		}
+
+		//the same conditions as IntersectAABB, the far distance is already clamped to the closest hit and the near distance to TMin
+		typename Vector::Type rtHit = Math::SIMD::And(Math::SIMD::LessEqual(rtNear, rtFar), Math::SIMD::Less(Vector::Splat(0.0f), rtFar));
+		rtHit = Math::SIMD::And(rtHit, Math::SIMD::Less(rtNear, Vector::Splat(fClosestT)));
+		return (uint32_t)Math::SIMD::MoveMask(rtHit) & iValidChildren;
+	}
+
+
+	//the traversal of a wide bvh: the stack stores groups of nodes (the first node and a bit mask of the nodes, which are still to visit),
+	//so it needs at most one entry per level, with AnyHit the traversal stops at the first hit (for the occlusion queries)
+	template<bool AnyHit = false, uint32_t Width>
+	inline void TraverseWideBVH(const WideBVHNode<Width>* rtNodes, const IntersectionTriangle* rtTriangles, const Ray& rtCurrentRay,
+		Math::float4& rtResult, Index& iHitIndex)
+	{
+		Math::float3 rtInverseDirection = GetInverseDirection(rtCurrentRay.Direction);
+		Math::uint2 rtGroups[WIDE_BVH_STACK_SIZE];
+		uint32_t iNumGroups = 0;
+		Math::uint2 rtCurrentGroup = Math::uint2(0, 1); // the trunk
+
+		while (true)
+		{
+			if (rtCurrentGroup.y == 0)
+			{
+				if (iNumGroups == 0) break;
+				iNumGroups--;
+				rtCurrentGroup = rtGroups[iNumGroups];
+			}
+
+			//take the next node out of the group
+			uint32_t iNodeIndex = rtCurrentGroup.x + (uint32_t)std::countr_zero(rtCurrentGroup.y);
+			rtCurrentGroup.y &= rtCurrentGroup.y - 1;
+			if (rtCurrentGroup.y != 0) // the stack has an entry for every level (see WIDE_BVH_STACK_SIZE)
+			{
+				rtGroups[iNumGroups] = rtCurrentGroup;
+				iNumGroups++;
+			}
+
+			//test the triangles of the hit leaves right away and collect the hit inner children
+			const WideBVHNode<Width>& rtNode = rtNodes[iNodeIndex];
+			uint32_t iHitChildren = IntersectWideNode(rtNode, rtCurrentRay.Origin, rtInverseDirection, rtCurrentRay.TMin, rtResult.x);
+			uint32_t iInnerChildren = 0;
+			while (iHitChildren != 0)
+			{
+				uint8_t iMeta = rtNode.Meta[std::countr_zero(iHitChildren)];
+				iHitChildren &= iHitChildren - 1;
+				if (iMeta & WIDE_BVH_INNER_CHILD)
+				{
+					iInnerChildren |= 1u << (iMeta & WIDE_BVH_RANK_MASK);
+				}
+				else
+				{
+					uint32_t iFirstTriangle = rtNode.TriangleBaseIndex + (iMeta & ((1u << WIDE_BVH_TRIANGLE_COUNT_SHIFT) - 1));
+					uint32_t iNumTriangles = iMeta >> WIDE_BVH_TRIANGLE_COUNT_SHIFT;
+					for (uint32_t i = 0; i < iNumTriangles; i++)
+					{
+						CheckIntersection(rtTriangles, rtCurrentRay, iFirstTriangle + i, rtResult, iHitIndex);
+					}
+					if (AnyHit && (rtResult.x < rtCurrentRay.TMax)) return;
+				}
+			}
+			rtCurrentGroup = Math::uint2(rtNode.ChildBaseIndex, iInnerChildren);
+		}
+	}
+
+
+	//the work of a traversal of the binary bvh, only counted when the traversal gets a pointer to it
+	struct TraversalCounters
+	{
+		uint64_t NumNodeTests;
+		uint64_t NumTriangleTests;
+	};
+
+	//test the one or two triangles of a leaf of the binary bvh
+	inline void CheckLeafIntersection(const IntersectionTriangle* rtTriangles, const Ray& rtCurrentRay, const AABB& rtLeaf, Math::float4& rtResult, Index& iHitIndex,
+		TraversalCounters* rtCounters)
+	{
+		CheckIntersection(rtTriangles, rtCurrentRay, rtLeaf.Padding.x & ~BVH_LEAF_FLAG, rtResult, iHitIndex);
+		if (rtLeaf.Padding.y != BVH_INVALID_INDEX)
+		{
+			CheckIntersection(rtTriangles, rtCurrentRay, rtLeaf.Padding.y & ~BVH_LEAF_FLAG, rtResult, iHitIndex);
+		}
+		if (rtCounters) rtCounters->NumTriangleTests += (rtLeaf.Padding.y != BVH_INVALID_INDEX) ? 2 : 1;
+	}
+
+	//the front-to-back traversal of the binary bvh, like BVHTraversal.hlsli without RT_USE_STACKLESS_BVH: both children of a node are tested at once,
+	//the near child is visited first and the far child is pushed with its entry distance, entries behind the closest hit are skipped when they are popped
+	//with AnyHit, this and the stackless traversal stop at the first hit, which doesn't have to be the closest one (for the occlusion queries)
+	template<bool AnyHit = false>
+	inline void TraverseBVH(const AABB* rtBVH, const IntersectionTriangle* rtTriangles, const Ray& rtCurrentRay, Math::float4& rtResult, Index& iHitIndex,
+		TraversalCounters* rtCounters = nullptr)
+	{
+		Math::uint2 rtStack[BVH_STACK_SIZE]; // x: the node, y: the entry distance as uint
+		uint32_t iNumEntries = 0;
+		uint32_t iNodeIndex = (IntersectAABB(rtCurrentRay, rtBVH[0]) != AABB_MISS) ? 0 : BVH_INVALID_INDEX;
+		if (rtCounters) rtCounters->NumNodeTests++;
+
+		while (true)
+		{
+			//continue with the nearest pushed node, which starts before the closest hit
+			while ((iNodeIndex == BVH_INVALID_INDEX) && (iNumEntries > 0))
+			{
+				iNumEntries--;
+				if (Math::asfloat(rtStack[iNumEntries].y) < rtResult.x) iNodeIndex = rtStack[iNumEntries].x;
+			}
+			if (iNodeIndex == BVH_INVALID_INDEX) break;
+
+			const AABB& rtCurrentAABB = rtBVH[iNodeIndex];
+			if (rtCurrentAABB.Padding.x & BVH_LEAF_FLAG)
+			{
+				CheckLeafIntersection(rtTriangles, rtCurrentRay, rtCurrentAABB, rtResult, iHitIndex, rtCounters);
+				if (AnyHit && (rtResult.x < rtCurrentRay.TMax)) return;
+				iNodeIndex = BVH_INVALID_INDEX;
+				continue;
+			}
+
+			float fLeft = IntersectAABB(rtCurrentRay, rtBVH[rtCurrentAABB.Padding.x]);
+			float fRight = (rtCurrentAABB.Padding.y != BVH_INVALID_INDEX) ? IntersectAABB(rtCurrentRay, rtBVH[rtCurrentAABB.Padding.y]) : AABB_MISS;
+			if (rtCounters) rtCounters->NumNodeTests += (rtCurrentAABB.Padding.y != BVH_INVALID_INDEX) ? 2 : 1;
+			bool bLeft = (fLeft != AABB_MISS) && (fLeft < rtResult.x);
+			bool bRight = (fRight != AABB_MISS) && (fRight < rtResult.x);
+
+			if (bLeft && bRight)
+			{
+				bool bLeftFirst = (fLeft <= fRight);
+				iNodeIndex = bLeftFirst ? rtCurrentAABB.Padding.x : rtCurrentAABB.Padding.y;
+				rtStack[iNumEntries] = bLeftFirst ? Math::uint2(rtCurrentAABB.Padding.y, Math::asuint(fRight)) : Math::uint2(rtCurrentAABB.Padding.x, Math::asuint(fLeft));
+				iNumEntries++; // the stack has an entry for every level (see BVH_STACK_SIZE)
+			}
+			else
+			{
+				iNodeIndex = bLeft ? rtCurrentAABB.Padding.x : (bRight ? rtCurrentAABB.Padding.y : BVH_INVALID_INDEX);
+			}
+		}
+	}
+
+	//the stackless traversal of the binary bvh with the skip links of BuildSkipLinks: a hit inner node continues with its left child,
+	//a missed node or a leaf continues with its skip link, so the nodes are always visited in depth-first order (left child first)
+	template<bool AnyHit = false>
+	inline void TraverseBVHStackless(const AABB* rtBVH, const uint32_t* iSkipLinks, const IntersectionTriangle* rtTriangles, const Ray& rtCurrentRay,
+		Math::float4& rtResult, Index& iHitIndex, TraversalCounters* rtCounters = nullptr)
+	{
+		uint32_t iNodeIndex = 0;
+		while (iNodeIndex != BVH_INVALID_INDEX)
+		{
+			const AABB& rtCurrentAABB = rtBVH[iNodeIndex];
+			float fCurrentResult = IntersectAABB(rtCurrentRay, rtCurrentAABB);
+			if (rtCounters) rtCounters->NumNodeTests++;
+			if ((fCurrentResult != AABB_MISS) && (fCurrentResult < rtResult.x))
+			{
+				if (!(rtCurrentAABB.Padding.x & BVH_LEAF_FLAG))
+				{
+					iNodeIndex = rtCurrentAABB.Padding.x;
+					continue;
+				}
+				CheckLeafIntersection(rtTriangles, rtCurrentRay, rtCurrentAABB, rtResult, iHitIndex, rtCounters);
+				if (AnyHit && (rtResult.x < rtCurrentRay.TMax)) return;
+			}
+			iNodeIndex = iSkipLinks[iNodeIndex];
+		}
+	}
+
+
+	//barycentric interpolation of the vertex attributes
+	template<typename Type>
+	inline Type Interpolate(const Type& rtAttr1, const Type& rtAttr2, const Type& rtAttr3, float fU, float fV)
+	{
+		return rtAttr1 * (1.0f - fU - fV) + rtAttr2 * fU + rtAttr3 * fV;
+	}
+
+}
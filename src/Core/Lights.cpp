@@ -0,0 +1,92 @@
+//include-files
+#include "Lights.h"
+
+#include <vector>
+
+
+
+namespace RT::Core
+{
+
+	std::shared_ptr<const LightList> BuildLightList(const MeshInfo& rtMesh)
+	{
+		std::shared_ptr<LightList> rtLights = std::make_shared<LightList>();
+		rtLights->TotalPower = 0.0f;
+		if ((!(rtMesh.Indices)) || (!(rtMesh.Vertices)) || (!(rtMesh.Materials))) return rtLights;
+
+		//collect the triangles with an emissive material and their power
+		std::vector<float> fPowers;
+		double dTotalPower = 0.0;
+		for (uint64_t i = 0; i + 2 < rtMesh.IndexCount; i += 3)
+		{
+			const Vertex& rtVertex1 = rtMesh.Vertices[rtMesh.Indices[i]];
+			uint32_t iMaterialID = rtVertex1.MaterialID;
+			if (iMaterialID >= rtMesh.MaterialCount) continue;
+			float fLuminance = Luminance(rtMesh.Materials[iMaterialID].Emissive);
+			if (!(fLuminance > 0.0f)) continue;
+
+			EmissiveTriangle rtLight{};
+			rtLight.Vertex1 = rtVertex1.Position;
+			rtLight.FirstIndex = (Index)i;
+			rtLight.Edge1 = rtMesh.Vertices[rtMesh.Indices[i + 1]].Position - rtVertex1.Position;
+			rtLight.Edge2 = rtMesh.Vertices[rtMesh.Indices[i + 2]].Position - rtVertex1.Position;
+			float fPower = fLuminance * 0.5f * Math::length(Math::cross(rtLight.Edge1, rtLight.Edge2));
+			if (!(fPower > 0.0f)) continue; // degenerate triangles can't be sampled
+
+			rtLights->Triangles.push_back(rtLight);
+			fPowers.push_back(fPower);
+			dTotalPower += (double)fPower;
+		}
+		if (rtLights->Triangles.empty()) return rtLights;
+		rtLights->TotalPower = (float)dTotalPower;
+
+		//build the alias table with Vose's method: the lights, which are picked less often than the average, are filled up with the alias of a bigger one
+		const uint32_t iNumLights = (uint32_t)rtLights->Triangles.size();
+		std::vector<double> dScaledPowers(iNumLights);
+		std::vector<uint32_t> iSmall;
+		std::vector<uint32_t> iLarge;
+		for (uint32_t i = 0; i < iNumLights; i++)
+		{
+			dScaledPowers[i] = (double)fPowers[i] * (double)iNumLights / dTotalPower;
+			if (dScaledPowers[i] < 1.0)
+			{
+				iSmall.push_back(i);
+			}
+			else
+			{
+				iLarge.push_back(i);
+			}
+		}
+		while ((!(iSmall.empty())) && (!(iLarge.empty())))
+		{
+			uint32_t iSmallLight = iSmall.back();
+			uint32_t iLargeLight = iLarge.back();
+			iSmall.pop_back();
+			rtLights->Triangles[iSmallLight].AliasProbability = (float)dScaledPowers[iSmallLight];
+			rtLights->Triangles[iSmallLight].Alias = iLargeLight;
+
+			//the large light gives away the rest of the small one's slot
+			dScaledPowers[iLargeLight] -= 1.0 - dScaledPowers[iSmallLight];
+			if (dScaledPowers[iLargeLight] < 1.0)
+			{
+				iLarge.pop_back();
+				iSmall.push_back(iLargeLight);
+			}
+		}
+
+		//the remaining lights fill their slot completely (only rounding errors are left)
+		for (uint32_t i : iSmall)
+		{
+			rtLights->Triangles[i].AliasProbability = 1.0f;
+			rtLights->Triangles[i].Alias = i;
+		}
+		for (uint32_t i : iLarge)
+		{
+			rtLights->Triangles[i].AliasProbability = 1.0f;
+			rtLights->Triangles[i].Alias = i;
+		}
+
+		return rtLights;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cmath>
+
+#include "Core/Math.h"
+#include "Core/MeshLoader.h"
+
+
+
+//the light list for next-event estimation: every triangle with an emissive material is a light, which is picked with the probability of its power
+//(the cpu port of LightSampling.hlsli, the layouts match the structs in the shaders)
+namespace RT::Core
+{
+
+	//a light of the alias table, the light i is picked, if a random number is below AliasProbability, otherwise its alias is picked
+	struct EmissiveTriangle
+	{
+		Math::float3 Vertex1;
+		Index FirstIndex; // the position of the triangle in the index buffer
+		Math::float3 Edge1; // = Vertex2 - Vertex1
+		float AliasProbability;
+		Math::float3 Edge2; // = Vertex3 - Vertex1
+		uint32_t Alias; // = 3 * 16 bytes = 48 bytes
+	};
+
+	struct LightList
+	{
+		std::vector<EmissiveTriangle> Triangles;
+		float TotalPower; // the summed luminance of the emissive materials times the area of their triangles
+	};
+
+	static_assert(sizeof(EmissiveTriangle) == 48, "EmissiveTriangle has to match the layout in LightSampling.hlsli");
+
+
+	//collects the emissive triangles of the mesh into a power weighted alias table (the emissive textures aren't part of the power)
+	std::shared_ptr<const LightList> BuildLightList(const MeshInfo& rtMesh);
+
+
+
+	//the functions of LightSampling.hlsli
+	//the brightness of an emissive color, which weights the lights
+	inline float Luminance(const Math::float3& rtColor)
+	{
+		return Math::dot(rtColor, Math::float3(0.2126f, 0.7152f, 0.0722f));
+	}
+
+	//picks a light with the probability of its power in constant time
+	inline uint32_t SelectLight(const EmissiveTriangle* rtLights, uint32_t iNumLights, float fRandom1, float fRandom2)
+	{
+		uint32_t iLight = (uint32_t)(fRandom1 * (float)iNumLights);
+		iLight = (iLight < iNumLights) ? iLight : (iNumLights - 1);
+		return (fRandom2 < rtLights[iLight].AliasProbability) ? iLight : rtLights[iLight].Alias;
+	}
+
+	//a uniformly distributed point on a triangle, returned as the barycentric coordinates of the second and the third vertex
+	inline Math::float2 PointOnTriangle(float fRandom1, float fRandom2)
+	{
+		float fSqrtRandom = std::sqrt(fRandom1);
+		return Math::float2(fSqrtRandom * (1.0f - fRandom2), fSqrtRandom * fRandom2);
+	}
+
+	//the solid angle pdf of reaching a point of a light, either by sampling the light list or by a bsdf sample, which hits it:
+	//the power of the triangle over the total power, divided by its area and converted from area to solid angle
+	//(luminance * area / total power) * (1 / area) * (distance^2 / cos) = luminance * distance^2 / (total power * cos)
+	inline float LightPDF(float fLuminance, float fInverseTotalPower, float fDistanceSquared, float fLightCosine)
+	{
+		return (fLightCosine > 1e-6f) ? (fLuminance * fInverseTotalPower * fDistanceSquared / fLightCosine) : 0.0f;
+	}
+
+	//the power heuristic of multiple importance sampling: the weight of a sample with the pdf fPDF1, which could also be taken with the pdf fPDF2
+	inline float PowerHeuristic(float fPDF1, float fPDF2)
+	{
+		float fSquaredPDF1 = fPDF1 * fPDF1;
+		return (fPDF1 > 0.0f) ? (fSquaredPDF1 / (fSquaredPDF1 + fPDF2 * fPDF2)) : 0.0f;
+	}
+
+}
\ No newline at end of file
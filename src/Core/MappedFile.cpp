@@ -0,0 +1,110 @@
+//include-files
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+
+namespace RT::Core
+{
+
+	//constructor: initializes all the variables
+	MappedFile::MappedFile() :
+		//initialize the class variables
+		m_pData(nullptr),
+		m_iSize(0),
+#ifdef _WIN32
+		m_pFileHandle(INVALID_HANDLE_VALUE),
+		m_pMappingHandle(nullptr)
+#else
+		m_iFileDescriptor(-1)
+#endif
+	{
+
+	}
+
+	//destructor: unmaps the file
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+
+
+	//public class functions
+	bool MappedFile::Open(const std::string& sFileName)
+	{
+		Close();
+
+#ifdef _WIN32
+		m_pFileHandle = CreateFileA(sFileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (m_pFileHandle == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER iFileSize{};
+		if ((!GetFileSizeEx(m_pFileHandle, &iFileSize)) || (iFileSize.QuadPart <= 0))
+		{
+			Close();
+			return false;
+		}
+		m_iSize = (uint64_t)iFileSize.QuadPart;
+
+		m_pMappingHandle = CreateFileMappingA(m_pFileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_pMappingHandle)
+		{
+			Close();
+			return false;
+		}
+		m_pData = (const uint8_t*)MapViewOfFile(m_pMappingHandle, FILE_MAP_READ, 0, 0, 0);
+#else
+		m_iFileDescriptor = open(sFileName.c_str(), O_RDONLY);
+		if (m_iFileDescriptor < 0) return false;
+
+		struct stat rtFileStatus{};
+		if ((fstat(m_iFileDescriptor, &rtFileStatus) != 0) || (rtFileStatus.st_size <= 0))
+		{
+			Close();
+			return false;
+		}
+		m_iSize = (uint64_t)rtFileStatus.st_size;
+
+		void* pData = mmap(nullptr, m_iSize, PROT_READ, MAP_PRIVATE, m_iFileDescriptor, 0);
+		m_pData = (pData == MAP_FAILED) ? nullptr : (const uint8_t*)pData;
+#endif
+
+		if (!m_pData)
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+
+	void MappedFile::Close()
+	{
+#ifdef _WIN32
+		if (m_pData) UnmapViewOfFile(m_pData);
+		if (m_pMappingHandle) CloseHandle(m_pMappingHandle);
+		if (m_pFileHandle != INVALID_HANDLE_VALUE) CloseHandle(m_pFileHandle);
+		m_pMappingHandle = nullptr;
+		m_pFileHandle = INVALID_HANDLE_VALUE;
+#else
+		if (m_pData) munmap((void*)m_pData, m_iSize);
+		if (m_iFileDescriptor >= 0) close(m_iFileDescriptor);
+		m_iFileDescriptor = -1;
+#endif
+		m_pData = nullptr;
+		m_iSize = 0;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+
+
+namespace RT::Core
+{
+
+	//a read only memory mapping of a whole file, the pages are loaded by the operating system when they are accessed
+	class MappedFile
+	{
+	private:
+
+		//the mapping
+		const uint8_t* m_pData;
+		uint64_t m_iSize;
+#ifdef _WIN32
+		void* m_pFileHandle;
+		void* m_pMappingHandle;
+#else
+		int m_iFileDescriptor;
+#endif
+
+
+	public: // = usable outside of the class
+
+		//constructor and destructor
+		MappedFile();
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+
+		//class functions
+		bool Open(const std::string& sFileName);
+		void Close();
+
+
+		//helper functions
+		const uint8_t* GetData() const { return m_pData; };
+		uint64_t GetSize() const { return m_iSize; };
+		bool IsOpen() const { return m_pData != nullptr; };
+
+	};
+
+}
\ No newline at end of file
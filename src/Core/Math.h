@@ -0,0 +1,260 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+
+
+//a small hlsl-like math library, so the shader code can be ported to the cpu almost line by line
+namespace RT::Math
+{
+
+	//vector types
+	struct float2
+	{
+		float x, y;
+
+		float2() : x(0.0f), y(0.0f) {};
+		float2(float fValue) : x(fValue), y(fValue) {};
+		float2(float fX, float fY) : x(fX), y(fY) {};
+	};
+
+	struct float3
+	{
+		float x, y, z;
+
+		float3() : x(0.0f), y(0.0f), z(0.0f) {};
+		float3(float fValue) : x(fValue), y(fValue), z(fValue) {};
+		float3(float fX, float fY, float fZ) : x(fX), y(fY), z(fZ) {};
+
+		float2 xy() const { return float2(x, y); };
+	};
+
+	struct float4
+	{
+		float x, y, z, w;
+
+		float4() : x(0.0f), y(0.0f), z(0.0f), w(0.0f) {};
+		float4(float fValue) : x(fValue), y(fValue), z(fValue), w(fValue) {};
+		float4(float fX, float fY, float fZ, float fW) : x(fX), y(fY), z(fZ), w(fW) {};
+		float4(float2 rtXY, float fZ, float fW) : x(rtXY.x), y(rtXY.y), z(fZ), w(fW) {};
+		float4(float3 rtXYZ, float fW) : x(rtXYZ.x), y(rtXYZ.y), z(rtXYZ.z), w(fW) {};
+
+		float2 xy() const { return float2(x, y); };
+		float2 zw() const { return float2(z, w); };
+		float3 xyz() const { return float3(x, y, z); };
+	};
+
+	struct int2
+	{
+		int32_t x, y;
+	};
+
+	struct uint2
+	{
+		uint32_t x, y;
+	};
+
+	struct uint3
+	{
+		uint32_t x, y, z;
+	};
+
+	struct uint4
+	{
+		uint32_t x, y, z, w;
+	};
+
+	//a row major matrix, that is used like the DirectXMath matrices (row vectors, v' = v * M)
+	struct float4x4
+	{
+		float m[4][4];
+	};
+
+
+
+	//per component operators
+#define RT_MATH_VECTOR_OPERATOR(Type, Op) \
+	inline Type operator Op(const Type& rtA, const Type& rtB) \
+	{ \
+		Type rtResult; \
+		for (int i = 0; i < (int)(sizeof(Type) / sizeof(float)); i++) { (&rtResult.x)[i] = (&rtA.x)[i] Op (&rtB.x)[i]; } \
+		return rtResult; \
+	} \
+	inline Type operator Op(const Type& rtA, float fB) { return rtA Op Type(fB); } \
+	inline Type operator Op(float fA, const Type& rtB) { return Type(fA) Op rtB; } \
+	inline Type& operator Op##=(Type& rtA, const Type& rtB) { rtA = rtA Op rtB; return rtA; } \
+	inline Type& operator Op##=(Type& rtA, float fB) { rtA = rtA Op Type(fB); return rtA; }
+
+	RT_MATH_VECTOR_OPERATOR(float2, +)
+	RT_MATH_VECTOR_OPERATOR(float2, -)
+	RT_MATH_VECTOR_OPERATOR(float2, *)
+	RT_MATH_VECTOR_OPERATOR(float2, /)
+	RT_MATH_VECTOR_OPERATOR(float3, +)
+	RT_MATH_VECTOR_OPERATOR(float3, -)
+	RT_MATH_VECTOR_OPERATOR(float3, *)
+	RT_MATH_VECTOR_OPERATOR(float3, /)
+	RT_MATH_VECTOR_OPERATOR(float4, +)
+	RT_MATH_VECTOR_OPERATOR(float4, -)
+	RT_MATH_VECTOR_OPERATOR(float4, *)
+	RT_MATH_VECTOR_OPERATOR(float4, /)
+
+#undef RT_MATH_VECTOR_OPERATOR
+
+	inline float2 operator-(const float2& rtA) { return float2(-rtA.x, -rtA.y); }
+	inline float3 operator-(const float3& rtA) { return float3(-rtA.x, -rtA.y, -rtA.z); }
+	inline float4 operator-(const float4& rtA) { return float4(-rtA.x, -rtA.y, -rtA.z, -rtA.w); }
+
+
+
+	//scalar functions
+	inline float saturate(float fValue) { return std::min(std::max(fValue, 0.0f), 1.0f); }
+	inline float lerp(float fA, float fB, float fT) { return fA + (fB - fA) * fT; }
+	inline float rcp(float fValue) { return 1.0f / fValue; }
+	inline float frac(float fValue) { return fValue - std::floor(fValue); }
+	inline float asfloat(uint32_t iValue) { float fResult; std::memcpy(&fResult, &iValue, sizeof(float)); return fResult; }
+	inline uint32_t asuint(float fValue) { uint32_t iResult; std::memcpy(&iResult, &fValue, sizeof(float)); return iResult; }
+
+
+	//vector functions
+	inline float dot(const float2& rtA, const float2& rtB) { return rtA.x * rtB.x + rtA.y * rtB.y; }
+	inline float dot(const float3& rtA, const float3& rtB) { return rtA.x * rtB.x + rtA.y * rtB.y + rtA.z * rtB.z; }
+	inline float dot(const float4& rtA, const float4& rtB) { return rtA.x * rtB.x + rtA.y * rtB.y + rtA.z * rtB.z + rtA.w * rtB.w; }
+
+	inline float3 cross(const float3& rtA, const float3& rtB)
+	{
+		return float3(rtA.y * rtB.z - rtA.z * rtB.y, rtA.z * rtB.x - rtA.x * rtB.z, rtA.x * rtB.y - rtA.y * rtB.x);
+	}
+
+	inline float length(const float3& rtA) { return std::sqrt(dot(rtA, rtA)); }
+	inline float3 normalize(const float3& rtA) { return rtA * (1.0f / length(rtA)); }
+
+	inline float3 min(const float3& rtA, const float3& rtB) { return float3(std::min(rtA.x, rtB.x), std::min(rtA.y, rtB.y), std::min(rtA.z, rtB.z)); }
+	inline float3 max(const float3& rtA, const float3& rtB) { return float3(std::max(rtA.x, rtB.x), std::max(rtA.y, rtB.y), std::max(rtA.z, rtB.z)); }
+	inline float3 saturate(const float3& rtA) { return float3(saturate(rtA.x), saturate(rtA.y), saturate(rtA.z)); }
+	inline float3 abs(const float3& rtA) { return float3(std::fabs(rtA.x), std::fabs(rtA.y), std::fabs(rtA.z)); }
+	inline float3 reflect(const float3& rtI, const float3& rtN) { return rtI - rtN * (2.0f * dot(rtI, rtN)); }
+	inline float2 lerp(const float2& rtA, const float2& rtB, float fT) { return rtA + (rtB - rtA) * fT; }
+	inline float3 lerp(const float3& rtA, const float3& rtB, float fT) { return rtA + (rtB - rtA) * fT; }
+
+
+
+	//matrix functions
+	//hlsl's mul(vector, matrix), the vector is treated as a row vector
+	inline float4 mul(const float4& rtV, const float4x4& rtM)
+	{
+		float4 rtResult;
+		for (int i = 0; i < 4; i++)
+		{
+			(&rtResult.x)[i] = rtV.x * rtM.m[0][i] + rtV.y * rtM.m[1][i] + rtV.z * rtM.m[2][i] + rtV.w * rtM.m[3][i];
+		}
+		return rtResult;
+	}
+
+	//hlsl's mul(matrix, vector), the vector is treated as a column vector
+	inline float4 mul(const float4x4& rtM, const float4& rtV)
+	{
+		float4 rtResult;
+		for (int i = 0; i < 4; i++)
+		{
+			(&rtResult.x)[i] = rtM.m[i][0] * rtV.x + rtM.m[i][1] * rtV.y + rtM.m[i][2] * rtV.z + rtM.m[i][3] * rtV.w;
+		}
+		return rtResult;
+	}
+
+	inline float4x4 mul(const float4x4& rtA, const float4x4& rtB)
+	{
+		float4x4 rtResult{};
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				rtResult.m[i][j] = rtA.m[i][0] * rtB.m[0][j] + rtA.m[i][1] * rtB.m[1][j] + rtA.m[i][2] * rtB.m[2][j] + rtA.m[i][3] * rtB.m[3][j];
+			}
+		}
+		return rtResult;
+	}
+
+	inline float4x4 Transpose(const float4x4& rtM)
+	{
+		float4x4 rtResult{};
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				rtResult.m[i][j] = rtM.m[j][i];
+			}
+		}
+		return rtResult;
+	}
+
+	//general 4x4 inverse using the cofactors of the matrix
+	inline float4x4 Inverse(const float4x4& rtM)
+	{
+		const float* a = &rtM.m[0][0];
+		float b[16];
+
+		b[0] = a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+		b[4] = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+		b[8] = a[4] * a[9] * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+		b[12] = -a[4] * a[9] * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+		b[1] = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+		b[5] = a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+		b[9] = -a[0] * a[9] * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+		b[13] = a[0] * a[9] * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+		b[2] = a[1] * a[6] * a[15] - a[1] * a[7] * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14] + a[13] * a[2] * a[7] - a[13] * a[3] * a[6];
+		b[6] = -a[0] * a[6] * a[15] + a[0] * a[7] * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14] - a[12] * a[2] * a[7] + a[12] * a[3] * a[6];
+		b[10] = a[0] * a[5] * a[15] - a[0] * a[7] * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13] + a[12] * a[1] * a[7] - a[12] * a[3] * a[5];
+		b[14] = -a[0] * a[5] * a[14] + a[0] * a[6] * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13] - a[12] * a[1] * a[6] + a[12] * a[2] * a[5];
+		b[3] = -a[1] * a[6] * a[11] + a[1] * a[7] * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10] - a[9] * a[2] * a[7] + a[9] * a[3] * a[6];
+		b[7] = a[0] * a[6] * a[11] - a[0] * a[7] * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10] + a[8] * a[2] * a[7] - a[8] * a[3] * a[6];
+		b[11] = -a[0] * a[5] * a[11] + a[0] * a[7] * a[9] + a[4] * a[1] * a[11] - a[4] * a[3] * a[9] - a[8] * a[1] * a[7] + a[8] * a[3] * a[5];
+		b[15] = a[0] * a[5] * a[10] - a[0] * a[6] * a[9] - a[4] * a[1] * a[10] + a[4] * a[2] * a[9] + a[8] * a[1] * a[6] - a[8] * a[2] * a[5];
+
+		float fDeterminant = a[0] * b[0] + a[1] * b[4] + a[2] * b[8] + a[3] * b[12];
+		float fInverseDeterminant = (fDeterminant == 0.0f) ? 0.0f : 1.0f / fDeterminant;
+
+		float4x4 rtResult{};
+		for (int i = 0; i < 16; i++)
+		{
+			(&rtResult.m[0][0])[i] = b[i] * fInverseDeterminant;
+		}
+		return rtResult;
+	}
+
+	//the same matrices as DirectX::XMMatrixPerspectiveFovLH and DirectX::XMMatrixLookAtLH
+	inline float4x4 PerspectiveFovLH(float fFovAngleY, float fAspectRatio, float fNearZ, float fFarZ)
+	{
+		float fHeight = std::cos(0.5f * fFovAngleY) / std::sin(0.5f * fFovAngleY);
+		float fWidth = fHeight / fAspectRatio;
+		float fRange = fFarZ / (fFarZ - fNearZ);
+
+		float4x4 rtResult{};
+		rtResult.m[0][0] = fWidth;
+		rtResult.m[1][1] = fHeight;
+		rtResult.m[2][2] = fRange;
+		rtResult.m[2][3] = 1.0f;
+		rtResult.m[3][2] = -fRange * fNearZ;
+		return rtResult;
+	}
+
+	inline float4x4 LookAtLH(const float3& rtEyePosition, const float3& rtFocusPosition, const float3& rtUpDirection)
+	{
+		float3 rtZAxis = normalize(rtFocusPosition - rtEyePosition);
+		float3 rtXAxis = normalize(cross(rtUpDirection, rtZAxis));
+		float3 rtYAxis = cross(rtZAxis, rtXAxis);
+
+		float4x4 rtResult{};
+		rtResult.m[0][0] = rtXAxis.x; rtResult.m[0][1] = rtYAxis.x; rtResult.m[0][2] = rtZAxis.x;
+		rtResult.m[1][0] = rtXAxis.y; rtResult.m[1][1] = rtYAxis.y; rtResult.m[1][2] = rtZAxis.y;
+		rtResult.m[2][0] = rtXAxis.z; rtResult.m[2][1] = rtYAxis.z; rtResult.m[2][2] = rtZAxis.z;
+		rtResult.m[3][0] = -dot(rtXAxis, rtEyePosition);
+		rtResult.m[3][1] = -dot(rtYAxis, rtEyePosition);
+		rtResult.m[3][2] = -dot(rtZAxis, rtEyePosition);
+		rtResult.m[3][3] = 1.0f;
+		return rtResult;
+	}
+
+}
\ No newline at end of file
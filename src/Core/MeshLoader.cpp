@@ -0,0 +1,610 @@
+//include-files
+#include "MeshLoader.h"
+#include "SIMD.h"
+#include "Parallel.h"
+#include "ObjParser.h"
+#include "Lights.h"
+
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <bit>
+#include <chrono>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tinyobjloader/tiny_obj_loader.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+
+
+namespace RT::Core
+{
+	//load a texture
+	TextureInfo LoadTextureFromFile(const std::string& sFileName, int iDesiredNumChannels, bool bHighPrecision)
+	{
+		int iWidth = 0;
+		int iHeight = 0;
+		int iNumComponents = 0;
+		int iBytesPerChannel = 0;
+		unsigned char* pData = nullptr;
+
+		if (bHighPrecision)
+		{
+			iBytesPerChannel = 2;
+			pData = (unsigned char*)stbi_load_16(sFileName.c_str(), &iWidth, &iHeight, &iNumComponents, iDesiredNumChannels);
+		}
+		else
+		{
+			iBytesPerChannel = 1;
+			pData = stbi_load(sFileName.c_str(), &iWidth, &iHeight, &iNumComponents, iDesiredNumChannels);
+		}
+		if (iDesiredNumChannels > 0) iNumComponents = iDesiredNumChannels;
+		if ((!pData) || (iNumComponents < 1) || (iBytesPerChannel < 1) || (iWidth < 1) || (iHeight < 1))
+		{
+			std::cout << "Error loading textures: " << stbi_failure_reason() << "\n";
+			return TextureInfo{};
+		}
+
+		unsigned int iMemorySize = (unsigned int)iWidth * (unsigned int)iHeight * (unsigned int)iNumComponents * (unsigned int)iBytesPerChannel;
+		TextureInfo rtTextureData{};
+		rtTextureData.Data = new uint8_t[iMemorySize];
+		memcpy(rtTextureData.Data, pData, iMemorySize);
+		rtTextureData.Width = iWidth;
+		rtTextureData.Height = iHeight;
+		rtTextureData.BytesPerChannel = (unsigned short)iBytesPerChannel;
+		rtTextureData.ChannelCount = (unsigned short)iNumComponents;
+
+		stbi_image_free(pData);
+
+		std::cout << "Successfully loaded a texture with following parameters:\n Width:           " << rtTextureData.Width << "\n Height:          "
+			<< rtTextureData.Height << "\n Bytes per pixel: " << (rtTextureData.BytesPerChannel * rtTextureData.ChannelCount) << "\n";
+
+		return rtTextureData;
+	}
+
+
+	//helper functions for mesh loading
+	const uint64_t ACCUMULATION_RANGE_SIZE = 16384; // the triangles of a partial sum of AccumulateTriangleValues and the vertices of a block of its merge
+
+	//adds fnGetValue(iIndex1, iIndex2, iIndex3) of every triangle to its three vertices and calls fnStore(iVertex, rtSum) for every used vertex
+	//every range of ACCUMULATION_RANGE_SIZE triangles is summed up in its own buffer, which only covers the vertices of these triangles
+	//(the vertices are numbered in the order of their first use, so these ranges are small and only overlap a little)
+	//the ranges don't depend on the number of threads, so the sums are rounded the same way on every machine
+	template<typename ValueFunction, typename StoreFunction>
+	void AccumulateTriangleValues(MeshInfo* ionMeshInfo, const ValueFunction& fnGetValue, const StoreFunction& fnStore)
+	{
+		struct PartialSums
+		{
+			uint64_t FirstVertex;
+			std::vector<Math::SIMD::float4v> Sums;
+			std::vector<uint8_t> Used;
+		};
+
+		const Index* iIndexData = ionMeshInfo->Indices;
+		const uint64_t iTriangleCount = ionMeshInfo->IndexCount / 3;
+		const uint64_t iNumRanges = std::max<uint64_t>(1, (iTriangleCount + ACCUMULATION_RANGE_SIZE - 1) / ACCUMULATION_RANGE_SIZE);
+		std::vector<PartialSums> rtPartialSums(iNumRanges);
+
+		//the sums of every range, the triangles of a range are added in their order
+		ParallelFor(iNumRanges, 1, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t r = iBegin; r < iEnd; r++)
+			{
+				const uint64_t iFirstTriangle = r * ACCUMULATION_RANGE_SIZE;
+				const uint64_t iLastTriangle = std::min(iTriangleCount, (r + 1) * ACCUMULATION_RANGE_SIZE);
+				if (iFirstTriangle >= iLastTriangle) continue;
+
+				Index iMinIndex = iIndexData[iFirstTriangle * 3];
+				Index iMaxIndex = iMinIndex;
+				for (uint64_t i = iFirstTriangle * 3; i < iLastTriangle * 3; i++)
+				{
+					iMinIndex = std::min(iMinIndex, iIndexData[i]);
+					iMaxIndex = std::max(iMaxIndex, iIndexData[i]);
+				}
+
+				PartialSums& rtSums = rtPartialSums[r];
+				rtSums.FirstVertex = iMinIndex;
+				rtSums.Sums.assign((uint64_t)(iMaxIndex - iMinIndex) + 1, Math::SIMD::Zero());
+				rtSums.Used.assign((uint64_t)(iMaxIndex - iMinIndex) + 1, 0);
+				for (uint64_t i = iFirstTriangle; i < iLastTriangle; i++)
+				{
+					Index iIndex1 = iIndexData[i * 3];
+					Index iIndex2 = iIndexData[i * 3 + 1];
+					Index iIndex3 = iIndexData[i * 3 + 2];
+
+					Math::SIMD::float4v rtValue = fnGetValue(iIndex1, iIndex2, iIndex3);
+					rtSums.Sums[iIndex1 - iMinIndex] += rtValue;
+					rtSums.Sums[iIndex2 - iMinIndex] += rtValue;
+					rtSums.Sums[iIndex3 - iMinIndex] += rtValue;
+					rtSums.Used[iIndex1 - iMinIndex] = 1;
+					rtSums.Used[iIndex2 - iMinIndex] = 1;
+					rtSums.Used[iIndex3 - iMinIndex] = 1;
+				}
+			}
+		});
+
+		//add up the partial sums of every vertex in the order of the ranges, every block of vertices only looks at the ranges, which overlap it
+		const uint64_t iNumBlocks = (ionMeshInfo->VertexCount + ACCUMULATION_RANGE_SIZE - 1) / ACCUMULATION_RANGE_SIZE;
+		ParallelFor(iNumBlocks, 1, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			std::vector<const PartialSums*> rtBlockSums;
+			for (uint64_t b = iBegin; b < iEnd; b++)
+			{
+				const uint64_t iFirstVertex = b * ACCUMULATION_RANGE_SIZE;
+				const uint64_t iLastVertex = std::min(ionMeshInfo->VertexCount, (b + 1) * ACCUMULATION_RANGE_SIZE);
+				rtBlockSums.clear();
+				for (const PartialSums& rtSums : rtPartialSums)
+				{
+					if ((!(rtSums.Sums.empty())) && (rtSums.FirstVertex < iLastVertex) && (rtSums.FirstVertex + rtSums.Sums.size() > iFirstVertex)) rtBlockSums.push_back(&rtSums);
+				}
+
+				for (uint64_t v = iFirstVertex; v < iLastVertex; v++)
+				{
+					Math::SIMD::float4v rtSum = Math::SIMD::Zero();
+					bool bUsed = false;
+					for (const PartialSums* rtSums : rtBlockSums)
+					{
+						if ((v < rtSums->FirstVertex) || (v >= rtSums->FirstVertex + rtSums->Sums.size())) continue;
+						rtSum += rtSums->Sums[v - rtSums->FirstVertex];
+						bUsed = bUsed || rtSums->Used[v - rtSums->FirstVertex];
+					}
+					if (bUsed) fnStore(v, rtSum);
+				}
+			}
+		});
+	}
+
+	void CalculateNormals(MeshInfo* ionMeshInfo)
+	{
+		Vertex* ionVertexData = ionMeshInfo->Vertices;
+
+		AccumulateTriangleValues(ionMeshInfo, [&](Index iIndex1, Index iIndex2, Index iIndex3)
+		{
+			Math::SIMD::float4v rtPosition1 = Math::SIMD::Load(ionVertexData[iIndex1].Position);
+			Math::SIMD::float4v rtPosition2 = Math::SIMD::Load(ionVertexData[iIndex2].Position);
+			Math::SIMD::float4v rtPosition3 = Math::SIMD::Load(ionVertexData[iIndex3].Position);
+			Math::SIMD::float4v rtEdge1 = rtPosition3 - rtPosition1;
+			Math::SIMD::float4v rtEdge2 = rtPosition2 - rtPosition1;
+
+			return Math::SIMD::Cross3(rtEdge2, rtEdge1);
+		},
+		[&](uint64_t iVertex, Math::SIMD::float4v rtSum)
+		{
+			//average the normals
+			ionVertexData[iVertex].Normal = Math::SIMD::StoreFloat3(Math::SIMD::Normalize3(rtSum));
+		});
+	}
+
+	void CalculateTangents(MeshInfo* ionMeshInfo)
+	{
+		Vertex* ionVertexData = ionMeshInfo->Vertices;
+		const Math::SIMD::float4v rtEpsilon = Math::SIMD::Splat(FLT_EPSILON);
+
+		AccumulateTriangleValues(ionMeshInfo, [&](Index iIndex1, Index iIndex2, Index iIndex3)
+		{
+			//load some required data from the given mesh
+			Math::SIMD::float4v rtPosition1 = Math::SIMD::Load(ionVertexData[iIndex1].Position);
+			Math::SIMD::float4v rtPosition2 = Math::SIMD::Load(ionVertexData[iIndex2].Position);
+			Math::SIMD::float4v rtPosition3 = Math::SIMD::Load(ionVertexData[iIndex3].Position);
+			Math::SIMD::float4v rtEdge1 = rtPosition2 - rtPosition1;
+			Math::SIMD::float4v rtEdge2 = rtPosition3 - rtPosition1;
+
+			Math::SIMD::float4v rtTextureUV1 = Math::SIMD::Load(ionVertexData[iIndex1].UV);
+			Math::SIMD::float4v rtTextureUV2 = Math::SIMD::Load(ionVertexData[iIndex2].UV);
+			Math::SIMD::float4v rtTextureUV3 = Math::SIMD::Load(ionVertexData[iIndex3].UV);
+			Math::SIMD::float4v rtTextureEdge1 = rtTextureUV2 - rtTextureUV1;
+			Math::SIMD::float4v rtTextureEdge2 = rtTextureUV3 - rtTextureUV1;
+
+			//compute a nominator and denominator for the final calculations
+			Math::SIMD::float4v rtDenominator = Math::SIMD::Cross2(rtTextureEdge1, rtTextureEdge2);
+			Math::SIMD::float4v rtNominatorA = Math::SIMD::SplatY(rtTextureEdge2) * rtEdge1;
+			Math::SIMD::float4v rtNominatorB = Math::SIMD::SplatY(rtTextureEdge1) * rtEdge2;
+			Math::SIMD::float4v rtNominator = rtNominatorA - rtNominatorB;
+
+			//check if the denominator isn't almost equal to 0 and compute the tangent
+			Math::SIMD::float4v rtDivideByZero = Math::SIMD::InBounds(rtDenominator, rtEpsilon);
+			return Math::SIMD::Select(rtNominator / rtDenominator, Math::SIMD::Zero(), rtDivideByZero);
+		},
+		[&](uint64_t iVertex, Math::SIMD::float4v rtSum)
+		{
+			//average the tangents
+			ionVertexData[iVertex].Tangent = Math::SIMD::StoreFloat3(Math::SIMD::Normalize3(rtSum));
+		});
+	}
+
+	bool VerticesAreEqual(const Vertex& rtVertex1, const Vertex& rtVertex2)
+	{
+		if ((rtVertex1.Position.x != rtVertex2.Position.x) ||
+			(rtVertex1.Position.y != rtVertex2.Position.y) ||
+			(rtVertex1.Position.z != rtVertex2.Position.z)) return false;
+		if ((rtVertex1.UV.x != rtVertex2.UV.x) ||
+			(rtVertex1.UV.y != rtVertex2.UV.y)) return false;
+		if ((rtVertex1.Normal.x != rtVertex2.Normal.x) ||
+			(rtVertex1.Normal.y != rtVertex2.Normal.y) ||
+			(rtVertex1.Normal.z != rtVertex2.Normal.z)) return false;
+		if (rtVertex1.MaterialID != rtVertex2.MaterialID) return false;
+		return true;
+	}
+
+	//the hash of a vertex, equal vertices (see VerticesAreEqual) always get the same hash
+	uint64_t HashVertex(const Vertex& rtVertex)
+	{
+		const float fAttributes[8] = { rtVertex.Position.x, rtVertex.Position.y, rtVertex.Position.z, rtVertex.UV.x, rtVertex.UV.y,
+			rtVertex.Normal.x, rtVertex.Normal.y, rtVertex.Normal.z };
+
+		uint64_t iHash = rtVertex.MaterialID;
+		for (float fAttribute : fAttributes)
+		{
+			//0.0 and -0.0 are equal, so they need the same bits
+			uint32_t iBits = (fAttribute == 0.0f) ? 0 : std::bit_cast<uint32_t>(fAttribute);
+			iHash = (iHash ^ iBits) * 0x9e3779b97f4a7c15ull;
+			iHash ^= iHash >> 32;
+		}
+
+		//the finalizer of murmur3, so that the upper bits (the shard) and the lower bits (the slot) are both well distributed
+		iHash ^= iHash >> 33;
+		iHash *= 0xff51afd7ed558ccdull;
+		iHash ^= iHash >> 33;
+		iHash *= 0xc4ceb9fe1a85ec53ull;
+		iHash ^= iHash >> 33;
+		return iHash;
+	}
+
+	//removes the duplicates of the vertices and writes the index of the remaining vertex for every input vertex
+	//the unique vertices are stored in the order of their first occurrence, so the result doesn't depend on the number of threads
+	uint64_t WeldVertices(const Vertex* rtVertices, uint64_t iNumVertices, Index* rtIndices, Vertex* rtUniqueVertices)
+	{
+		const uint32_t iShardBits = 6;
+		const uint32_t iNumShards = 1 << iShardBits;
+		const uint64_t iGrainSize = 65536;
+		const uint64_t iNumChunks = (iNumVertices + iGrainSize - 1) / iGrainSize;
+		const Index iEmptySlot = 0xffffffff;
+
+		//hash all vertices
+		std::vector<uint64_t> iHashes(iNumVertices);
+		ParallelFor(iNumVertices, iGrainSize, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t i = iBegin; i < iEnd; i++)
+			{
+				iHashes[i] = HashVertex(rtVertices[i]);
+			}
+		});
+		auto fnGetShard = [&](uint64_t iVertex) { return (uint32_t)(iHashes[iVertex] >> (64 - iShardBits)); };
+
+		//distribute the vertices to the shards (a stable counting sort by the upper bits of the hash)
+		std::vector<uint64_t> iChunkOffsets(iNumChunks * iNumShards, 0);
+		ParallelFor(iNumChunks, 1, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t c = iBegin; c < iEnd; c++)
+			{
+				for (uint64_t i = c * iGrainSize; i < std::min((c + 1) * iGrainSize, iNumVertices); i++)
+				{
+					iChunkOffsets[c * iNumShards + fnGetShard(i)]++;
+				}
+			}
+		});
+
+		std::vector<uint64_t> iShardOffsets(iNumShards + 1, 0);
+		uint64_t iOffset = 0;
+		for (uint32_t s = 0; s < iNumShards; s++)
+		{
+			iShardOffsets[s] = iOffset;
+			for (uint64_t c = 0; c < iNumChunks; c++)
+			{
+				uint64_t iCount = iChunkOffsets[c * iNumShards + s];
+				iChunkOffsets[c * iNumShards + s] = iOffset;
+				iOffset += iCount;
+			}
+		}
+		iShardOffsets[iNumShards] = iOffset;
+
+		std::vector<Index> iShardVertices(iNumVertices);
+		ParallelFor(iNumChunks, 1, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t c = iBegin; c < iEnd; c++)
+			{
+				uint64_t* iOffsets = &(iChunkOffsets[c * iNumShards]);
+				for (uint64_t i = c * iGrainSize; i < std::min((c + 1) * iGrainSize, iNumVertices); i++)
+				{
+					iShardVertices[iOffsets[fnGetShard(i)]++] = (Index)i;
+				}
+			}
+		});
+
+		//find the first occurrence of every vertex, every shard has its own open addressing hash table (with linear probing)
+		//the vertices of a shard are in ascending order, so the first vertex inserted into a slot is always the first occurrence
+		std::vector<Index> iFirstOccurrences(iNumVertices);
+		ParallelFor(iNumShards, 1, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			std::vector<Index> iTable;
+			for (uint64_t s = iBegin; s < iEnd; s++)
+			{
+				uint64_t iShardSize = iShardOffsets[s + 1] - iShardOffsets[s];
+				if (iShardSize == 0) continue;
+
+				//the table is at most half full
+				const uint64_t iTableMask = std::bit_ceil(2 * iShardSize) - 1;
+				iTable.assign(iTableMask + 1, iEmptySlot);
+
+				for (uint64_t i = iShardOffsets[s]; i < iShardOffsets[s + 1]; i++)
+				{
+					Index iVertex = iShardVertices[i];
+					uint64_t iSlot = iHashes[iVertex] & iTableMask;
+					while (true)
+					{
+						Index iEntry = iTable[iSlot];
+						if (iEntry == iEmptySlot)
+						{
+							iTable[iSlot] = iVertex;
+							iFirstOccurrences[iVertex] = iVertex;
+							break;
+						}
+						if ((iHashes[iEntry] == iHashes[iVertex]) && VerticesAreEqual(rtVertices[iEntry], rtVertices[iVertex]))
+						{
+							iFirstOccurrences[iVertex] = iEntry;
+							break;
+						}
+						iSlot = (iSlot + 1) & iTableMask;
+					}
+				}
+			}
+		});
+
+		//number the unique vertices in the order of their first occurrence
+		std::vector<uint64_t> iChunkUniqueOffsets(iNumChunks, 0);
+		ParallelFor(iNumChunks, 1, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t c = iBegin; c < iEnd; c++)
+			{
+				for (uint64_t i = c * iGrainSize; i < std::min((c + 1) * iGrainSize, iNumVertices); i++)
+				{
+					if (iFirstOccurrences[i] == i) iChunkUniqueOffsets[c]++;
+				}
+			}
+		});
+
+		uint64_t iNumUniqueVertices = 0;
+		for (uint64_t c = 0; c < iNumChunks; c++)
+		{
+			uint64_t iCount = iChunkUniqueOffsets[c];
+			iChunkUniqueOffsets[c] = iNumUniqueVertices;
+			iNumUniqueVertices += iCount;
+		}
+
+		ParallelFor(iNumChunks, 1, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t c = iBegin; c < iEnd; c++)
+			{
+				uint64_t iUniqueIndex = iChunkUniqueOffsets[c];
+				for (uint64_t i = c * iGrainSize; i < std::min((c + 1) * iGrainSize, iNumVertices); i++)
+				{
+					if (iFirstOccurrences[i] != i) continue;
+					rtUniqueVertices[iUniqueIndex] = rtVertices[i];
+					rtIndices[i] = (Index)iUniqueIndex;
+					iUniqueIndex++;
+				}
+			}
+		});
+
+		//the duplicates get the index of their first occurrence
+		ParallelFor(iNumVertices, iGrainSize, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t i = iBegin; i < iEnd; i++)
+			{
+				if (iFirstOccurrences[i] != i) rtIndices[i] = rtIndices[iFirstOccurrences[i]];
+			}
+		});
+
+		return iNumUniqueVertices;
+	}
+
+	void GetTexture(const std::string& sTextureName, std::unordered_map<std::string, uint32_t>& stdTextureNames)
+	{
+		if (!(stdTextureNames.contains(sTextureName)))
+		{
+			uint64_t iTextureIndex = stdTextureNames.size();
+			stdTextureNames[sTextureName] = iTextureIndex;
+		}
+	}
+
+	//the actual mesh loading function
+	MeshInfo LoadMeshFromFile(const std::string& sFileName, MeshLoadTimings* rtTimings)
+	{
+		MeshLoadTimings rtStageTimes{};
+		auto stdStageStart = std::chrono::steady_clock::now();
+		auto fnEndStage = [&](double& fSeconds)
+		{
+			auto stdNow = std::chrono::steady_clock::now();
+			fSeconds = std::chrono::duration<double>(stdNow - stdStageStart).count();
+			stdStageStart = stdNow;
+		};
+
+		ObjData rtObjData{};
+		if (!(ParseObjFile(sFileName, &rtObjData))) return MeshInfo{};
+		auto& tolMaterials = rtObjData.Materials;
+		fnEndStage(rtStageTimes.Parsing);
+
+		//generate the vertices, the three corners of every triangle
+		const uint64_t iNumVertices = rtObjData.Corners.size();
+		Vertex* rtVertices = new Vertex[iNumVertices]();
+		std::atomic<bool> bCalculateNormals = false;
+		ParallelFor(iNumVertices / 3, 16384, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			bool bMissingNormals = false;
+			for (uint64_t i = iBegin * 3; i < iEnd * 3; i++)
+			{
+				const ObjCorner& rtCorner = rtObjData.Corners[i];
+
+				//get the position
+				rtVertices[i].Position = rtObjData.Positions[rtCorner.Position];
+
+				//get the texture uv (vertices without one keep (0, 0))
+				if (rtCorner.UV >= 0)
+				{
+					rtVertices[i].UV = rtObjData.UVs[rtCorner.UV];
+				}
+
+				//get the normal (missing normals are calculated from the welded vertices later)
+				if (rtCorner.Normal >= 0)
+				{
+					rtVertices[i].Normal = rtObjData.Normals[rtCorner.Normal];
+				}
+				else
+				{
+					bMissingNormals = true;
+				}
+
+				//get the material index
+				rtVertices[i].MaterialID = (uint32_t)(rtObjData.MaterialIDs[i / 3]);
+			}
+			if (bMissingNormals) bCalculateNormals = true;
+		});
+		fnEndStage(rtStageTimes.Triangles);
+
+		//remove any vertex duplicates
+		Index* rtIndices = new Index[iNumVertices];
+		Vertex* rtUniqueVertices = new Vertex[iNumVertices];
+		uint64_t iNumUniqueVertices = WeldVertices(rtVertices, iNumVertices, rtIndices, rtUniqueVertices);
+		delete[] rtVertices;
+		fnEndStage(rtStageTimes.Welding);
+
+		//get the materials
+		uint64_t iNumMaterials = tolMaterials.size();
+		PBRMaterial* rtMaterials = new PBRMaterial[iNumMaterials];
+		std::unordered_map<std::string, uint32_t> stdTextureNames;
+		stdTextureNames[""] = 0;
+		for (uint64_t i = 0; i < iNumMaterials; i++)
+		{
+			auto& tolCurrentMaterial = tolMaterials[i];
+
+			rtMaterials[i].Albedo.x = tolCurrentMaterial.diffuse[0];
+			rtMaterials[i].Albedo.y = tolCurrentMaterial.diffuse[1];
+			rtMaterials[i].Albedo.z = tolCurrentMaterial.diffuse[2];
+
+			float fRoughness = 0.0f;
+			if (tolCurrentMaterial.shininess == 1.0f)
+			{
+				fRoughness = tolCurrentMaterial.roughness;
+			}
+			else
+			{
+				//converts shininess to a value between 0 and 1, which is better suited for the PBR lighting model
+				fRoughness = 1.0f - (std::log2(std::min(std::max(tolCurrentMaterial.shininess, 1.0f), 1448.15f)) / 10.5f);
+			}
+
+			rtMaterials[i].Roughness = fRoughness;
+			rtMaterials[i].F0Color.x = tolCurrentMaterial.specular[0];
+			rtMaterials[i].F0Color.y = tolCurrentMaterial.specular[1];
+			rtMaterials[i].F0Color.z = tolCurrentMaterial.specular[2];
+			rtMaterials[i].Metallic = tolCurrentMaterial.metallic;
+			rtMaterials[i].Emissive.x = tolCurrentMaterial.emission[0];
+			rtMaterials[i].Emissive.y = tolCurrentMaterial.emission[1];
+			rtMaterials[i].Emissive.z = tolCurrentMaterial.emission[2];
+			
+			GetTexture(tolCurrentMaterial.diffuse_texname, stdTextureNames);
+			GetTexture(tolCurrentMaterial.roughness_texname, stdTextureNames);
+			GetTexture(tolCurrentMaterial.specular_texname, stdTextureNames);
+			GetTexture(tolCurrentMaterial.metallic_texname, stdTextureNames);
+			GetTexture(tolCurrentMaterial.emissive_texname, stdTextureNames);
+
+			rtMaterials[i].AlbedoTextureID = stdTextureNames[tolCurrentMaterial.diffuse_texname];
+			rtMaterials[i].RoughnessTextureID = stdTextureNames[tolCurrentMaterial.roughness_texname];
+			rtMaterials[i].F0TextureID = stdTextureNames[tolCurrentMaterial.specular_texname];
+			rtMaterials[i].MetallicTextureID = stdTextureNames[tolCurrentMaterial.metallic_texname];
+			rtMaterials[i].EmissiveTextureID = stdTextureNames[tolCurrentMaterial.emissive_texname];
+		}
+
+		//fill in the meshinfo structure
+		MeshInfo rtMesh{};
+		rtMesh.IndexCount = iNumVertices;
+		rtMesh.Indices = rtIndices;
+		rtMesh.VertexCount = iNumUniqueVertices;
+		rtMesh.Vertices = new Vertex[rtMesh.VertexCount];
+		rtMesh.MaterialCount = std::max<uint64_t>(1, iNumMaterials);
+		rtMesh.Materials = iNumMaterials > 0 ? rtMaterials : nullptr;
+		rtMesh.TextureNameCount = stdTextureNames.size();
+		rtMesh.TextureNames = new std::string[rtMesh.TextureNameCount];
+		rtMesh.SceneAABB = AABB();
+		for (auto& [sTextureName, iTextureIndex] : stdTextureNames)
+		{
+			rtMesh.TextureNames[iTextureIndex] = sTextureName;
+		}
+
+		memcpy(rtMesh.Vertices, rtUniqueVertices, sizeof(Vertex)* rtMesh.VertexCount);
+		delete[] rtUniqueVertices;
+
+		//the bounding box of the triangle centroids, every thread expands its own box
+		const Math::SIMD::float4v rtOneThird = Math::SIMD::Splat(1.0f / 3.0f);
+		std::vector<Math::SIMD::float4v> rtThreadMin(GetThreadCount(), Math::SIMD::Splat(FLT_MAX));
+		std::vector<Math::SIMD::float4v> rtThreadMax(GetThreadCount(), Math::SIMD::Splat(-FLT_MAX));
+		ParallelFor(rtMesh.IndexCount / 3, 16384, [&](uint64_t iBegin, uint64_t iEnd, unsigned int iThreadIndex)
+		{
+			Math::SIMD::float4v rtMin = rtThreadMin[iThreadIndex];
+			Math::SIMD::float4v rtMax = rtThreadMax[iThreadIndex];
+			for (uint64_t i = iBegin * 3; i < iEnd * 3; i += 3)
+			{
+				//get the vertex positions
+				Math::SIMD::float4v rtPosition1 = Math::SIMD::Load(rtMesh.Vertices[rtMesh.Indices[i]].Position);
+				Math::SIMD::float4v rtPosition2 = Math::SIMD::Load(rtMesh.Vertices[rtMesh.Indices[i + 1]].Position);
+				Math::SIMD::float4v rtPosition3 = Math::SIMD::Load(rtMesh.Vertices[rtMesh.Indices[i + 2]].Position);
+
+				//expand the scene AABB according to the centroid value
+				Math::SIMD::float4v rtCentroid = (rtPosition1 + rtPosition2 + rtPosition3) * rtOneThird;
+				rtMin = Math::SIMD::Min(rtMin, rtCentroid);
+				rtMax = Math::SIMD::Max(rtMax, rtCentroid);
+			}
+			rtThreadMin[iThreadIndex] = rtMin;
+			rtThreadMax[iThreadIndex] = rtMax;
+		});
+
+		Math::SIMD::float4v rtSceneMin = Math::SIMD::Splat(FLT_MAX);
+		Math::SIMD::float4v rtSceneMax = Math::SIMD::Splat(-FLT_MAX);
+		for (uint64_t i = 0; i < rtThreadMin.size(); i++)
+		{
+			rtSceneMin = Math::SIMD::Min(rtSceneMin, rtThreadMin[i]);
+			rtSceneMax = Math::SIMD::Max(rtSceneMax, rtThreadMax[i]);
+		}
+		//store the scene bounding box
+		rtMesh.SceneAABB.Min = Math::SIMD::StoreFloat3(rtSceneMin);
+		rtMesh.SceneAABB.Max = Math::SIMD::StoreFloat3(rtSceneMax);
+		
+		//make a default material, if there are no materials (it slightly glows so the scene isn't completely dark)
+		if (iNumMaterials < 1)
+		{
+			rtMesh.Materials = new PBRMaterial[1]();
+			rtMesh.Materials[0].Albedo = { 0.0f, 0.0f, 0.0f };
+			rtMesh.Materials[0].Roughness = 0.0f;
+			rtMesh.Materials[0].F0Color = { 0.0f, 0.0f, 0.0f };
+			rtMesh.Materials[0].Metallic = 0.0f;
+			rtMesh.Materials[0].Emissive = { 0.5f, 0.5f, 0.5f };
+		}
+
+		fnEndStage(rtStageTimes.SceneBounds);
+
+		//calculate the normals and tangents
+		if (bCalculateNormals)
+		{
+			CalculateNormals(&rtMesh);
+			fnEndStage(rtStageTimes.Normals);
+		}
+		CalculateTangents(&rtMesh);
+		fnEndStage(rtStageTimes.Tangents);
+
+		//collect the emissive triangles for the light sampling
+		rtMesh.Lights = BuildLightList(rtMesh);
+
+		if (rtTimings)
+		{
+			*rtTimings = rtStageTimes;
+		}
+
+		std::cout << "Successfully loaded the scene with:\n " << rtMesh.VertexCount << " vertices\n " << rtMesh.IndexCount << " indices\n "
+			<< rtMesh.MaterialCount << " materials\n " << (rtMesh.TextureNameCount - 1) << " textures\n " << rtMesh.Lights->Triangles.size() << " emissive triangles\n";
+
+		return rtMesh;
+	}
+
+}
\ No newline at end of file
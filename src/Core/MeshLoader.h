@@ -0,0 +1,126 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <iostream>
+#include <memory>
+
+#include "Core/Math.h"
+
+
+
+//the scene data, which is shared by all backends (the layouts match the structs in the shaders)
+namespace RT::Core
+{
+
+	struct AABB
+	{
+		Math::float3 Min;
+		Math::float3 Max;
+		Math::uint2 Padding;
+	};
+
+	class SceneCache;
+	struct LightList;
+
+	//define indices and vertices
+	typedef uint32_t Index;
+
+	struct Vertex
+	{
+		Math::float3 Position;
+		Math::float2 UV;
+		Math::float3 Normal;
+		Math::float3 Tangent;
+		uint32_t MaterialID; // = 12 * 4 bytes = 48 bytes = 384 bits
+	};
+
+	//the intersection-only copy of a triangle, stored in the order of the bvh leaves (the full vertices are only read for the closest hit)
+	struct IntersectionTriangle
+	{
+		Math::float3 Vertex1;
+		Index FirstIndex; // the position of the triangle in the index buffer
+		Math::float3 Edge1; // = Vertex2 - Vertex1
+		float Padding1;
+		Math::float3 Edge2; // = Vertex3 - Vertex1
+		float Padding2; // = 3 * 16 bytes = 48 bytes, one read instead of three indices and three vertices
+	};
+
+	struct PBRMaterial
+	{
+		Math::float3 Albedo;
+		float Roughness;
+		Math::float3 F0Color;
+		float Metallic;
+		Math::float3 Emissive;
+
+		uint32_t AlbedoTextureID;
+		uint32_t RoughnessTextureID;
+		uint32_t F0TextureID;
+		uint32_t MetallicTextureID;
+		uint32_t EmissiveTextureID;
+	};
+
+	struct TextureInfo
+	{
+		void* Data;
+		uint32_t Width;
+		uint32_t Height;
+		uint16_t BytesPerChannel;
+		uint16_t ChannelCount;
+	};
+
+	struct MeshInfo
+	{
+		uint64_t IndexCount;
+		Index* Indices;
+		uint64_t VertexCount;
+		Vertex* Vertices;
+		uint64_t MaterialCount;
+		PBRMaterial* Materials;
+		uint64_t TextureNameCount;
+		std::string* TextureNames;
+		AABB SceneAABB;
+		std::shared_ptr<const SceneCache> Cache; // set, if the arrays are stored in a memory mapped scene cache (they mustn't be deleted then)
+		std::shared_ptr<const LightList> Lights; // the emissive triangles for next-event estimation (see Lights.h)
+	};
+
+	static_assert(sizeof(AABB) == 32, "AABB has to match the layout in Raytracer.hlsli");
+	static_assert(sizeof(Vertex) == 48, "Vertex has to match the layout in Raytracer.hlsli");
+	static_assert(sizeof(IntersectionTriangle) == 48, "IntersectionTriangle has to match the layout in Raytracer.hlsli");
+	static_assert(sizeof(PBRMaterial) == 64, "PBRMaterial has to match the layout in PerRayShading.hlsli");
+
+
+	//the duration of the stages of LoadMeshFromFile in seconds
+	struct MeshLoadTimings
+	{
+		double Parsing;
+		double Triangles;
+		double Welding;
+		double SceneBounds;
+		double Normals; // 0, if the file contains all normals
+		double Tangents;
+	};
+
+
+	TextureInfo LoadTextureFromFile(const std::string& sFileName, int iDesiredNumChannels = 4, bool bHighPrecision = true);
+	MeshInfo LoadMeshFromFile(const std::string& sFileName, MeshLoadTimings* rtTimings = nullptr);
+
+}
+
+
+//the backends use the scene types of the core library
+namespace RT::GraphicsAPI
+{
+
+	using Core::AABB;
+	using Core::Index;
+	using Core::Vertex;
+	using Core::IntersectionTriangle;
+	using Core::PBRMaterial;
+	using Core::TextureInfo;
+	using Core::MeshInfo;
+	using Core::LoadTextureFromFile;
+	using Core::LoadMeshFromFile;
+
+}
\ No newline at end of file
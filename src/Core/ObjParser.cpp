@@ -0,0 +1,417 @@
+//include-files
+#include "ObjParser.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+
+
+
+namespace RT::Core
+{
+
+	//the size of the chunks, which are parsed by one thread (they are extended to the end of the last line)
+	const uint64_t OBJ_CHUNK_SIZE = 1 << 20;
+
+
+	//a line of an OBJ file, which changes the parser state, these are rare, so they are collected in the counting pass
+	struct ObjStateLine
+	{
+		uint64_t TriangleIndex; // the number of triangles in the chunk before this line
+		std::string Name;
+		bool IsMaterialLibrary; // "mtllib" or "usemtl"
+	};
+
+	//the number of elements in a chunk, the offsets of the chunks are the prefix sums of these
+	struct ObjChunk
+	{
+		const char* Begin;
+		const char* End;
+		uint64_t NumPositions;
+		uint64_t NumUVs;
+		uint64_t NumNormals;
+		uint64_t NumTriangles;
+		std::vector<ObjStateLine> StateLines;
+		int32_t FirstMaterialID; // the material of the last "usemtl" in the chunks before
+		bool Error;
+	};
+
+
+	//helper functions for the parsing
+	static bool IsSpace(char cCharacter)
+	{
+		return (cCharacter == ' ') || (cCharacter == '\t') || (cCharacter == '\r');
+	}
+
+	static const char* SkipSpaces(const char* pCurrent, const char* pEnd)
+	{
+		while ((pCurrent < pEnd) && IsSpace(*pCurrent)) pCurrent++;
+		return pCurrent;
+	}
+
+	static const char* SkipToken(const char* pCurrent, const char* pEnd)
+	{
+		while ((pCurrent < pEnd) && (!IsSpace(*pCurrent))) pCurrent++;
+		return pCurrent;
+	}
+
+	//checks, if a line starts with a keyword, which is followed by a space
+	static bool IsKeyword(const char* pLine, const char* pLineEnd, const char* sKeyword, uint64_t iLength)
+	{
+		return ((uint64_t)(pLineEnd - pLine) > iLength) && (memcmp(pLine, sKeyword, iLength) == 0) && IsSpace(pLine[iLength]);
+	}
+
+	static const char* ParseFloat(const char* pCurrent, const char* pEnd, float* fValue)
+	{
+		pCurrent = SkipSpaces(pCurrent, pEnd);
+		if ((pCurrent < pEnd) && (*pCurrent == '+')) pCurrent++; // from_chars doesn't accept a plus sign
+		std::from_chars_result stdResult = std::from_chars(pCurrent, pEnd, *fValue);
+		if (stdResult.ec != std::errc())
+		{
+			*fValue = 0.0f;
+			return SkipToken(pCurrent, pEnd);
+		}
+		return stdResult.ptr;
+	}
+
+	//converts a (1 based or negative relative) OBJ index into a 0 based index, iCount is the number of elements defined so far
+	static bool ParseIndex(const char*& pCurrent, const char* pEnd, int64_t iCount, int32_t* iIndex)
+	{
+		int64_t iValue = 0;
+		std::from_chars_result stdResult = std::from_chars(pCurrent, pEnd, iValue);
+		if ((stdResult.ec != std::errc()) || (iValue == 0)) return false;
+		pCurrent = stdResult.ptr;
+
+		iValue = (iValue > 0) ? (iValue - 1) : (iCount + iValue);
+		if ((iValue < 0) || (iValue > INT32_MAX)) return false;
+		*iIndex = (int32_t)iValue;
+		return true;
+	}
+
+	//a corner of a face: "v", "v/vt", "v//vn" or "v/vt/vn"
+	static bool ParseCorner(const char*& pCurrent, const char* pEnd, const int64_t* iCounts, ObjCorner* rtCorner)
+	{
+		rtCorner->UV = -1;
+		rtCorner->Normal = -1;
+		if (!(ParseIndex(pCurrent, pEnd, iCounts[0], &(rtCorner->Position)))) return false;
+		if ((pCurrent < pEnd) && (*pCurrent == '/'))
+		{
+			pCurrent++;
+			if ((pCurrent < pEnd) && (*pCurrent != '/'))
+			{
+				if (!(ParseIndex(pCurrent, pEnd, iCounts[1], &(rtCorner->UV)))) return false;
+			}
+			if ((pCurrent < pEnd) && (*pCurrent == '/'))
+			{
+				pCurrent++;
+				if (!(ParseIndex(pCurrent, pEnd, iCounts[2], &(rtCorner->Normal)))) return false;
+			}
+		}
+		return (pCurrent == pEnd) || IsSpace(*pCurrent);
+	}
+
+	//the number of corners of a face line (without the "f")
+	static uint64_t CountTokens(const char* pCurrent, const char* pEnd)
+	{
+		uint64_t iNumTokens = 0;
+		pCurrent = SkipSpaces(pCurrent, pEnd);
+		while (pCurrent < pEnd)
+		{
+			iNumTokens++;
+			pCurrent = SkipSpaces(SkipToken(pCurrent, pEnd), pEnd);
+		}
+		return iNumTokens;
+	}
+
+	//calls fnFunction(pLine, pLineEnd) for every line of a chunk, the leading spaces are already removed
+	template<typename Function>
+	static void ForEachLine(const char* pBegin, const char* pEnd, const Function& fnFunction)
+	{
+		while (pBegin < pEnd)
+		{
+			const char* pLineEnd = (const char*)memchr(pBegin, '\n', pEnd - pBegin);
+			if (!pLineEnd) pLineEnd = pEnd;
+			const char* pLine = SkipSpaces(pBegin, pLineEnd);
+			if ((pLine < pLineEnd) && (*pLine != '#')) fnFunction(pLine, pLineEnd);
+			pBegin = pLineEnd + 1;
+		}
+	}
+
+
+	//the directory of the OBJ file, which the names of the MTL files are relative to
+	static std::string GetBaseDirectory(const std::string& sFileName)
+	{
+		size_t iDirectoryEnd = sFileName.find_last_of("/\\");
+		return (iDirectoryEnd != std::string::npos) ? sFileName.substr(0, iDirectoryEnd) : std::string();
+	}
+
+	static std::string GetMaterialLibraryPath(const std::string& sName, const std::string& sBaseDirectory)
+	{
+		return sBaseDirectory.empty() ? sName : (sBaseDirectory + "/" + sName);
+	}
+
+	//the name of the file of a "mtllib" line, which is loaded, the first file that exists is used (like tinyobjloader does it)
+	static bool FindMaterialLibrary(const std::string& sLine, const std::string& sBaseDirectory, std::string* sName)
+	{
+		const char* pCurrent = sLine.data();
+		const char* pEnd = pCurrent + sLine.size();
+		for (pCurrent = SkipSpaces(pCurrent, pEnd); pCurrent < pEnd; pCurrent = SkipSpaces(pCurrent, pEnd))
+		{
+			const char* pNameEnd = SkipToken(pCurrent, pEnd);
+			*sName = std::string(pCurrent, pNameEnd);
+			pCurrent = pNameEnd;
+			if (std::ifstream(GetMaterialLibraryPath(*sName, sBaseDirectory))) return true;
+		}
+		return false;
+	}
+
+	//load the materials of a "mtllib" line, every file is only loaded once
+	static void LoadMaterialLibrary(const std::string& sLine, const std::string& sBaseDirectory, std::set<std::string>& stdLoadedFiles,
+		std::map<std::string, int>& stdMaterialMap, std::vector<tinyobj::material_t>& rtMaterials)
+	{
+		std::string sName;
+		if (!(FindMaterialLibrary(sLine, sBaseDirectory, &sName)))
+		{
+			std::cout << "Error loading materials: the material library [" << sLine << "] wasn't found\n";
+			return;
+		}
+		if (stdLoadedFiles.contains(sName)) return;
+
+		std::ifstream stdFile(GetMaterialLibraryPath(sName, sBaseDirectory));
+		std::string sWarning;
+		std::string sError;
+		tinyobj::LoadMtl(&stdMaterialMap, &rtMaterials, &stdFile, &sWarning, &sError);
+		if (!(sError.empty())) std::cout << "Error loading materials: " << sError << "\n";
+		stdLoadedFiles.insert(sName);
+	}
+
+
+
+	bool ParseObjFile(const std::string& sFileName, ObjData* rtData)
+	{
+		MappedFile rtFile;
+		if (!(rtFile.Open(sFileName)))
+		{
+			std::cout << "Error loading scene: Cannot open the file " << sFileName << "\n";
+			return false;
+		}
+		const char* pFileBegin = (const char*)rtFile.GetData();
+		const char* pFileEnd = pFileBegin + rtFile.GetSize();
+
+		//split the file into chunks, which begin at the start of a line
+		std::vector<ObjChunk> rtChunks;
+		for (const char* pBegin = pFileBegin; pBegin < pFileEnd;)
+		{
+			const char* pEnd = pBegin + std::min<uint64_t>(OBJ_CHUNK_SIZE, pFileEnd - pBegin);
+			const char* pLineEnd = (pEnd < pFileEnd) ? (const char*)memchr(pEnd, '\n', pFileEnd - pEnd) : nullptr;
+			pEnd = pLineEnd ? (pLineEnd + 1) : pFileEnd;
+
+			ObjChunk rtChunk{};
+			rtChunk.Begin = pBegin;
+			rtChunk.End = pEnd;
+			rtChunks.push_back(rtChunk);
+			pBegin = pEnd;
+		}
+
+		//the first pass counts the elements of every chunk and collects the material lines
+		ParallelFor(rtChunks.size(), 1, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t c = iBegin; c < iEnd; c++)
+			{
+				ObjChunk& rtChunk = rtChunks[c];
+				ForEachLine(rtChunk.Begin, rtChunk.End, [&](const char* pLine, const char* pLineEnd)
+				{
+					if (IsKeyword(pLine, pLineEnd, "v", 1)) rtChunk.NumPositions++;
+					else if (IsKeyword(pLine, pLineEnd, "vt", 2)) rtChunk.NumUVs++;
+					else if (IsKeyword(pLine, pLineEnd, "vn", 2)) rtChunk.NumNormals++;
+					else if (IsKeyword(pLine, pLineEnd, "f", 1))
+					{
+						uint64_t iNumCorners = CountTokens(pLine + 1, pLineEnd);
+						if (iNumCorners >= 3) rtChunk.NumTriangles += iNumCorners - 2;
+					}
+					else if (IsKeyword(pLine, pLineEnd, "usemtl", 6) || IsKeyword(pLine, pLineEnd, "mtllib", 6))
+					{
+						const char* pName = SkipSpaces(pLine + 6, pLineEnd);
+						const char* pNameEnd = pLineEnd;
+						while ((pNameEnd > pName) && IsSpace(pNameEnd[-1])) pNameEnd--;
+						bool bIsLibrary = (pLine[0] == 'm');
+						rtChunk.StateLines.push_back({ rtChunk.NumTriangles, std::string(pName, bIsLibrary ? pNameEnd : SkipToken(pName, pNameEnd)), bIsLibrary });
+					}
+				});
+			}
+		});
+
+		//the offsets of the chunks, the materials and the material of the first triangle of every chunk
+		std::string sBaseDirectory = GetBaseDirectory(sFileName);
+		std::set<std::string> stdLoadedFiles;
+		std::map<std::string, int> stdMaterialMap;
+
+		uint64_t iOffsets[4] = {};
+		int32_t iMaterialID = -1;
+		for (ObjChunk& rtChunk : rtChunks)
+		{
+			uint64_t iCounts[4] = { rtChunk.NumPositions, rtChunk.NumUVs, rtChunk.NumNormals, rtChunk.NumTriangles };
+			rtChunk.NumPositions = iOffsets[0];
+			rtChunk.NumUVs = iOffsets[1];
+			rtChunk.NumNormals = iOffsets[2];
+			rtChunk.NumTriangles = iOffsets[3];
+			for (uint32_t i = 0; i < 4; i++) iOffsets[i] += iCounts[i];
+
+			rtChunk.FirstMaterialID = iMaterialID;
+			for (ObjStateLine& rtLine : rtChunk.StateLines)
+			{
+				if (rtLine.IsMaterialLibrary)
+				{
+					LoadMaterialLibrary(rtLine.Name, sBaseDirectory, stdLoadedFiles, stdMaterialMap, rtData->Materials);
+				}
+				else
+				{
+					auto stdMaterial = stdMaterialMap.find(rtLine.Name);
+					iMaterialID = (stdMaterial != stdMaterialMap.end()) ? stdMaterial->second : -1;
+				}
+			}
+		}
+		if ((iOffsets[0] > INT32_MAX) || (iOffsets[1] > INT32_MAX) || (iOffsets[2] > INT32_MAX))
+		{
+			std::cout << "Error loading scene: too many vertices\n";
+			return false;
+		}
+
+		rtData->Positions.resize(iOffsets[0]);
+		rtData->UVs.resize(iOffsets[1]);
+		rtData->Normals.resize(iOffsets[2]);
+		rtData->Corners.resize(iOffsets[3] * 3);
+		rtData->MaterialIDs.resize(iOffsets[3]);
+
+		//the second pass parses the chunks, every chunk writes to its own part of the arrays
+		ParallelFor(rtChunks.size(), 1, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			std::vector<ObjCorner> rtFaceCorners;
+			for (uint64_t c = iBegin; c < iEnd; c++)
+			{
+				ObjChunk& rtChunk = rtChunks[c];
+				int64_t iCounts[3] = { (int64_t)rtChunk.NumPositions, (int64_t)rtChunk.NumUVs, (int64_t)rtChunk.NumNormals };
+				uint64_t iTriangle = rtChunk.NumTriangles;
+				uint64_t iStateLine = 0;
+				int32_t iCurrentMaterialID = rtChunk.FirstMaterialID;
+
+				ForEachLine(rtChunk.Begin, rtChunk.End, [&](const char* pLine, const char* pLineEnd)
+				{
+					if (IsKeyword(pLine, pLineEnd, "v", 1))
+					{
+						Math::float3& rtPosition = rtData->Positions[iCounts[0]++];
+						const char* pCurrent = ParseFloat(pLine + 1, pLineEnd, &(rtPosition.x));
+						pCurrent = ParseFloat(pCurrent, pLineEnd, &(rtPosition.y));
+						ParseFloat(pCurrent, pLineEnd, &(rtPosition.z));
+					}
+					else if (IsKeyword(pLine, pLineEnd, "vt", 2))
+					{
+						Math::float2& rtUV = rtData->UVs[iCounts[1]++];
+						const char* pCurrent = ParseFloat(pLine + 2, pLineEnd, &(rtUV.x));
+						ParseFloat(pCurrent, pLineEnd, &(rtUV.y));
+					}
+					else if (IsKeyword(pLine, pLineEnd, "vn", 2))
+					{
+						Math::float3& rtNormal = rtData->Normals[iCounts[2]++];
+						const char* pCurrent = ParseFloat(pLine + 2, pLineEnd, &(rtNormal.x));
+						pCurrent = ParseFloat(pCurrent, pLineEnd, &(rtNormal.y));
+						ParseFloat(pCurrent, pLineEnd, &(rtNormal.z));
+					}
+					else if (IsKeyword(pLine, pLineEnd, "f", 1))
+					{
+						//parse all corners of the face and split it into a triangle fan
+						rtFaceCorners.clear();
+						for (const char* pCurrent = SkipSpaces(pLine + 1, pLineEnd); pCurrent < pLineEnd; pCurrent = SkipSpaces(pCurrent, pLineEnd))
+						{
+							ObjCorner rtCorner{};
+							if (!(ParseCorner(pCurrent, pLineEnd, iCounts, &rtCorner)))
+							{
+								rtChunk.Error = true;
+								pCurrent = SkipToken(pCurrent, pLineEnd);
+							}
+							rtFaceCorners.push_back(rtCorner);
+						}
+
+						for (uint64_t i = 2; i < rtFaceCorners.size(); i++)
+						{
+							rtData->Corners[iTriangle * 3] = rtFaceCorners[0];
+							rtData->Corners[iTriangle * 3 + 1] = rtFaceCorners[i - 1];
+							rtData->Corners[iTriangle * 3 + 2] = rtFaceCorners[i];
+							rtData->MaterialIDs[iTriangle] = iCurrentMaterialID;
+							iTriangle++;
+						}
+					}
+					else if (IsKeyword(pLine, pLineEnd, "usemtl", 6))
+					{
+						//the material lines were collected in the same order
+						while (rtChunk.StateLines[iStateLine].IsMaterialLibrary) iStateLine++;
+						auto stdMaterial = stdMaterialMap.find(rtChunk.StateLines[iStateLine].Name);
+						iCurrentMaterialID = (stdMaterial != stdMaterialMap.end()) ? stdMaterial->second : -1;
+						iStateLine++;
+					}
+				});
+			}
+		});
+
+		//check, that all indices are valid
+		bool bValid = true;
+		for (ObjChunk& rtChunk : rtChunks)
+		{
+			bValid = bValid && (!(rtChunk.Error));
+		}
+		std::atomic<bool> bIndicesValid = true;
+		ParallelFor(iOffsets[3] * 3, 65536, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t i = iBegin; i < iEnd; i++)
+			{
+				const ObjCorner& rtCorner = rtData->Corners[i];
+				if (((uint64_t)rtCorner.Position >= iOffsets[0]) || (rtCorner.UV >= (int64_t)iOffsets[1]) || (rtCorner.Normal >= (int64_t)iOffsets[2]))
+				{
+					bIndicesValid = false;
+					return;
+				}
+			}
+		});
+		if ((!bValid) || (!bIndicesValid))
+		{
+			std::cout << "Error loading scene: " << sFileName << " contains an invalid face\n";
+			return false;
+		}
+
+		return true;
+	}
+
+
+	//only the "mtllib" lines are read, in the same order as ParseObjFile loads them
+	std::vector<std::string> FindMaterialLibraries(const std::string& sFileName)
+	{
+		std::vector<std::string> sPaths;
+		MappedFile rtFile;
+		if (!(rtFile.Open(sFileName))) return sPaths;
+
+		const std::string sBaseDirectory = GetBaseDirectory(sFileName);
+		std::set<std::string> stdFoundFiles;
+		const char* pFileBegin = (const char*)rtFile.GetData();
+		ForEachLine(pFileBegin, pFileBegin + rtFile.GetSize(), [&](const char* pLine, const char* pLineEnd)
+		{
+			if (!(IsKeyword(pLine, pLineEnd, "mtllib", 6))) return;
+
+			const char* pName = SkipSpaces(pLine + 6, pLineEnd);
+			const char* pNameEnd = pLineEnd;
+			while ((pNameEnd > pName) && IsSpace(pNameEnd[-1])) pNameEnd--;
+			std::string sName;
+			if ((FindMaterialLibrary(std::string(pName, pNameEnd), sBaseDirectory, &sName)) && (!(stdFoundFiles.contains(sName))))
+			{
+				stdFoundFiles.insert(sName);
+				sPaths.push_back(GetMaterialLibraryPath(sName, sBaseDirectory));
+			}
+		});
+		return sPaths;
+	}
+
+}
\ No newline at end of file
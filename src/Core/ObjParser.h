@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Core/Math.h"
+
+#include <tinyobjloader/tiny_obj_loader.h>
+
+
+
+namespace RT::Core
+{
+
+	//the attribute indices of one corner of a triangle (-1, if the attribute is missing)
+	struct ObjCorner
+	{
+		int32_t Position;
+		int32_t UV;
+		int32_t Normal;
+	};
+
+	//the content of an OBJ file, the faces are already split into triangles
+	struct ObjData
+	{
+		std::vector<Math::float3> Positions;
+		std::vector<Math::float2> UVs;
+		std::vector<Math::float3> Normals;
+		std::vector<ObjCorner> Corners; // 3 per triangle
+		std::vector<int32_t> MaterialIDs; // 1 per triangle, -1 if the triangle has no material
+		std::vector<tinyobj::material_t> Materials;
+	};
+
+
+	//parses an OBJ file on all cores: the memory mapped file is split into chunks of whole lines, which are counted first and parsed afterwards
+	//the MTL files are loaded with tinyobjloader (from the directory of the OBJ file, like tinyobj::ObjReader does it)
+	bool ParseObjFile(const std::string& sFileName, ObjData* rtData);
+
+	//the paths of the MTL files, which ParseObjFile loads for the "mtllib" lines of an OBJ file (without parsing the rest of the file)
+	std::vector<std::string> FindMaterialLibraries(const std::string& sFileName);
+
+}
\ No newline at end of file
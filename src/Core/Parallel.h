@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+
+
+namespace RT::Core
+{
+
+	//the number of worker threads used by the cpu code paths
+	inline unsigned int GetThreadCount()
+	{
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+
+	//calls fnFunction(iBegin, iEnd, iThreadIndex) for chunks of [0, iCount), distributed across all cores
+	//the chunks are handed out through an atomic counter, so uneven workloads are balanced automatically
+	template<typename Function>
+	void ParallelFor(uint64_t iCount, uint64_t iGrainSize, const Function& fnFunction)
+	{
+		if (iCount == 0) return;
+		iGrainSize = std::max<uint64_t>(iGrainSize, 1);
+
+		const uint64_t iNumChunks = (iCount + iGrainSize - 1) / iGrainSize;
+		const unsigned int iNumThreads = (unsigned int)std::min<uint64_t>(GetThreadCount(), iNumChunks);
+		std::atomic<uint64_t> iNextChunk = 0;
+
+		auto fnWorker = [&](unsigned int iThreadIndex)
+		{
+			for (uint64_t iChunk = iNextChunk++; iChunk < iNumChunks; iChunk = iNextChunk++)
+			{
+				uint64_t iBegin = iChunk * iGrainSize;
+				uint64_t iEnd = std::min(iBegin + iGrainSize, iCount);
+				fnFunction(iBegin, iEnd, iThreadIndex);
+			}
+		};
+
+		//the calling thread does work as well
+		std::vector<std::thread> stdThreads;
+		stdThreads.reserve(iNumThreads - 1);
+		for (unsigned int i = 1; i < iNumThreads; i++)
+		{
+			stdThreads.emplace_back(fnWorker, i);
+		}
+		fnWorker(0);
+		for (auto& stdThread : stdThreads)
+		{
+			stdThread.join();
+		}
+	}
+
+}
\ No newline at end of file
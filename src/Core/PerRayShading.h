@@ -0,0 +1,223 @@
+#pragma once
+
+#include "Core/Math.h"
+#include "Core/MeshLoader.h"
+#include "Core/Random.h"
+
+
+
+//the cpu port of PerRayShading.hlsli, shared by the cpu backends
+namespace RT::Core
+{
+
+	const float SHADING_EPSILON = 1e-6f;
+	const float PI = 3.141592654f;
+
+
+	struct ShaderInput
+	{
+		float Clockwiseability; // pixel on counterclockwise triangle: -1.0f, else 1.0f
+		Math::float2 TextureUV;
+		Math::float3 Normal;
+		Math::float3 Tangent;
+		Math::float3 OldRayDirection; // the V in the equations (normalized)
+		Math::float3 NewRayDirection; // the L in the equations (normalized)
+		uint32_t MaterialID;
+	};
+
+	struct ShaderOutput
+	{
+		Math::float3 Scattered;
+		Math::float3 Emitted;
+		float PDF; // the pdf of NewRayDirection, which weights the emission of the next hit
+	};
+
+	//the material after the textures were applied
+	struct PBRMaterialProperties
+	{
+		Math::float3 Albedo;
+		float Roughness;
+		Math::float3 F0Color;
+		float Metallic;
+		Math::float3 Emissive;
+	};
+
+
+
+	//shading functions
+	//calculate the specular contribution
+	inline Math::float3 ReflectedColor(float fRoughness, const Math::float3& rtF0Color, float fNdotL, float fNdotV, float fNdotH, float fVdotH)
+	{
+		//calculate an alpha value from the roughness
+		float fAlpha = fRoughness * fRoughness;
+
+		//calculate Fresnel
+		float fScalingFactor = std::pow(Math::saturate(1.0f - fVdotH), 5.0f);
+		Math::float3 rtF = rtF0Color + fScalingFactor - rtF0Color * fScalingFactor;
+
+		//calculate the NDF
+		float a2 = fAlpha * fAlpha;
+		float fNdotH2 = fNdotH * fNdotH;
+		float fSqrtDenominator = fNdotH2 * a2 - fNdotH2 + 1.0f;
+		float fDDenominator = PI * fSqrtDenominator * fSqrtDenominator; // the a2 is added in the final calculation
+
+		//calculate the visibility term
+		float k = fAlpha * 0.5f;
+		float fPartialGDenominatorV = (fNdotV - k * fNdotV + k);
+		float fPartialGDenominatorL = (fNdotL - k * fNdotL + k);
+		float fGDenominator = fPartialGDenominatorV * fPartialGDenominatorL; // NdotV * NdotL is cancelled out by the normalization factor
+
+		//normalization factor: 1.0f / (4.0f * NdotL * NdotV)
+		return (0.25f * rtF * a2) / (fDDenominator * fGDenominator + SHADING_EPSILON); // NdotL * NdotV is cancelled out by the visibility term
+	}
+
+	//calculate the diffuse contribution (from https://www.gdcvault.com/play/1024478/PBR-Diffuse-Lighting-for-GGX)
+	inline Math::float3 RefractedColor(float fRoughness, float fMetallic, const Math::float3& rtAlbedo, float fNdotL, float fNdotV, float fVdotH, float fLdotV)
+	{
+		float fFacing = fLdotV * 0.5f + 0.5f;
+		float fPartialRough = fFacing * (0.9f - 0.4f * fFacing);
+		float fRough = fPartialRough * (fVdotH / (fNdotL + fNdotV + SHADING_EPSILON)) + fPartialRough;
+		float fSmooth = 1.05f * (1.0f - std::pow(1.0f - fNdotL, 5.0f)) * (1.0f - std::pow(1.0f - fNdotV, 5.0f));
+
+		float fAlpha = fRoughness * fRoughness;
+		float fSingle = Math::lerp(fSmooth, fRough, fAlpha) / PI;
+		float fMulti = 0.1159f * fAlpha;
+
+		Math::float3 rtDiffuse = rtAlbedo * (rtAlbedo * fMulti + fSingle);
+		return rtDiffuse - rtDiffuse * fMetallic;
+	}
+
+
+
+	//the brdf times NdotL for the direction L, which is the light arriving from L, that is reflected towards V
+	inline Math::float3 CosineWeightedBRDF(const Math::float3& V, const Math::float3& L, const Math::float3& N, const PBRMaterialProperties& rtMaterial)
+	{
+		Math::float3 H = Math::normalize(V + L); //both V and L are already normalized
+
+		//get some needed dot products for further calculations
+		float fVdotH = Math::saturate(Math::dot(V, H));
+		float fNdotH = Math::saturate(Math::dot(N, H));
+		float fNdotV = Math::saturate(Math::dot(N, V));
+		float fNdotL = Math::saturate(Math::dot(N, L));
+		float fLdotV = Math::saturate(Math::dot(L, V));
+
+		Math::float3 rtFr = ReflectedColor(rtMaterial.Roughness, rtMaterial.F0Color, fNdotL, fNdotV, fNdotH, fVdotH);
+		Math::float3 rtFd = RefractedColor(rtMaterial.Roughness, rtMaterial.Metallic, rtMaterial.Albedo, fNdotL, fNdotV, fVdotH, fLdotV);
+		return Math::max(Math::float3(0.0f), (rtFr + rtFd) * fNdotL);
+	}
+
+
+
+	//brdf importance sampling: the specular lobe is sampled with the visible normals of GGX, the diffuse lobe with cosine weighted directions
+	//the probability of sampling the specular lobe, estimated from the fresnel term at NdotV and the albedo of the diffuse lobe
+	inline float SpecularProbability(const Math::float3& V, const Math::float3& N, const PBRMaterialProperties& rtMaterial)
+	{
+		float fNdotV = Math::dot(N, V);
+		if (fNdotV <= 0.0f) return 0.0f; // the visible normals only exist above the surface
+
+		float fScalingFactor = std::pow(1.0f - fNdotV, 5.0f);
+		Math::float3 rtF = rtMaterial.F0Color + fScalingFactor - rtMaterial.F0Color * fScalingFactor;
+		float fSpecularWeight = Math::dot(rtF, Math::float3(0.2126f, 0.7152f, 0.0722f));
+		float fDiffuseWeight = Math::dot(rtMaterial.Albedo, Math::float3(0.2126f, 0.7152f, 0.0722f)) * Math::saturate(1.0f - rtMaterial.Metallic);
+
+		//both lobes keep some samples, so neither of them gets a tiny pdf, where the estimate is only roughly right
+		return (fDiffuseWeight > 0.0f) ? std::clamp(fSpecularWeight / (fSpecularWeight + fDiffuseWeight), 0.1f, 0.9f) : 1.0f;
+	}
+
+	//the alpha of the sampled distribution, a perfect mirror can't be sampled with a pdf
+	inline float SamplingAlpha(float fRoughness)
+	{
+		return std::max(fRoughness * fRoughness, 1e-3f);
+	}
+
+	//the solid angle pdf of a direction, which is reflected at a visible normal of GGX: G1(V) * D(H) / (4 * NdotV)
+	inline float GGXVisibleNormalPDF(float fAlpha, float fNdotV, float fNdotH)
+	{
+		float a2 = fAlpha * fAlpha;
+		float fNdotH2 = fNdotH * fNdotH;
+		float fSqrtDenominator = fNdotH2 * a2 - fNdotH2 + 1.0f;
+		float fD = a2 / (PI * fSqrtDenominator * fSqrtDenominator);
+
+		//G1(V) = 2 * NdotV / (NdotV + sqrt(a2 + (1 - a2) * NdotV^2)), the NdotV is cancelled out
+		return fD / (2.0f * (fNdotV + std::sqrt(a2 + (1.0f - a2) * fNdotV * fNdotV)));
+	}
+
+	//reflect V at a normal of the visible normals of GGX, from "Sampling the GGX Distribution of Visible Normals" (Heitz 2018)
+	inline Math::float3 SampleGGXVisibleNormal(float fRandom1, float fRandom2, const Math::float3& V, const Math::float3& N, float fAlpha)
+	{
+		//transform V into the space, where N is the z axis, and stretch it, so the distribution becomes a hemisphere
+		Math::float3 rtPerpendicular1, rtPerpendicular2;
+		PerpendicularDirections(N, rtPerpendicular1, rtPerpendicular2);
+		Math::float3 rtVh = Math::normalize(Math::float3(fAlpha * Math::dot(V, rtPerpendicular1), fAlpha * Math::dot(V, rtPerpendicular2), Math::dot(V, N)));
+
+		float fLengthSquared = rtVh.x * rtVh.x + rtVh.y * rtVh.y;
+		Math::float3 rtT1 = (fLengthSquared > 0.0f) ? (Math::float3(-rtVh.y, rtVh.x, 0.0f) / std::sqrt(fLengthSquared)) : Math::float3(1.0f, 0.0f, 0.0f);
+		Math::float3 rtT2 = Math::cross(rtVh, rtT1);
+
+		//a point on the disk, which is projected onto the visible half of the hemisphere
+		float r = std::sqrt(fRandom1);
+		float phi = 6.2831853f * fRandom2;
+		float t1 = r * std::cos(phi);
+		float t2 = r * std::sin(phi);
+		float s = 0.5f * (1.0f + rtVh.z);
+		t2 = (1.0f - s) * std::sqrt(1.0f - t1 * t1) + s * t2;
+
+		//unstretch the normal and transform it back
+		Math::float3 rtNh = t1 * rtT1 + t2 * rtT2 + std::sqrt(std::max(0.0f, 1.0f - t1 * t1 - t2 * t2)) * rtVh;
+		Math::float3 rtLocalH = Math::normalize(Math::float3(fAlpha * rtNh.x, fAlpha * rtNh.y, std::max(0.0f, rtNh.z)));
+		Math::float3 H = (rtLocalH.x * rtPerpendicular1) + (rtLocalH.y * rtPerpendicular2) + (rtLocalH.z * N);
+		return Math::reflect(-V, H);
+	}
+
+	//pick one of the lobes with the first random number and sample a direction L for it with the other two, V and N have to be normalized
+	inline Math::float3 SampleBRDF(const Math::float3& rtRandomNumbers, const Math::float3& V, const Math::float3& N, const PBRMaterialProperties& rtMaterial)
+	{
+		if (rtRandomNumbers.x < SpecularProbability(V, N, rtMaterial))
+		{
+			return SampleGGXVisibleNormal(rtRandomNumbers.y, rtRandomNumbers.z, V, N, SamplingAlpha(rtMaterial.Roughness));
+		}
+		return RotatedRandomDirection(Math::float2(rtRandomNumbers.y, rtRandomNumbers.z), N);
+	}
+
+	//the solid angle pdf of SampleBRDF for the direction L, which both lobes could have sampled
+	inline float BRDFSamplePDF(const Math::float3& V, const Math::float3& L, const Math::float3& N, const PBRMaterialProperties& rtMaterial)
+	{
+		float fSpecularPDF = 0.0f;
+		float fNdotV = Math::dot(N, V);
+		float fSpecularChance = SpecularProbability(V, N, rtMaterial);
+		if (fSpecularChance > 0.0f)
+		{
+			Math::float3 H = Math::normalize(V + L);
+			float fNdotH = Math::dot(N, H);
+			fSpecularPDF = (fNdotH > 0.0f) ? GGXVisibleNormalPDF(SamplingAlpha(rtMaterial.Roughness), fNdotV, fNdotH) : 0.0f; // no normal of GGX points below the surface
+		}
+		return Math::lerp(RotatedRandomDirectionPDF(Math::dot(N, L)), fSpecularPDF, fSpecularChance);
+	}
+
+	//russian roulette: the probability, that a path with this throughput continues, the surviving paths are divided by it, so the estimate stays unbiased
+	inline float SurvivalProbability(const Math::float3& rtThroughput)
+	{
+		return Math::saturate(std::max(rtThroughput.x, std::max(rtThroughput.y, rtThroughput.z)));
+	}
+
+
+
+	//the main shading function, the material has to be sampled by the caller
+	//the emission is scaled by fEmissionWeight, the weight of multiple importance sampling, if the lights are also sampled directly
+	inline ShaderOutput Shader(const ShaderInput& rtInput, const PBRMaterialProperties& rtMaterial,
+		const Math::float3& rtScatteredLight, const Math::float3& rtEmittedLight, float fEmissionWeight = 1.0f)
+	{
+		//get some direction vectors
+		Math::float3 V = -(rtInput.OldRayDirection);
+		Math::float3 L = rtInput.NewRayDirection;
+		Math::float3 N = rtInput.Normal;
+
+		//see PerRayShading.hlsli for the derivation of the recursive formula
+		ShaderOutput rtOutput;
+		rtOutput.PDF = BRDFSamplePDF(V, L, N, rtMaterial);
+		rtOutput.Scattered = rtScatteredLight * CosineWeightedBRDF(V, L, N, rtMaterial) / std::max(rtOutput.PDF, SHADING_EPSILON);
+		rtOutput.Emitted = Math::max(Math::float3(0.0f), rtScatteredLight * rtMaterial.Emissive) * fEmissionWeight + rtEmittedLight;
+		return rtOutput;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,163 @@
+//include-files
+#include "RadixSort.h"
+#include "Parallel.h"
+
+#include <atomic>
+#include <memory>
+
+
+
+namespace RT::Core
+{
+
+	//count the digits of all passes at once (CS_SortHistogram.hlsl)
+	static void BuildGlobalHistograms(const std::vector<Math::uint2>& rtKeys, uint32_t iNumTiles, uint32_t* iGlobalHistograms)
+	{
+		std::unique_ptr<std::atomic<uint32_t>[]> iHistograms(new std::atomic<uint32_t>[RADIX_SORT_RADIX * RADIX_SORT_NUM_PASSES]);
+		for (uint32_t i = 0; i < RADIX_SORT_RADIX * RADIX_SORT_NUM_PASSES; i++)
+		{
+			iHistograms[i] = 0;
+		}
+
+		ParallelFor(iNumTiles, 16, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			uint32_t iTileHistograms[RADIX_SORT_RADIX * RADIX_SORT_NUM_PASSES] = {};
+			uint64_t iLastElement = std::min<uint64_t>(iEnd * RADIX_SORT_TILE_SIZE, rtKeys.size());
+			for (uint64_t i = iBegin * RADIX_SORT_TILE_SIZE; i < iLastElement; i++)
+			{
+				uint32_t iKey = rtKeys[i].x;
+				for (uint32_t j = 0; j < RADIX_SORT_NUM_PASSES; j++)
+				{
+					iTileHistograms[j * RADIX_SORT_RADIX + ((iKey >> (8 * j)) & 0xff)]++;
+				}
+			}
+
+			for (uint32_t i = 0; i < RADIX_SORT_RADIX * RADIX_SORT_NUM_PASSES; i++)
+			{
+				if (iTileHistograms[i] > 0) iHistograms[i].fetch_add(iTileHistograms[i], std::memory_order_relaxed);
+			}
+		});
+
+		//turn the histograms into the offsets of the digits (CS_SortPrefixSum.hlsl)
+		for (uint32_t i = 0; i < RADIX_SORT_NUM_PASSES; i++)
+		{
+			uint32_t iPrefixSum = 0;
+			for (uint32_t j = 0; j < RADIX_SORT_RADIX; j++)
+			{
+				iGlobalHistograms[i * RADIX_SORT_RADIX + j] = iPrefixSum;
+				iPrefixSum += iHistograms[i * RADIX_SORT_RADIX + j];
+			}
+		}
+	}
+
+
+	//one pass of the onesweep sort (CS_SortOnesweep.hlsl)
+	static void SortPass(const std::vector<Math::uint2>& rtSource, std::vector<Math::uint2>& rtTarget, uint32_t iPassIndex,
+		const uint32_t* iGlobalOffsets, std::atomic<uint32_t>* iPartitionStatus, uint32_t iNumTiles)
+	{
+		std::atomic<uint32_t> iTileCounter = 0;
+		const uint32_t iShift = 8 * iPassIndex;
+		const uint64_t iNumElements = rtSource.size();
+
+		ParallelFor(iNumTiles, 1, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			Math::uint2 rtSortedKeys[RADIX_SORT_TILE_SIZE];
+			uint32_t iRanks[RADIX_SORT_TILE_SIZE];
+
+			for (uint64_t iChunk = iBegin; iChunk < iEnd; iChunk++)
+			{
+				//the tiles are numbered in the order in which they are started, so every previous tile is already being processed
+				uint32_t iTileIndex = iTileCounter.fetch_add(1);
+				uint64_t iTileStart = (uint64_t)iTileIndex * RADIX_SORT_TILE_SIZE;
+				uint32_t iNumTileElements = (uint32_t)std::min<uint64_t>(RADIX_SORT_TILE_SIZE, iNumElements - iTileStart);
+				const Math::uint2* rtTileKeys = &(rtSource[iTileStart]);
+
+				//rank the keys: the number of keys with the same digit in front of them
+				uint32_t iDigitCounts[RADIX_SORT_RADIX] = {};
+				for (uint32_t i = 0; i < iNumTileElements; i++)
+				{
+					iRanks[i] = iDigitCounts[(rtTileKeys[i].x >> iShift) & 0xff]++;
+				}
+
+				//publish the digit counts of this tile, the first tile already knows its inclusive counts
+				std::atomic<uint32_t>* iTileStatus = iPartitionStatus + (uint64_t)iTileIndex * RADIX_SORT_RADIX;
+				uint32_t iFlag = (iTileIndex == 0) ? RADIX_SORT_FLAG_INCLUSIVE : RADIX_SORT_FLAG_AGGREGATE;
+				for (uint32_t i = 0; i < RADIX_SORT_RADIX; i++)
+				{
+					iTileStatus[i].store(iFlag | iDigitCounts[i], std::memory_order_release);
+				}
+
+				//the offsets of the digits in this tile
+				uint32_t iDigitOffsets[RADIX_SORT_RADIX];
+				uint32_t iPrefixSum = 0;
+				for (uint32_t i = 0; i < RADIX_SORT_RADIX; i++)
+				{
+					iDigitOffsets[i] = iPrefixSum;
+					iPrefixSum += iDigitCounts[i];
+				}
+
+				//the decoupled look-back: add up the counts of the previous tiles until a tile with an inclusive count is found
+				uint32_t iGlobalDigitOffsets[RADIX_SORT_RADIX];
+				for (uint32_t i = 0; i < RADIX_SORT_RADIX; i++)
+				{
+					uint32_t iPreviousCount = 0;
+					if (iTileIndex > 0)
+					{
+						uint32_t iLookBackTile = iTileIndex - 1;
+						while (true)
+						{
+							uint32_t iStatus = iPartitionStatus[(uint64_t)iLookBackTile * RADIX_SORT_RADIX + i].load(std::memory_order_acquire);
+							if ((iStatus & RADIX_SORT_FLAG_MASK) == RADIX_SORT_FLAG_NOT_READY)
+							{
+								std::this_thread::yield(); // wait for the previous tile
+								continue;
+							}
+
+							iPreviousCount += iStatus & RADIX_SORT_VALUE_MASK;
+							if ((iStatus & RADIX_SORT_FLAG_MASK) == RADIX_SORT_FLAG_INCLUSIVE) break;
+							iLookBackTile--;
+						}
+
+						iTileStatus[i].store(RADIX_SORT_FLAG_INCLUSIVE | (iPreviousCount + iDigitCounts[i]), std::memory_order_release);
+					}
+					iGlobalDigitOffsets[i] = iGlobalOffsets[iPassIndex * RADIX_SORT_RADIX + i] + iPreviousCount;
+				}
+
+				//sort the keys of the tile locally and write them out in order
+				for (uint32_t i = 0; i < iNumTileElements; i++)
+				{
+					rtSortedKeys[iDigitOffsets[(rtTileKeys[i].x >> iShift) & 0xff] + iRanks[i]] = rtTileKeys[i];
+				}
+				for (uint32_t i = 0; i < iNumTileElements; i++)
+				{
+					uint32_t iDigit = (rtSortedKeys[i].x >> iShift) & 0xff;
+					rtTarget[iGlobalDigitOffsets[iDigit] + i - iDigitOffsets[iDigit]] = rtSortedKeys[i];
+				}
+			}
+		});
+	}
+
+
+	void RadixSortOnesweep(std::vector<Math::uint2>& rtKeys, std::vector<Math::uint2>& rtTempKeys)
+	{
+		rtTempKeys.resize(rtKeys.size());
+		if (rtKeys.empty()) return;
+
+		const uint32_t iNumTiles = GetRadixSortTileCount(rtKeys.size());
+		uint32_t iGlobalOffsets[RADIX_SORT_RADIX * RADIX_SORT_NUM_PASSES];
+		BuildGlobalHistograms(rtKeys, iNumTiles, iGlobalOffsets);
+
+		std::unique_ptr<std::atomic<uint32_t>[]> iPartitionStatus(new std::atomic<uint32_t>[(uint64_t)iNumTiles * RADIX_SORT_RADIX]);
+		for (uint32_t iPassIndex = 0; iPassIndex < RADIX_SORT_NUM_PASSES; iPassIndex++)
+		{
+			for (uint64_t i = 0; i < (uint64_t)iNumTiles * RADIX_SORT_RADIX; i++)
+			{
+				iPartitionStatus[i].store(RADIX_SORT_FLAG_NOT_READY, std::memory_order_relaxed);
+			}
+
+			SortPass(rtKeys, rtTempKeys, iPassIndex, iGlobalOffsets, iPartitionStatus.get(), iNumTiles);
+			rtKeys.swap(rtTempKeys);
+		}
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+
+#include "Core/Math.h"
+
+
+
+//the cpu version of the onesweep radix sort in CS_SortHistogram.hlsl, CS_SortPrefixSum.hlsl and CS_SortOnesweep.hlsl
+//it uses the same tiles, ranks and decoupled look-back, so it produces the same result and can be used to validate the gpu sort
+namespace RT::Core
+{
+
+	//these values have to match the ones in Sort.hlsli
+	const uint32_t RADIX_SORT_RADIX = 256;
+	const uint32_t RADIX_SORT_NUM_PASSES = 4;
+	const uint32_t RADIX_SORT_GROUP_SIZE = 256;
+	const uint32_t RADIX_SORT_KEYS_PER_THREAD = 8;
+	const uint32_t RADIX_SORT_TILE_SIZE = RADIX_SORT_GROUP_SIZE * RADIX_SORT_KEYS_PER_THREAD;
+	const uint32_t RADIX_SORT_HISTOGRAM_BUFFER_SIZE = RADIX_SORT_RADIX * RADIX_SORT_NUM_PASSES + RADIX_SORT_NUM_PASSES; // the histograms and the tile counters
+
+	//the look-back status of a digit in a tile: the flag in the upper 2 bits, the number of keys in the lower 30 bits
+	const uint32_t RADIX_SORT_FLAG_NOT_READY = 0x00000000;
+	const uint32_t RADIX_SORT_FLAG_AGGREGATE = 0x40000000;
+	const uint32_t RADIX_SORT_FLAG_INCLUSIVE = 0x80000000;
+	const uint32_t RADIX_SORT_FLAG_MASK = 0xc0000000;
+	const uint32_t RADIX_SORT_VALUE_MASK = 0x3fffffff;
+
+
+	inline uint32_t GetRadixSortTileCount(uint64_t iNumElements) { return (uint32_t)((iNumElements + RADIX_SORT_TILE_SIZE - 1) / RADIX_SORT_TILE_SIZE); }
+
+	//a stable sort of the pairs by their x value (with less than 2^30 elements), rtTempKeys is used as scratch memory
+	void RadixSortOnesweep(std::vector<Math::uint2>& rtKeys, std::vector<Math::uint2>& rtTempKeys);
+
+}
\ No newline at end of file
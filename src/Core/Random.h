@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Core/Math.h"
+
+
+
+//the cpu port of Random.hlsli, shared by the cpu backends
+namespace RT::Core
+{
+
+	//implements a basic xorshift algorithm for pseudo random numbers: http://www.jstatsoft.org/v08/i14/paper
+	inline uint32_t XorShift(uint32_t& iSeed)
+	{
+		iSeed ^= iSeed << 13;
+		iSeed ^= iSeed >> 17;
+		iSeed ^= iSeed << 5;
+		return iSeed;
+	}
+	inline Math::uint2 XorShift(Math::uint2& rtSeed)
+	{
+		XorShift(rtSeed.x);
+		XorShift(rtSeed.y);
+		return rtSeed;
+	}
+	inline Math::uint3 XorShift(Math::uint3& rtSeed)
+	{
+		XorShift(rtSeed.x);
+		XorShift(rtSeed.y);
+		XorShift(rtSeed.z);
+		return rtSeed;
+	}
+
+	//returns a random number between 0 and 1 using the xorshift algorithm
+	inline float Random(uint32_t& iSeed)
+	{
+		return Math::saturate((float)XorShift(iSeed) * 2.3283064e-10f);
+	}
+	inline Math::float2 Random(Math::uint2& rtSeed)
+	{
+		XorShift(rtSeed);
+		return Math::float2(Math::saturate((float)rtSeed.x * 2.3283064e-10f), Math::saturate((float)rtSeed.y * 2.3283064e-10f));
+	}
+	inline Math::float3 Random(Math::uint3& rtSeed)
+	{
+		XorShift(rtSeed);
+		return Math::float3(Math::saturate((float)rtSeed.x * 2.3283064e-10f), Math::saturate((float)rtSeed.y * 2.3283064e-10f),
+			Math::saturate((float)rtSeed.z * 2.3283064e-10f));
+	}
+
+	//the seed initialization, which every shader does with its thread id
+	inline Math::uint3 InitializeSeed(uint32_t iThreadID, const Math::uint3& rtSeedOffset)
+	{
+		Math::uint3 rtSeed = { iThreadID, iThreadID, iThreadID };
+		rtSeed.x *= rtSeed.x + 17;
+		rtSeed.y *= rtSeed.y + 17;
+		rtSeed.z *= rtSeed.z + 17;
+		XorShift(rtSeed);
+		rtSeed.x += rtSeedOffset.x;
+		rtSeed.y += rtSeedOffset.y;
+		rtSeed.z += rtSeedOffset.z;
+		return rtSeed;
+	}
+
+	//functions for returning a point on a hemisphere
+	//uniform point sampling on a hemisphere, courtesy of https://raytracing.github.io/books/RayTracingTheRestOfYourLife.html
+	inline Math::float3 PointOnHemisphere(const Math::float2& rtRandomNumber)
+	{
+		float y = std::sqrt(1.0f - rtRandomNumber.y);
+		float r = std::sqrt(rtRandomNumber.y);
+		float phi = 6.2831853f * rtRandomNumber.x;
+		return Math::float3(std::cos(phi) * r, y, std::sin(phi) * r);
+	}
+	inline Math::float3 PointOnHemisphere(Math::uint3& rtSeed)
+	{
+		return PointOnHemisphere(Random(rtSeed).xy());
+	}
+	//two directions, which are perpendicular to the normal and to each other
+	inline void PerpendicularDirections(const Math::float3& rtNormal, Math::float3& rtPerpendicular1, Math::float3& rtPerpendicular2)
+	{
+		//see Random.hlsli for why this is always perpendicular to the normal
+		rtPerpendicular1 = Math::normalize(Math::float3(-rtNormal.z, 0.0f, rtNormal.x));
+		if ((rtNormal.z == 0.0f) && (rtNormal.x == 0.0f)) //if the normal points straight up or down the code above generates an unusable vector
+			rtPerpendicular1 = Math::float3(1.0f, 0.0f, 0.0f);
+		rtPerpendicular2 = Math::normalize(Math::cross(rtNormal, rtPerpendicular1));
+		rtPerpendicular1 = Math::normalize(Math::cross(rtNormal, rtPerpendicular2));
+	}
+	inline Math::float3 RotatedRandomDirection(const Math::float2& rtRandomNumbers, const Math::float3& rtNormal)
+	{
+		Math::float3 rtPerpendicular1, rtPerpendicular2;
+		PerpendicularDirections(rtNormal, rtPerpendicular1, rtPerpendicular2);
+
+		Math::float3 rtBasePoint = PointOnHemisphere(rtRandomNumbers);
+		return (rtBasePoint.x * rtPerpendicular1) + (rtBasePoint.y * rtNormal) + (rtBasePoint.z * rtPerpendicular2);
+	}
+	inline Math::float3 RotatedRandomDirection(Math::uint3& rtSeed, const Math::float3& rtNormal)
+	{
+		return RotatedRandomDirection(Random(rtSeed).xy(), rtNormal);
+	}
+
+	//the solid angle pdf of RotatedRandomDirection, the points on the hemisphere are cosine weighted
+	inline float RotatedRandomDirectionPDF(float fNdotL)
+	{
+		return Math::saturate(fNdotL) * 0.318309886f; // = NdotL / PI
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+//include-files
+#include "RayQueue.h"
+#include "Parallel.h"
+#include "RadixSort.h"
+
+#include <vector>
+#include <algorithm>
+
+
+
+namespace RT::Core
+{
+
+	uint32_t CompactRayQueue(const uint32_t* iRayQueue, const uint8_t* iSurvivors, uint32_t iNumRays, uint32_t* iCompactedQueue)
+	{
+		if (iNumRays == 0) return 0;
+		const uint32_t iNumBlocks = (iNumRays + RAY_QUEUE_BLOCK_SIZE - 1) / RAY_QUEUE_BLOCK_SIZE;
+
+		//count the survivors of every block
+		std::vector<uint32_t> iBlockOffsets(iNumBlocks + 1, 0);
+		ParallelFor(iNumBlocks, 1, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t iBlock = iBegin; iBlock < iEnd; iBlock++)
+			{
+				uint32_t iFirst = (uint32_t)iBlock * RAY_QUEUE_BLOCK_SIZE;
+				uint32_t iLast = std::min(iFirst + RAY_QUEUE_BLOCK_SIZE, iNumRays);
+				uint32_t iCount = 0;
+				for (uint32_t i = iFirst; i < iLast; i++)
+				{
+					iCount += (iSurvivors[i] != 0) ? 1 : 0;
+				}
+				iBlockOffsets[iBlock + 1] = iCount;
+			}
+		});
+
+		//the exclusive prefix sum over the blocks gives the first output position of every block
+		for (uint32_t i = 0; i < iNumBlocks; i++)
+		{
+			iBlockOffsets[i + 1] += iBlockOffsets[i];
+		}
+
+		//scatter the survivors, every block writes its own range, so the order is kept
+		ParallelFor(iNumBlocks, 1, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t iBlock = iBegin; iBlock < iEnd; iBlock++)
+			{
+				uint32_t iFirst = (uint32_t)iBlock * RAY_QUEUE_BLOCK_SIZE;
+				uint32_t iLast = std::min(iFirst + RAY_QUEUE_BLOCK_SIZE, iNumRays);
+				uint32_t iOutput = iBlockOffsets[iBlock];
+				for (uint32_t i = iFirst; i < iLast; i++)
+				{
+					if (iSurvivors[i] != 0)
+					{
+						iCompactedQueue[iOutput] = iRayQueue[i];
+						iOutput++;
+					}
+				}
+			}
+		});
+
+		return iBlockOffsets[iNumBlocks];
+	}
+
+
+
+	void SortRayQueueByMaterial(const uint32_t* iRayQueue, const uint32_t* iMaterialIDs, uint32_t iNumRays, uint32_t iNumMaterials,
+		uint32_t* iMaterialOffsets, uint32_t* iSortedQueue)
+	{
+		if (iNumMaterials == 0) return;
+		std::fill(iMaterialOffsets, iMaterialOffsets + iNumMaterials + 1, 0);
+		if (iNumRays == 0) return;
+		const uint32_t iNumBlocks = (iNumRays + RAY_QUEUE_BLOCK_SIZE - 1) / RAY_QUEUE_BLOCK_SIZE;
+		auto fnGetMaterial = [&](uint32_t iQueueIndex)
+		{
+			return std::min(iMaterialIDs[iRayQueue[iQueueIndex]], iNumMaterials - 1);
+		};
+
+		//the histogram of every block, iBlockOffsets[iBlock * iNumMaterials + m] is the number of hits of material m in the block
+		std::vector<uint32_t> iBlockOffsets((uint64_t)iNumBlocks * iNumMaterials, 0);
+		ParallelFor(iNumBlocks, 1, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t iBlock = iBegin; iBlock < iEnd; iBlock++)
+			{
+				uint32_t iFirst = (uint32_t)iBlock * RAY_QUEUE_BLOCK_SIZE;
+				uint32_t iLast = std::min(iFirst + RAY_QUEUE_BLOCK_SIZE, iNumRays);
+				uint32_t* iCounts = &iBlockOffsets[iBlock * iNumMaterials];
+				for (uint32_t i = iFirst; i < iLast; i++)
+				{
+					iCounts[fnGetMaterial(i)]++;
+				}
+			}
+		});
+
+		//the exclusive prefix sum in material major order: all blocks of material 0 first, then material 1 and so on
+		uint32_t iOffset = 0;
+		for (uint32_t m = 0; m < iNumMaterials; m++)
+		{
+			iMaterialOffsets[m] = iOffset;
+			for (uint32_t iBlock = 0; iBlock < iNumBlocks; iBlock++)
+			{
+				uint32_t iCount = iBlockOffsets[(uint64_t)iBlock * iNumMaterials + m];
+				iBlockOffsets[(uint64_t)iBlock * iNumMaterials + m] = iOffset;
+				iOffset += iCount;
+			}
+		}
+		iMaterialOffsets[iNumMaterials] = iOffset;
+
+		//scatter the entries, every block owns its ranges of the buckets, so the order inside a bucket is kept
+		ParallelFor(iNumBlocks, 1, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t iBlock = iBegin; iBlock < iEnd; iBlock++)
+			{
+				uint32_t iFirst = (uint32_t)iBlock * RAY_QUEUE_BLOCK_SIZE;
+				uint32_t iLast = std::min(iFirst + RAY_QUEUE_BLOCK_SIZE, iNumRays);
+				uint32_t* iOutputs = &iBlockOffsets[iBlock * iNumMaterials];
+				for (uint32_t i = iFirst; i < iLast; i++)
+				{
+					iSortedQueue[iOutputs[fnGetMaterial(i)]++] = iRayQueue[i];
+				}
+			}
+		});
+	}
+
+
+
+	void BinRayQueue(uint32_t* iRayQueue, uint32_t iNumRays, const Ray* rtRays, const uint32_t* iRayPixels, Math::uint2 rtScreenSize,
+		std::vector<Math::uint2>& rtBins, std::vector<Math::uint2>& rtTempBins)
+	{
+		//x: the bin key, y: the ray
+		rtBins.resize(iNumRays);
+		ParallelFor(iNumRays, RAY_QUEUE_BLOCK_SIZE, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t i = iBegin; i < iEnd; i++)
+			{
+				uint32_t iRayIndex = iRayQueue[i];
+				uint32_t iPixel = iRayPixels[iRayIndex];
+				rtBins[i] = Math::uint2(GetRayBinKey(rtRays[iRayIndex].Direction, Math::uint2(iPixel >> 16, iPixel & 0xffff), rtScreenSize), iRayIndex);
+			}
+		});
+
+		//the sort is stable, so the rays of a bin keep their order in the queue
+		RadixSortOnesweep(rtBins, rtTempBins);
+
+		ParallelFor(iNumRays, RAY_QUEUE_BLOCK_SIZE, [&](uint64_t iBegin, uint64_t iEnd, unsigned int)
+		{
+			for (uint64_t i = iBegin; i < iEnd; i++)
+			{
+				iRayQueue[i] = rtBins[i].y;
+			}
+		});
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "Core/Math.h"
+#include "Core/Intersection.h"
+
+
+
+//the queue of the live rays for wavefront path tracing: after every bounce, the rays that hit something are compacted into a dense queue,
+//so the next bounce only traces them (the cpu version of the compaction in CS_TraceRays.hlsl), the queue can be reordered by material or by ray bin
+namespace RT::Core
+{
+
+	const uint32_t RAY_QUEUE_BLOCK_SIZE = 4096; // the number of queue entries, which are counted and scattered by one work item
+	const uint32_t RAY_BIN_DIRECTION_BITS = 16; // the octahedral direction in the low bits of a bin key, the screen tile is above it
+	const uint32_t RAY_BIN_INVALID_KEY = 0xffffffff; // the gpu sorts the empty slots of the queue behind all rays with this key
+
+
+	//copy the entries of iRayQueue, whose flag in iSurvivors (indexed by the queue position) is not 0, to the front of iCompactedQueue
+	//the order of the surviving entries doesn't change, the return value is their number
+	uint32_t CompactRayQueue(const uint32_t* iRayQueue, const uint8_t* iSurvivors, uint32_t iNumRays, uint32_t* iCompactedQueue);
+
+	//bucket the entries of iRayQueue by the material of their hit (iMaterialIDs is indexed by the ray) with a stable counting sort,
+	//so the hits of one material can be shaded together (the cpu version of CS_SortHits.hlsl), ids from iNumMaterials on use the last bucket
+	//the hits of material m are iSortedQueue[iMaterialOffsets[m]] to iSortedQueue[iMaterialOffsets[m + 1] - 1], iMaterialOffsets needs iNumMaterials + 1 entries
+	void SortRayQueueByMaterial(const uint32_t* iRayQueue, const uint32_t* iMaterialIDs, uint32_t iNumRays, uint32_t iNumMaterials,
+		uint32_t* iMaterialOffsets, uint32_t* iSortedQueue);
+
+
+	//the bin of a ray (the same key as in CS_BinRays.hlsl): 4 bits for the screen tile (2 horizontal and 2 vertical) above
+	//16 bits for the direction (8 bits per axis of its octahedral mapping), rays with the same key start close to each other and point in the same direction
+	inline uint32_t GetRayBinKey(const Math::float3& rtDirection, Math::uint2 rtPixel, Math::uint2 rtScreenSize)
+	{
+		//the octahedral mapping of the direction to [-1, 1]^2
+		float fLength = std::fabs(rtDirection.x) + std::fabs(rtDirection.y) + std::fabs(rtDirection.z);
+		float fU = (fLength > 0.0f) ? (rtDirection.x / fLength) : 0.0f;
+		float fV = (fLength > 0.0f) ? (rtDirection.y / fLength) : 0.0f;
+		if (rtDirection.z < 0.0f)
+		{
+			float fFoldedU = (1.0f - std::fabs(fV)) * ((fU >= 0.0f) ? 1.0f : -1.0f);
+			float fFoldedV = (1.0f - std::fabs(fU)) * ((fV >= 0.0f) ? 1.0f : -1.0f);
+			fU = fFoldedU;
+			fV = fFoldedV;
+		}
+		uint32_t iU = (uint32_t)std::min(std::max((fU * 0.5f + 0.5f) * 256.0f, 0.0f), 255.0f);
+		uint32_t iV = (uint32_t)std::min(std::max((fV * 0.5f + 0.5f) * 256.0f, 0.0f), 255.0f);
+
+		uint32_t iTileX = std::min(rtPixel.x * 4 / std::max(rtScreenSize.x, 1u), 3u);
+		uint32_t iTileY = std::min(rtPixel.y * 4 / std::max(rtScreenSize.y, 1u), 3u);
+
+		return (((iTileY << 2) | iTileX) << RAY_BIN_DIRECTION_BITS) | (iV << 8) | iU;
+	}
+
+	//sort the entries of iRayQueue by the bin keys of their rays (with the onesweep radix sort), so the traversal of neighbouring entries touches the same nodes
+	//iRayPixels is indexed by the ray and packs the pixel like the RayPixels buffer ((x << 16) | y), rtBins and rtTempBins are scratch memory
+	void BinRayQueue(uint32_t* iRayQueue, uint32_t iNumRays, const Ray* rtRays, const uint32_t* iRayPixels, Math::uint2 rtScreenSize,
+		std::vector<Math::uint2>& rtBins, std::vector<Math::uint2>& rtTempBins);
+
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+
+
+namespace RT::Core
+{
+
+	//the interface of a raytracer backend (d3d12 or cpu), the initialization is backend specific since it needs different resources
+	class RaytracerBackend
+	{
+	public: // = usable outside of the class
+
+		//destructor
+		virtual ~RaytracerBackend() {};
+
+
+		//public class functions
+		virtual bool Render() = 0; // a single iteration: every ray is traced once
+
+
+		//helper functions
+		virtual uint32_t GetNumSamples() = 0; // the number of completed samples per pixel
+		virtual bool IsConverged() = 0; // true, when the adaptive sampling doesn't add samples to any pixel anymore
+		virtual const char* GetBackendName() = 0;
+
+	};
+
+}
@@ -0,0 +1,158 @@
+//include-files
+#include "RenderSettings.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+
+
+
+namespace RT::Core
+{
+
+	static std::string Trim(const std::string& sText)
+	{
+		size_t iBegin = sText.find_first_not_of(" \t\r\n");
+		if (iBegin == std::string::npos) return "";
+		size_t iEnd = sText.find_last_not_of(" \t\r\n");
+		return sText.substr(iBegin, iEnd - iBegin + 1);
+	}
+
+
+	//the parsers of the values, the whole value has to be used
+	static bool ParseValue(const std::string& sValue, uint32_t& iValue)
+	{
+		char* sEnd = nullptr;
+		unsigned long long iParsedValue = std::strtoull(sValue.c_str(), &sEnd, 10);
+		if ((sValue.empty()) || (sValue[0] == '-') || (*sEnd != '\0') || (iParsedValue > 0xffffffffull)) return false;
+		iValue = (uint32_t)iParsedValue;
+		return true;
+	}
+
+	static bool ParseValue(const std::string& sValue, float& fValue)
+	{
+		char* sEnd = nullptr;
+		fValue = std::strtof(sValue.c_str(), &sEnd);
+		return (!(sValue.empty())) && (*sEnd == '\0');
+	}
+
+	static bool ParseValue(const std::string& sValue, bool& bValue)
+	{
+		std::string sLowerValue = sValue;
+		std::transform(sLowerValue.begin(), sLowerValue.end(), sLowerValue.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+		if ((sLowerValue == "1") || (sLowerValue == "true") || (sLowerValue == "on")) bValue = true;
+		else if ((sLowerValue == "0") || (sLowerValue == "false") || (sLowerValue == "off")) bValue = false;
+		else return false;
+		return true;
+	}
+
+	//three numbers, which are separated by spaces or commas
+	static bool ParseValue(const std::string& sValue, Math::float3& rtValue)
+	{
+		std::string sNumbers = sValue;
+		std::replace(sNumbers.begin(), sNumbers.end(), ',', ' ');
+		std::istringstream stdStream(sNumbers);
+		std::string sX, sY, sZ, sRest;
+		if (!(stdStream >> sX >> sY >> sZ) || (stdStream >> sRest)) return false;
+		return ParseValue(sX, rtValue.x) && ParseValue(sY, rtValue.y) && ParseValue(sZ, rtValue.z);
+	}
+
+	//a file name, which can be in quotes
+	static bool ParseValue(const std::string& sValue, std::string& sText)
+	{
+		sText = ((sValue.size() >= 2) && (sValue.front() == '"') && (sValue.back() == '"')) ? sValue.substr(1, sValue.size() - 2) : sValue;
+		return !(sText.empty());
+	}
+
+
+	bool SetRenderSetting(RenderSettings& rtSettings, const std::string& sName, const std::string& sValue)
+	{
+		std::string sTrimmedValue = Trim(sValue);
+		RenderSettings rtNewSettings = rtSettings;
+		bool bValid = false;
+
+		//the image
+		if (sName == "image.width") bValid = ParseValue(sTrimmedValue, rtNewSettings.Width) && (rtNewSettings.Width > 0) && (rtNewSettings.Width <= 0xffff);
+		else if (sName == "image.height") bValid = ParseValue(sTrimmedValue, rtNewSettings.Height) && (rtNewSettings.Height > 0) && (rtNewSettings.Height <= 0xffff);
+		else if (sName == "image.scene") bValid = ParseValue(sTrimmedValue, rtNewSettings.SceneFileName);
+		else if (sName == "image.scene_cache") bValid = ParseValue(sTrimmedValue, rtNewSettings.UseSceneCache);
+		else if (sName == "image.output") bValid = ParseValue(sTrimmedValue, rtNewSettings.OutputFileName);
+		else if (sName == "image.samples") bValid = ParseValue(sTrimmedValue, rtNewSettings.MaxSamples);
+		else if (sName == "image.seconds") bValid = ParseValue(sTrimmedValue, rtNewSettings.MaxSeconds);
+		else if (sName == "image.seed") bValid = ParseValue(sTrimmedValue, rtNewSettings.Seed);
+
+		//the camera
+		else if (sName == "camera.position") bValid = ParseValue(sTrimmedValue, rtNewSettings.Camera.Position);
+		else if (sName == "camera.focus_point") bValid = ParseValue(sTrimmedValue, rtNewSettings.Camera.FocusPoint);
+		else if (sName == "camera.up_direction") bValid = ParseValue(sTrimmedValue, rtNewSettings.Camera.UpDirection);
+		else if (sName == "camera.fov") bValid = ParseValue(sTrimmedValue, rtNewSettings.Camera.VerticalFOV) && (rtNewSettings.Camera.VerticalFOV > 0.0f);
+		else if (sName == "camera.nearz") bValid = ParseValue(sTrimmedValue, rtNewSettings.Camera.NearZ) && (rtNewSettings.Camera.NearZ > 0.0f);
+		else if (sName == "camera.farz") bValid = ParseValue(sTrimmedValue, rtNewSettings.Camera.FarZ) && (rtNewSettings.Camera.FarZ > 0.0f);
+
+		//the path tracing
+		else if (sName == "pathtracing.max_ray_depth") bValid = ParseValue(sTrimmedValue, rtNewSettings.MaxRayDepth) && (rtNewSettings.MaxRayDepth > 0);
+		else if (sName == "pathtracing.russian_roulette_depth") bValid = ParseValue(sTrimmedValue, rtNewSettings.RussianRouletteDepth);
+		else if (sName == "pathtracing.aa_sample_spread") bValid = ParseValue(sTrimmedValue, rtNewSettings.AASampleSpread);
+		else if (sName == "pathtracing.dof_sample_spread") bValid = ParseValue(sTrimmedValue, rtNewSettings.DOFSampleSpread);
+		else if (sName == "pathtracing.sampler") bValid = ParseValue(sTrimmedValue, rtNewSettings.Sampler) && (rtNewSettings.Sampler <= 2);
+		else if (sName == "pathtracing.light_sampling") bValid = ParseValue(sTrimmedValue, rtNewSettings.UseLightSampling);
+		else if (sName == "pathtracing.adaptive_error_threshold") bValid = ParseValue(sTrimmedValue, rtNewSettings.AdaptiveErrorThreshold) && (rtNewSettings.AdaptiveErrorThreshold >= 0.0f);
+		else if (sName == "pathtracing.adaptive_min_samples") bValid = ParseValue(sTrimmedValue, rtNewSettings.AdaptiveMinSamples);
+
+		//the ray tracing
+		else if (sName == "raytracing.bvh") bValid = ParseValue(sTrimmedValue, rtNewSettings.UseBVH);
+		else if (sName == "raytracing.sah_bvh") bValid = ParseValue(sTrimmedValue, rtNewSettings.UseSAHBVH);
+		else if (sName == "raytracing.stackless_bvh") bValid = ParseValue(sTrimmedValue, rtNewSettings.UseStacklessBVH);
+		else if (sName == "raytracing.persistent_threads") bValid = ParseValue(sTrimmedValue, rtNewSettings.UsePersistentThreads);
+		else if (sName == "raytracing.ray_binning") bValid = ParseValue(sTrimmedValue, rtNewSettings.UseRayBinning);
+
+		//only valid values change the settings
+		if (bValid) rtSettings = rtNewSettings;
+		return bValid;
+	}
+
+
+	bool LoadRenderSettings(const std::string& sFileName, RenderSettings& rtSettings)
+	{
+		std::ifstream stdFile(sFileName);
+		if (!stdFile)
+		{
+			std::cout << "The settings file " << sFileName << " wasn't found\n";
+			return false;
+		}
+
+		//the settings of the file are applied together, so an invalid line keeps all previous settings
+		RenderSettings rtNewSettings = rtSettings;
+		std::string sSection;
+		std::string sLine;
+		uint32_t iLineNumber = 0;
+		while (std::getline(stdFile, sLine))
+		{
+			iLineNumber++;
+			sLine = Trim(sLine.substr(0, sLine.find_first_of(";#")));
+			if (sLine.empty()) continue;
+
+			if ((sLine.front() == '[') && (sLine.back() == ']'))
+			{
+				sSection = Trim(sLine.substr(1, sLine.size() - 2));
+				continue;
+			}
+
+			size_t iEquals = sLine.find('=');
+			std::string sKey = (iEquals == std::string::npos) ? sLine : Trim(sLine.substr(0, iEquals));
+			std::string sName = sSection.empty() ? sKey : (sSection + "." + sKey);
+			if ((iEquals == std::string::npos) || (!(SetRenderSetting(rtNewSettings, sName, sLine.substr(iEquals + 1)))))
+			{
+				std::cout << "Error in the settings file " << sFileName << " (line " << iLineNumber << "): unknown setting or invalid value for " << sName << "\n";
+				return false;
+			}
+		}
+
+		rtSettings = rtNewSettings;
+		return true;
+	}
+
+}
\ No newline at end of file
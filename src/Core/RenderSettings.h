@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+
+#include "Core/Math.h"
+
+
+
+namespace RT::Core
+{
+
+	//the camera of a render
+	struct CameraSettings
+	{
+		Math::float3 Position;
+		Math::float3 FocusPoint;
+		Math::float3 UpDirection;
+		float VerticalFOV; // in radians
+		float NearZ;
+		float FarZ;
+	};
+
+	//the properties of a render, which are read at runtime, so parameter sweeps don't need to recompile the raytracer or the shaders
+	//the defaults are the values of Settings.h (GetDefaultRenderSettings of the backends), a settings file and the command line override them
+	struct RenderSettings
+	{
+		//the image
+		uint32_t Width;
+		uint32_t Height;
+		std::string SceneFileName;
+		bool UseSceneCache;
+		std::string OutputFileName;
+		uint32_t MaxSamples;
+		float MaxSeconds;
+		uint32_t Seed; // every random number of the render is derived from it, so two renders with the same settings and seed are identical
+		CameraSettings Camera;
+
+		//the path tracing
+		uint32_t MaxRayDepth;
+		uint32_t RussianRouletteDepth;
+		float AASampleSpread;
+		float DOFSampleSpread;
+		uint32_t Sampler; // the values of RT_SAMPLER
+		bool UseLightSampling;
+		float AdaptiveErrorThreshold;
+		uint32_t AdaptiveMinSamples;
+
+		//the ray tracing (the width of the SAH BVH stays RT_BVH_WIDTH, since the node layout depends on it)
+		bool UseBVH;
+		bool UseSAHBVH;
+		bool UseStacklessBVH;
+		bool UsePersistentThreads;
+		bool UseRayBinning;
+	};
+
+
+	//changes a single setting, the names are "section.key" like in the settings file (e.g. "camera.position" with the value "-4 2 -3")
+	//returns false, if the name is unknown or the value is invalid
+	bool SetRenderSetting(RenderSettings& rtSettings, const std::string& sName, const std::string& sValue);
+
+	//reads an ini file with the sections [image], [camera], [pathtracing] and [raytracing], every line "key = value" overrides one setting
+	//the settings, which aren't in the file, keep their values, comments start with ';' or '#'
+	bool LoadRenderSettings(const std::string& sFileName, RenderSettings& rtSettings);
+
+}
\ No newline at end of file
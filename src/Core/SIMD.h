@@ -0,0 +1,334 @@
+#pragma once
+
+#include "Core/Math.h"
+
+//detect the available instruction sets
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#define RT_SIMD_SSE 1
+	#include <immintrin.h>
+	#if defined(__AVX__)
+		#define RT_SIMD_AVX 1
+	#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+	#define RT_SIMD_NEON 1
+	#include <arm_neon.h>
+#endif
+
+
+
+//a small vector math layer for the cpu hot paths, it uses sse/avx or neon when available and plain c++ otherwise
+namespace RT::Math::SIMD
+{
+
+	//4 floats, which are processed at once (xyz are used for 3d vectors)
+	struct float4v
+	{
+#if RT_SIMD_SSE
+		__m128 v;
+#elif RT_SIMD_NEON
+		float32x4_t v;
+#else
+		float v[4];
+#endif
+	};
+
+
+
+	//loading and storing
+	inline float4v Set(float fX, float fY, float fZ, float fW)
+	{
+#if RT_SIMD_SSE
+		return { _mm_setr_ps(fX, fY, fZ, fW) };
+#elif RT_SIMD_NEON
+		float fValues[4] = { fX, fY, fZ, fW };
+		return { vld1q_f32(fValues) };
+#else
+		return { { fX, fY, fZ, fW } };
+#endif
+	}
+
+	inline float4v Splat(float fValue)
+	{
+#if RT_SIMD_SSE
+		return { _mm_set1_ps(fValue) };
+#elif RT_SIMD_NEON
+		return { vdupq_n_f32(fValue) };
+#else
+		return { { fValue, fValue, fValue, fValue } };
+#endif
+	}
+
+	inline float4v Zero() { return Splat(0.0f); }
+	inline float4v Load(const float2& rtValue) { return Set(rtValue.x, rtValue.y, 0.0f, 0.0f); }
+	inline float4v Load(const float3& rtValue) { return Set(rtValue.x, rtValue.y, rtValue.z, 0.0f); }
+
+	inline float4v Load(const float4& rtValue)
+	{
+#if RT_SIMD_SSE
+		return { _mm_loadu_ps(&rtValue.x) };
+#elif RT_SIMD_NEON
+		return { vld1q_f32(&rtValue.x) };
+#else
+		return { { rtValue.x, rtValue.y, rtValue.z, rtValue.w } };
+#endif
+	}
+
+	//4 bytes converted to floats (the quantized bounds of the wide bvh nodes)
+	inline float4v LoadBytes(const uint8_t* iValues)
+	{
+#if RT_SIMD_SSE
+		int32_t iPacked;
+		std::memcpy(&iPacked, iValues, sizeof(int32_t));
+		__m128i iZero = _mm_setzero_si128();
+		__m128i iWords = _mm_unpacklo_epi8(_mm_cvtsi32_si128(iPacked), iZero);
+		return { _mm_cvtepi32_ps(_mm_unpacklo_epi16(iWords, iZero)) };
+#elif RT_SIMD_NEON
+		uint8x8_t iBytes = vreinterpret_u8_u32(vld1_dup_u32((const uint32_t*)iValues));
+		return { vcvtq_f32_u32(vmovl_u16(vget_low_u16(vmovl_u8(iBytes)))) };
+#else
+		return { { (float)iValues[0], (float)iValues[1], (float)iValues[2], (float)iValues[3] } };
+#endif
+	}
+
+	inline float4 StoreFloat4(const float4v& rtValue)
+	{
+		float4 rtResult;
+#if RT_SIMD_SSE
+		_mm_storeu_ps(&rtResult.x, rtValue.v);
+#elif RT_SIMD_NEON
+		vst1q_f32(&rtResult.x, rtValue.v);
+#else
+		rtResult = float4(rtValue.v[0], rtValue.v[1], rtValue.v[2], rtValue.v[3]);
+#endif
+		return rtResult;
+	}
+
+	inline float3 StoreFloat3(const float4v& rtValue) { return StoreFloat4(rtValue).xyz(); }
+	inline float GetX(const float4v& rtValue) { return StoreFloat4(rtValue).x; }
+
+
+
+	//arithmetic
+#if RT_SIMD_SSE
+	inline float4v operator+(const float4v& rtA, const float4v& rtB) { return { _mm_add_ps(rtA.v, rtB.v) }; }
+	inline float4v operator-(const float4v& rtA, const float4v& rtB) { return { _mm_sub_ps(rtA.v, rtB.v) }; }
+	inline float4v operator*(const float4v& rtA, const float4v& rtB) { return { _mm_mul_ps(rtA.v, rtB.v) }; }
+	inline float4v operator/(const float4v& rtA, const float4v& rtB) { return { _mm_div_ps(rtA.v, rtB.v) }; }
+	inline float4v Min(const float4v& rtA, const float4v& rtB) { return { _mm_min_ps(rtA.v, rtB.v) }; }
+	inline float4v Max(const float4v& rtA, const float4v& rtB) { return { _mm_max_ps(rtA.v, rtB.v) }; }
+	inline float4v Sqrt(const float4v& rtA) { return { _mm_sqrt_ps(rtA.v) }; }
+#elif RT_SIMD_NEON
+	inline float4v operator+(const float4v& rtA, const float4v& rtB) { return { vaddq_f32(rtA.v, rtB.v) }; }
+	inline float4v operator-(const float4v& rtA, const float4v& rtB) { return { vsubq_f32(rtA.v, rtB.v) }; }
+	inline float4v operator*(const float4v& rtA, const float4v& rtB) { return { vmulq_f32(rtA.v, rtB.v) }; }
+	inline float4v operator/(const float4v& rtA, const float4v& rtB)
+	{
+		float fA[4], fB[4];
+		vst1q_f32(fA, rtA.v);
+		vst1q_f32(fB, rtB.v);
+		for (int i = 0; i < 4; i++) { fA[i] /= fB[i]; }
+		return { vld1q_f32(fA) };
+	}
+	inline float4v Min(const float4v& rtA, const float4v& rtB) { return { vminq_f32(rtA.v, rtB.v) }; }
+	inline float4v Max(const float4v& rtA, const float4v& rtB) { return { vmaxq_f32(rtA.v, rtB.v) }; }
+	inline float4v Sqrt(const float4v& rtA)
+	{
+		float fA[4];
+		vst1q_f32(fA, rtA.v);
+		for (int i = 0; i < 4; i++) { fA[i] = std::sqrt(fA[i]); }
+		return { vld1q_f32(fA) };
+	}
+#else
+	#define RT_SIMD_SCALAR_OPERATION(Name, Expression) \
+	inline float4v Name(const float4v& rtA, const float4v& rtB) \
+	{ \
+		float4v rtResult; \
+		for (int i = 0; i < 4; i++) { rtResult.v[i] = Expression; } \
+		return rtResult; \
+	}
+
+	RT_SIMD_SCALAR_OPERATION(operator+, rtA.v[i] + rtB.v[i])
+	RT_SIMD_SCALAR_OPERATION(operator-, rtA.v[i] - rtB.v[i])
+	RT_SIMD_SCALAR_OPERATION(operator*, rtA.v[i] * rtB.v[i])
+	RT_SIMD_SCALAR_OPERATION(operator/, rtA.v[i] / rtB.v[i])
+	RT_SIMD_SCALAR_OPERATION(Min, (rtB.v[i] < rtA.v[i]) ? rtB.v[i] : rtA.v[i])
+	RT_SIMD_SCALAR_OPERATION(Max, (rtB.v[i] > rtA.v[i]) ? rtB.v[i] : rtA.v[i])
+
+	#undef RT_SIMD_SCALAR_OPERATION
+
+	inline float4v Sqrt(const float4v& rtA) { return { { std::sqrt(rtA.v[0]), std::sqrt(rtA.v[1]), std::sqrt(rtA.v[2]), std::sqrt(rtA.v[3]) } }; }
+#endif
+
+	inline float4v& operator+=(float4v& rtA, const float4v& rtB) { rtA = rtA + rtB; return rtA; }
+	inline float4v& operator-=(float4v& rtA, const float4v& rtB) { rtA = rtA - rtB; return rtA; }
+	inline float4v& operator*=(float4v& rtA, const float4v& rtB) { rtA = rtA * rtB; return rtA; }
+
+
+
+	//comparisons, which return a mask with all bits set in the lanes where the comparison is true
+#if RT_SIMD_SSE
+	inline float4v Less(const float4v& rtA, const float4v& rtB) { return { _mm_cmplt_ps(rtA.v, rtB.v) }; }
+	inline float4v LessEqual(const float4v& rtA, const float4v& rtB) { return { _mm_cmple_ps(rtA.v, rtB.v) }; }
+	inline float4v And(const float4v& rtA, const float4v& rtB) { return { _mm_and_ps(rtA.v, rtB.v) }; }
+	inline float4v Select(const float4v& rtA, const float4v& rtB, const float4v& rtMask) { return { _mm_or_ps(_mm_andnot_ps(rtMask.v, rtA.v), _mm_and_ps(rtMask.v, rtB.v)) }; }
+	inline int MoveMask(const float4v& rtMask) { return _mm_movemask_ps(rtMask.v); }
+#elif RT_SIMD_NEON
+	inline float4v Less(const float4v& rtA, const float4v& rtB) { return { vreinterpretq_f32_u32(vcltq_f32(rtA.v, rtB.v)) }; }
+	inline float4v LessEqual(const float4v& rtA, const float4v& rtB) { return { vreinterpretq_f32_u32(vcleq_f32(rtA.v, rtB.v)) }; }
+	inline float4v And(const float4v& rtA, const float4v& rtB) { return { vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(rtA.v), vreinterpretq_u32_f32(rtB.v))) }; }
+	inline float4v Select(const float4v& rtA, const float4v& rtB, const float4v& rtMask) { return { vbslq_f32(vreinterpretq_u32_f32(rtMask.v), rtB.v, rtA.v) }; }
+	inline int MoveMask(const float4v& rtMask)
+	{
+		uint32_t iLanes[4];
+		vst1q_u32(iLanes, vshrq_n_u32(vreinterpretq_u32_f32(rtMask.v), 31));
+		return (int)(iLanes[0] | (iLanes[1] << 1) | (iLanes[2] << 2) | (iLanes[3] << 3));
+	}
+#else
+	inline float4v MaskFromBools(bool b0, bool b1, bool b2, bool b3)
+	{
+		float fAllBits = asfloat(0xffffffff);
+		return { { b0 ? fAllBits : 0.0f, b1 ? fAllBits : 0.0f, b2 ? fAllBits : 0.0f, b3 ? fAllBits : 0.0f } };
+	}
+	inline float4v Less(const float4v& rtA, const float4v& rtB) { return MaskFromBools(rtA.v[0] < rtB.v[0], rtA.v[1] < rtB.v[1], rtA.v[2] < rtB.v[2], rtA.v[3] < rtB.v[3]); }
+	inline float4v LessEqual(const float4v& rtA, const float4v& rtB) { return MaskFromBools(rtA.v[0] <= rtB.v[0], rtA.v[1] <= rtB.v[1], rtA.v[2] <= rtB.v[2], rtA.v[3] <= rtB.v[3]); }
+	inline float4v And(const float4v& rtA, const float4v& rtB)
+	{
+		float4v rtResult;
+		for (int i = 0; i < 4; i++) { rtResult.v[i] = asfloat(asuint(rtA.v[i]) & asuint(rtB.v[i])); }
+		return rtResult;
+	}
+	inline float4v Select(const float4v& rtA, const float4v& rtB, const float4v& rtMask)
+	{
+		float4v rtResult;
+		for (int i = 0; i < 4; i++) { rtResult.v[i] = (asuint(rtMask.v[i]) & 0x80000000) ? rtB.v[i] : rtA.v[i]; }
+		return rtResult;
+	}
+	inline int MoveMask(const float4v& rtMask)
+	{
+		int iResult = 0;
+		for (int i = 0; i < 4; i++) { iResult |= (int)(asuint(rtMask.v[i]) >> 31) << i; }
+		return iResult;
+	}
+#endif
+
+	//returns a mask for all lanes within [-rtBounds, rtBounds]
+	inline float4v InBounds(const float4v& rtA, const float4v& rtBounds)
+	{
+		return And(LessEqual(rtA, rtBounds), LessEqual(Zero() - rtBounds, rtA));
+	}
+
+
+
+	//swizzles and geometric functions
+	inline float4v SplatX(const float4v& rtA) { float4 rtV = StoreFloat4(rtA); return Splat(rtV.x); }
+	inline float4v SplatY(const float4v& rtA) { float4 rtV = StoreFloat4(rtA); return Splat(rtV.y); }
+
+	inline float Dot3(const float4v& rtA, const float4v& rtB)
+	{
+		float4 rtProduct = StoreFloat4(rtA * rtB);
+		return rtProduct.x + rtProduct.y + rtProduct.z;
+	}
+
+	inline float4v Cross3(const float4v& rtA, const float4v& rtB)
+	{
+#if RT_SIMD_SSE
+		__m128 rtAYZX = _mm_shuffle_ps(rtA.v, rtA.v, _MM_SHUFFLE(3, 0, 2, 1));
+		__m128 rtBYZX = _mm_shuffle_ps(rtB.v, rtB.v, _MM_SHUFFLE(3, 0, 2, 1));
+		__m128 rtResult = _mm_sub_ps(_mm_mul_ps(rtA.v, rtBYZX), _mm_mul_ps(rtAYZX, rtB.v));
+		return { _mm_shuffle_ps(rtResult, rtResult, _MM_SHUFFLE(3, 0, 2, 1)) };
+#else
+		float3 rtVectorA = StoreFloat3(rtA);
+		float3 rtVectorB = StoreFloat3(rtB);
+		return Load(cross(rtVectorA, rtVectorB));
+#endif
+	}
+
+	//the 2d cross product (x1 * y2 - y1 * x2) in all lanes
+	inline float4v Cross2(const float4v& rtA, const float4v& rtB)
+	{
+		float4 rtVectorA = StoreFloat4(rtA);
+		float4 rtVectorB = StoreFloat4(rtB);
+		return Splat(rtVectorA.x * rtVectorB.y - rtVectorA.y * rtVectorB.x);
+	}
+
+	//a zero vector stays zero instead of turning into NaNs
+	inline float4v Normalize3(const float4v& rtA)
+	{
+		float fLength = std::sqrt(Dot3(rtA, rtA));
+		return (fLength > 0.0f) ? (rtA * Splat(1.0f / fLength)) : Zero();
+	}
+
+	//the horizontal minimum and maximum of the xyz lanes
+	inline float ReduceMin3(const float4v& rtA)
+	{
+		float4 rtV = StoreFloat4(rtA);
+		return std::min(rtV.x, std::min(rtV.y, rtV.z));
+	}
+
+	inline float ReduceMax3(const float4v& rtA)
+	{
+		float4 rtV = StoreFloat4(rtA);
+		return std::max(rtV.x, std::max(rtV.y, rtV.z));
+	}
+
+
+
+	//8 floats, which are processed at once (avx registers, or two 4 wide vectors without avx)
+	struct float8v
+	{
+#if RT_SIMD_AVX
+		__m256 v;
+#else
+		float4v Low;
+		float4v High;
+#endif
+	};
+
+#if RT_SIMD_AVX
+	inline float8v Splat8(float fValue) { return { _mm256_set1_ps(fValue) }; }
+	inline float8v Load8(const float* fValues) { return { _mm256_loadu_ps(fValues) }; }
+	inline void Store8(float* fTarget, const float8v& rtValue) { _mm256_storeu_ps(fTarget, rtValue.v); }
+	inline float8v LoadBytes8(const uint8_t* iValues)
+	{
+		int64_t iPacked;
+		std::memcpy(&iPacked, iValues, sizeof(int64_t));
+		__m128i iZero = _mm_setzero_si128();
+		__m128i iWords = _mm_unpacklo_epi8(_mm_cvtsi64_si128(iPacked), iZero);
+		__m256i iDoubleWords = _mm256_insertf128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16(iWords, iZero)), _mm_unpackhi_epi16(iWords, iZero), 1);
+		return { _mm256_cvtepi32_ps(iDoubleWords) };
+	}
+	inline float8v operator+(const float8v& rtA, const float8v& rtB) { return { _mm256_add_ps(rtA.v, rtB.v) }; }
+	inline float8v operator-(const float8v& rtA, const float8v& rtB) { return { _mm256_sub_ps(rtA.v, rtB.v) }; }
+	inline float8v operator*(const float8v& rtA, const float8v& rtB) { return { _mm256_mul_ps(rtA.v, rtB.v) }; }
+	inline float8v Min(const float8v& rtA, const float8v& rtB) { return { _mm256_min_ps(rtA.v, rtB.v) }; }
+	inline float8v Max(const float8v& rtA, const float8v& rtB) { return { _mm256_max_ps(rtA.v, rtB.v) }; }
+	inline float8v Less(const float8v& rtA, const float8v& rtB) { return { _mm256_cmp_ps(rtA.v, rtB.v, _CMP_LT_OQ) }; }
+	inline float8v LessEqual(const float8v& rtA, const float8v& rtB) { return { _mm256_cmp_ps(rtA.v, rtB.v, _CMP_LE_OQ) }; }
+	inline float8v And(const float8v& rtA, const float8v& rtB) { return { _mm256_and_ps(rtA.v, rtB.v) }; }
+	inline int MoveMask(const float8v& rtMask) { return _mm256_movemask_ps(rtMask.v); }
+#else
+	inline float8v Splat8(float fValue) { return { Splat(fValue), Splat(fValue) }; }
+	inline float8v Load8(const float* fValues)
+	{
+		return { Set(fValues[0], fValues[1], fValues[2], fValues[3]), Set(fValues[4], fValues[5], fValues[6], fValues[7]) };
+	}
+	inline void Store8(float* fTarget, const float8v& rtValue)
+	{
+		float4 rtLow = StoreFloat4(rtValue.Low);
+		float4 rtHigh = StoreFloat4(rtValue.High);
+		std::memcpy(fTarget, &rtLow, sizeof(float4));
+		std::memcpy(fTarget + 4, &rtHigh, sizeof(float4));
+	}
+	inline float8v LoadBytes8(const uint8_t* iValues) { return { LoadBytes(iValues), LoadBytes(iValues + 4) }; }
+	inline float8v operator+(const float8v& rtA, const float8v& rtB) { return { rtA.Low + rtB.Low, rtA.High + rtB.High }; }
+	inline float8v operator-(const float8v& rtA, const float8v& rtB) { return { rtA.Low - rtB.Low, rtA.High - rtB.High }; }
+	inline float8v operator*(const float8v& rtA, const float8v& rtB) { return { rtA.Low * rtB.Low, rtA.High * rtB.High }; }
+	inline float8v Min(const float8v& rtA, const float8v& rtB) { return { Min(rtA.Low, rtB.Low), Min(rtA.High, rtB.High) }; }
+	inline float8v Max(const float8v& rtA, const float8v& rtB) { return { Max(rtA.Low, rtB.Low), Max(rtA.High, rtB.High) }; }
+	inline float8v Less(const float8v& rtA, const float8v& rtB) { return { Less(rtA.Low, rtB.Low), Less(rtA.High, rtB.High) }; }
+	inline float8v LessEqual(const float8v& rtA, const float8v& rtB) { return { LessEqual(rtA.Low, rtB.Low), LessEqual(rtA.High, rtB.High) }; }
+	inline float8v And(const float8v& rtA, const float8v& rtB) { return { And(rtA.Low, rtB.Low), And(rtA.High, rtB.High) }; }
+	inline int MoveMask(const float8v& rtMask) { return MoveMask(rtMask.Low) | (MoveMask(rtMask.High) << 4); }
+#endif
+
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "Core/Math.h"
+#include "Core/Random.h"
+
+
+
+//the cpu port of Sampler.hlsli, shared by the cpu backends
+namespace RT::Core
+{
+
+	//the kinds of samplers (the values of RT_SAMPLER)
+	const uint32_t SAMPLER_XORSHIFT = 0; // white noise
+	const uint32_t SAMPLER_SOBOL = 1; // owen scrambled sobol points, scrambled with another seed for every pixel
+	const uint32_t SAMPLER_BLUE_NOISE_SOBOL = 2; // the same scrambled sobol points for all pixels, shifted by a blue noise mask
+
+	//the groups of 4 dimensions
+	const uint32_t SAMPLER_CAMERA_DIMENSIONS = 0; // anti-aliasing (xy) and depth of field (zw)
+	const uint32_t SAMPLER_BSDF_DIMENSIONS = 1; // the lobe (x) and the direction (yz) of the bounced ray of a hit and the russian roulette (w)
+	const uint32_t SAMPLER_LIGHT_DIMENSIONS = 2; // the light (xy) and the point on it (zw) of the shadow ray of a hit
+	const uint32_t SAMPLER_DIMENSIONS_PER_BOUNCE = 2; // the bsdf and light groups of bounce i are 1 + 2 * i and 2 + 2 * i
+
+
+	//the direction numbers of the first 4 dimensions of the sobol sequence (the first one is the van der Corput sequence)
+	inline constexpr uint32_t SOBOL_DIRECTIONS[4][32] =
+	{
+		{
+			0x80000000, 0x40000000, 0x20000000, 0x10000000, 0x08000000, 0x04000000, 0x02000000, 0x01000000,
+			0x00800000, 0x00400000, 0x00200000, 0x00100000, 0x00080000, 0x00040000, 0x00020000, 0x00010000,
+			0x00008000, 0x00004000, 0x00002000, 0x00001000, 0x00000800, 0x00000400, 0x00000200, 0x00000100,
+			0x00000080, 0x00000040, 0x00000020, 0x00000010, 0x00000008, 0x00000004, 0x00000002, 0x00000001
+		},
+		{
+			0x80000000, 0xc0000000, 0xa0000000, 0xf0000000, 0x88000000, 0xcc000000, 0xaa000000, 0xff000000,
+			0x80800000, 0xc0c00000, 0xa0a00000, 0xf0f00000, 0x88880000, 0xcccc0000, 0xaaaa0000, 0xffff0000,
+			0x80008000, 0xc000c000, 0xa000a000, 0xf000f000, 0x88008800, 0xcc00cc00, 0xaa00aa00, 0xff00ff00,
+			0x80808080, 0xc0c0c0c0, 0xa0a0a0a0, 0xf0f0f0f0, 0x88888888, 0xcccccccc, 0xaaaaaaaa, 0xffffffff
+		},
+		{
+			0x80000000, 0xc0000000, 0x60000000, 0x90000000, 0xe8000000, 0x5c000000, 0x8e000000, 0xc5000000,
+			0x68800000, 0x9cc00000, 0xee600000, 0x55900000, 0x80680000, 0xc09c0000, 0x60ee0000, 0x90550000,
+			0xe8808000, 0x5cc0c000, 0x8e606000, 0xc5909000, 0x6868e800, 0x9c9c5c00, 0xeeee8e00, 0x5555c500,
+			0x8000e880, 0xc0005cc0, 0x60008e60, 0x9000c590, 0xe8006868, 0x5c009c9c, 0x8e00eeee, 0xc5005555
+		},
+		{
+			0x80000000, 0xc0000000, 0x20000000, 0x50000000, 0xf8000000, 0x74000000, 0xa2000000, 0x93000000,
+			0xd8800000, 0x25400000, 0x59e00000, 0xe6d00000, 0x78080000, 0xb40c0000, 0x82020000, 0xc3050000,
+			0x208f8000, 0x51474000, 0xfbea2000, 0x75d93000, 0xa0858800, 0x914e5400, 0xdbe79e00, 0x25db6d00,
+			0x58800080, 0xe54000c0, 0x79e00020, 0xb6d00050, 0x800800f8, 0xc00c0074, 0x200200a2, 0x50050093
+		}
+	};
+
+
+	struct Sampler
+	{
+		Math::uint3 RNGSeed; // the state of the xorshift generator (SAMPLER_XORSHIFT)
+		uint32_t PixelSeed; // scrambles the sobol points of the pixel and depends on the image seed, it is the same for all pixels with the blue noise mask
+		uint32_t SampleIndex; // the index of this sample in the sequence of the pixel
+		Math::uint2 Pixel;
+	};
+
+
+
+	//a well mixing integer hash ("lowbias32" by Chris Wellons)
+	inline uint32_t Hash(uint32_t iValue)
+	{
+		iValue ^= iValue >> 16;
+		iValue *= 0x7feb352du;
+		iValue ^= iValue >> 15;
+		iValue *= 0x846ca68bu;
+		iValue ^= iValue >> 16;
+		return iValue;
+	}
+
+	inline uint32_t ReverseBits(uint32_t iValue)
+	{
+		iValue = ((iValue >> 1) & 0x55555555u) | ((iValue & 0x55555555u) << 1);
+		iValue = ((iValue >> 2) & 0x33333333u) | ((iValue & 0x33333333u) << 2);
+		iValue = ((iValue >> 4) & 0x0f0f0f0fu) | ((iValue & 0x0f0f0f0fu) << 4);
+		iValue = ((iValue >> 8) & 0x00ff00ffu) | ((iValue & 0x00ff00ffu) << 8);
+		return (iValue >> 16) | (iValue << 16);
+	}
+
+	//the sobol point with the given index in one of the first 4 dimensions, as a 32 bit fixed point number
+	inline uint32_t Sobol(uint32_t iIndex, uint32_t iDimension)
+	{
+		uint32_t iResult = 0;
+		for (uint32_t iBit = 0; iIndex != 0; iBit++, iIndex >>= 1)
+		{
+			iResult ^= (iIndex & 1) ? SOBOL_DIRECTIONS[iDimension][iBit] : 0;
+		}
+		return iResult;
+	}
+
+	//an owen scrambling of the bits of a fixed point number: every bit is flipped depending on the bits above it (the hash of Laine and Karras works on the reversed bits)
+	inline uint32_t NestedUniformScramble(uint32_t iValue, uint32_t iSeed)
+	{
+		iValue = ReverseBits(iValue);
+		iValue += iSeed;
+		iValue ^= iValue * 0x6c50b47cu;
+		iValue ^= iValue * 0xb82f1e52u;
+		iValue ^= iValue * 0xc7afe638u;
+		iValue ^= iValue * 0x8d22f6e6u;
+		return ReverseBits(iValue);
+	}
+
+	//4 dimensions of the shuffled and scrambled sobol sequence: the index is scrambled as well, so every seed visits the points in another order
+	inline Math::float4 ScrambledSobol(uint32_t iIndex, uint32_t iSeed)
+	{
+		iIndex = NestedUniformScramble(iIndex, iSeed);
+		float fPoint[4];
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			fPoint[i] = (float)(NestedUniformScramble(Sobol(iIndex, i), Hash(iSeed + i)) >> 8) * 5.9604645e-8f; // = 2^-24, the 24 upper bits fit exactly into a float below 1.0
+		}
+		return Math::float4(fPoint[0], fPoint[1], fPoint[2], fPoint[3]);
+	}
+
+	//a procedural blue noise mask (the R2 dither of Roberts), every dimension weights the pixel coordinates differently, so the shifts of the dimensions aren't correlated
+	//(the seed moves the mask, so different image seeds give different images)
+	inline Math::float4 BlueNoiseShift(Math::uint2 rtPixel, uint32_t iDimensionGroup, uint32_t iSeed)
+	{
+		uint32_t x = rtPixel.x + (Hash(iDimensionGroup ^ iSeed) & 0xffff);
+		uint32_t y = rtPixel.y + (Hash((iDimensionGroup + 0x9e3779b9u) ^ iSeed) & 0xffff);
+		const uint32_t iWeight1 = 0xc13fa9a9u; // = 2^32 / the plastic number
+		const uint32_t iWeight2 = 0x91e10da6u; // = 2^32 / the plastic number^2
+		uint32_t iShift[4] = { x * iWeight1 + y * iWeight2, x * iWeight2 + y * iWeight1, x * iWeight1 - y * iWeight2, y * iWeight1 - x * iWeight2 }; // the fractional part wraps around for free
+		return Math::float4((float)(iShift[0] >> 8), (float)(iShift[1] >> 8), (float)(iShift[2] >> 8), (float)(iShift[3] >> 8)) * 5.9604645e-8f;
+	}
+
+
+
+	//the sampler of the sample iSampleIndex of a pixel (rtRNGSeed is the seed of the xorshift generator, iImageSeed the seed of the settings)
+	inline Sampler InitializeSampler(uint32_t iSamplerType, Math::uint2 rtPixel, uint32_t iSampleIndex, const Math::uint3& rtRNGSeed, uint32_t iImageSeed)
+	{
+		Sampler rtSampler;
+		rtSampler.RNGSeed = rtRNGSeed;
+		rtSampler.PixelSeed = (iSamplerType == SAMPLER_BLUE_NOISE_SOBOL) ? Hash(iImageSeed) : Hash(rtPixel.x ^ Hash(rtPixel.y ^ Hash(iImageSeed)));
+		rtSampler.SampleIndex = iSampleIndex;
+		rtSampler.Pixel = rtPixel;
+		return rtSampler;
+	}
+
+	//4 random numbers between 0 and 1 of one group of dimensions
+	inline Math::float4 SampleDimensions(uint32_t iSamplerType, Sampler& rtSampler, uint32_t iDimensionGroup)
+	{
+		if (iSamplerType == SAMPLER_XORSHIFT)
+		{
+			Math::float3 rtRandomNumbers = Random(rtSampler.RNGSeed);
+			return Math::float4(rtRandomNumbers, Random(rtSampler.RNGSeed.x));
+		}
+
+		Math::float4 rtPoint = ScrambledSobol(rtSampler.SampleIndex, Hash(rtSampler.PixelSeed ^ Hash(iDimensionGroup)));
+		if (iSamplerType == SAMPLER_BLUE_NOISE_SOBOL)
+		{
+			Math::float4 rtShift = BlueNoiseShift(rtSampler.Pixel, iDimensionGroup, rtSampler.PixelSeed);
+			rtPoint = Math::float4(Math::frac(rtPoint.x + rtShift.x), Math::frac(rtPoint.y + rtShift.y), Math::frac(rtPoint.z + rtShift.z), Math::frac(rtPoint.w + rtShift.w));
+		}
+		return rtPoint;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,376 @@
+//include-files
+#include "SceneCache.h"
+#include "ObjParser.h"
+#include "BVH.h"
+#include "Lights.h"
+
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <memory>
+
+
+
+namespace RT::Core
+{
+
+	//the size and modification time of a file (both are 0, if the file doesn't exist)
+	static SceneCacheFileInfo GetFileInfo(const std::string& sFileName)
+	{
+		SceneCacheFileInfo rtFileInfo{};
+		std::error_code stdError;
+		uint64_t iSize = std::filesystem::file_size(sFileName, stdError);
+		if (stdError) return rtFileInfo;
+		auto stdTime = std::filesystem::last_write_time(sFileName, stdError);
+		if (stdError) return rtFileInfo;
+
+		rtFileInfo.Size = iSize;
+		rtFileInfo.ModificationTime = (int64_t)(stdTime.time_since_epoch().count());
+		return rtFileInfo;
+	}
+
+	static bool FileInfosAreEqual(const SceneCacheFileInfo& rtFileInfo1, const SceneCacheFileInfo& rtFileInfo2)
+	{
+		return (rtFileInfo1.Size == rtFileInfo2.Size) && (rtFileInfo1.ModificationTime == rtFileInfo2.ModificationTime);
+	}
+
+	//a fast 64 bit hash of the content of a file, which reads 8 bytes at once
+	static bool HashFile(const std::string& sFileName, uint64_t* iHash)
+	{
+		MappedFile rtFile;
+		if (!(rtFile.Open(sFileName))) return false;
+
+		const uint8_t* pData = rtFile.GetData();
+		const uint64_t iSize = rtFile.GetSize();
+		uint64_t iCurrentHash = 0xcbf29ce484222325ull ^ iSize;
+		for (uint64_t i = 0; i < iSize; i += 8)
+		{
+			uint64_t iWord = 0;
+			memcpy(&iWord, pData + i, std::min<uint64_t>(8, iSize - i));
+			iCurrentHash = (iCurrentHash ^ iWord) * 0x100000001b3ull;
+			iCurrentHash ^= iCurrentHash >> 29;
+		}
+
+		*iHash = iCurrentHash;
+		return true;
+	}
+
+	static uint64_t AlignSectionOffset(uint64_t iOffset)
+	{
+		return (iOffset + 63) & ~(uint64_t)63;
+	}
+
+
+
+	//constructor: initializes all the variables
+	SceneCache::SceneCache() :
+		//initialize the class variables
+		m_rtFile(),
+		m_rtHeader(nullptr)
+	{
+
+	}
+
+	//destructor: unmaps the file
+	SceneCache::~SceneCache()
+	{
+		Close();
+	}
+
+
+
+	//private class functions
+	//the null terminated strings of a section
+	std::vector<std::string> SceneCache::GetNames(SceneCacheSection eSection) const
+	{
+		std::vector<std::string> sNames;
+		const char* pNames = (const char*)(m_rtFile.GetData() + m_rtHeader->Sections[eSection].Offset);
+		const char* pNamesEnd = pNames + m_rtHeader->Sections[eSection].Size;
+		for (uint64_t i = 0; (i < m_rtHeader->Sections[eSection].Count) && (pNames < pNamesEnd); i++)
+		{
+			sNames.push_back(std::string(pNames, strnlen(pNames, pNamesEnd - pNames)));
+			pNames += sNames.back().size() + 1;
+		}
+		return sNames;
+	}
+
+
+
+	//public class functions
+	//maps the cache file and checks, that it matches the current version of the source file, its MTL files and its textures
+	bool SceneCache::Open(const std::string& sCacheFileName, const std::string& sSourceFileName, uint32_t iRequiredBVHWidth)
+	{
+		Close();
+		if (!(m_rtFile.Open(sCacheFileName))) return false;
+		if (m_rtFile.GetSize() < sizeof(SceneCacheHeader))
+		{
+			Close();
+			return false;
+		}
+		m_rtHeader = (const SceneCacheHeader*)m_rtFile.GetData();
+
+		//check the format
+		bool bValid = (memcmp(m_rtHeader->Magic, "RTSCENE", 8) == 0) && (m_rtHeader->Version == SCENE_CACHE_VERSION) &&
+			(m_rtHeader->HeaderSize == sizeof(SceneCacheHeader));
+
+		//every section has to fit into the file and its elements into the section (a name has at least its null terminator)
+		const uint64_t iElementSizes[SceneCacheSectionCount] = { sizeof(Index), sizeof(Vertex), sizeof(PBRMaterial), sizeof(char), sizeof(SceneCacheFileInfo),
+			sizeof(char), sizeof(SceneCacheHashedFileInfo), sizeof(TextureID), sizeof(uint16_t), GetBVHNodeSize(m_rtHeader->BVHWidth), sizeof(IntersectionTriangle) };
+		for (uint32_t i = 0; (i < SceneCacheSectionCount) && bValid; i++)
+		{
+			const SceneCacheSectionInfo& rtSection = m_rtHeader->Sections[i];
+			bValid = (rtSection.Offset % 64 == 0) && (rtSection.Offset <= m_rtFile.GetSize()) && (rtSection.Size <= m_rtFile.GetSize() - rtSection.Offset) &&
+				(rtSection.Count <= rtSection.Size / iElementSizes[i]);
+		}
+		if (bValid && (iRequiredBVHWidth > 0))
+		{
+			bValid = (m_rtHeader->BVHWidth == iRequiredBVHWidth) && (m_rtHeader->Sections[SceneCacheBVH].Count > 0) &&
+				(m_rtHeader->Sections[SceneCacheTriangles].Count == m_rtHeader->Sections[SceneCacheIndices].Count / 3);
+		}
+
+		//the cache is outdated, if the source file, one of the MTL files or one of the textures has changed
+		if (bValid)
+		{
+			uint64_t iSourceHash = 0;
+			bValid = FileInfosAreEqual(GetFileInfo(sSourceFileName), m_rtHeader->SourceFile) && HashFile(sSourceFileName, &iSourceHash) &&
+				(iSourceHash == m_rtHeader->SourceHash);
+		}
+		if (bValid)
+		{
+			std::vector<std::string> sLibraryNames = GetNames(SceneCacheMaterialLibraryNames);
+			std::span<const SceneCacheHashedFileInfo> rtLibraryFiles = GetSection<SceneCacheHashedFileInfo>(SceneCacheMaterialLibraryFiles);
+			bValid = (rtLibraryFiles.size() == sLibraryNames.size());
+			for (size_t i = 0; (i < sLibraryNames.size()) && bValid; i++)
+			{
+				uint64_t iLibraryHash = 0;
+				bValid = FileInfosAreEqual(GetFileInfo(sLibraryNames[i]), rtLibraryFiles[i].File) && HashFile(sLibraryNames[i], &iLibraryHash) &&
+					(iLibraryHash == rtLibraryFiles[i].Hash);
+			}
+		}
+		if (bValid)
+		{
+			MeshInfo rtMesh = GetMesh();
+			std::span<const SceneCacheFileInfo> rtTextureFiles = GetSection<SceneCacheFileInfo>(SceneCacheTextureFiles);
+			bValid = (rtTextureFiles.size() == rtMesh.TextureNameCount);
+			for (uint64_t i = 0; (i < rtMesh.TextureNameCount) && bValid; i++)
+			{
+				bValid = FileInfosAreEqual(GetFileInfo(rtMesh.TextureNames[i]), rtTextureFiles[i]);
+			}
+			delete[] rtMesh.TextureNames;
+		}
+
+		if (!bValid)
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+
+	void SceneCache::Close()
+	{
+		m_rtFile.Close();
+		m_rtHeader = nullptr;
+	}
+
+
+	//writes all sections to a temporary file, which replaces the old cache afterwards, so that an interrupted write never leaves a broken cache behind
+	bool SceneCache::Write(const std::string& sCacheFileName, const std::string& sSourceFileName, const MeshInfo& rtMesh,
+		const TextureAtlasData& rtTextures, uint32_t iBVHWidth, const void* pBVHNodes, uint64_t iNumBVHNodes, const std::vector<IntersectionTriangle>& rtTriangles)
+	{
+		SceneCacheHeader rtHeader{};
+		memcpy(rtHeader.Magic, "RTSCENE", 8);
+		rtHeader.Version = SCENE_CACHE_VERSION;
+		rtHeader.HeaderSize = sizeof(SceneCacheHeader);
+		rtHeader.SourceFile = GetFileInfo(sSourceFileName);
+		if (!(HashFile(sSourceFileName, &(rtHeader.SourceHash)))) return false;
+		rtHeader.BVHWidth = (iNumBVHNodes > 0) ? iBVHWidth : 0;
+		rtHeader.SceneAABB = rtMesh.SceneAABB;
+
+		//the texture names and the versions of the texture files
+		std::string sTextureNames;
+		std::vector<SceneCacheFileInfo> rtTextureFiles((size_t)rtMesh.TextureNameCount);
+		for (uint64_t i = 0; i < rtMesh.TextureNameCount; i++)
+		{
+			sTextureNames += rtMesh.TextureNames[i];
+			sTextureNames.push_back('\0');
+			rtTextureFiles[i] = GetFileInfo(rtMesh.TextureNames[i]);
+		}
+
+		//the MTL files of the source file, they aren't part of the source hash
+		std::string sLibraryNames;
+		std::vector<std::string> sLibraryFiles = FindMaterialLibraries(sSourceFileName);
+		std::vector<SceneCacheHashedFileInfo> rtLibraryFiles(sLibraryFiles.size());
+		for (size_t i = 0; i < sLibraryFiles.size(); i++)
+		{
+			sLibraryNames += sLibraryFiles[i];
+			sLibraryNames.push_back('\0');
+			rtLibraryFiles[i].File = GetFileInfo(sLibraryFiles[i]);
+			if (!(HashFile(sLibraryFiles[i], &(rtLibraryFiles[i].Hash)))) return false;
+		}
+
+		//the layout of the file
+		const void* pSectionData[SceneCacheSectionCount] = { rtMesh.Indices, rtMesh.Vertices, rtMesh.Materials, sTextureNames.data(),
+			rtTextureFiles.data(), sLibraryNames.data(), rtLibraryFiles.data(), rtTextures.GetTextureIDs(), rtTextures.GetTexelData(), pBVHNodes, rtTriangles.data() };
+		const uint64_t iSectionSizes[SceneCacheSectionCount] = { rtMesh.IndexCount * sizeof(Index), rtMesh.VertexCount * sizeof(Vertex),
+			rtMesh.MaterialCount * sizeof(PBRMaterial), sTextureNames.size(), rtTextureFiles.size() * sizeof(SceneCacheFileInfo), sLibraryNames.size(),
+			rtLibraryFiles.size() * sizeof(SceneCacheHashedFileInfo), rtTextures.GetTextureCount() * sizeof(TextureID), rtTextures.GetTexelDataSize(),
+			iNumBVHNodes * GetBVHNodeSize(iBVHWidth), rtTriangles.size() * sizeof(IntersectionTriangle) };
+		const uint64_t iSectionCounts[SceneCacheSectionCount] = { rtMesh.IndexCount, rtMesh.VertexCount, rtMesh.MaterialCount, rtMesh.TextureNameCount,
+			rtTextureFiles.size(), sLibraryFiles.size(), rtLibraryFiles.size(), rtTextures.GetTextureCount(), rtTextures.GetTexelDataSize() / sizeof(uint16_t),
+			iNumBVHNodes, rtTriangles.size() };
+
+		uint64_t iOffset = AlignSectionOffset(sizeof(SceneCacheHeader));
+		for (uint32_t i = 0; i < SceneCacheSectionCount; i++)
+		{
+			rtHeader.Sections[i].Offset = iOffset;
+			rtHeader.Sections[i].Size = iSectionSizes[i];
+			rtHeader.Sections[i].Count = iSectionCounts[i];
+			iOffset = AlignSectionOffset(iOffset + iSectionSizes[i]);
+		}
+
+		//write the file
+		const std::string sTempFileName = sCacheFileName + ".tmp";
+		{
+			std::ofstream stdFile(sTempFileName, std::ios::binary | std::ios::trunc);
+			if (!stdFile) return false;
+
+			const char iZeros[64] = {};
+			stdFile.write((const char*)&rtHeader, sizeof(SceneCacheHeader));
+			uint64_t iPosition = sizeof(SceneCacheHeader);
+			for (uint32_t i = 0; i < SceneCacheSectionCount; i++)
+			{
+				stdFile.write(iZeros, rtHeader.Sections[i].Offset - iPosition);
+				if (iSectionSizes[i] > 0) stdFile.write((const char*)pSectionData[i], iSectionSizes[i]);
+				iPosition = rtHeader.Sections[i].Offset + iSectionSizes[i];
+			}
+
+			if (!(stdFile.good()))
+			{
+				stdFile.close();
+				std::filesystem::remove(sTempFileName);
+				return false;
+			}
+		}
+
+		std::error_code stdError;
+		std::filesystem::rename(sTempFileName, sCacheFileName, stdError);
+		return !stdError;
+	}
+
+
+	//the mesh arrays aren't copied, they are only read by the backends
+	MeshInfo SceneCache::GetMesh() const
+	{
+		MeshInfo rtMesh{};
+		if (!m_rtHeader) return rtMesh;
+
+		rtMesh.IndexCount = m_rtHeader->Sections[SceneCacheIndices].Count;
+		rtMesh.Indices = (Index*)(GetSection<Index>(SceneCacheIndices).data());
+		rtMesh.VertexCount = m_rtHeader->Sections[SceneCacheVertices].Count;
+		rtMesh.Vertices = (Vertex*)(GetSection<Vertex>(SceneCacheVertices).data());
+		rtMesh.MaterialCount = m_rtHeader->Sections[SceneCacheMaterials].Count;
+		rtMesh.Materials = (PBRMaterial*)(GetSection<PBRMaterial>(SceneCacheMaterials).data());
+		rtMesh.SceneAABB = m_rtHeader->SceneAABB;
+
+		//the texture names are stored one after another
+		rtMesh.TextureNameCount = m_rtHeader->Sections[SceneCacheTextureNames].Count;
+		rtMesh.TextureNames = new std::string[rtMesh.TextureNameCount];
+		std::vector<std::string> sTextureNames = GetNames(SceneCacheTextureNames);
+		for (size_t i = 0; i < sTextureNames.size(); i++)
+		{
+			rtMesh.TextureNames[i] = sTextureNames[i];
+		}
+
+		//the light list isn't stored, it is collected from the mapped arrays again
+		rtMesh.Lights = BuildLightList(rtMesh);
+
+		return rtMesh;
+	}
+
+
+	//the atlas uses the packed texels of the mapped file
+	void SceneCache::GetTextureAtlas(TextureAtlasData* rtTextures) const
+	{
+		if ((!m_rtHeader) || (!rtTextures)) return;
+		rtTextures->SetMappedData(GetSection<TextureID>(SceneCacheTextureIDs), GetSection<uint16_t>(SceneCacheTexels));
+	}
+
+
+
+	//loads the scene and creates the cache, if it is necessary
+	MeshInfo LoadScene(const std::string& sFileName, uint32_t iBVHWidth)
+	{
+		const std::string sCacheFileName = sFileName + ".rtcache";
+		std::shared_ptr<SceneCache> rtCache = std::make_shared<SceneCache>();
+
+		if (!(rtCache->Open(sCacheFileName, sFileName, iBVHWidth)))
+		{
+			std::cout << "The scene cache " << sCacheFileName << " is missing or outdated, it is created from " << sFileName << "\n";
+
+			//load and prepare everything the same way as the backends do it
+			MeshInfo rtMesh = LoadMeshFromFile(sFileName);
+			if ((!(rtMesh.Indices)) || (!(rtMesh.Vertices))) return rtMesh;
+
+			TextureAtlasData rtTextures;
+			for (uint64_t i = 1; i < rtMesh.TextureNameCount; i++)
+			{
+				if (!(rtTextures.AddTexture(nullptr, LoadTextureFromFile(rtMesh.TextureNames[i])))) return rtMesh;
+			}
+
+			std::vector<AABB> rtBVH;
+			std::vector<IntersectionTriangle> rtTriangles;
+			std::vector<WideBVHNode<4>> rtWideBVH4;
+			std::vector<WideBVHNode<8>> rtWideBVH8;
+			std::vector<IntersectionTriangle> rtWideTriangles;
+			const void* pBVHNodes = rtBVH.data();
+			uint64_t iNumBVHNodes = 0;
+			if (iBVHWidth > 0)
+			{
+				if (!(BuildSAHBVH(rtMesh, rtBVH))) return rtMesh;
+				if (!(BuildTriangleStream(rtMesh, rtBVH, rtTriangles))) return rtMesh;
+				pBVHNodes = rtBVH.data();
+				iNumBVHNodes = rtBVH.size();
+
+				//the wide bvh replaces the binary one (and its triangle stream)
+				if (iBVHWidth == 4)
+				{
+					if (!(BuildWideBVH<4>(rtBVH, rtTriangles, rtWideBVH4, rtWideTriangles))) return rtMesh;
+					pBVHNodes = rtWideBVH4.data();
+					iNumBVHNodes = rtWideBVH4.size();
+					rtTriangles.swap(rtWideTriangles);
+				}
+				else if (iBVHWidth == 8)
+				{
+					if (!(BuildWideBVH<8>(rtBVH, rtTriangles, rtWideBVH8, rtWideTriangles))) return rtMesh;
+					pBVHNodes = rtWideBVH8.data();
+					iNumBVHNodes = rtWideBVH8.size();
+					rtTriangles.swap(rtWideTriangles);
+				}
+			}
+
+			//without a cache (e.g. in a read only directory), the backends use the loaded mesh
+			if (!(SceneCache::Write(sCacheFileName, sFileName, rtMesh, rtTextures, iBVHWidth, pBVHNodes, iNumBVHNodes, rtTriangles)))
+			{
+				std::cout << "Error writing the scene cache " << sCacheFileName << "\n";
+				return rtMesh;
+			}
+
+			delete[] rtMesh.Indices;
+			delete[] rtMesh.Vertices;
+			delete[] rtMesh.Materials;
+			delete[] rtMesh.TextureNames;
+			if (!(rtCache->Open(sCacheFileName, sFileName, iBVHWidth))) return MeshInfo{};
+		}
+
+		MeshInfo rtMesh = rtCache->GetMesh();
+		rtMesh.Cache = rtCache;
+
+		std::cout << "Successfully loaded the scene from " << sCacheFileName << " with:\n " << rtMesh.VertexCount << " vertices\n " << rtMesh.IndexCount
+			<< " indices\n " << rtMesh.MaterialCount << " materials\n " << (rtMesh.TextureNameCount - 1) << " textures\n";
+
+		return rtMesh;
+	}
+
+}
\ No newline at end of file
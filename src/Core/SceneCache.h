@@ -0,0 +1,129 @@
+#pragma once
+
+#include <string>
+#include <span>
+#include <vector>
+
+#include "Core/MeshLoader.h"
+#include "Core/WideBVH.h"
+#include "Core/Textures.h"
+#include "Core/MappedFile.h"
+
+
+
+namespace RT::Core
+{
+
+	//the version of the file format, it has to be increased whenever the layout of the file or of one of the stored structs changes
+	const uint32_t SCENE_CACHE_VERSION = 4;
+
+	//the sections of a cache file, every section starts at a multiple of 64 bytes
+	enum SceneCacheSection : uint32_t
+	{
+		SceneCacheIndices = 0,
+		SceneCacheVertices,
+		SceneCacheMaterials,
+		SceneCacheTextureNames, // null terminated strings
+		SceneCacheTextureFiles, // the size and modification time of every texture file
+		SceneCacheMaterialLibraryNames, // the paths of the MTL files as null terminated strings
+		SceneCacheMaterialLibraryFiles, // the size, modification time and hash of every MTL file
+		SceneCacheTextureIDs,
+		SceneCacheTexels,
+		SceneCacheBVH, // empty, if the bvh isn't stored, the nodes have the layout of SceneCacheHeader::BVHWidth and the leaves point into the triangle stream
+		SceneCacheTriangles, // the intersection-only triangle stream in the order of the bvh leaves (empty without a bvh)
+		SceneCacheSectionCount
+	};
+
+	struct SceneCacheSectionInfo
+	{
+		uint64_t Offset; // in bytes from the start of the file
+		uint64_t Size; // in bytes
+		uint64_t Count; // the number of elements
+		uint64_t Padding;
+	};
+
+	//identifies the version of a file, which the cache was made from
+	struct SceneCacheFileInfo
+	{
+		uint64_t Size;
+		int64_t ModificationTime;
+	};
+
+	//the MTL files are small, so their content is compared as well
+	struct SceneCacheHashedFileInfo
+	{
+		SceneCacheFileInfo File;
+		uint64_t Hash;
+	};
+
+	struct SceneCacheHeader
+	{
+		char Magic[8]; // "RTSCENE"
+		uint32_t Version;
+		uint32_t HeaderSize;
+		SceneCacheFileInfo SourceFile;
+		uint64_t SourceHash;
+		uint32_t BVHWidth; // 2: AABB nodes, 4 or 8: WideBVHNode<BVHWidth>, 0: no bvh
+		uint32_t Padding;
+		AABB SceneAABB;
+		SceneCacheSectionInfo Sections[SceneCacheSectionCount];
+	};
+
+
+	//a versioned binary file with the final data of a scene (the mesh, the materials, the packed texture atlas and optionally the bvh with its triangle stream)
+	//the file is memory mapped, so the arrays can be used (and uploaded to the gpu) without any conversion
+	class SceneCache
+	{
+	private:
+
+		//the mapped file
+		MappedFile m_rtFile;
+		const SceneCacheHeader* m_rtHeader;
+
+
+		//private functions
+		std::vector<std::string> GetNames(SceneCacheSection eSection) const;
+		//the elements of a section, Open checks, that Count elements of its type fit into the section
+		template<typename T>
+		std::span<const T> GetSection(SceneCacheSection eSection) const
+		{
+			const SceneCacheSectionInfo& rtSection = m_rtHeader->Sections[eSection];
+			return std::span<const T>((const T*)(m_rtFile.GetData() + rtSection.Offset), (size_t)rtSection.Count);
+		};
+
+	public: // = usable outside of the class
+
+		//constructor and destructor
+		SceneCache();
+		~SceneCache();
+
+
+		//class functions
+		bool Open(const std::string& sCacheFileName, const std::string& sSourceFileName, uint32_t iRequiredBVHWidth); // fails, if the OBJ, MTL or texture files have changed
+		void Close();
+		static bool Write(const std::string& sCacheFileName, const std::string& sSourceFileName, const MeshInfo& rtMesh,
+			const TextureAtlasData& rtTextures, uint32_t iBVHWidth, const void* pBVHNodes, uint64_t iNumBVHNodes, const std::vector<IntersectionTriangle>& rtTriangles);
+
+		MeshInfo GetMesh() const; // the arrays point into the mapped file, only the texture names are copied
+		void GetTextureAtlas(TextureAtlasData* rtTextures) const;
+
+
+		//helper functions
+		uint32_t GetBVHWidth() const { return m_rtHeader ? m_rtHeader->BVHWidth : 0; };
+		std::span<const AABB> GetBVH() const { return (GetBVHWidth() == 2) ? GetSection<AABB>(SceneCacheBVH) : std::span<const AABB>(); };
+		template<uint32_t Width>
+		std::span<const WideBVHNode<Width>> GetWideBVH() const
+		{
+			return (GetBVHWidth() == Width) ? GetSection<WideBVHNode<Width>>(SceneCacheBVH) : std::span<const WideBVHNode<Width>>();
+		};
+		std::span<const IntersectionTriangle> GetTriangles() const { return GetSection<IntersectionTriangle>(SceneCacheTriangles); };
+
+	};
+
+
+	//loads a scene from its cache file (sFileName + ".rtcache"), the cache is created first, if it is missing or outdated
+	//iBVHWidth selects the stored SAH bvh (0: none, 2: binary, 4 or 8: collapsed into a wide bvh)
+	//the returned mesh keeps the cache alive through MeshInfo::Cache
+	MeshInfo LoadScene(const std::string& sFileName, uint32_t iBVHWidth);
+
+}
\ No newline at end of file
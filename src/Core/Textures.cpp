@@ -0,0 +1,112 @@
+//include-files
+#include "Textures.h"
+
+
+
+namespace RT::Core
+{
+
+	//constructor: initializes all the variables
+	TextureAtlasData::TextureAtlasData() :
+		//initialize the class variables
+		m_stdTextureIDs(),
+		m_stdTexels(),
+		m_stdMappedTextureIDs(),
+		m_stdMappedTexels()
+	{
+		//make a default (white) texture for meshes that don't use any textures
+		TextureID rtTextureID{};
+		rtTextureID.Offset = 0;
+		rtTextureID.Width = 1;
+		rtTextureID.Height = 1;
+		rtTextureID.RowPitch = 1;
+
+		m_stdTextureIDs.push_back(rtTextureID);
+		m_stdTexels.assign(8, 0xffff); //the texels are padded to multiples of 2 pixels (= 16 bytes)
+	}
+
+	//destructor: uninitializes all our pointers
+	TextureAtlasData::~TextureAtlasData()
+	{
+
+	}
+
+
+
+	//public class functions
+	//add a texture to the atlas, the data of the texture is freed afterwards
+	bool TextureAtlasData::AddTexture(uint32_t* iTextureID, TextureInfo rtProperties)
+	{
+		if (iTextureID)
+		{
+			*iTextureID = 0;
+		}
+
+		//some safety checks
+		if (!(rtProperties.Data)) return false;
+		if (!(m_stdMappedTextureIDs.empty()))
+		{
+			delete[] (uint8_t*)rtProperties.Data;
+			return false;
+		}
+		if ((rtProperties.ChannelCount != 4) || (rtProperties.BytesPerChannel != 2))
+		{
+			delete[] (uint8_t*)rtProperties.Data;
+			return false;
+		}
+
+		//generate the texture ID, the offset is counted in pixels, since this is how the shaders address the atlas
+		TextureID rtTextureID{};
+		rtTextureID.Offset = (uint32_t)(m_stdTexels.size() / 4);
+		rtTextureID.Width = rtProperties.Width;
+		rtTextureID.Height = rtProperties.Height;
+		rtTextureID.RowPitch = rtProperties.Width;
+
+		//store the texture data and align the end to a multiple of 16 bytes
+		const uint16_t* iTexels = (const uint16_t*)rtProperties.Data;
+		m_stdTexels.insert(m_stdTexels.end(), iTexels, iTexels + (size_t)rtProperties.Width * rtProperties.Height * 4);
+		m_stdTexels.resize((m_stdTexels.size() + 7) & ~(size_t)7, 0);
+		delete[] (uint8_t*)rtProperties.Data;
+
+		if (iTextureID)
+		{
+			*iTextureID = (uint32_t)m_stdTextureIDs.size();
+		}
+		m_stdTextureIDs.push_back(rtTextureID);
+
+		return true;
+	}
+
+
+	//use the packed textures of a scene cache, the memory has to stay valid as long as the atlas is used
+	void TextureAtlasData::SetMappedData(std::span<const TextureID> stdTextureIDs, std::span<const uint16_t> stdTexels)
+	{
+		m_stdMappedTextureIDs = stdTextureIDs;
+		m_stdMappedTexels = stdTexels;
+	}
+
+
+	//nearest point sampling, like SampleTexture() in PerRayShading.hlsli
+	Math::float3 TextureAtlasData::SampleTexture(uint32_t iTextureID, Math::float2 rtUV) const
+	{
+		std::span<const TextureID> stdTextureIDs = GetTextureIDSpan();
+		std::span<const uint16_t> stdTexels = GetTexelSpan();
+		if (iTextureID >= stdTextureIDs.size()) return Math::float3(0.0f);
+		const TextureID& rtTextureSampleInfo = stdTextureIDs[iTextureID];
+
+		//a negative coordinate becomes 0 when converted to an unsigned integer on the gpu
+		float fX = std::nearbyint(rtUV.x * (float)(rtTextureSampleInfo.Width - 1));
+		float fY = std::nearbyint(rtUV.y * (float)(rtTextureSampleInfo.Height - 1));
+		uint64_t iSampleX = (fX > 0.0f) ? (uint64_t)fX : 0;
+		uint64_t iSampleY = (fY > 0.0f) ? (uint64_t)fY : 0;
+		uint64_t iLocation = iSampleX + (uint64_t)rtTextureSampleInfo.RowPitch * iSampleY + rtTextureSampleInfo.Offset;
+
+		//out of bounds reads return zero, like they do on the gpu
+		if ((iLocation * 4 + 3) >= stdTexels.size()) return Math::float3(0.0f);
+
+		const uint16_t* iPixel = &(stdTexels[iLocation * 4]);
+		Math::float3 rtColor = Math::float3((float)iPixel[0], (float)iPixel[1], (float)iPixel[2]) * 1.5259022e-5f;
+		return rtColor * rtColor; //approximate gamma correction
+	}
+
+}
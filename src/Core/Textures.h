@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <span>
+
+#include "Core/Math.h"
+#include "Core/MeshLoader.h"
+
+
+
+namespace RT::Core
+{
+
+	//the same layout as the "TextureID" struct in PerRayShading.hlsli
+	struct TextureID
+	{
+		uint32_t Offset; // in pixels
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t RowPitch;
+	};
+
+
+	//packs all textures of a scene into one array with 4 channels and 16 bits per channel, which is used by every backend
+	class TextureAtlasData
+	{
+	private:
+
+		//the texture data
+		std::vector<TextureID> m_stdTextureIDs;
+		std::vector<uint16_t> m_stdTexels;
+
+		//the texture data of a scene cache, which is used instead of the vectors, if it is set
+		std::span<const TextureID> m_stdMappedTextureIDs;
+		std::span<const uint16_t> m_stdMappedTexels;
+
+
+		//private functions
+		std::span<const TextureID> GetTextureIDSpan() const { return m_stdMappedTextureIDs.empty() ? std::span<const TextureID>(m_stdTextureIDs) : m_stdMappedTextureIDs; };
+		std::span<const uint16_t> GetTexelSpan() const { return m_stdMappedTextureIDs.empty() ? std::span<const uint16_t>(m_stdTexels) : m_stdMappedTexels; };
+
+
+	public: // = usable outside of the class
+
+		//constructor and destructor
+		TextureAtlasData();
+		~TextureAtlasData();
+
+
+		//class functions
+		bool AddTexture(uint32_t* iTextureID, TextureInfo rtProperties);
+		void SetMappedData(std::span<const TextureID> stdTextureIDs, std::span<const uint16_t> stdTexels);
+		Math::float3 SampleTexture(uint32_t iTextureID, Math::float2 rtUV) const;
+
+
+		//helper functions
+		unsigned int GetTextureCount() const { return (unsigned int)GetTextureIDSpan().size(); };
+		const TextureID* GetTextureIDs() const { return GetTextureIDSpan().data(); };
+		const void* GetTexelData() const { return GetTexelSpan().data(); };
+		uint64_t GetTexelDataSize() const { return GetTexelSpan().size_bytes(); }; // always a multiple of 16 bytes
+
+	};
+
+}
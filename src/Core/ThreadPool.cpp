@@ -0,0 +1,207 @@
+//include-files
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+
+
+namespace RT::Core
+{
+
+	//constructor: starts the worker threads, the calling thread of ParallelFor is the thread 0
+	ThreadPool::ThreadPool(unsigned int iNumThreads) :
+		//initialize the class variables
+		m_stdWorkers(),
+		m_rtWorkRanges(new WorkRange[std::max(iNumThreads, 1u)]),
+		m_dFinishTimes(new double[std::max(iNumThreads, 1u)]),
+		m_dBusyTimes(new double[std::max(iNumThreads, 1u)]),
+		m_stdStartTime(),
+		m_fnJob(),
+		m_iCount(0),
+		m_iBatchSize(1),
+		m_iNumSteals(0),
+		m_iNumRunning(0),
+		m_stdMutex(),
+		m_stdStartCondition(),
+		m_stdDoneCondition(),
+		m_iGeneration(0),
+		m_iNumThreads(std::max(iNumThreads, 1u)),
+		m_bShutdown(false)
+	{
+		for (unsigned int i = 0; i < m_iNumThreads; i++)
+		{
+			m_rtWorkRanges[i].Range.store(0, std::memory_order_relaxed);
+		}
+
+		m_stdWorkers.reserve(m_iNumThreads - 1);
+		for (unsigned int i = 1; i < m_iNumThreads; i++)
+		{
+			m_stdWorkers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+		}
+	}
+
+	//destructor: stops the worker threads
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> stdLock(m_stdMutex);
+			m_bShutdown = true;
+		}
+		m_stdStartCondition.notify_all();
+		for (auto& stdWorker : m_stdWorkers)
+		{
+			stdWorker.join();
+		}
+	}
+
+
+
+	//private class functions
+	void ThreadPool::WorkerLoop(unsigned int iThreadIndex)
+	{
+		uint64_t iSeenGeneration = 0;
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> stdLock(m_stdMutex);
+				m_stdStartCondition.wait(stdLock, [&]() { return m_bShutdown || (m_iGeneration != iSeenGeneration); });
+				if (m_bShutdown) return;
+				iSeenGeneration = m_iGeneration;
+			}
+
+			RunBatches(iThreadIndex);
+
+			//the last worker wakes up the calling thread
+			if (m_iNumRunning.fetch_sub(1) == 1)
+			{
+				std::lock_guard<std::mutex> stdLock(m_stdMutex);
+				m_stdDoneCondition.notify_one();
+			}
+		}
+	}
+
+	void ThreadPool::RunBatches(unsigned int iThreadIndex)
+	{
+		double dBusyTime = 0.0;
+		uint64_t iBatch = 0;
+		while (true)
+		{
+			if (!(PopBatch(iThreadIndex, iBatch)))
+			{
+				if (StealBatches(iThreadIndex)) continue;
+				break;
+			}
+
+			auto stdBatchStartTime = std::chrono::steady_clock::now();
+			uint64_t iBegin = iBatch * m_iBatchSize;
+			m_fnJob(iBegin, std::min(iBegin + m_iBatchSize, m_iCount), iThreadIndex);
+			dBusyTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - stdBatchStartTime).count();
+		}
+
+		m_dFinishTimes[iThreadIndex] = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_stdStartTime).count();
+		m_dBusyTimes[iThreadIndex] = dBusyTime;
+	}
+
+	//the owner takes the batches from the front of its range
+	bool ThreadPool::PopBatch(unsigned int iThreadIndex, uint64_t& iBatch)
+	{
+		std::atomic<uint64_t>& iRange = m_rtWorkRanges[iThreadIndex].Range;
+		uint64_t iCurrentRange = iRange.load(std::memory_order_acquire);
+		while (true)
+		{
+			uint64_t iBegin = iCurrentRange & 0xffffffff;
+			uint64_t iEnd = iCurrentRange >> 32;
+			if (iBegin >= iEnd) return false;
+			if (iRange.compare_exchange_weak(iCurrentRange, (iEnd << 32) | (iBegin + 1), std::memory_order_acq_rel))
+			{
+				iBatch = iBegin;
+				return true;
+			}
+		}
+	}
+
+	//a thief takes the back half of the range of the next thread, which still has batches
+	bool ThreadPool::StealBatches(unsigned int iThreadIndex)
+	{
+		for (unsigned int i = 1; i < m_iNumThreads; i++)
+		{
+			std::atomic<uint64_t>& iVictimRange = m_rtWorkRanges[(iThreadIndex + i) % m_iNumThreads].Range;
+			uint64_t iCurrentRange = iVictimRange.load(std::memory_order_acquire);
+			while (true)
+			{
+				uint64_t iBegin = iCurrentRange & 0xffffffff;
+				uint64_t iEnd = iCurrentRange >> 32;
+				if (iBegin >= iEnd) break;
+
+				uint64_t iNewEnd = iEnd - (iEnd - iBegin + 1) / 2;
+				if (iVictimRange.compare_exchange_weak(iCurrentRange, (iNewEnd << 32) | iBegin, std::memory_order_acq_rel))
+				{
+					//nobody steals from an empty range, so the own range can be replaced
+					m_rtWorkRanges[iThreadIndex].Range.store((iEnd << 32) | iNewEnd, std::memory_order_release);
+					m_iNumSteals.fetch_add(1, std::memory_order_relaxed);
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+
+
+	//public class functions
+	void ThreadPool::ParallelFor(uint64_t iCount, uint64_t iBatchSize, const std::function<void(uint64_t, uint64_t, unsigned int)>& fnFunction,
+		ThreadPoolStats* rtStats)
+	{
+		if (rtStats) *rtStats = ThreadPoolStats{};
+		if (iCount == 0) return;
+
+		//every thread starts with a contiguous part of the batches
+		m_iBatchSize = std::max<uint64_t>(iBatchSize, 1);
+		m_iCount = iCount;
+		const uint64_t iNumBatches = (iCount + m_iBatchSize - 1) / m_iBatchSize;
+		for (unsigned int i = 0; i < m_iNumThreads; i++)
+		{
+			uint64_t iBegin = iNumBatches * i / m_iNumThreads;
+			uint64_t iEnd = iNumBatches * (i + 1) / m_iNumThreads;
+			m_rtWorkRanges[i].Range.store((iEnd << 32) | iBegin, std::memory_order_relaxed);
+		}
+		m_fnJob = fnFunction;
+		m_iNumSteals.store(0, std::memory_order_relaxed);
+		m_iNumRunning.store(m_iNumThreads - 1);
+		m_stdStartTime = std::chrono::steady_clock::now();
+
+		//start the workers and work on the own batches
+		{
+			std::lock_guard<std::mutex> stdLock(m_stdMutex);
+			m_iGeneration++;
+		}
+		m_stdStartCondition.notify_all();
+		RunBatches(0);
+
+		{
+			std::unique_lock<std::mutex> stdLock(m_stdMutex);
+			m_stdDoneCondition.wait(stdLock, [&]() { return m_iNumRunning.load() == 0; });
+		}
+		double dWallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_stdStartTime).count();
+		m_fnJob = nullptr;
+
+		if (rtStats)
+		{
+			double dFirstFinishTime = m_dFinishTimes[0];
+			double dLastFinishTime = m_dFinishTimes[0];
+			double dBusyTime = 0.0;
+			for (unsigned int i = 0; i < m_iNumThreads; i++)
+			{
+				dFirstFinishTime = std::min(dFirstFinishTime, m_dFinishTimes[i]);
+				dLastFinishTime = std::max(dLastFinishTime, m_dFinishTimes[i]);
+				dBusyTime += m_dBusyTimes[i];
+			}
+			rtStats->WallSeconds = dWallTime;
+			rtStats->TailSeconds = dLastFinishTime - dFirstFinishTime;
+			rtStats->IdleSeconds = std::max(dWallTime * (double)m_iNumThreads - dBusyTime, 0.0);
+			rtStats->NumBatches = iNumBatches;
+			rtStats->NumSteals = m_iNumSteals.load(std::memory_order_relaxed);
+		}
+	}
+
+}
\ No newline at end of file
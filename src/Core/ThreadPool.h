@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <memory>
+
+#include "Core/Parallel.h"
+
+
+
+//the cpu version of the persistent threads in CS_TraceRays.hlsl: the workers are started once and fetch batches until the work is done
+namespace RT::Core
+{
+
+	//the timings of the last ThreadPool::ParallelFor
+	struct ThreadPoolStats
+	{
+		double WallSeconds; // from the start until the last thread finished
+		double TailSeconds; // from the first thread running out of work until the last thread finished
+		double IdleSeconds; // the time, the threads didn't work on batches (waking up, stealing and waiting for the last thread), summed over all threads
+		uint64_t NumBatches;
+		uint64_t NumSteals;
+	};
+
+	class ThreadPool
+	{
+	private:
+
+		//the batches [begin, end) of a thread, packed as (end << 32) | begin, so the owner and the thieves can change them with one compare exchange
+		struct alignas(64) WorkRange
+		{
+			std::atomic<uint64_t> Range;
+		};
+
+		//private member variables
+		std::vector<std::thread> m_stdWorkers;
+		std::unique_ptr<WorkRange[]> m_rtWorkRanges;
+		std::unique_ptr<double[]> m_dFinishTimes; // in seconds after the start of the job
+		std::unique_ptr<double[]> m_dBusyTimes; // the time, a thread worked on batches
+		std::chrono::steady_clock::time_point m_stdStartTime;
+		std::function<void(uint64_t, uint64_t, unsigned int)> m_fnJob;
+		uint64_t m_iCount;
+		uint64_t m_iBatchSize;
+		std::atomic<uint64_t> m_iNumSteals;
+		std::atomic<unsigned int> m_iNumRunning;
+		std::mutex m_stdMutex;
+		std::condition_variable m_stdStartCondition;
+		std::condition_variable m_stdDoneCondition;
+		uint64_t m_iGeneration;
+		unsigned int m_iNumThreads;
+		bool m_bShutdown;
+
+
+		//private functions
+		void WorkerLoop(unsigned int iThreadIndex);
+		void RunBatches(unsigned int iThreadIndex);
+		bool PopBatch(unsigned int iThreadIndex, uint64_t& iBatch);
+		bool StealBatches(unsigned int iThreadIndex);
+
+
+	public: // = usable outside of the class
+
+		//constructor and destructor
+		ThreadPool(unsigned int iNumThreads = GetThreadCount());
+		~ThreadPool();
+
+
+		//public class functions
+		//calls fnFunction(iBegin, iEnd, iThreadIndex) for batches of iBatchSize elements of [0, iCount), every thread starts with its own part of the batches
+		//and steals half of the remaining batches of another thread, when it runs out of work
+		void ParallelFor(uint64_t iCount, uint64_t iBatchSize, const std::function<void(uint64_t, uint64_t, unsigned int)>& fnFunction,
+			ThreadPoolStats* rtStats = nullptr);
+
+
+		//helper functions
+		unsigned int GetNumThreads() { return m_iNumThreads; };
+
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,175 @@
+//include-files
+#include "WideBVH.h"
+#include "BVH.h"
+
+#include <cmath>
+#include <algorithm>
+
+
+
+namespace RT::Core
+{
+
+	static inline float SurfaceArea(const AABB& rtBounds)
+	{
+		Math::float3 rtExtent = Math::max(rtBounds.Max - rtBounds.Min, Math::float3(0.0f));
+		return rtExtent.x * rtExtent.y + rtExtent.y * rtExtent.z + rtExtent.z * rtExtent.x;
+	}
+
+	//the biased exponent of the smallest power of two scale, for which 255 steps cover the extent of the node on one axis
+	static uint32_t GetQuantizationExponent(float fOrigin, float fMax)
+	{
+		float fStep = (fMax - fOrigin) / 255.0f;
+		uint32_t iExponent = (Math::asuint(fStep) >> 23) & 0xff;
+		if ((Math::asuint(fStep) & 0x007fffff) != 0) iExponent++; // round up to the next power of two
+		iExponent = std::min(std::max(iExponent, 1u), 254u);
+
+		//the rounding of the dequantization must not shrink the node
+		while ((iExponent < 254) && (fOrigin + 255.0f * Math::asfloat(iExponent << 23) < fMax))
+		{
+			iExponent++;
+		}
+
+		return iExponent;
+	}
+
+	//quantize the child bounds conservatively: the dequantized box (Origin + Quantized * Scale) always contains the child
+	static uint8_t QuantizeMin(float fValue, float fOrigin, float fScale)
+	{
+		int32_t iQuantized = std::min(std::max((int32_t)std::floor((fValue - fOrigin) / fScale), 0), 255);
+		while ((iQuantized > 0) && (fOrigin + (float)iQuantized * fScale > fValue))
+		{
+			iQuantized--;
+		}
+		return (uint8_t)iQuantized;
+	}
+
+	static uint8_t QuantizeMax(float fValue, float fOrigin, float fScale)
+	{
+		int32_t iQuantized = std::min(std::max((int32_t)std::ceil((fValue - fOrigin) / fScale), 0), 255);
+		while ((iQuantized < 255) && (fOrigin + (float)iQuantized * fScale < fValue))
+		{
+			iQuantized++;
+		}
+		return (uint8_t)iQuantized;
+	}
+
+
+	template<uint32_t Width>
+	bool BuildWideBVH(const std::vector<AABB>& rtBVH, const std::vector<IntersectionTriangle>& rtTriangles,
+		std::vector<WideBVHNode<Width>>& rtWideBVH, std::vector<IntersectionTriangle>& rtWideTriangles)
+	{
+		rtWideBVH.clear();
+		rtWideTriangles.clear();
+		if (rtBVH.empty()) return false;
+		rtWideBVH.reserve(rtBVH.size() / 2 + 1);
+		rtWideTriangles.reserve(rtTriangles.size());
+
+		//x: the binary node, y: the wide node, which replaces it
+		std::vector<Math::uint2> rtNodeStack = { Math::uint2(0, 0) };
+		rtWideBVH.push_back(WideBVHNode<Width>{});
+
+		while (!rtNodeStack.empty())
+		{
+			Math::uint2 rtCurrent = rtNodeStack.back();
+			rtNodeStack.pop_back();
+			const AABB& rtBinaryNode = rtBVH[rtCurrent.x];
+
+			//the children of the binary node (the trunk can be a leaf itself)
+			uint32_t iChildren[Width];
+			uint32_t iNumChildren = 0;
+			if (rtBinaryNode.Padding.x & BVH_LEAF_FLAG)
+			{
+				iChildren[iNumChildren++] = rtCurrent.x;
+			}
+			else
+			{
+				iChildren[iNumChildren++] = rtBinaryNode.Padding.x;
+				if (rtBinaryNode.Padding.y != BVH_INVALID_INDEX) iChildren[iNumChildren++] = rtBinaryNode.Padding.y;
+			}
+
+			//open the inner child with the biggest surface area, until the node is full
+			while (iNumChildren < Width)
+			{
+				uint32_t iBestChild = Width;
+				float fBestArea = -1.0f;
+				for (uint32_t i = 0; i < iNumChildren; i++)
+				{
+					const AABB& rtChild = rtBVH[iChildren[i]];
+					if ((!(rtChild.Padding.x & BVH_LEAF_FLAG)) && (SurfaceArea(rtChild) > fBestArea))
+					{
+						iBestChild = i;
+						fBestArea = SurfaceArea(rtChild);
+					}
+				}
+				if (iBestChild == Width) break;
+
+				const AABB& rtOpenedChild = rtBVH[iChildren[iBestChild]];
+				iChildren[iBestChild] = rtOpenedChild.Padding.x;
+				if (rtOpenedChild.Padding.y != BVH_INVALID_INDEX) iChildren[iNumChildren++] = rtOpenedChild.Padding.y;
+			}
+
+			//the bounds of the node and the quantization grid
+			AABB rtBounds = rtBVH[iChildren[0]];
+			for (uint32_t i = 1; i < iNumChildren; i++)
+			{
+				rtBounds.Min = Math::min(rtBounds.Min, rtBVH[iChildren[i]].Min);
+				rtBounds.Max = Math::max(rtBounds.Max, rtBVH[iChildren[i]].Max);
+			}
+
+			WideBVHNode<Width> rtNode{};
+			rtNode.Origin = rtBounds.Min;
+			rtNode.Exponents = GetQuantizationExponent(rtBounds.Min.x, rtBounds.Max.x) |
+				(GetQuantizationExponent(rtBounds.Min.y, rtBounds.Max.y) << 8) |
+				(GetQuantizationExponent(rtBounds.Min.z, rtBounds.Max.z) << 16);
+			rtNode.ChildBaseIndex = (uint32_t)rtWideBVH.size();
+			rtNode.TriangleBaseIndex = (uint32_t)rtWideTriangles.size();
+
+			const float* fOrigin = &rtNode.Origin.x;
+			uint32_t iNumInnerChildren = 0;
+			uint32_t iNumLeafTriangles = 0;
+			for (uint32_t i = 0; i < iNumChildren; i++)
+			{
+				const AABB& rtChild = rtBVH[iChildren[i]];
+				const float* fChildMin = &rtChild.Min.x;
+				const float* fChildMax = &rtChild.Max.x;
+				for (uint32_t iAxis = 0; iAxis < 3; iAxis++)
+				{
+					float fScale = GetWideBVHScale(rtNode.Exponents, iAxis);
+					rtNode.QuantizedMin[iAxis][i] = QuantizeMin(fChildMin[iAxis], fOrigin[iAxis], fScale);
+					rtNode.QuantizedMax[iAxis][i] = QuantizeMax(fChildMax[iAxis], fOrigin[iAxis], fScale);
+				}
+
+				if (rtChild.Padding.x & BVH_LEAF_FLAG)
+				{
+					//copy the triangles of the leaf behind the ones of the previous leaf children
+					uint32_t iNumTriangles = (rtChild.Padding.y != BVH_INVALID_INDEX) ? 2 : 1;
+					for (uint32_t j = 0; j < iNumTriangles; j++)
+					{
+						uint32_t iTriangle = ((j == 0) ? rtChild.Padding.x : rtChild.Padding.y) & ~BVH_LEAF_FLAG;
+						if (iTriangle >= rtTriangles.size()) return false;
+						rtWideTriangles.push_back(rtTriangles[iTriangle]);
+					}
+					rtNode.Meta[i] = (uint8_t)((iNumTriangles << WIDE_BVH_TRIANGLE_COUNT_SHIFT) | iNumLeafTriangles);
+					iNumLeafTriangles += iNumTriangles;
+				}
+				else
+				{
+					//the inner children get consecutive nodes, which are filled when they are popped from the stack
+					rtNode.Meta[i] = (uint8_t)(WIDE_BVH_INNER_CHILD | iNumInnerChildren);
+					rtNodeStack.push_back(Math::uint2(iChildren[i], rtNode.ChildBaseIndex + iNumInnerChildren));
+					iNumInnerChildren++;
+				}
+			}
+
+			rtWideBVH.resize(rtWideBVH.size() + iNumInnerChildren);
+			rtWideBVH[rtCurrent.y] = rtNode;
+		}
+
+		return rtWideTriangles.size() == rtTriangles.size();
+	}
+
+	template bool BuildWideBVH<4>(const std::vector<AABB>&, const std::vector<IntersectionTriangle>&, std::vector<WideBVHNode<4>>&, std::vector<IntersectionTriangle>&);
+	template bool BuildWideBVH<8>(const std::vector<AABB>&, const std::vector<IntersectionTriangle>&, std::vector<WideBVHNode<8>>&, std::vector<IntersectionTriangle>&);
+
+}
\ No newline at end of file
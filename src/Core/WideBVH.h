@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+
+#include "Core/Math.h"
+#include "Core/MeshLoader.h"
+#include "Core/BVH.h"
+
+
+
+//the binary bvh collapsed into a bvh with 4 or 8 children per node, the bounds of the children are quantized to 8 bits per axis relative to their parent
+//based on: https://research.nvidia.com/publication/2017-07_efficient-incoherent-ray-traversal-gpus-through-compressed-wide-bvhs
+namespace RT::Core
+{
+
+	//the meta byte of a child: 0 for an empty slot, WIDE_BVH_INNER_CHILD | the rank of the child among the inner children,
+	//or (triangle count << WIDE_BVH_TRIANGLE_COUNT_SHIFT) | the offset of its first triangle from TriangleBaseIndex for a leaf
+	const uint8_t WIDE_BVH_INNER_CHILD = 0x80;
+	const uint8_t WIDE_BVH_RANK_MASK = 0x1f;
+	const uint32_t WIDE_BVH_TRIANGLE_COUNT_SHIFT = 5;
+	const uint32_t WIDE_BVH_STACK_SIZE = 32; // one entry per level, the collapsed tree has at most as many levels as the binary one
+	static_assert((WIDE_BVH_STACK_SIZE >= BVH_MAX_DEPTH) && (WIDE_BVH_STACK_SIZE >= LBVH_MAX_DEPTH), "the wide traversal needs one stack entry per level");
+
+
+	//the layout matches the "WideBVHNode" struct in BVHTraversal.hlsli (Width = RT_BVH_WIDTH)
+	template<uint32_t Width>
+	struct WideBVHNode
+	{
+		Math::float3 Origin; // the minimum of the node bounds
+		uint32_t Exponents; // the biased exponents (like the exponent bits of a float) of the quantization scale of x, y and z in the lowest 3 bytes
+		uint32_t ChildBaseIndex; // the inner children are stored next to each other, sorted by rank
+		uint32_t TriangleBaseIndex; // the triangles of the leaf children are stored next to each other in the triangle stream
+		uint8_t Meta[Width];
+		uint8_t QuantizedMin[3][Width]; // child min = Origin + QuantizedMin * 2^(exponent - 127)
+		uint8_t QuantizedMax[3][Width];
+	};
+
+	static_assert(sizeof(WideBVHNode<4>) == 52, "WideBVHNode<4> has to match the layout in BVHTraversal.hlsli");
+	static_assert(sizeof(WideBVHNode<8>) == 80, "WideBVHNode<8> has to match the layout in BVHTraversal.hlsli");
+
+
+	//the quantization scale of an axis from its biased exponent
+	inline float GetWideBVHScale(uint32_t iExponents, uint32_t iAxis)
+	{
+		return Math::asfloat(((iExponents >> (8 * iAxis)) & 0xff) << 23);
+	}
+
+	//the size of a node of a bvh with iWidth children per node (2 is the binary AABB tree)
+	inline uint64_t GetBVHNodeSize(uint32_t iWidth)
+	{
+		return (iWidth == 8) ? sizeof(WideBVHNode<8>) : ((iWidth == 4) ? sizeof(WideBVHNode<4>) : sizeof(AABB));
+	}
+
+
+	//collapse a binary bvh, whose leaves point into rtTriangles (see BuildTriangleStream), into a wide bvh
+	//the inner node with the biggest surface area is replaced by its children until a node has Width children,
+	//rtWideTriangles is the triangle stream in the order of the wide leaves
+	template<uint32_t Width>
+	bool BuildWideBVH(const std::vector<AABB>& rtBVH, const std::vector<IntersectionTriangle>& rtTriangles,
+		std::vector<WideBVHNode<Width>>& rtWideBVH, std::vector<IntersectionTriangle>& rtWideTriangles);
+
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Settings.h"
+#include "Core/RenderSettings.h"
+
+
+
+namespace RT::Core
+{
+
+	//the values of Settings.h, which are overridden by the settings file and the command line (shared by both backends)
+	inline RenderSettings GetDefaultRenderSettings()
+	{
+		RenderSettings rtSettings{};
+		rtSettings.Width = RT_WINDOW_WIDTH;
+		rtSettings.Height = RT_WINDOW_HEIGHT;
+		rtSettings.SceneFileName = RT_SCENE_FILENAME;
+		rtSettings.UseSceneCache = RT_USE_SCENE_CACHE;
+		rtSettings.OutputFileName = RT_OUTPUT_FILENAME;
+		rtSettings.MaxSamples = RT_MAX_SAMPLES;
+		rtSettings.MaxSeconds = RT_MAX_SECONDS;
+		rtSettings.Seed = RT_RANDOM_SEED;
+		rtSettings.Camera.VerticalFOV = RT_CAMERA_FOV;
+		rtSettings.Camera.NearZ = RT_CAMERA_NEARZ;
+		rtSettings.Camera.FarZ = RT_CAMERA_FARZ;
+		rtSettings.Camera.Position = RT_CAMERA_POSITION;
+		rtSettings.Camera.FocusPoint = RT_CAMERA_FOCUS_POINT;
+		rtSettings.Camera.UpDirection = RT_CAMERA_UP_DIRECTION;
+		rtSettings.MaxRayDepth = RT_MAX_RAY_DEPTH;
+		rtSettings.RussianRouletteDepth = RT_RUSSIAN_ROULETTE_DEPTH;
+		rtSettings.AASampleSpread = RT_AA_SAMPLE_SPREAD;
+		rtSettings.DOFSampleSpread = RT_DOF_SAMPLE_SPREAD;
+		rtSettings.Sampler = RT_SAMPLER;
+		rtSettings.UseLightSampling = RT_USE_LIGHT_SAMPLING;
+		rtSettings.AdaptiveErrorThreshold = RT_ADAPTIVE_ERROR_THRESHOLD;
+		rtSettings.AdaptiveMinSamples = RT_ADAPTIVE_MIN_SAMPLES;
+		rtSettings.UseBVH = RT_USE_BVH;
+		rtSettings.UseSAHBVH = RT_USE_SAH_BVH;
+		rtSettings.UseStacklessBVH = RT_USE_STACKLESS_BVH;
+		rtSettings.UsePersistentThreads = RT_USE_PERSISTENT_THREADS;
+		rtSettings.UseRayBinning = RT_USE_RAY_BINNING;
+		return rtSettings;
+	}
+
+}
\ No newline at end of file
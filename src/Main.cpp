@@ -2,10 +2,13 @@
 #include <iostream>
 #include <chrono>
 #include <thread>
+#include <filesystem>
 
 #include "Settings.h"
+#include "DefaultSettings.h"
 #include "GPUDevice.h"
 #include "RaytracerPipeline.h"
+#include "Core/SceneCache.h"
 
 
 
@@ -15,7 +18,7 @@ using namespace std::chrono_literals;
 std::atomic_bool bAppShouldRun = true;
 
 //run the rendering on a separate thread to increase application responsiveness
-void RenderFunction(RT::GraphicsAPI::RaytracerPipeline* rtTracer)
+void RenderFunction(RT::Core::RaytracerBackend* rtTracer)
 {
 	while (bAppShouldRun)
 	{
@@ -28,6 +31,14 @@ void RenderFunction(RT::GraphicsAPI::RaytracerPipeline* rtTracer)
 
 int main()
 {
+	//the settings of Settings.h, which are overridden by the settings file
+	RT::Core::RenderSettings rtSettings = RT::Core::GetDefaultRenderSettings();
+	if (std::filesystem::exists(RT_SETTINGS_FILENAME) && (!(RT::Core::LoadRenderSettings(RT_SETTINGS_FILENAME, rtSettings))))
+	{
+		std::cin.get();
+		return 0;
+	}
+
 	RT::GraphicsAPI::WND::Window rtWindow = RT::GraphicsAPI::WND::Window();
 	RT::GraphicsAPI::DX12Device rtDevice = RT::GraphicsAPI::DX12Device();
 	RT::GraphicsAPI::RaytracerPipeline rtTracer = RT::GraphicsAPI::RaytracerPipeline();
@@ -49,7 +60,9 @@ int main()
 	}
 	std::cout << "DirectX was initialized successfully\n";
 
-	if (!(rtTracer.Initialize(&rtDevice, RT::GraphicsAPI::LoadMeshFromFile(RT_SCENE_FILENAME))))
+	RT::Core::MeshInfo rtScene = rtSettings.UseSceneCache ?
+		RT::Core::LoadScene(rtSettings.SceneFileName, (RT_USE_BVH && RT_USE_SAH_BVH) ? RT_BVH_WIDTH : 0) : RT::GraphicsAPI::LoadMeshFromFile(rtSettings.SceneFileName);
+	if (!(rtTracer.Initialize(&rtDevice, rtScene, rtSettings)))
 	{
 		std::cout << "An error occured during pipeline initialization\n";
 		std::cin.get();
@@ -73,7 +86,7 @@ int main()
 		//stop the raytracer if we exceeded the time limit
 		auto stdCurrentTime = stdClock.now();
 		auto iElapsedTime = (std::chrono::duration_cast<std::chrono::microseconds>(stdCurrentTime - stdStartTime)).count();
-		if (((float)iElapsedTime * 0.000001f) >= RT_MAX_SECONDS)
+		if (((float)iElapsedTime * 0.000001f) >= rtSettings.MaxSeconds)
 			bAppShouldRun = false;
 	}
 
@@ -1,12 +1,31 @@
 //include-files
 #include "RaytracerPipeline.h"
 
+#include <iostream>
+
 
 
 namespace RT::GraphicsAPI
 {
 
-	static std::random_device s_stdSeedGenerator;
+	//every stage with random numbers gets its own generator, which is derived from the seed of the settings and the stage, so the samples are the same in every run
+	static std::mt19937 CreatePRNG(uint32_t iSeed, uint32_t iStage)
+	{
+		std::seed_seq stdSeedSequence{ iSeed, iStage };
+		return std::mt19937(stdSeedSequence);
+	}
+
+	//the shaders with a pixel sampler are compiled once per sampler, the permutation of RT_SAMPLER is the default shader
+	static std::string GetSamplerShaderFile(const std::string& sShaderName, uint32_t iSampler)
+	{
+		if (iSampler == RT_SAMPLER) return "shader/shaderbin/" + sShaderName + ".cso";
+		return "shader/permutations/shaderbin/" + sShaderName + "_S" + std::to_string(iSampler) + ".cso";
+	}
+
+	static DirectX::XMVECTOR LoadFloat3(const Math::float3& rtVector)
+	{
+		return DirectX::XMVectorSet(rtVector.x, rtVector.y, rtVector.z, 0.0f);
+	}
 	
 
 
@@ -22,7 +41,7 @@ namespace RT::GraphicsAPI
 		m_rtRayBuffer(nullptr),
 		m_rtOldRayBuffer(nullptr),
 		m_rtRayPixelsBuffer(nullptr),
-		m_stdPRNG(s_stdSeedGenerator())
+		m_stdPRNG()
 	{
 
 	}
@@ -40,26 +59,28 @@ namespace RT::GraphicsAPI
 
 
 	//public class functions
-	bool CameraRayGen::Initialize(GPUScheduler* rtScheduler, DescriptorHeap* rtUAVDescriptorTable, CameraInfo rtCameraData)
+	bool CameraRayGen::Initialize(GPUScheduler* rtScheduler, DescriptorHeap* rtUAVDescriptorTable, const Core::RenderSettings& rtSettings)
 	{
 		//assign the device
 		m_rtFrameScheduler = rtScheduler;
 		ID3D12CommandQueue* d3dCommandQueue = m_rtFrameScheduler->GetDX12Device()->GetCommandQueue();
 		IDXGISwapChain4* dxSwapChain = m_rtFrameScheduler->GetDX12Device()->GetSwapChain();
 		m_rtUAVDescriptorHeap = rtUAVDescriptorTable;
+		m_stdPRNG = CreatePRNG(rtSettings.Seed, 0);
 
 
 		//create the pipeline state for the camera ray generation shader
 		RootSignature rtRootSignatures;
 		DescriptorTable rtDescriptorTable;
 		rtRootSignatures.AddConstantBuffer(0, 0, ShaderStageCS);
-		rtDescriptorTable.AddUAVRange(0, 0, 3);
+		rtDescriptorTable.AddUAVRange(0, 0, 5);
 		rtRootSignatures.AddDescriptorTable(rtDescriptorTable, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(5, 0, ShaderStageCS);
 
 		m_rtCameraRayGenState = new PipelineState();
 		m_rtCameraRayGenState->Initialize(m_rtFrameScheduler, true);
 		if (!(m_rtCameraRayGenState->SetRootSignature(rtRootSignatures))) return false;
-		if (!(m_rtCameraRayGenState->SetCS("shader/shaderbin/CS_CameraRayGeneration.cso"))) return false;
+		if (!(m_rtCameraRayGenState->SetCS(GetSamplerShaderFile("CS_CameraRayGeneration", rtSettings.Sampler)))) return false;
 		if (!(m_rtCameraRayGenState->CreatePSO())) return false;
 
 		//create the resources
@@ -78,32 +99,41 @@ namespace RT::GraphicsAPI
 		if (!(m_rtRayPixelsBuffer->Initialize(m_rtFrameScheduler, SIZEOF_RAYPIXEL, MAX_RAYS, DescriptorHeapInfo(m_rtUAVDescriptorHeap, 2)))) return false;
 
 		//store the info data and make it visible to the gpu
+		const Core::CameraSettings& rtCameraData = rtSettings.Camera;
 		float fAspectRatio = (float)RT_WINDOW_WIDTH / (float)RT_WINDOW_HEIGHT;
 		DirectX::XMVECTOR xmDeterminant{};
 		DirectX::XMMATRIX xmInverseProjectionMatrix = DirectX::XMMatrixInverse(&xmDeterminant, DirectX::XMMatrixTranspose(
 			DirectX::XMMatrixPerspectiveFovLH(rtCameraData.VerticalFOV, fAspectRatio, rtCameraData.NearZ, rtCameraData.FarZ)));
 		DirectX::XMMATRIX xmInverseViewMatrix = DirectX::XMMatrixInverse(&xmDeterminant, DirectX::XMMatrixTranspose(DirectX::XMMatrixLookAtLH(
-			DirectX::XMLoadFloat3(&(rtCameraData.Position)), DirectX::XMLoadFloat3(&(rtCameraData.FocusPoint)), DirectX::XMLoadFloat3(&(rtCameraData.UpDirection)))));
+			LoadFloat3(rtCameraData.Position), LoadFloat3(rtCameraData.FocusPoint), LoadFloat3(rtCameraData.UpDirection))));
 
 		DirectX::XMStoreFloat4x4(&(m_rtInfoData.InverseView), xmInverseViewMatrix);
 		DirectX::XMStoreFloat4x4(&(m_rtInfoData.InverseProjection), xmInverseProjectionMatrix);
 		m_rtInfoData.ScreenSize.x = RT_WINDOW_WIDTH;
 		m_rtInfoData.ScreenSize.y = RT_WINDOW_HEIGHT;
-		m_rtInfoData.AASampleSpread = AA_SAMPLE_SPREAD;
-		m_rtInfoData.DOFSampleSpread = DOF_SAMPLE_SPREAD;
+		m_rtInfoData.AASampleSpread = rtSettings.AASampleSpread;
+		m_rtInfoData.DOFSampleSpread = rtSettings.DOFSampleSpread;
 		m_rtInfoData.MaxRaysPerPixel = MAX_RAYS_PER_PIXEL;
 		m_rtInfoData.RNGSeed.x = 0;
 		m_rtInfoData.RNGSeed.y = 0;
 		m_rtInfoData.RNGSeed.z = 0;
+		m_rtInfoData.TileOffset.x = 0;
+		m_rtInfoData.TileOffset.y = 0;
+		m_rtInfoData.TileSize.x = RENDER_TILE_WIDTH;
+		m_rtInfoData.TileSize.y = RENDER_TILE_HEIGHT;
+		m_rtInfoData.SampleIndex = 0;
+		m_rtInfoData.ImageSeed = rtSettings.Seed;
 		m_rtCameraRayGenInfoBuffer->UpdateAll(&m_rtInfoData);
 
 		return true;
 	}
 
 
-	//render a single frame
-	bool CameraRayGen::Render()
+	//generate the camera rays of the render tile iTile, the tiles, which the adaptive sampling stopped (rtConvergedTiles), get no new rays
+	bool CameraRayGen::Render(RWStructuredBuffer* rtConvergedTiles, uint32_t iTile)
 	{
+		if (!rtConvergedTiles) return false;
+		if (iTile >= NUM_RENDER_TILES) return false;
 		ID3D12CommandQueue* d3dCommandQueue = m_rtFrameScheduler->GetDX12Device()->GetCommandQueue();
 		IDXGISwapChain4* dxSwapChain = m_rtFrameScheduler->GetDX12Device()->GetSwapChain();
 		ID3D12GraphicsCommandList* d3dCommandList = m_rtFrameScheduler->GetCommandList();
@@ -113,14 +143,17 @@ namespace RT::GraphicsAPI
 		m_rtInfoData.RNGSeed.x = m_stdPRNG();
 		m_rtInfoData.RNGSeed.y = m_stdPRNG();
 		m_rtInfoData.RNGSeed.z = m_stdPRNG();
+		m_rtInfoData.TileOffset = GetRenderTileOffset(iTile);
 		m_rtCameraRayGenInfoBuffer->Update(&m_rtInfoData);
+		if (iTile == NUM_RENDER_TILES - 1) m_rtInfoData.SampleIndex++; // the next camera rays are the next samples of the pixels
 
 		//camera ray generation
 		m_rtCameraRayGenState->Bind();
 		m_rtUAVDescriptorHeap->Bind(1, 0, true);
 		m_rtCameraRayGenInfoBuffer->Bind(0, true);
+		rtConvergedTiles->Bind(2, true);
 
-		D3D12_RESOURCE_BARRIER d3dUAVBarriers[3] = {};
+		D3D12_RESOURCE_BARRIER d3dUAVBarriers[4] = {};
 		d3dUAVBarriers[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
 		d3dUAVBarriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
 		d3dUAVBarriers[0].UAV.pResource = m_rtRayBuffer->GetResources()[0];
@@ -130,10 +163,13 @@ namespace RT::GraphicsAPI
 		d3dUAVBarriers[2].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
 		d3dUAVBarriers[2].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
 		d3dUAVBarriers[2].UAV.pResource = m_rtRayPixelsBuffer->GetResources()[0];
-		d3dCommandList->ResourceBarrier(3, d3dUAVBarriers);
+		d3dUAVBarriers[3].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		d3dUAVBarriers[3].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+		d3dUAVBarriers[3].UAV.pResource = nullptr; // the scattered and emitted light of the ray slots belong to TraceRays
+		d3dCommandList->ResourceBarrier(4, d3dUAVBarriers);
 
-		//dispatch the workload
-		d3dCommandList->Dispatch((RT_WINDOW_WIDTH + 15) / 16, (RT_WINDOW_HEIGHT + 15) / 16, 1);
+		//dispatch the workload, one thread per pixel of the render tile
+		d3dCommandList->Dispatch((RENDER_TILE_WIDTH + 15) / 16, (RENDER_TILE_HEIGHT + 15) / 16, 1);
 
 		d3dUAVBarriers[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
 		d3dUAVBarriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
@@ -144,35 +180,34 @@ namespace RT::GraphicsAPI
 		d3dUAVBarriers[2].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
 		d3dUAVBarriers[2].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
 		d3dUAVBarriers[2].UAV.pResource = m_rtRayPixelsBuffer->GetResources()[0];
-		d3dCommandList->ResourceBarrier(3, d3dUAVBarriers);
+		d3dUAVBarriers[3].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		d3dUAVBarriers[3].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+		d3dUAVBarriers[3].UAV.pResource = nullptr; // the scattered and emitted light of the ray slots belong to TraceRays
+		d3dCommandList->ResourceBarrier(4, d3dUAVBarriers);
 
 		return true;
 	}
 
 
 
-	//the ray tracing class
+	//the radix sort class
 	//class constructor
-	SortPrimitives::SortPrimitives() :
+	OnesweepSort::OnesweepSort() :
 		//initialize the class variables
 		m_rtFrameScheduler(nullptr),
-		m_rtGenMortonCodeState(nullptr),
-		m_rtSortCountState(nullptr),
+		m_rtSortHistogramState(nullptr),
 		m_rtSortPrefixSumState(nullptr),
-		m_rtSortSortState(nullptr),
-		m_rtMortonCodeInfoData(),
+		m_rtSortOnesweepState(nullptr),
 		m_rtSortInfoData(),
-		m_rtMortonCodeInfoBuffer(nullptr),
 		m_rtSortInfoBuffer(),
-		m_rtMortonCodeBuffer(nullptr),
-		m_rtTempMortonCodeBuffer(nullptr),
-		m_rtCodeFrequenciesBuffer(nullptr)
+		m_rtHistogramBuffer(nullptr),
+		m_rtPartitionStatusBuffer(nullptr)
 	{
 
 	}
 
 	//destructor: uninitializes all our pointers
-	SortPrimitives::~SortPrimitives()
+	OnesweepSort::~OnesweepSort()
 	{
 
 	}
@@ -184,39 +219,25 @@ namespace RT::GraphicsAPI
 
 
 	//public class functions
-	bool SortPrimitives::Initialize(GPUScheduler* rtScheduler, uint32_t iNumPrimitives, AABB rtSceneAABB)
+	bool OnesweepSort::Initialize(GPUScheduler* rtScheduler, uint32_t iNumElements)
 	{
 		//assign the device
 		m_rtFrameScheduler = rtScheduler;
-		ID3D12CommandQueue* d3dCommandQueue = m_rtFrameScheduler->GetDX12Device()->GetCommandQueue();
-		IDXGISwapChain4* dxSwapChain = m_rtFrameScheduler->GetDX12Device()->GetSwapChain();
 
 		RootSignature rtRootSignatures;
 
 
 		//create the pipeline states for the different shaders
-		rtRootSignatures.Release();
-		rtRootSignatures.AddConstantBuffer(0, 0, ShaderStageCS);
-		rtRootSignatures.AddShaderResource(0, 0, ShaderStageCS);
-		rtRootSignatures.AddShaderResource(1, 0, ShaderStageCS);
-		rtRootSignatures.AddUnorderedAccessResource(5, 0, ShaderStageCS);
-		rtRootSignatures.AddUnorderedAccessResource(7, 0, ShaderStageCS);
-		m_rtGenMortonCodeState = new PipelineState();
-		m_rtGenMortonCodeState->Initialize(m_rtFrameScheduler, true);
-		if (!(m_rtGenMortonCodeState->SetRootSignature(rtRootSignatures))) return false;
-		if (!(m_rtGenMortonCodeState->SetCS("shader/shaderbin/CS_GenerateMortonCodes.cso"))) return false;
-		if (!(m_rtGenMortonCodeState->CreatePSO())) return false;
-
 		rtRootSignatures.Release();
 		rtRootSignatures.AddConstantBuffer(0, 0, ShaderStageCS);
 		rtRootSignatures.AddUnorderedAccessResource(5, 0, ShaderStageCS);
-		rtRootSignatures.AddUnorderedAccessResource(6, 0, ShaderStageCS);
 		rtRootSignatures.AddUnorderedAccessResource(7, 0, ShaderStageCS);
-		m_rtSortCountState = new PipelineState();
-		m_rtSortCountState->Initialize(m_rtFrameScheduler, true);
-		if (!(m_rtSortCountState->SetRootSignature(rtRootSignatures))) return false;
-		if (!(m_rtSortCountState->SetCS("shader/shaderbin/CS_SortCount.cso"))) return false;
-		if (!(m_rtSortCountState->CreatePSO())) return false;
+		rtRootSignatures.AddUnorderedAccessResource(8, 0, ShaderStageCS);
+		m_rtSortHistogramState = new PipelineState();
+		m_rtSortHistogramState->Initialize(m_rtFrameScheduler, true);
+		if (!(m_rtSortHistogramState->SetRootSignature(rtRootSignatures))) return false;
+		if (!(m_rtSortHistogramState->SetCS("shader/shaderbin/CS_SortHistogram.cso"))) return false;
+		if (!(m_rtSortHistogramState->CreatePSO())) return false;
 
 		rtRootSignatures.Release();
 		rtRootSignatures.AddConstantBuffer(0, 0, ShaderStageCS);
@@ -232,16 +253,14 @@ namespace RT::GraphicsAPI
 		rtRootSignatures.AddUnorderedAccessResource(5, 0, ShaderStageCS);
 		rtRootSignatures.AddUnorderedAccessResource(6, 0, ShaderStageCS);
 		rtRootSignatures.AddUnorderedAccessResource(7, 0, ShaderStageCS);
-		m_rtSortSortState = new PipelineState();
-		m_rtSortSortState->Initialize(m_rtFrameScheduler, true);
-		if (!(m_rtSortSortState->SetRootSignature(rtRootSignatures))) return false;
-		if (!(m_rtSortSortState->SetCS("shader/shaderbin/CS_SortSort.cso"))) return false;
-		if (!(m_rtSortSortState->CreatePSO())) return false;
+		rtRootSignatures.AddUnorderedAccessResource(8, 0, ShaderStageCS);
+		m_rtSortOnesweepState = new PipelineState();
+		m_rtSortOnesweepState->Initialize(m_rtFrameScheduler, true);
+		if (!(m_rtSortOnesweepState->SetRootSignature(rtRootSignatures))) return false;
+		if (!(m_rtSortOnesweepState->SetCS("shader/shaderbin/CS_SortOnesweep.cso"))) return false;
+		if (!(m_rtSortOnesweepState->CreatePSO())) return false;
 
 		//create the constant buffers
-		m_rtMortonCodeInfoBuffer = new ConstantBuffer();
-		if (!m_rtMortonCodeInfoBuffer) return false;
-		if (!(m_rtMortonCodeInfoBuffer->Initialize(m_rtFrameScheduler, sizeof(MortonCodeInfo)))) return false;
 		for (uint32_t i = 0; i < 4; i++)
 		{
 			m_rtSortInfoBuffer[i] = new ConstantBuffer();
@@ -249,6 +268,150 @@ namespace RT::GraphicsAPI
 			if (!(m_rtSortInfoBuffer[i]->Initialize(m_rtFrameScheduler, sizeof(SortInfo)))) return false;
 		}
 
+		//create the structured buffers
+		m_rtHistogramBuffer = new RWStructuredBuffer();
+		if (!m_rtHistogramBuffer) return false;
+		if (!(m_rtHistogramBuffer->Initialize(m_rtFrameScheduler, sizeof(uint32_t), Core::RADIX_SORT_HISTOGRAM_BUFFER_SIZE))) return false;
+		m_rtPartitionStatusBuffer = new RWStructuredBuffer();
+		if (!m_rtPartitionStatusBuffer) return false;
+		uint32_t iNumStatusEntries = (Core::GetRadixSortTileCount(iNumElements) + 1) * Core::RADIX_SORT_RADIX * Core::RADIX_SORT_NUM_PASSES;
+		if (!(m_rtPartitionStatusBuffer->Initialize(m_rtFrameScheduler, sizeof(uint32_t), iNumStatusEntries))) return false;
+
+
+		//save the number of elements
+		m_rtSortInfoData.NumElements = iNumElements;
+		m_rtSortInfoData.NumTiles = Core::GetRadixSortTileCount(iNumElements);
+
+
+		return true;
+	}
+
+
+	//sort the keys, the result ends up in rtKeys again
+	bool OnesweepSort::Sort(RWStructuredBuffer* rtKeys, RWStructuredBuffer* rtTempKeys)
+	{
+		ID3D12GraphicsCommandList* d3dCommandList = m_rtFrameScheduler->GetCommandList();
+
+		D3D12_RESOURCE_BARRIER d3dUAVBarriers[4] = {};
+		RWStructuredBuffer* rtBarrierBuffers[4] = { rtKeys, rtTempKeys, m_rtHistogramBuffer, m_rtPartitionStatusBuffer };
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			d3dUAVBarriers[i].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+			d3dUAVBarriers[i].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+			d3dUAVBarriers[i].UAV.pResource = rtBarrierBuffers[i]->GetResources()[0];
+		}
+		d3dCommandList->ResourceBarrier(4, d3dUAVBarriers);
+
+		for (uint32_t i = 0; i < Core::RADIX_SORT_NUM_PASSES; i++)
+		{
+			m_rtSortInfoData.SortPassIndex = i;
+			m_rtSortInfoBuffer[i]->Update(&m_rtSortInfoData);
+		}
+
+		//count the digits of all passes at once
+		m_rtSortHistogramState->Bind();
+		m_rtSortInfoBuffer[0]->Bind(0, true);
+		rtKeys->Bind(1, true);
+		m_rtHistogramBuffer->Bind(2, true);
+		m_rtPartitionStatusBuffer->Bind(3, true);
+
+		d3dCommandList->Dispatch(m_rtSortInfoData.NumTiles, 1, 1);
+
+		d3dCommandList->ResourceBarrier(4, d3dUAVBarriers);
+
+		//the prefix sums of the histograms
+		m_rtSortPrefixSumState->Bind();
+		m_rtSortInfoBuffer[0]->Bind(0, true);
+		m_rtHistogramBuffer->Bind(1, true);
+
+		d3dCommandList->Dispatch(Core::RADIX_SORT_NUM_PASSES, 1, 1);
+
+		d3dCommandList->ResourceBarrier(4, d3dUAVBarriers);
+
+		//the sorting passes, every pass reads the result of the previous one, so the result ends up in the key buffer again
+		for (uint32_t i = 0; i < Core::RADIX_SORT_NUM_PASSES; i++)
+		{
+			RWStructuredBuffer* rtSourceBuffer = (i % 2 == 0) ? rtKeys : rtTempKeys;
+			RWStructuredBuffer* rtTargetBuffer = (i % 2 == 0) ? rtTempKeys : rtKeys;
+
+			m_rtSortOnesweepState->Bind();
+			m_rtSortInfoBuffer[i]->Bind(0, true);
+			rtSourceBuffer->Bind(1, true);
+			rtTargetBuffer->Bind(2, true);
+			m_rtHistogramBuffer->Bind(3, true);
+			m_rtPartitionStatusBuffer->Bind(4, true);
+
+			d3dCommandList->Dispatch(m_rtSortInfoData.NumTiles, 1, 1);
+
+			d3dCommandList->ResourceBarrier(4, d3dUAVBarriers);
+		}
+
+		return true;
+	}
+
+
+
+	//the primitive sorting class
+	//class constructor
+	SortPrimitives::SortPrimitives() :
+		//initialize the class variables
+		m_rtFrameScheduler(nullptr),
+		m_rtGenMortonCodeState(nullptr),
+		m_rtSort(nullptr),
+		m_rtMortonCodeInfoData(),
+		m_rtMortonCodeInfoBuffer(nullptr),
+		m_rtMortonCodeBuffer(nullptr),
+		m_rtTempMortonCodeBuffer(nullptr)
+	{
+
+	}
+
+	//destructor: uninitializes all our pointers
+	SortPrimitives::~SortPrimitives()
+	{
+
+	}
+
+
+
+	//private class functions
+
+
+
+	//public class functions
+	bool SortPrimitives::Initialize(GPUScheduler* rtScheduler, uint32_t iNumPrimitives, AABB rtSceneAABB)
+	{
+		//assign the device
+		m_rtFrameScheduler = rtScheduler;
+		ID3D12CommandQueue* d3dCommandQueue = m_rtFrameScheduler->GetDX12Device()->GetCommandQueue();
+		IDXGISwapChain4* dxSwapChain = m_rtFrameScheduler->GetDX12Device()->GetSwapChain();
+
+		RootSignature rtRootSignatures;
+
+
+		//create the pipeline state for the morton codes
+		rtRootSignatures.Release();
+		rtRootSignatures.AddConstantBuffer(0, 0, ShaderStageCS);
+		rtRootSignatures.AddShaderResource(0, 0, ShaderStageCS);
+		rtRootSignatures.AddShaderResource(1, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(5, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(7, 0, ShaderStageCS);
+		m_rtGenMortonCodeState = new PipelineState();
+		m_rtGenMortonCodeState->Initialize(m_rtFrameScheduler, true);
+		if (!(m_rtGenMortonCodeState->SetRootSignature(rtRootSignatures))) return false;
+		if (!(m_rtGenMortonCodeState->SetCS("shader/shaderbin/CS_GenerateMortonCodes.cso"))) return false;
+		if (!(m_rtGenMortonCodeState->CreatePSO())) return false;
+
+		//the sorting passes
+		m_rtSort = new OnesweepSort();
+		if (!m_rtSort) return false;
+		if (!(m_rtSort->Initialize(m_rtFrameScheduler, iNumPrimitives))) return false;
+
+		//create the constant buffers
+		m_rtMortonCodeInfoBuffer = new ConstantBuffer();
+		if (!m_rtMortonCodeInfoBuffer) return false;
+		if (!(m_rtMortonCodeInfoBuffer->Initialize(m_rtFrameScheduler, sizeof(MortonCodeInfo)))) return false;
+
 		//create the structured buffers
 		m_rtMortonCodeBuffer = new RWStructuredBuffer();
 		if (!m_rtMortonCodeBuffer) return false;
@@ -256,16 +419,12 @@ namespace RT::GraphicsAPI
 		m_rtTempMortonCodeBuffer = new RWStructuredBuffer();
 		if (!m_rtTempMortonCodeBuffer) return false;
 		if (!(m_rtTempMortonCodeBuffer->Initialize(m_rtFrameScheduler, 16, iNumPrimitives))) return false;
-		m_rtCodeFrequenciesBuffer = new RWStructuredBuffer();
-		if (!m_rtCodeFrequenciesBuffer) return false;
-		if (!(m_rtCodeFrequenciesBuffer->Initialize(m_rtFrameScheduler, 16, 256))) return false;
 
 
 		//save the scene AABB and the number of primitives
 		m_rtMortonCodeInfoData.SceneMin = { rtSceneAABB.Min.x, rtSceneAABB.Min.y, rtSceneAABB.Min.z, 0.0f };
 		m_rtMortonCodeInfoData.SceneMax = { rtSceneAABB.Max.x, rtSceneAABB.Max.y, rtSceneAABB.Max.z, 0.0f };
 		m_rtMortonCodeInfoData.NumPrimitives = iNumPrimitives;
-		m_rtSortInfoData.NumElements = iNumPrimitives;
 
 
 		return true;
@@ -280,104 +439,33 @@ namespace RT::GraphicsAPI
 		ID3D12GraphicsCommandList* d3dCommandList = m_rtFrameScheduler->GetCommandList();
 
 
-		//the pass, which calculates the morton codes
+		//the pass, which calculates the morton codes (it also resets the histograms)
 		m_rtMortonCodeInfoBuffer->Update(&m_rtMortonCodeInfoData);
 
 		m_rtGenMortonCodeState->Bind();
 		m_rtMortonCodeInfoBuffer->Bind(0, true);
 		rtMesh->Bind(1, 2, true);
 		m_rtMortonCodeBuffer->Bind(3, true);
-		m_rtCodeFrequenciesBuffer->Bind(4, true);
-		
-		D3D12_RESOURCE_BARRIER d3dUAVBarrier[1] = {};
-		d3dUAVBarrier[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-		d3dUAVBarrier[0].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-		d3dUAVBarrier[0].UAV.pResource = m_rtMortonCodeBuffer->GetResources()[0];
-		d3dCommandList->ResourceBarrier(1, d3dUAVBarrier);
-
-		d3dCommandList->Dispatch((m_rtSortInfoData.NumElements + 255) / 256, 1, 1);
-
-		d3dUAVBarrier[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-		d3dUAVBarrier[0].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-		d3dUAVBarrier[0].UAV.pResource = m_rtMortonCodeBuffer->GetResources()[0];
-		d3dCommandList->ResourceBarrier(1, d3dUAVBarrier);
+		m_rtSort->GetHistograms()->Bind(4, true);
 
-
-		//the sorting
-		for (uint32_t i = 0; i < 4; i++)
+		D3D12_RESOURCE_BARRIER d3dUAVBarriers[3] = {};
+		RWStructuredBuffer* rtBarrierBuffers[3] = { m_rtMortonCodeBuffer, m_rtTempMortonCodeBuffer, m_rtSort->GetHistograms() };
+		for (uint32_t i = 0; i < 3; i++)
 		{
-			//update the info buffer
-			m_rtSortInfoData.SortPassIndex = i;
-			m_rtSortInfoBuffer[i]->Update(&m_rtSortInfoData);
-
-			//the counting pass
-			m_rtSortCountState->Bind();
-			m_rtSortInfoBuffer[i]->Bind(0, true);
-			m_rtMortonCodeBuffer->Bind(1, true);
-			m_rtTempMortonCodeBuffer->Bind(2, true);
-			m_rtCodeFrequenciesBuffer->Bind(3, true);
-
-			D3D12_RESOURCE_BARRIER d3dUAVBarriers[2] = {};
-			d3dUAVBarriers[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-			d3dUAVBarriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-			d3dUAVBarriers[0].UAV.pResource = m_rtMortonCodeBuffer->GetResources()[0];
-			d3dUAVBarriers[1].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-			d3dUAVBarriers[1].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-			d3dUAVBarriers[1].UAV.pResource = m_rtCodeFrequenciesBuffer->GetResources()[0];
-			d3dCommandList->ResourceBarrier(2, d3dUAVBarriers);
-
-			d3dCommandList->Dispatch((m_rtSortInfoData.NumElements + 255) / 256, 1, 1);
-
-			d3dUAVBarriers[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-			d3dUAVBarriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-			d3dUAVBarriers[0].UAV.pResource = m_rtMortonCodeBuffer->GetResources()[0];
-			d3dUAVBarriers[1].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-			d3dUAVBarriers[1].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-			d3dUAVBarriers[1].UAV.pResource = m_rtCodeFrequenciesBuffer->GetResources()[0];
-			d3dCommandList->ResourceBarrier(2, d3dUAVBarriers);
-
-			//the prefix sum pass
-			m_rtSortPrefixSumState->Bind();
-			m_rtSortInfoBuffer[i]->Bind(0, true);
-			m_rtCodeFrequenciesBuffer->Bind(1, true);
-
-			d3dUAVBarrier[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-			d3dUAVBarrier[0].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-			d3dUAVBarrier[0].UAV.pResource = m_rtCodeFrequenciesBuffer->GetResources()[0];
-			d3dCommandList->ResourceBarrier(1, d3dUAVBarriers);
-
-			d3dCommandList->Dispatch(1, 1, 1);
-
-			d3dUAVBarrier[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-			d3dUAVBarrier[0].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-			d3dUAVBarrier[0].UAV.pResource = m_rtCodeFrequenciesBuffer->GetResources()[0];
-			d3dCommandList->ResourceBarrier(1, d3dUAVBarriers);
+			d3dUAVBarriers[i].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+			d3dUAVBarriers[i].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+			d3dUAVBarriers[i].UAV.pResource = rtBarrierBuffers[i]->GetResources()[0];
+		}
+		d3dCommandList->ResourceBarrier(3, d3dUAVBarriers);
 
-			//the actual sorting pass
-			m_rtSortSortState->Bind();
-			m_rtSortInfoBuffer[i]->Bind(0, true);
-			m_rtMortonCodeBuffer->Bind(1, true);
-			m_rtTempMortonCodeBuffer->Bind(2, true);
-			m_rtCodeFrequenciesBuffer->Bind(3, true);
-
-			d3dUAVBarriers[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-			d3dUAVBarriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-			d3dUAVBarriers[0].UAV.pResource = m_rtMortonCodeBuffer->GetResources()[0];
-			d3dUAVBarriers[1].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-			d3dUAVBarriers[1].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-			d3dUAVBarriers[1].UAV.pResource = m_rtCodeFrequenciesBuffer->GetResources()[0];
-			d3dCommandList->ResourceBarrier(2, d3dUAVBarriers);
+		//there have to be enough threads to reset the whole histogram buffer
+		uint32_t iNumGroups = (m_rtMortonCodeInfoData.NumPrimitives + 255) / 256;
+		uint32_t iMinNumGroups = (Core::RADIX_SORT_HISTOGRAM_BUFFER_SIZE + 255) / 256;
+		d3dCommandList->Dispatch((iNumGroups > iMinNumGroups) ? iNumGroups : iMinNumGroups, 1, 1);
 
-			d3dCommandList->Dispatch(1, 1, 1);
 
-			d3dUAVBarriers[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-			d3dUAVBarriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-			d3dUAVBarriers[0].UAV.pResource = m_rtMortonCodeBuffer->GetResources()[0];
-			d3dUAVBarriers[1].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-			d3dUAVBarriers[1].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-			d3dUAVBarriers[1].UAV.pResource = m_rtCodeFrequenciesBuffer->GetResources()[0];
-			d3dCommandList->ResourceBarrier(2, d3dUAVBarriers);
-		}
+		//the sorting (onesweep radix sort)
+		if (!(m_rtSort->Sort(m_rtMortonCodeBuffer, m_rtTempMortonCodeBuffer))) return false;
 
 		return true;
 	}
@@ -391,10 +479,13 @@ namespace RT::GraphicsAPI
 		m_rtFrameScheduler(nullptr),
 		m_rtBuildLeavesState(nullptr),
 		m_rtBuildState(nullptr),
+		m_rtBuildSkipLinksState(nullptr),
 		m_rtBVHInfoData(),
 		m_rtBuildLeavesInfoBuffer(nullptr),
 		m_rtBVHBuildInfoBuffer(),
-		m_rtBVHBuffer(nullptr)
+		m_rtBVHBuffer(nullptr),
+		m_rtTriangleBuffer(nullptr),
+		m_rtSkipLinkBuffer(nullptr)
 	{
 
 	}
@@ -408,6 +499,41 @@ namespace RT::GraphicsAPI
 
 
 	//private class functions
+	//upload a tree (binary or wide), which was built on the cpu, its triangle stream and the skip links of a binary tree
+	bool BuildBVH::Upload(std::span<const std::byte> rtBVH, std::span<const IntersectionTriangle> rtTriangles, std::span<const uint32_t> iSkipLinks)
+	{
+		const unsigned int iBVHSize = (unsigned int)(rtBVH.size_bytes());
+		const unsigned int iTrianglesSize = (unsigned int)(rtTriangles.size_bytes());
+		const unsigned int iSkipLinksSize = (unsigned int)(iSkipLinks.size_bytes());
+
+		GPUScheduler rtUploadScheduler;
+		UploadBuffer rtUploadBuffer;
+		if (!(rtUploadScheduler.Initialize(m_rtFrameScheduler->GetDX12Device()))) return false;
+		if (!(rtUploadBuffer.Initialize(&rtUploadScheduler, iBVHSize + iTrianglesSize + iSkipLinksSize))) return false;
+		if (iBVHSize > 0)
+		{
+			if (!(rtUploadBuffer.Update(rtBVH.data(), iBVHSize, 0))) return false;
+		}
+		if (!(rtUploadBuffer.Update(rtTriangles.data(), iTrianglesSize, iBVHSize))) return false;
+		if (iSkipLinksSize > 0)
+		{
+			if (!(rtUploadBuffer.Update(iSkipLinks.data(), iSkipLinksSize, iBVHSize + iTrianglesSize))) return false;
+		}
+		if (!(rtUploadScheduler.Record())) return false;
+		if (iBVHSize > 0)
+		{
+			if (!(m_rtBVHBuffer->Upload(&rtUploadBuffer, iBVHSize))) return false;
+		}
+		if (!(m_rtTriangleBuffer->Upload(&rtUploadBuffer, iTrianglesSize, iBVHSize))) return false;
+		if (iSkipLinksSize > 0)
+		{
+			if (!(m_rtSkipLinkBuffer->Upload(&rtUploadBuffer, iSkipLinksSize, iBVHSize + iTrianglesSize))) return false;
+		}
+		if (!(rtUploadScheduler.Execute())) return false;
+		rtUploadScheduler.Flush();
+
+		return true;
+	}
 
 
 
@@ -429,6 +555,7 @@ namespace RT::GraphicsAPI
 		rtRootSignatures.AddShaderResource(1, 0, ShaderStageCS);
 		rtRootSignatures.AddUnorderedAccessResource(5, 0, ShaderStageCS);
 		rtRootSignatures.AddUnorderedAccessResource(6, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(7, 0, ShaderStageCS);
 		m_rtBuildLeavesState = new PipelineState();
 		m_rtBuildLeavesState->Initialize(m_rtFrameScheduler, true);
 		if (!(m_rtBuildLeavesState->SetRootSignature(rtRootSignatures))) return false;
@@ -444,6 +571,16 @@ namespace RT::GraphicsAPI
 		if (!(m_rtBuildState->SetCS("shader/shaderbin/CS_BVHBuild.cso"))) return false;
 		if (!(m_rtBuildState->CreatePSO())) return false;
 
+		rtRootSignatures.Release();
+		rtRootSignatures.AddConstantBuffer(0, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(6, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(16, 0, ShaderStageCS);
+		m_rtBuildSkipLinksState = new PipelineState();
+		m_rtBuildSkipLinksState->Initialize(m_rtFrameScheduler, true);
+		if (!(m_rtBuildSkipLinksState->SetRootSignature(rtRootSignatures))) return false;
+		if (!(m_rtBuildSkipLinksState->SetCS("shader/shaderbin/CS_BVHBuildSkipLinks.cso"))) return false;
+		if (!(m_rtBuildSkipLinksState->CreatePSO())) return false;
+
 		//create the constant buffers
 		m_rtBuildLeavesInfoBuffer = new ConstantBuffer();
 		if (!m_rtBuildLeavesInfoBuffer) return false;
@@ -459,6 +596,12 @@ namespace RT::GraphicsAPI
 		m_rtBVHBuffer = new RWStructuredBuffer();
 		if (!m_rtBVHBuffer) return false;
 		if (!(m_rtBVHBuffer->Initialize(m_rtFrameScheduler, sizeof(AABB), iNumPrimitives * 4))) return false;
+		m_rtTriangleBuffer = new RWStructuredBuffer();
+		if (!m_rtTriangleBuffer) return false;
+		if (!(m_rtTriangleBuffer->Initialize(m_rtFrameScheduler, sizeof(IntersectionTriangle), iNumPrimitives))) return false;
+		m_rtSkipLinkBuffer = new RWStructuredBuffer();
+		if (!m_rtSkipLinkBuffer) return false;
+		if (!(m_rtSkipLinkBuffer->Initialize(m_rtFrameScheduler, sizeof(uint32_t), iNumPrimitives * 4))) return false;
 
 
 		//save the number of BVH leaves
@@ -487,29 +630,32 @@ namespace RT::GraphicsAPI
 		rtMesh->Bind(1, 2, true);
 		rtMortonCodes->Bind(3, true);
 		m_rtBVHBuffer->Bind(4, true);
+		m_rtTriangleBuffer->Bind(5, true);
 		
-		D3D12_RESOURCE_BARRIER d3dUAVBarrier[1] = {};
+		D3D12_RESOURCE_BARRIER d3dUAVBarrier[2] = {};
 		d3dUAVBarrier[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
 		d3dUAVBarrier[0].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
 		d3dUAVBarrier[0].UAV.pResource = m_rtBVHBuffer->GetResources()[0];
-		d3dCommandList->ResourceBarrier(1, d3dUAVBarrier);
+		d3dUAVBarrier[1].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		d3dUAVBarrier[1].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+		d3dUAVBarrier[1].UAV.pResource = m_rtTriangleBuffer->GetResources()[0];
+		d3dCommandList->ResourceBarrier(2, d3dUAVBarrier);
 
 		m_rtBVHInfoData.NumChildren = (m_rtBVHInfoData.NumChildren + 1) / 2;
 		d3dCommandList->Dispatch((m_rtBVHInfoData.NumChildren + 255) / 256, 1, 1);
 
-		d3dUAVBarrier[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-		d3dUAVBarrier[0].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-		d3dUAVBarrier[0].UAV.pResource = m_rtBVHBuffer->GetResources()[0];
-		d3dCommandList->ResourceBarrier(1, d3dUAVBarrier);
+		d3dCommandList->ResourceBarrier(2, d3dUAVBarrier);
 
 
 		//build the rest of the tree
 		uint32_t iIndex = 0;
+		uint32_t iNumParents[32] = {}; // the nodes of every level, the skip links are built with the same info buffers
 		for (; m_rtBVHInfoData.NumChildren != 2;)
 		{
 			//update the info buffer
 			m_rtBVHBuildInfoBuffer[iIndex]->Update(&m_rtBVHInfoData);
 			m_rtBVHInfoData.NumChildren = (m_rtBVHInfoData.NumChildren + 1) / 2; //refresh the value after updating the buffer with it
+			iNumParents[iIndex] = m_rtBVHInfoData.NumChildren;
 
 			//the compute pass
 			m_rtBuildState->Bind();
@@ -558,10 +704,87 @@ namespace RT::GraphicsAPI
 		d3dUAVBarrier[0].UAV.pResource = m_rtBVHBuffer->GetResources()[0];
 		d3dCommandList->ResourceBarrier(1, d3dUAVBarrier);
 
+
+		//the skip links for the stackless traversal: top-down from the trunk, every level needs the skip links of its parents
+		if (USE_STACKLESS_BVH)
+		{
+			m_rtBuildSkipLinksState->Bind();
+			m_rtBVHBuffer->Bind(1, true);
+			m_rtSkipLinkBuffer->Bind(2, true);
+
+			d3dUAVBarrier[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+			d3dUAVBarrier[0].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+			d3dUAVBarrier[0].UAV.pResource = m_rtSkipLinkBuffer->GetResources()[0];
+
+			m_rtBVHBuildInfoBuffer[31]->Bind(0, true);
+			d3dCommandList->Dispatch(1, 1, 1);
+			d3dCommandList->ResourceBarrier(1, d3dUAVBarrier);
+
+			for (uint32_t i = iIndex; i > 0; i--)
+			{
+				m_rtBVHBuildInfoBuffer[i - 1]->Bind(0, true);
+				d3dCommandList->Dispatch((iNumParents[i - 1] + 255) / 256, 1, 1);
+				d3dCommandList->ResourceBarrier(1, d3dUAVBarrier);
+			}
+		}
+
 		return true;
 	}
 
 
+	//build the bvh with the surface area heuristic on the cpu and upload it, this replaces Build()
+	bool BuildBVH::BuildSAH(const MeshInfo& rtMesh)
+	{
+		//the scene cache can already contain the tree (with the same width) and its triangle stream, which are uploaded directly from the mapped file
+		std::vector<AABB> rtBuiltBVH;
+		std::vector<Core::WideBVHNode<WIDE_BVH_WIDTH>> rtBuiltWideBVH;
+		std::vector<IntersectionTriangle> rtBuiltTriangles;
+		std::vector<IntersectionTriangle> rtBuiltWideTriangles;
+		std::span<const std::byte> rtBVH;
+		std::span<const IntersectionTriangle> rtTriangles;
+		if ((rtMesh.Cache) && (rtMesh.Cache->GetBVHWidth() == RT_BVH_WIDTH))
+		{
+			rtBVH = USE_WIDE_BVH ? std::as_bytes(rtMesh.Cache->GetWideBVH<WIDE_BVH_WIDTH>()) : std::as_bytes(rtMesh.Cache->GetBVH());
+			rtTriangles = rtMesh.Cache->GetTriangles();
+		}
+		if (rtBVH.empty())
+		{
+			if (!(Core::BuildSAHBVH(rtMesh, rtBuiltBVH))) return false;
+			if (!(Core::BuildTriangleStream(rtMesh, rtBuiltBVH, rtBuiltTriangles))) return false;
+			rtBVH = std::as_bytes(std::span<const AABB>(rtBuiltBVH));
+			rtTriangles = rtBuiltTriangles;
+
+			//collapse the binary tree, the wide leaves get their own triangle stream
+			if (USE_WIDE_BVH)
+			{
+				if (!(Core::BuildWideBVH<WIDE_BVH_WIDTH>(rtBuiltBVH, rtBuiltTriangles, rtBuiltWideBVH, rtBuiltWideTriangles))) return false;
+				rtBVH = std::as_bytes(std::span<const Core::WideBVHNode<WIDE_BVH_WIDTH>>(rtBuiltWideBVH));
+				rtTriangles = rtBuiltWideTriangles;
+			}
+		}
+
+		//the binary tree gets the skip links for the stackless traversal
+		std::vector<uint32_t> iSkipLinks;
+		if (USE_STACKLESS_BVH)
+		{
+			Core::BuildSkipLinks(std::span<const AABB>((const AABB*)rtBVH.data(), rtBVH.size() / sizeof(AABB)), iSkipLinks);
+		}
+
+		return Upload(rtBVH, rtTriangles, iSkipLinks);
+	}
+
+
+	//only upload the triangle stream (in the order of the index buffer) for tracing without a bvh, this replaces Build()
+	bool BuildBVH::BuildTriangles(const MeshInfo& rtMesh)
+	{
+		std::vector<AABB> rtNoBVH;
+		std::vector<IntersectionTriangle> rtTriangles;
+		if (!(Core::BuildTriangleStream(rtMesh, rtNoBVH, rtTriangles))) return false;
+
+		return Upload({}, rtTriangles, {});
+	}
+
+
 
 	//the ray tracing class
 	//class constructor
@@ -577,7 +800,27 @@ namespace RT::GraphicsAPI
 		m_rtMaterialBuffer(nullptr),
 		m_rtScatteredLightBuffer(nullptr),
 		m_rtEmittedLightBuffer(nullptr),
-		m_stdPRNG(s_stdSeedGenerator())
+		m_rtPrepareRayQueueState(nullptr),
+		m_rtSortHitsState(nullptr),
+		m_rtShadeHitsState(nullptr),
+		m_rtBinRaysState(nullptr),
+		m_rtResolveShadowRaysState(nullptr),
+		m_rtRayQueueBuffers{ nullptr, nullptr },
+		m_rtRayQueueStateBuffer(nullptr),
+		m_rtRayQueueArgumentBuffer(nullptr),
+		m_rtHitBuffer(nullptr),
+		m_rtMaterialQueueBuffer(nullptr),
+		m_rtShadingQueueBuffer(nullptr),
+		m_rtRayBinBuffer(nullptr),
+		m_rtTempRayBinBuffer(nullptr),
+		m_rtRayBinSort(nullptr),
+		m_rtLightBuffer(nullptr),
+		m_rtShadowLightBuffer(nullptr),
+		m_rtTraceShadowRays(nullptr),
+		m_d3dDispatchSignature(nullptr),
+		m_iCurrentRayQueue(0),
+		m_bUseLightSampling(false),
+		m_stdPRNG()
 	{
 
 	}
@@ -591,20 +834,47 @@ namespace RT::GraphicsAPI
 
 
 	//private class functions
+	//the binning, the intersection, the sorting, the shading and the shadow ray resolve pass share their root signature
+	void TraceRays::BindResources(RWStructuredBuffer* rtBVH, RWStructuredBuffer* rtTriangles, RWStructuredBuffer* rtSkipLinks)
+	{
+		rtBVH->Bind(5, true);
+		m_rtUAVDescriptorHeap->Bind(6, 0, true);
+		m_rtUAVDescriptorHeap->Bind(7, 7, true, false);
+		m_rtTraceRaysInfoBuffer->Bind(0, true);
+		m_rtMaterialBuffer->Bind(3, true);
+		m_rtMesh->Bind(1, 2, true);
+		m_rtTextures->Bind(4, true);
+		rtTriangles->Bind(8, true);
+		m_rtRayQueueBuffers[m_iCurrentRayQueue]->Bind(9, true);
+		m_rtRayQueueBuffers[1 - m_iCurrentRayQueue]->Bind(10, true);
+		m_rtRayQueueStateBuffer->Bind(11, true);
+		m_rtHitBuffer->Bind(12, true);
+		m_rtMaterialQueueBuffer->Bind(13, true);
+		m_rtShadingQueueBuffer->Bind(14, true);
+		m_rtRayBinBuffer->Bind(15, true);
+		m_rtRayBinSort->GetHistograms()->Bind(16, true);
+		rtSkipLinks->Bind(17, true);
+		m_rtTraceShadowRays->GetRays()->Bind(18, true);
+		m_rtTraceShadowRays->GetVisibility()->Bind(19, true);
+		m_rtShadowLightBuffer->Bind(20, true);
+		m_rtLightBuffer->Bind(21, true);
+	}
 
 
 
 	//public class functions
-	bool TraceRays::Initialize(GPUScheduler* rtScheduler, DescriptorHeap* rtUAVDescriptorTable, MeshInfo rtMeshData)
+	bool TraceRays::Initialize(GPUScheduler* rtScheduler, DescriptorHeap* rtUAVDescriptorTable, MeshInfo rtMeshData, const Core::RenderSettings& rtSettings)
 	{
 		//assign the device
 		m_rtFrameScheduler = rtScheduler;
 		ID3D12CommandQueue* d3dCommandQueue = m_rtFrameScheduler->GetDX12Device()->GetCommandQueue();
 		IDXGISwapChain4* dxSwapChain = m_rtFrameScheduler->GetDX12Device()->GetSwapChain();
 		m_rtUAVDescriptorHeap = rtUAVDescriptorTable;
+		m_bUseLightSampling = rtSettings.UseLightSampling;
+		m_stdPRNG = CreatePRNG(rtSettings.Seed, 1);
 
 
-		//create the pipeline state for the trace rays shader
+		//create the pipeline states for the intersection, the sorting of the hits by material and the shading
 		RootSignature rtRootSignatures;
 		DescriptorTable rtDescriptorTable1;
 		DescriptorTable rtDescriptorTable2;
@@ -618,6 +888,20 @@ namespace RT::GraphicsAPI
 		rtDescriptorTable2.AddSRVRange(4, 0, 1);
 		rtRootSignatures.AddDescriptorTable(rtDescriptorTable1, ShaderStageCS);
 		rtRootSignatures.AddDescriptorTable(rtDescriptorTable2, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(7, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(8, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(9, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(10, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(11, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(12, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(13, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(14, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(15, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(16, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(17, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(18, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(19, 0, ShaderStageCS);
+		rtRootSignatures.AddShaderResource(5, 0, ShaderStageCS);
 
 		m_rtTraceRaysState = new PipelineState();
 		m_rtTraceRaysState->Initialize(m_rtFrameScheduler, true);
@@ -625,6 +909,59 @@ namespace RT::GraphicsAPI
 		if (!(m_rtTraceRaysState->SetCS("shader/shaderbin/CS_TraceRays.cso"))) return false;
 		if (!(m_rtTraceRaysState->CreatePSO())) return false;
 
+		m_rtSortHitsState = new PipelineState();
+		m_rtSortHitsState->Initialize(m_rtFrameScheduler, true);
+		if (!(m_rtSortHitsState->SetRootSignature(rtRootSignatures))) return false;
+		if (!(m_rtSortHitsState->SetCS("shader/shaderbin/CS_SortHits.cso"))) return false;
+		if (!(m_rtSortHitsState->CreatePSO())) return false;
+
+		m_rtShadeHitsState = new PipelineState();
+		m_rtShadeHitsState->Initialize(m_rtFrameScheduler, true);
+		if (!(m_rtShadeHitsState->SetRootSignature(rtRootSignatures))) return false;
+		if (!(m_rtShadeHitsState->SetCS(GetSamplerShaderFile("CS_ShadeHits", rtSettings.Sampler)))) return false;
+		if (!(m_rtShadeHitsState->CreatePSO())) return false;
+
+		m_rtBinRaysState = new PipelineState();
+		m_rtBinRaysState->Initialize(m_rtFrameScheduler, true);
+		if (!(m_rtBinRaysState->SetRootSignature(rtRootSignatures))) return false;
+		if (!(m_rtBinRaysState->SetCS("shader/shaderbin/CS_BinRays.cso"))) return false;
+		if (!(m_rtBinRaysState->CreatePSO())) return false;
+
+		m_rtResolveShadowRaysState = new PipelineState();
+		m_rtResolveShadowRaysState->Initialize(m_rtFrameScheduler, true);
+		if (!(m_rtResolveShadowRaysState->SetRootSignature(rtRootSignatures))) return false;
+		if (!(m_rtResolveShadowRaysState->SetCS("shader/shaderbin/CS_ResolveShadowRays.cso"))) return false;
+		if (!(m_rtResolveShadowRaysState->CreatePSO())) return false;
+
+		//the ray bins are sorted over all ray slots, the empty ones end up behind the rays of the queue
+		m_rtRayBinSort = new OnesweepSort();
+		if (!m_rtRayBinSort) return false;
+		if (!(m_rtRayBinSort->Initialize(m_rtFrameScheduler, MAX_RAYS))) return false;
+
+		//create the pipeline state for the pass, which turns the appended rays into the queue of the next passes and the material counts into offsets
+		RootSignature rtPrepareRootSignature;
+		rtPrepareRootSignature.AddConstantBuffer(0, 0, ShaderStageCS);
+		rtPrepareRootSignature.AddUnorderedAccessResource(0, 0, ShaderStageCS);
+		rtPrepareRootSignature.AddUnorderedAccessResource(1, 0, ShaderStageCS);
+		rtPrepareRootSignature.AddUnorderedAccessResource(2, 0, ShaderStageCS);
+
+		m_rtPrepareRayQueueState = new PipelineState();
+		m_rtPrepareRayQueueState->Initialize(m_rtFrameScheduler, true);
+		if (!(m_rtPrepareRayQueueState->SetRootSignature(rtPrepareRootSignature))) return false;
+		if (!(m_rtPrepareRayQueueState->SetCS("shader/shaderbin/CS_PrepareRayQueue.cso"))) return false;
+		if (!(m_rtPrepareRayQueueState->CreatePSO())) return false;
+
+		//the command signature of the indirect dispatch, which only contains the thread group counts
+		D3D12_INDIRECT_ARGUMENT_DESC d3dDispatchArgument{};
+		d3dDispatchArgument.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH;
+		D3D12_COMMAND_SIGNATURE_DESC d3dDispatchSignatureDesc{};
+		d3dDispatchSignatureDesc.ByteStride = sizeof(D3D12_DISPATCH_ARGUMENTS);
+		d3dDispatchSignatureDesc.NumArgumentDescs = 1;
+		d3dDispatchSignatureDesc.pArgumentDescs = &d3dDispatchArgument;
+		d3dDispatchSignatureDesc.NodeMask = 0;
+		if (m_rtFrameScheduler->GetDX12Device()->GetDevice()->CreateCommandSignature(&d3dDispatchSignatureDesc, nullptr,
+			IID_PPV_ARGS(&m_d3dDispatchSignature)) < 0) return false;
+
 		//create the resources
 		m_rtTraceRaysInfoBuffer = new ConstantBuffer();
 		m_rtMaterialBuffer = new StructuredBuffer();
@@ -634,24 +971,78 @@ namespace RT::GraphicsAPI
 		if (!(m_rtMaterialBuffer)) return false;
 		if (!m_rtScatteredLightBuffer) return false;
 		if (!m_rtEmittedLightBuffer) return false;
-
+		for (unsigned int i = 0; i < 2; i++)
+		{
+			m_rtRayQueueBuffers[i] = new RWStructuredBuffer();
+			if (!(m_rtRayQueueBuffers[i])) return false;
+			if (!(m_rtRayQueueBuffers[i]->Initialize(m_rtFrameScheduler, 4, MAX_RAYS))) return false;
+		}
+		m_rtRayQueueStateBuffer = new RWStructuredBuffer();
+		m_rtRayQueueArgumentBuffer = new RWStructuredBuffer();
+		m_rtHitBuffer = new RWStructuredBuffer();
+		m_rtMaterialQueueBuffer = new RWStructuredBuffer();
+		m_rtShadingQueueBuffer = new RWStructuredBuffer();
+		m_rtRayBinBuffer = new RWStructuredBuffer();
+		m_rtTempRayBinBuffer = new RWStructuredBuffer();
+		m_rtLightBuffer = new StructuredBuffer();
+		m_rtShadowLightBuffer = new RWStructuredBuffer();
+		if (!m_rtRayQueueStateBuffer) return false;
+		if (!m_rtRayQueueArgumentBuffer) return false;
+		if (!m_rtHitBuffer) return false;
+		if (!m_rtMaterialQueueBuffer) return false;
+		if (!m_rtShadingQueueBuffer) return false;
+		if (!m_rtRayBinBuffer) return false;
+		if (!m_rtTempRayBinBuffer) return false;
+		if (!m_rtLightBuffer) return false;
+		if (!m_rtShadowLightBuffer) return false;
+
+		//the queues of the materials (at least one for meshes without materials)
+		uint32_t iNumMaterials = (rtMeshData.MaterialCount > 0) ? (uint32_t)rtMeshData.MaterialCount : 1;
+
+		//the emissive triangles (a mesh, which was put together by hand, doesn't have a light list yet), the buffer has at least one element
+		if (!(rtMeshData.Lights)) rtMeshData.Lights = Core::BuildLightList(rtMeshData);
+		const std::vector<Core::EmissiveTriangle>& rtLights = rtMeshData.Lights->Triangles;
+		uint32_t iNumLightElements = rtLights.empty() ? 1 : (uint32_t)rtLights.size();
+
+		//the counters are zero initialized, so nothing is appended or counted yet
+		if (!(m_rtRayQueueStateBuffer->Initialize(m_rtFrameScheduler, 4, 3))) return false;
+		if (!(m_rtRayQueueArgumentBuffer->Initialize(m_rtFrameScheduler, sizeof(D3D12_DISPATCH_ARGUMENTS), 1))) return false;
+		if (!(m_rtHitBuffer->Initialize(m_rtFrameScheduler, 32, MAX_RAYS))) return false;
+		if (!(m_rtMaterialQueueBuffer->Initialize(m_rtFrameScheduler, 4, 2 * iNumMaterials))) return false;
+		if (!(m_rtShadingQueueBuffer->Initialize(m_rtFrameScheduler, 4, MAX_RAYS))) return false;
+		if (!(m_rtRayBinBuffer->Initialize(m_rtFrameScheduler, 16, MAX_RAYS))) return false;
+		if (!(m_rtTempRayBinBuffer->Initialize(m_rtFrameScheduler, 16, MAX_RAYS))) return false;
 		if (!(m_rtTraceRaysInfoBuffer->Initialize(m_rtFrameScheduler, sizeof(TraceRaysInfo), {}))) return false;
 		if (!(m_rtMaterialBuffer->Initialize(m_rtFrameScheduler, sizeof(PBRMaterial), rtMeshData.MaterialCount))) return false;
 		if (!(m_rtScatteredLightBuffer->Initialize(m_rtFrameScheduler, 16, MAX_RAYS, DescriptorHeapInfo(m_rtUAVDescriptorHeap, 3)))) return false;
 		if (!(m_rtEmittedLightBuffer->Initialize(m_rtFrameScheduler, 16, MAX_RAYS, DescriptorHeapInfo(m_rtUAVDescriptorHeap, 4)))) return false;
+		if (!(m_rtLightBuffer->Initialize(m_rtFrameScheduler, sizeof(Core::EmissiveTriangle), iNumLightElements))) return false;
+		if (!(m_rtShadowLightBuffer->Initialize(m_rtFrameScheduler, 16, MAX_RAYS))) return false;
+
+		//the shadow rays are traced by an occlusion query, the resolve pass adds the light of the visible ones
+		m_rtTraceShadowRays = new TraceOcclusionRays();
+		if (!m_rtTraceShadowRays) return false;
+		if (!(m_rtTraceShadowRays->Initialize(m_rtFrameScheduler, MAX_RAYS, (uint32_t)(rtMeshData.IndexCount / 3)))) return false;
 
-		//upload the materials to the gpu
+		//upload the materials and the emissive triangles to the gpu
+		std::vector<Core::EmissiveTriangle> rtLightData(iNumLightElements, Core::EmissiveTriangle{});
+		std::copy(rtLights.begin(), rtLights.end(), rtLightData.begin());
 		GPUScheduler rtUploadScheduler;
 		UploadBuffer rtUploadBuffer;
+		UploadBuffer rtLightUploadBuffer;
 		if (!(rtUploadScheduler.Initialize(m_rtFrameScheduler->GetDX12Device()))) return false;
 		if (!(rtUploadBuffer.Initialize(&rtUploadScheduler, sizeof(PBRMaterial) * rtMeshData.MaterialCount))) return false;
 		if (!(rtUploadBuffer.Update(rtMeshData.Materials))) return false;
+		if (!(rtLightUploadBuffer.Initialize(&rtUploadScheduler, sizeof(Core::EmissiveTriangle) * iNumLightElements))) return false;
+		if (!(rtLightUploadBuffer.Update(rtLightData.data()))) return false;
 
 		if (!(rtUploadScheduler.Record())) return false;
 		if (!(m_rtMaterialBuffer->UploadAll(&rtUploadBuffer))) return false;
+		if (!(m_rtLightBuffer->UploadAll(&rtLightUploadBuffer))) return false;
 		if (!(rtUploadScheduler.Execute())) return false;
 		rtUploadScheduler.Flush();
 		
+		rtLightUploadBuffer.Release();
 		rtUploadBuffer.Release();
 		rtUploadScheduler.Release();
 		
@@ -659,32 +1050,51 @@ namespace RT::GraphicsAPI
 		m_rtMesh = new RaytracerMesh();
 		if (!(m_rtMesh->Initialize(m_rtFrameScheduler, rtMeshData))) return false;
 
-		//create the texture atlas
+		//create the texture atlas (the scene cache already contains the packed textures, which are uploaded directly from the mapped file)
 		m_rtTextures = new TextureAtlas();
-		for (uint64_t i = 1; i < rtMeshData.TextureNameCount; i++)
+		if (rtMeshData.Cache)
 		{
-			uint32_t iTextureID = 0; //we don't use this, since the textures are sorted by index
-			if (!(m_rtTextures->AddTexture(&iTextureID, LoadTextureFromFile(rtMeshData.TextureNames[i])))) return false;
+			rtMeshData.Cache->GetTextureAtlas(m_rtTextures->GetTextureData());
+		}
+		else
+		{
+			for (uint64_t i = 1; i < rtMeshData.TextureNameCount; i++)
+			{
+				uint32_t iTextureID = 0; //we don't use this, since the textures are sorted by index
+				if (!(m_rtTextures->AddTexture(&iTextureID, LoadTextureFromFile(rtMeshData.TextureNames[i])))) return false;
+			}
 		}
 		if (!(m_rtTextures->Initialize(m_rtFrameScheduler, DescriptorHeapInfo(m_rtUAVDescriptorHeap, 7)))) return false;
 		
 		//store the info data and make it visible to the gpu
 		m_rtInfoData.ScreenDimensions.x = RT_WINDOW_WIDTH;
 		m_rtInfoData.ScreenDimensions.y = RT_WINDOW_HEIGHT;
-		m_rtInfoData.NumIndices = (uint32_t)(m_rtMesh->GetIndexCount());
+		m_rtInfoData.NumTriangles = (uint32_t)(m_rtMesh->GetIndexCount() / 3);
 		m_rtInfoData.NumRays = MAX_RAYS;
 		m_rtInfoData.MaxRaysPerPixel = MAX_RAYS_PER_PIXEL;
 		m_rtInfoData.RNGSeed.x = 0;
 		m_rtInfoData.RNGSeed.y = 0;
 		m_rtInfoData.RNGSeed.z = 0;
+		m_rtInfoData.UseRayQueue = 0;
+		m_rtInfoData.NumMaterials = iNumMaterials;
+		m_rtInfoData.UseRayBins = 0;
+		m_rtInfoData.NumLights = m_bUseLightSampling ? (uint32_t)rtLights.size() : 0; // CS_ShadeHits.hlsl doesn't sample the lights, if there are none
+		m_rtInfoData.InverseLightPower = (rtMeshData.Lights->TotalPower > 0.0f) ? (1.0f / rtMeshData.Lights->TotalPower) : 0.0f;
+		m_rtInfoData.LastBounce = 0;
+		m_rtInfoData.SampleIndex = 0;
+		m_rtInfoData.Bounce = 0;
+		m_rtInfoData.RussianRouletteDepth = rtSettings.RussianRouletteDepth;
+		m_rtInfoData.ImageSeed = rtSettings.Seed;
 		m_rtTraceRaysInfoBuffer->UpdateAll(&m_rtInfoData);
 		
 		return true;
 	}
 
 
-	//render a single frame
-	bool TraceRays::Render(RWStructuredBuffer* rtBVH)
+	//trace the live rays once: the camera rays (bNewRays) are all traced, every other bounce only traces the rays in the queue with an indirect dispatch (sorted by their bins)
+	//the rays, which hit something, are appended to the queue of the next bounce, sorted by their material and shaded in this order
+	//with light sampling, the shading writes a shadow ray per hit, which is traced by an occlusion query and resolved afterwards (bLastBounce: the bounced rays aren't traced anymore)
+	bool TraceRays::Render(RWStructuredBuffer* rtBVH, RWStructuredBuffer* rtTriangles, RWStructuredBuffer* rtSkipLinks, bool bNewRays, bool bLastBounce, bool bLastTile)
 	{
 		ID3D12CommandQueue* d3dCommandQueue = m_rtFrameScheduler->GetDX12Device()->GetCommandQueue();
 		IDXGISwapChain4* dxSwapChain = m_rtFrameScheduler->GetDX12Device()->GetSwapChain();
@@ -695,35 +1105,214 @@ namespace RT::GraphicsAPI
 		m_rtInfoData.RNGSeed.x = m_stdPRNG();
 		m_rtInfoData.RNGSeed.y = m_stdPRNG();
 		m_rtInfoData.RNGSeed.z = m_stdPRNG();
+		m_rtInfoData.UseRayQueue = bNewRays ? 0 : 1;
+		m_rtInfoData.UseRayBins = ((!bNewRays) && USE_RAY_BINNING) ? 1 : 0;
+		m_rtInfoData.LastBounce = bLastBounce ? 1 : 0;
+		m_rtInfoData.Bounce = bNewRays ? 0 : (m_rtInfoData.Bounce + 1);
 		m_rtTraceRaysInfoBuffer->Update(&m_rtInfoData);
+		if (bLastBounce && bLastTile) m_rtInfoData.SampleIndex++; // the next camera rays are the next samples of the pixels
+
+		//the rays are in the descriptor table of the camera ray generation, so every pass waits for all unordered accesses of the previous one
+		D3D12_RESOURCE_BARRIER d3dUAVBarrier{};
+		d3dUAVBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		d3dUAVBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+		d3dUAVBarrier.UAV.pResource = nullptr;
 
+		D3D12_RESOURCE_BARRIER d3dResourceTransition{};
+		d3dResourceTransition.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		d3dResourceTransition.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+		d3dResourceTransition.Transition.pResource = m_rtRayQueueArgumentBuffer->GetResources()[0];
+		d3dResourceTransition.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+
+		d3dCommandList->ResourceBarrier(1, &d3dUAVBarrier);
+
+		//the bounced rays are traced in the order of their bins (the camera rays are coherent already)
+		if (m_rtInfoData.UseRayBins)
+		{
+			m_rtBinRaysState->Bind();
+			BindResources(rtBVH, rtTriangles, rtSkipLinks);
+			d3dCommandList->Dispatch((MAX_RAYS + 255) / 256, 1, 1);
+
+			if (!(m_rtRayBinSort->Sort(m_rtRayBinBuffer, m_rtTempRayBinBuffer))) return false;
+			d3dCommandList->ResourceBarrier(1, &d3dUAVBarrier);
+		}
+
+		//the intersection
 		m_rtTraceRaysState->Bind();
-		rtBVH->Bind(5, true);
-		m_rtUAVDescriptorHeap->Bind(6, 0, true);
-		m_rtUAVDescriptorHeap->Bind(7, 7, true, false);
+		BindResources(rtBVH, rtTriangles, rtSkipLinks);
+		if (USE_PERSISTENT_THREADS)
+		{
+			//the groups fetch the rays of the queue themselves, so their number doesn't depend on the live rays
+			d3dCommandList->Dispatch(PERSISTENT_THREAD_GROUPS, 1, 1);
+		}
+		else if (bNewRays)
+		{
+			d3dCommandList->Dispatch((MAX_RAYS + 255) / 256, 1, 1);
+		}
+		else
+		{
+			//the thread group count was written by the prepare pass of the last bounce
+			d3dResourceTransition.Transition.StateBefore = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+			d3dResourceTransition.Transition.StateAfter = D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT;
+			d3dCommandList->ResourceBarrier(1, &d3dResourceTransition);
+
+			d3dCommandList->ExecuteIndirect(m_d3dDispatchSignature, 1, m_rtRayQueueArgumentBuffer->GetResources()[0], 0, nullptr, 0);
+
+			d3dResourceTransition.Transition.StateBefore = D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT;
+			d3dResourceTransition.Transition.StateAfter = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+			d3dCommandList->ResourceBarrier(1, &d3dResourceTransition);
+		}
+
+		d3dCommandList->ResourceBarrier(1, &d3dUAVBarrier);
+
+		//turn the appended rays into the queue of the next passes and the hit counts of the materials into their offsets in the shading queue
+		m_rtPrepareRayQueueState->Bind();
 		m_rtTraceRaysInfoBuffer->Bind(0, true);
-		m_rtMaterialBuffer->Bind(3, true);
-		m_rtMesh->Bind(1, 2, true);
-		m_rtTextures->Bind(4, true);
-		
-		D3D12_RESOURCE_BARRIER d3dUAVBarriers[2] = {};
-		d3dUAVBarriers[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-		d3dUAVBarriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-		d3dUAVBarriers[0].UAV.pResource = m_rtScatteredLightBuffer->GetResources()[0];
-		d3dUAVBarriers[1].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-		d3dUAVBarriers[1].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-		d3dUAVBarriers[1].UAV.pResource = m_rtEmittedLightBuffer->GetResources()[0];
-		d3dCommandList->ResourceBarrier(2, d3dUAVBarriers);
+		m_rtRayQueueStateBuffer->Bind(1, true);
+		m_rtRayQueueArgumentBuffer->Bind(2, true);
+		m_rtMaterialQueueBuffer->Bind(3, true);
+		d3dCommandList->Dispatch(1, 1, 1);
 
-		d3dCommandList->Dispatch((MAX_RAYS + 255) / 256, 1, 1);
+		d3dCommandList->ResourceBarrier(1, &d3dUAVBarrier);
+
+		//sort the hits by material and shade them, both passes have one thread per hit
+		d3dResourceTransition.Transition.StateBefore = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+		d3dResourceTransition.Transition.StateAfter = D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT;
+		d3dCommandList->ResourceBarrier(1, &d3dResourceTransition);
+
+		m_rtSortHitsState->Bind();
+		BindResources(rtBVH, rtTriangles, rtSkipLinks);
+		d3dCommandList->ExecuteIndirect(m_d3dDispatchSignature, 1, m_rtRayQueueArgumentBuffer->GetResources()[0], 0, nullptr, 0);
+
+		d3dCommandList->ResourceBarrier(1, &d3dUAVBarrier);
+
+		m_rtShadeHitsState->Bind();
+		BindResources(rtBVH, rtTriangles, rtSkipLinks);
+		d3dCommandList->ExecuteIndirect(m_d3dDispatchSignature, 1, m_rtRayQueueArgumentBuffer->GetResources()[0], 0, nullptr, 0);
+
+		d3dResourceTransition.Transition.StateBefore = D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT;
+		d3dResourceTransition.Transition.StateAfter = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+		d3dCommandList->ResourceBarrier(1, &d3dResourceTransition);
+		d3dCommandList->ResourceBarrier(1, &d3dUAVBarrier);
+
+		//trace the shadow rays and add the light of the visible ones, the number of hits is only known on the gpu, so every slot is traced (the empty ones end right away)
+		if (m_bUseLightSampling)
+		{
+			if (!(m_rtTraceShadowRays->Render(rtBVH, rtTriangles, rtSkipLinks, MAX_RAYS))) return false;
+
+			m_rtResolveShadowRaysState->Bind();
+			BindResources(rtBVH, rtTriangles, rtSkipLinks);
+			d3dCommandList->Dispatch((MAX_RAYS + 255) / 256, 1, 1);
+
+			d3dCommandList->ResourceBarrier(1, &d3dUAVBarrier);
+		}
+
+		m_iCurrentRayQueue = 1 - m_iCurrentRayQueue;
+
+		return true;
+	}
+
+
+
+	//the occlusion query class
+	//class constructor
+	TraceOcclusionRays::TraceOcclusionRays() :
+		//initialize the class variables
+		m_rtFrameScheduler(nullptr),
+		m_rtTraceOcclusionRaysState(nullptr),
+		m_rtInfoData(),
+		m_rtTraceOcclusionRaysInfoBuffer(nullptr),
+		m_rtOcclusionRayBuffer(nullptr),
+		m_rtVisibilityBuffer(nullptr),
+		m_iMaxRays(0)
+	{
+
+	}
+
+	//destructor: uninitializes all our pointers
+	TraceOcclusionRays::~TraceOcclusionRays()
+	{
+
+	}
+
+
+
+	//public class functions
+	bool TraceOcclusionRays::Initialize(GPUScheduler* rtScheduler, uint32_t iMaxRays, uint32_t iNumTriangles)
+	{
+		//assign the device
+		m_rtFrameScheduler = rtScheduler;
+		m_iMaxRays = iMaxRays;
+
+
+		//create the pipeline state, the bvh is bound to the same registers as in the passes of TraceRays
+		RootSignature rtRootSignatures;
+		rtRootSignatures.AddConstantBuffer(0, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(6, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(7, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(16, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(17, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(18, 0, ShaderStageCS);
+
+		m_rtTraceOcclusionRaysState = new PipelineState();
+		m_rtTraceOcclusionRaysState->Initialize(m_rtFrameScheduler, true);
+		if (!(m_rtTraceOcclusionRaysState->SetRootSignature(rtRootSignatures))) return false;
+		if (!(m_rtTraceOcclusionRaysState->SetCS("shader/shaderbin/CS_TraceOcclusionRays.cso"))) return false;
+		if (!(m_rtTraceOcclusionRaysState->CreatePSO())) return false;
+
+		//create the resources
+		m_rtTraceOcclusionRaysInfoBuffer = new ConstantBuffer();
+		m_rtOcclusionRayBuffer = new RWStructuredBuffer();
+		m_rtVisibilityBuffer = new RWStructuredBuffer();
+		if (!m_rtTraceOcclusionRaysInfoBuffer) return false;
+		if (!m_rtOcclusionRayBuffer) return false;
+		if (!m_rtVisibilityBuffer) return false;
+		if (!(m_rtTraceOcclusionRaysInfoBuffer->Initialize(m_rtFrameScheduler, sizeof(TraceOcclusionRaysInfo), {}))) return false;
+		if (!(m_rtOcclusionRayBuffer->Initialize(m_rtFrameScheduler, SIZEOF_RAY, iMaxRays))) return false;
+		if (!(m_rtVisibilityBuffer->Initialize(m_rtFrameScheduler, 4, (iMaxRays + 31) / 32))) return false;
+
+		//store the info data
+		m_rtInfoData.NumRays = 0;
+		m_rtInfoData.NumTriangles = iNumTriangles;
+		m_rtInfoData.Padding.x = 0;
+		m_rtInfoData.Padding.y = 0;
 
-		d3dUAVBarriers[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-		d3dUAVBarriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-		d3dUAVBarriers[0].UAV.pResource = m_rtScatteredLightBuffer->GetResources()[0];
-		d3dUAVBarriers[1].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-		d3dUAVBarriers[1].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-		d3dUAVBarriers[1].UAV.pResource = m_rtEmittedLightBuffer->GetResources()[0];
-		d3dCommandList->ResourceBarrier(2, d3dUAVBarriers);
+
+		return true;
+	}
+
+
+	//test the first iNumRays rays of the ray buffer for occlusion, the result is one bit per ray in the visibility buffer
+	//the info buffer is updated once per frame, so there is one query per frame
+	bool TraceOcclusionRays::Render(RWStructuredBuffer* rtBVH, RWStructuredBuffer* rtTriangles, RWStructuredBuffer* rtSkipLinks, uint32_t iNumRays)
+	{
+		ID3D12GraphicsCommandList* d3dCommandList = m_rtFrameScheduler->GetCommandList();
+		if (iNumRays > m_iMaxRays) return false;
+		if (iNumRays == 0) return true;
+
+
+		//update the info buffer
+		m_rtInfoData.NumRays = iNumRays;
+		m_rtTraceOcclusionRaysInfoBuffer->Update(&m_rtInfoData);
+
+		D3D12_RESOURCE_BARRIER d3dUAVBarrier{};
+		d3dUAVBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		d3dUAVBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+		d3dUAVBarrier.UAV.pResource = nullptr;
+
+		//the rays were written by a previous pass
+		d3dCommandList->ResourceBarrier(1, &d3dUAVBarrier);
+
+		m_rtTraceOcclusionRaysState->Bind();
+		m_rtTraceOcclusionRaysInfoBuffer->Bind(0, true);
+		rtBVH->Bind(1, true);
+		rtTriangles->Bind(2, true);
+		rtSkipLinks->Bind(3, true);
+		m_rtOcclusionRayBuffer->Bind(4, true);
+		m_rtVisibilityBuffer->Bind(5, true);
+		d3dCommandList->Dispatch((iNumRays + 255) / 256, 1, 1);
+
+		d3dCommandList->ResourceBarrier(1, &d3dUAVBarrier);
 
 		return true;
 	}
@@ -740,7 +1329,9 @@ namespace RT::GraphicsAPI
 		m_rtInfoData(),
 		m_rtGenerateImageInfoBuffer(nullptr),
 		m_rtResultBuffer(nullptr),
-		m_rtOutputTexture(nullptr)
+		m_rtOutputTexture(nullptr),
+		m_rtSampleMomentsBuffer(nullptr),
+		m_rtConvergedTileBuffer(nullptr)
 	{
 
 	}
@@ -758,7 +1349,7 @@ namespace RT::GraphicsAPI
 
 
 	//public class functions
-	bool GenerateFinalImage::Initialize(GPUScheduler* rtScheduler, DescriptorHeap* rtUAVDescriptorTable, DXGI_FORMAT dxTargetFormat)
+	bool GenerateFinalImage::Initialize(GPUScheduler* rtScheduler, DescriptorHeap* rtUAVDescriptorTable, const Core::RenderSettings& rtSettings, DXGI_FORMAT dxTargetFormat)
 	{
 		//assign the device
 		m_rtFrameScheduler = rtScheduler;
@@ -773,6 +1364,8 @@ namespace RT::GraphicsAPI
 		rtRootSignatures.AddConstantBuffer(0, 0, ShaderStageCS);
 		rtDescriptorTable.AddUAVRange(3, 0, 4);
 		rtRootSignatures.AddDescriptorTable(rtDescriptorTable, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(7, 0, ShaderStageCS);
+		rtRootSignatures.AddUnorderedAccessResource(8, 0, ShaderStageCS);
 
 		m_rtGenerateImageState = new PipelineState();
 		m_rtGenerateImageState->Initialize(m_rtFrameScheduler, true);
@@ -784,21 +1377,35 @@ namespace RT::GraphicsAPI
 		m_rtGenerateImageInfoBuffer = new ConstantBuffer();
 		m_rtResultBuffer = new RWStructuredBuffer();
 		m_rtOutputTexture = new RWTexture2D();
+		m_rtSampleMomentsBuffer = new RWStructuredBuffer();
+		m_rtConvergedTileBuffer = new RWStructuredBuffer();
 		if (!m_rtGenerateImageInfoBuffer) return false;
 		if (!m_rtResultBuffer) return false;
 		if (!m_rtOutputTexture) return false;
+		if (!m_rtSampleMomentsBuffer) return false;
+		if (!m_rtConvergedTileBuffer) return false;
 
 		if (!(m_rtGenerateImageInfoBuffer->Initialize(m_rtFrameScheduler, sizeof(GenerateFinalImageInfo)))) return false;
 		if (!(m_rtResultBuffer->Initialize(m_rtFrameScheduler, 16, RT_WINDOW_WIDTH * RT_WINDOW_HEIGHT,
 			DescriptorHeapInfo(m_rtUAVDescriptorHeap, 5)))) return false;
 		if (!(m_rtOutputTexture->Initialize(m_rtFrameScheduler, dxTargetFormat,
 			RT_WINDOW_WIDTH, RT_WINDOW_HEIGHT, 1, DescriptorHeapInfo(m_rtUAVDescriptorHeap, 6)))) return false;
+		if (!(m_rtSampleMomentsBuffer->Initialize(m_rtFrameScheduler, 16, RT_WINDOW_WIDTH * RT_WINDOW_HEIGHT))) return false; // zero initialized: no samples and no converged tiles
+		if (!(m_rtConvergedTileBuffer->Initialize(m_rtFrameScheduler, 4, NUM_ADAPTIVE_TILES))) return false;
 
 		//store the info data and make it visible to the gpu
 		m_rtInfoData.ScreenDimensions.x = RT_WINDOW_WIDTH;
 		m_rtInfoData.ScreenDimensions.y = RT_WINDOW_HEIGHT;
 		m_rtInfoData.MaxRaysPerPixel = MAX_RAYS_PER_PIXEL;
 		m_rtInfoData.NumSamples = 1;
+		m_rtInfoData.ErrorThreshold = rtSettings.AdaptiveErrorThreshold;
+		m_rtInfoData.MinSamples = rtSettings.AdaptiveMinSamples;
+		m_rtInfoData.TileOffset.x = 0;
+		m_rtInfoData.TileOffset.y = 0;
+		m_rtInfoData.TileSize.x = RENDER_TILE_WIDTH;
+		m_rtInfoData.TileSize.y = RENDER_TILE_HEIGHT;
+		m_rtInfoData.Padding.x = 0;
+		m_rtInfoData.Padding.y = 0;
 		m_rtGenerateImageInfoBuffer->UpdateAll(&m_rtInfoData);
 
 		return true;
@@ -806,40 +1413,51 @@ namespace RT::GraphicsAPI
 
 
 	//render a single frame
-	bool GenerateFinalImage::Render(bool bApplyResults)
+	bool GenerateFinalImage::Render(uint32_t iTile, bool bApplyResults)
 	{
+		if (iTile >= NUM_RENDER_TILES) return false;
 		ID3D12CommandQueue* d3dCommandQueue = m_rtFrameScheduler->GetDX12Device()->GetCommandQueue();
 		IDXGISwapChain4* dxSwapChain = m_rtFrameScheduler->GetDX12Device()->GetSwapChain();
 		ID3D12GraphicsCommandList* d3dCommandList = m_rtFrameScheduler->GetCommandList();
 
 
-		//update the info buffer
+		//update the info buffer (a sample is complete, when the last render tile was added)
 		if (bApplyResults)
 		{
 			m_rtInfoData.NumSamples |= 0x80000000;
-			m_rtInfoData.NumSamples++;
+			if (iTile == NUM_RENDER_TILES - 1) m_rtInfoData.NumSamples++;
 		}
 		else
 		{
 			m_rtInfoData.NumSamples &= 0x7fffffff;
 		}
+		m_rtInfoData.TileOffset = GetRenderTileOffset(iTile);
 		m_rtGenerateImageInfoBuffer->Update(&m_rtInfoData);
 
 		//the pass to generate the final image
 		m_rtGenerateImageState->Bind();
 		m_rtUAVDescriptorHeap->Bind(1, 3, true);
 		m_rtGenerateImageInfoBuffer->Bind(0, true);
+		m_rtSampleMomentsBuffer->Bind(2, true);
+		m_rtConvergedTileBuffer->Bind(3, true);
 
-		D3D12_RESOURCE_BARRIER d3dUAVBarriers[2] = {};
+		D3D12_RESOURCE_BARRIER d3dUAVBarriers[4] = {};
 		d3dUAVBarriers[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
 		d3dUAVBarriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
 		d3dUAVBarriers[0].UAV.pResource = m_rtResultBuffer->GetResources()[0];
 		d3dUAVBarriers[1].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
 		d3dUAVBarriers[1].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
 		d3dUAVBarriers[1].UAV.pResource = m_rtOutputTexture->GetResource();
-		d3dCommandList->ResourceBarrier(2, d3dUAVBarriers);
+		d3dUAVBarriers[2].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		d3dUAVBarriers[2].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+		d3dUAVBarriers[2].UAV.pResource = m_rtSampleMomentsBuffer->GetResources()[0];
+		d3dUAVBarriers[3].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		d3dUAVBarriers[3].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+		d3dUAVBarriers[3].UAV.pResource = m_rtConvergedTileBuffer->GetResources()[0];
+		d3dCommandList->ResourceBarrier(4, d3dUAVBarriers);
 
-		d3dCommandList->Dispatch((RT_WINDOW_WIDTH + 15) / 16, (RT_WINDOW_HEIGHT + 15) / 16, 1);
+		//one thread group per tile of the adaptive sampling in the render tile
+		d3dCommandList->Dispatch((RENDER_TILE_WIDTH + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE, (RENDER_TILE_HEIGHT + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE, 1);
 
 		d3dUAVBarriers[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
 		d3dUAVBarriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
@@ -847,7 +1465,13 @@ namespace RT::GraphicsAPI
 		d3dUAVBarriers[1].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
 		d3dUAVBarriers[1].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
 		d3dUAVBarriers[1].UAV.pResource = m_rtOutputTexture->GetResource();
-		d3dCommandList->ResourceBarrier(2, d3dUAVBarriers);
+		d3dUAVBarriers[2].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		d3dUAVBarriers[2].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+		d3dUAVBarriers[2].UAV.pResource = m_rtSampleMomentsBuffer->GetResources()[0];
+		d3dUAVBarriers[3].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		d3dUAVBarriers[3].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+		d3dUAVBarriers[3].UAV.pResource = m_rtConvergedTileBuffer->GetResources()[0];
+		d3dCommandList->ResourceBarrier(4, d3dUAVBarriers);
 
 
 		return true;
@@ -867,7 +1491,8 @@ namespace RT::GraphicsAPI
 		m_rtTraceRays(nullptr),
 		m_rtImageGeneration(nullptr),
 		m_rtFinalPass(nullptr),
-		m_rtUAVDescriptorHeap(nullptr)
+		m_rtUAVDescriptorHeap(nullptr),
+		m_iMaxRayDepth(0)
 	{
 
 	}
@@ -885,8 +1510,19 @@ namespace RT::GraphicsAPI
 
 
 	//public class functions
-	bool RaytracerPipeline::Initialize(DX12Device* rtDevice, MeshInfo rtMeshData)
+	bool RaytracerPipeline::Initialize(DX12Device* rtDevice, MeshInfo rtMeshData, const Core::RenderSettings& rtSettings)
 	{
+		//the resolution and the bvh are compiled into the buffers and the shaders, so only the settings of Settings.h can be used for them
+		if ((rtSettings.Width != RT_WINDOW_WIDTH) || (rtSettings.Height != RT_WINDOW_HEIGHT) || (rtSettings.UseBVH != (bool)RT_USE_BVH) ||
+			(rtSettings.UseSAHBVH != (bool)RT_USE_SAH_BVH) || (rtSettings.UseStacklessBVH != (bool)RT_USE_STACKLESS_BVH) ||
+			(rtSettings.UsePersistentThreads != (bool)RT_USE_PERSISTENT_THREADS) || (rtSettings.UseRayBinning != (bool)RT_USE_RAY_BINNING))
+		{
+			std::cout << "The gpu raytracer can't change the image size or the [raytracing] settings at runtime, change them in Settings.h\n";
+			return false;
+		}
+		if (rtSettings.Sampler > 2) return false;
+		m_iMaxRayDepth = rtSettings.MaxRayDepth;
+
 		//assign the device
 		m_rtDevice = rtDevice;
 		ID3D12Device8* d3dDevice = m_rtDevice->GetDevice();
@@ -903,27 +1539,27 @@ namespace RT::GraphicsAPI
 		m_rtUAVDescriptorHeap = new DescriptorHeap();
 		if (!(m_rtUAVDescriptorHeap->Initialize(m_rtFrameScheduler, 8, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV))) return false;
 		
-		CameraInfo rtCamera{};
-		rtCamera.VerticalFOV = RT_CAMERA_FOV;
-		rtCamera.NearZ = RT_CAMERA_NEARZ;
-		rtCamera.FarZ = RT_CAMERA_FARZ;
-		rtCamera.Position = RT_CAMERA_POSITION;
-		rtCamera.FocusPoint = RT_CAMERA_FOCUS_POINT;
-		rtCamera.UpDirection = RT_CAMERA_UP_DIRECTION;
 		m_rtCameraRayGen = new CameraRayGen();
-		if (!(m_rtCameraRayGen->Initialize(m_rtFrameScheduler, m_rtUAVDescriptorHeap, rtCamera))) return false;
+		if (!(m_rtCameraRayGen->Initialize(m_rtFrameScheduler, m_rtUAVDescriptorHeap, rtSettings))) return false;
 
 		m_rtSortPrimitives = new SortPrimitives();
 		if (!(m_rtSortPrimitives->Initialize(m_rtFrameScheduler, rtMeshData.IndexCount / 3, rtMeshData.SceneAABB))) return false;
 		
 		m_rtBuildBVH = new BuildBVH();
 		if (!(m_rtBuildBVH->Initialize(m_rtFrameScheduler, rtMeshData.IndexCount / 3))) return false;
+#if !RT_USE_BVH
+		//the triangle stream is built on the cpu, so it has to happen before the mesh data is moved to the gpu
+		if (!(m_rtBuildBVH->BuildTriangles(rtMeshData))) return false;
+#elif RT_USE_SAH_BVH
+		//the sah build runs on the cpu, so it has to happen before the mesh data is moved to the gpu
+		if (!(m_rtBuildBVH->BuildSAH(rtMeshData))) return false;
+#endif
 
 		m_rtTraceRays = new TraceRays();
-		if (!(m_rtTraceRays->Initialize(m_rtFrameScheduler, m_rtUAVDescriptorHeap, rtMeshData))) return false;
+		if (!(m_rtTraceRays->Initialize(m_rtFrameScheduler, m_rtUAVDescriptorHeap, rtMeshData, rtSettings))) return false;
 
 		m_rtImageGeneration = new GenerateFinalImage();
-		if (!(m_rtImageGeneration->Initialize(m_rtFrameScheduler, m_rtUAVDescriptorHeap))) return false;
+		if (!(m_rtImageGeneration->Initialize(m_rtFrameScheduler, m_rtUAVDescriptorHeap, rtSettings))) return false;
 
 		//create the class that handles the pass which renders a texture to the back buffer
 		m_rtFinalPass = new TextureToScreenPass();
@@ -946,7 +1582,7 @@ namespace RT::GraphicsAPI
 		ID3D12GraphicsCommandList* d3dCommandList = m_rtFrameScheduler->GetCommandList();
 
 
-#if RT_USE_BVH
+#if RT_USE_BVH && !RT_USE_SAH_BVH
 
 		//building the bvh (only once)
 		static bool bBuildBVH = true;
@@ -961,22 +1597,28 @@ namespace RT::GraphicsAPI
 
 
 		//camera ray generation
-		//only generate rays from the camera on the first iteration
+		//only generate rays from the camera on the first iteration, every pass renders one tile of the image
 		static unsigned int iIteration = 0;
+		static unsigned int iTile = 0;
 		if (iIteration == 0)
 		{
-			if (!(m_rtCameraRayGen->Render())) return false;
+			if (!(m_rtCameraRayGen->Render(m_rtImageGeneration->GetConvergedTiles(), iTile))) return false;
 		}
 
 		//if we reached the maximum number of iterations, we start again from the camera
+		//the count of the live rays stays on the gpu, so the bounces after all paths were terminated by the russian roulette are empty indirect dispatches
+		bool bNewRays = (iIteration == 0);
 		iIteration++;
-		if (iIteration == MAX_RAY_DEPTH) iIteration = 0;
+		if (iIteration == m_iMaxRayDepth) iIteration = 0;
+		bool bLastBounce = (iIteration == 0);
 
-		//the ray tracing
-		if (!(m_rtTraceRays->Render(m_rtBuildBVH->GetBVH()))) return false;
+		//the ray tracing of the live rays
+		if (!(m_rtTraceRays->Render(m_rtBuildBVH->GetBVH(), m_rtBuildBVH->GetTriangles(), m_rtBuildBVH->GetSkipLinks(), bNewRays, bLastBounce,
+			iTile == NUM_RENDER_TILES - 1))) return false;
 
-		//the pass to generate the final image
-		if (!(m_rtImageGeneration->Render(iIteration == 0))) return false;
+		//the pass to generate the final image, the next pass continues with the next tile
+		if (!(m_rtImageGeneration->Render(iTile, iIteration == 0))) return false;
+		if (iIteration == 0) iTile = (iTile + 1) % NUM_RENDER_TILES;
 
 		//the final pass
 		m_rtFinalPass->Render(m_rtUAVDescriptorHeap, 6);
@@ -1,11 +1,13 @@
 #pragma once
 
 #include <random>
+#include <span>
 
 #include <DirectXMath.h>
 
 //include the dx12 device class
 #include "Settings.h"
+#include "DefaultSettings.h"
 #include "GPUDevice.h"
 #include "GPUScheduler.h"
 #include "RenderTarget.h"
@@ -14,6 +16,12 @@
 #include "RaytracerMesh.h"
 #include "TextureAtlas.h"
 #include "TextureToScreenPass.h"
+#include "Core/RaytracerBackend.h"
+#include "Core/BVH.h"
+#include "Core/WideBVH.h"
+#include "Core/RadixSort.h"
+#include "Core/SceneCache.h"
+#include "Core/Lights.h"
 
 
 
@@ -22,14 +30,35 @@ namespace RT::GraphicsAPI
 	//global constants
 	//customizeable parameters
 	const unsigned int MAX_RAYS_PER_PIXEL = RT_MAX_RAYS_PER_PIXEL; //number of rays per pixel, the higher this value, the better AA and DOF effects will be
-	const unsigned int MAX_RAY_DEPTH = RT_MAX_RAY_DEPTH; //after shooting this number of rays, we return to shooting a ray from the camera
-	const float AA_SAMPLE_SPREAD = RT_AA_SAMPLE_SPREAD; //anti-aliasing: the bigger the value, the blurrier the image, disabled at 0.0f, default is 1.0f
-	const float DOF_SAMPLE_SPREAD = RT_DOF_SAMPLE_SPREAD; //depth of field: the bigger the value, the stronger the DOF effect, disabled at 0.0f, default is 1.0f
+	//the ray depth, the anti-aliasing, the depth of field, the sampler, the light sampling and the adaptive sampling are read at runtime (Core::RenderSettings)
 
 	//strictly defined parameters
-	const unsigned int MAX_RAYS = RT_WINDOW_WIDTH * RT_WINDOW_HEIGHT * MAX_RAYS_PER_PIXEL;
+	const unsigned int RENDER_TILE_WIDTH = ((RT_RENDER_TILE_SIZE == 0) || (RT_RENDER_TILE_SIZE > RT_WINDOW_WIDTH)) ? RT_WINDOW_WIDTH : RT_RENDER_TILE_SIZE;
+	const unsigned int RENDER_TILE_HEIGHT = ((RT_RENDER_TILE_SIZE == 0) || (RT_RENDER_TILE_SIZE > RT_WINDOW_HEIGHT)) ? RT_WINDOW_HEIGHT : RT_RENDER_TILE_SIZE;
+	const unsigned int NUM_RENDER_TILES_X = (RT_WINDOW_WIDTH + RENDER_TILE_WIDTH - 1) / RENDER_TILE_WIDTH;
+	const unsigned int NUM_RENDER_TILES = NUM_RENDER_TILES_X * ((RT_WINDOW_HEIGHT + RENDER_TILE_HEIGHT - 1) / RENDER_TILE_HEIGHT);
+	const unsigned int MAX_RAYS = RENDER_TILE_WIDTH * RENDER_TILE_HEIGHT * MAX_RAYS_PER_PIXEL; // the ray slots of one render tile, which are reused for every tile
 	const unsigned int SIZEOF_RAY = 8 * 4;
 	const unsigned int SIZEOF_RAYPIXEL = 4 * 4;
+	const bool USE_WIDE_BVH = RT_USE_BVH && RT_USE_SAH_BVH && (RT_BVH_WIDTH > 2); // the same condition as in BVHTraversal.hlsli
+	const uint32_t WIDE_BVH_WIDTH = (RT_BVH_WIDTH == 4) ? 4 : 8;
+	const bool USE_RAY_BINNING = RT_USE_RAY_BINNING;
+	const bool USE_STACKLESS_BVH = RT_USE_STACKLESS_BVH && RT_USE_BVH && (!USE_WIDE_BVH); // the same condition as in BVHTraversal.hlsli
+	const bool USE_PERSISTENT_THREADS = RT_USE_PERSISTENT_THREADS;
+	const unsigned int PERSISTENT_THREAD_GROUPS = RT_PERSISTENT_THREAD_GROUPS;
+	const unsigned int ADAPTIVE_TILE_SIZE = 16; // the same as in AdaptiveSampling.hlsli
+	const unsigned int NUM_ADAPTIVE_TILES = ((RT_WINDOW_WIDTH + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE) * ((RT_WINDOW_HEIGHT + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE);
+
+	static_assert((RT_BVH_WIDTH == 2) || (RT_BVH_WIDTH == 4) || (RT_BVH_WIDTH == 8), "RT_BVH_WIDTH has to be 2, 4 or 8");
+	static_assert((RT_SAMPLER >= 0) && (RT_SAMPLER <= 2), "RT_SAMPLER has to be 0, 1 or 2 (see Sampler.hlsli)");
+	static_assert((RT_RENDER_TILE_SIZE % ADAPTIVE_TILE_SIZE) == 0, "RT_RENDER_TILE_SIZE has to be a multiple of 16 (the tiles of the adaptive sampling)");
+
+
+	//the first pixel of a render tile, the tiles are rendered row by row
+	inline DirectX::XMUINT2 GetRenderTileOffset(uint32_t iTile)
+	{
+		return DirectX::XMUINT2((iTile % NUM_RENDER_TILES_X) * RENDER_TILE_WIDTH, (iTile / NUM_RENDER_TILES_X) * RENDER_TILE_HEIGHT);
+	}
 
 
 	//the camera ray generation modules
@@ -42,16 +71,10 @@ namespace RT::GraphicsAPI
 		float DOFSampleSpread;
 		uint32_t MaxRaysPerPixel;
 		DirectX::XMUINT3 RNGSeed;
-	};
-
-	struct CameraInfo
-	{
-		DirectX::XMFLOAT3 Position;
-		DirectX::XMFLOAT3 FocusPoint;
-		DirectX::XMFLOAT3 UpDirection;
-		float VerticalFOV;
-		float NearZ;
-		float FarZ;
+		DirectX::XMUINT2 TileOffset; // the first pixel of the current render tile
+		DirectX::XMUINT2 TileSize; // the size of every render tile, the ray slots are ordered by the position of their pixel in the tile
+		uint32_t SampleIndex; // the number of camera passes before this one, ray i of a pixel is the sample SampleIndex * MaxRaysPerPixel + i of the pixel
+		uint32_t ImageSeed; // the seed of the settings, it scrambles the sobol points and moves the blue noise mask
 	};
 
 	class CameraRayGen
@@ -81,8 +104,8 @@ namespace RT::GraphicsAPI
 
 
 		//public class functions
-		bool Initialize(GPUScheduler* rtScheduler, DescriptorHeap* rtUAVDescriptorTable, CameraInfo rtCameraData);
-		bool Render();
+		bool Initialize(GPUScheduler* rtScheduler, DescriptorHeap* rtUAVDescriptorTable, const Core::RenderSettings& rtSettings);
+		bool Render(RWStructuredBuffer* rtConvergedTiles, uint32_t iTile);
 
 
 		//helper functions
@@ -102,6 +125,44 @@ namespace RT::GraphicsAPI
 	{
 		uint32_t NumElements;
 		uint32_t SortPassIndex;
+		uint32_t NumTiles;
+		uint32_t Padding;
+	};
+
+	//the onesweep radix sort of (key, value) pairs in 16 byte elements, it is used for the morton codes and for the ray bins
+	class OnesweepSort
+	{
+	private:
+
+		//private member variables
+		GPUScheduler* m_rtFrameScheduler;
+		PipelineState* m_rtSortHistogramState;
+		PipelineState* m_rtSortPrefixSumState;
+		PipelineState* m_rtSortOnesweepState;
+		SortInfo m_rtSortInfoData;
+		ConstantBuffer* m_rtSortInfoBuffer[4];
+		RWStructuredBuffer* m_rtHistogramBuffer; // the digit offsets of all passes and the tile counters
+		RWStructuredBuffer* m_rtPartitionStatusBuffer; // the look-back status of every digit in every tile
+
+
+		//private functions
+
+
+	public: // = usable outside of the class
+
+		//constructor and destructor
+		OnesweepSort();
+		~OnesweepSort();
+
+
+		//public class functions
+		bool Initialize(GPUScheduler* rtScheduler, uint32_t iNumElements);
+		bool Sort(RWStructuredBuffer* rtKeys, RWStructuredBuffer* rtTempKeys); // the histograms have to be reset by the pass, which writes the keys
+
+
+		//helper functions
+		RWStructuredBuffer* GetHistograms() { return m_rtHistogramBuffer; };
+
 	};
 
 	class SortPrimitives
@@ -111,16 +172,11 @@ namespace RT::GraphicsAPI
 		//private member variables
 		GPUScheduler* m_rtFrameScheduler;
 		PipelineState* m_rtGenMortonCodeState;
-		PipelineState* m_rtSortCountState;
-		PipelineState* m_rtSortPrefixSumState;
-		PipelineState* m_rtSortSortState;
+		OnesweepSort* m_rtSort;
 		MortonCodeInfo m_rtMortonCodeInfoData;
-		SortInfo m_rtSortInfoData;
 		ConstantBuffer* m_rtMortonCodeInfoBuffer;
-		ConstantBuffer* m_rtSortInfoBuffer[4];
 		RWStructuredBuffer* m_rtMortonCodeBuffer;
 		RWStructuredBuffer* m_rtTempMortonCodeBuffer;
-		RWStructuredBuffer* m_rtCodeFrequenciesBuffer;
 
 
 		//private functions
@@ -161,13 +217,17 @@ namespace RT::GraphicsAPI
 		GPUScheduler* m_rtFrameScheduler;
 		PipelineState* m_rtBuildLeavesState;
 		PipelineState* m_rtBuildState;
+		PipelineState* m_rtBuildSkipLinksState;
 		BVHInfo m_rtBVHInfoData;
 		ConstantBuffer* m_rtBuildLeavesInfoBuffer;
 		ConstantBuffer* m_rtBVHBuildInfoBuffer[32];
-		RWStructuredBuffer* m_rtBVHBuffer;
+		RWStructuredBuffer* m_rtBVHBuffer; // the AABB nodes or the wide nodes of the collapsed SAH bvh
+		RWStructuredBuffer* m_rtTriangleBuffer; // the intersection-only triangles in the order of the bvh leaves
+		RWStructuredBuffer* m_rtSkipLinkBuffer; // the node after the subtree of every node of the binary bvh for the stackless traversal
 
 
 		//private functions
+		bool Upload(std::span<const std::byte> rtBVH, std::span<const IntersectionTriangle> rtTriangles, std::span<const uint32_t> iSkipLinks);
 
 
 	public: // = usable outside of the class
@@ -180,10 +240,14 @@ namespace RT::GraphicsAPI
 		//public class functions
 		bool Initialize(GPUScheduler* rtScheduler, uint32_t iNumPrimitives);
 		bool Build(RaytracerMesh* rtMesh, RWStructuredBuffer* rtMortonCodes);
+		bool BuildSAH(const MeshInfo& rtMesh);
+		bool BuildTriangles(const MeshInfo& rtMesh);
 
 
 		//helper functions
 		RWStructuredBuffer* GetBVH() { return m_rtBVHBuffer; };
+		RWStructuredBuffer* GetTriangles() { return m_rtTriangleBuffer; };
+		RWStructuredBuffer* GetSkipLinks() { return m_rtSkipLinkBuffer; };
 
 	};
 
@@ -192,12 +256,24 @@ namespace RT::GraphicsAPI
 	struct TraceRaysInfo
 	{
 		DirectX::XMINT2 ScreenDimensions;
-		uint32_t NumIndices;
+		uint32_t NumTriangles;
 		uint32_t NumRays;
 		uint32_t MaxRaysPerPixel;
 		DirectX::XMUINT3 RNGSeed;
+		uint32_t UseRayQueue;
+		uint32_t NumMaterials;
+		uint32_t UseRayBins;
+		uint32_t NumLights;
+		float InverseLightPower;
+		uint32_t LastBounce;
+		uint32_t SampleIndex; // the number of camera passes before the current one
+		uint32_t Bounce; // 0 for the camera rays, selects the dimensions of the sampler
+		uint32_t RussianRouletteDepth; // the paths are terminated randomly from this number of rays on
+		uint32_t ImageSeed; // the seed of the settings, it scrambles the sobol points and moves the blue noise mask
 	};
 
+	class TraceOcclusionRays;
+
 	class TraceRays
 	{
 	private:
@@ -213,10 +289,31 @@ namespace RT::GraphicsAPI
 		StructuredBuffer* m_rtMaterialBuffer;
 		RWStructuredBuffer* m_rtScatteredLightBuffer;
 		RWStructuredBuffer* m_rtEmittedLightBuffer;
+		PipelineState* m_rtPrepareRayQueueState;
+		PipelineState* m_rtSortHitsState;
+		PipelineState* m_rtShadeHitsState;
+		PipelineState* m_rtBinRaysState;
+		PipelineState* m_rtResolveShadowRaysState;
+		RWStructuredBuffer* m_rtRayQueueBuffers[2]; // the queue of the current bounce and the one of the next bounce swap after every bounce
+		RWStructuredBuffer* m_rtRayQueueStateBuffer; // the number of live rays, the append counter and the work counter of the persistent threads
+		RWStructuredBuffer* m_rtRayQueueArgumentBuffer; // the arguments of the indirect dispatch
+		RWStructuredBuffer* m_rtHitBuffer; // the closest hit of every ray
+		RWStructuredBuffer* m_rtMaterialQueueBuffer; // the hit count of every material, followed by the next free slot of every material in the shading queue
+		RWStructuredBuffer* m_rtShadingQueueBuffer; // the hits sorted by material
+		RWStructuredBuffer* m_rtRayBinBuffer; // the bin key and the index of every ray in the queue, the empty slots are sorted behind the rays
+		RWStructuredBuffer* m_rtTempRayBinBuffer;
+		OnesweepSort* m_rtRayBinSort;
+		StructuredBuffer* m_rtLightBuffer; // the emissive triangles with their alias table
+		RWStructuredBuffer* m_rtShadowLightBuffer; // the light of the shadow ray of every entry of the shading queue and its pixel slot
+		TraceOcclusionRays* m_rtTraceShadowRays; // the shadow rays of the shading are its rays
+		ID3D12CommandSignature* m_d3dDispatchSignature;
+		unsigned int m_iCurrentRayQueue;
+		bool m_bUseLightSampling;
 		std::mt19937 m_stdPRNG;
 
 
 		//private functions
+		void BindResources(RWStructuredBuffer* rtBVH, RWStructuredBuffer* rtTriangles, RWStructuredBuffer* rtSkipLinks);
 
 
 	public: // = usable outside of the class
@@ -227,8 +324,8 @@ namespace RT::GraphicsAPI
 
 
 		//public class functions
-		bool Initialize(GPUScheduler* rtScheduler, DescriptorHeap* rtUAVDescriptorTable, MeshInfo rtMeshData);
-		bool Render(RWStructuredBuffer* rtBVH);
+		bool Initialize(GPUScheduler* rtScheduler, DescriptorHeap* rtUAVDescriptorTable, MeshInfo rtMeshData, const Core::RenderSettings& rtSettings);
+		bool Render(RWStructuredBuffer* rtBVH, RWStructuredBuffer* rtTriangles, RWStructuredBuffer* rtSkipLinks, bool bNewRays, bool bLastBounce, bool bLastTile);
 
 
 		//helper functions
@@ -237,12 +334,58 @@ namespace RT::GraphicsAPI
 	};
 
 
+	//the occlusion queries for shadow and visibility rays
+	struct TraceOcclusionRaysInfo
+	{
+		uint32_t NumRays;
+		uint32_t NumTriangles;
+		DirectX::XMUINT2 Padding;
+	};
+
+	class TraceOcclusionRays
+	{
+	private:
+
+		//private member variables
+		GPUScheduler* m_rtFrameScheduler;
+		PipelineState* m_rtTraceOcclusionRaysState;
+		TraceOcclusionRaysInfo m_rtInfoData;
+		ConstantBuffer* m_rtTraceOcclusionRaysInfoBuffer;
+		RWStructuredBuffer* m_rtOcclusionRayBuffer; // the rays of the queries, TMax is the distance to the light or the other point
+		RWStructuredBuffer* m_rtVisibilityBuffer; // one bit per ray, which is set, if nothing is hit between TMin and TMax
+		uint32_t m_iMaxRays;
+
+
+	public: // = usable outside of the class
+
+		//constructor and destructor
+		TraceOcclusionRays();
+		~TraceOcclusionRays();
+
+
+		//public class functions
+		bool Initialize(GPUScheduler* rtScheduler, uint32_t iMaxRays, uint32_t iNumTriangles);
+		bool Render(RWStructuredBuffer* rtBVH, RWStructuredBuffer* rtTriangles, RWStructuredBuffer* rtSkipLinks, uint32_t iNumRays);
+
+
+		//helper functions
+		RWStructuredBuffer* GetRays() { return m_rtOcclusionRayBuffer; };
+		RWStructuredBuffer* GetVisibility() { return m_rtVisibilityBuffer; };
+
+	};
+
+
 	//the final image generation
 	struct GenerateFinalImageInfo
 	{
 		DirectX::XMINT2 ScreenDimensions;
 		uint32_t MaxRaysPerPixel;
-		uint32_t NumSamples;
+		uint32_t NumSamples; // the highest bit is set, if the samples of this pass are added to the result
+		float ErrorThreshold; // the adaptive sampling stops a tile, when the error of all its pixels is below this threshold (never at 0.0f)
+		uint32_t MinSamples;
+		DirectX::XMUINT2 TileOffset; // the first pixel of the current render tile
+		DirectX::XMUINT2 TileSize;
+		DirectX::XMUINT2 Padding;
 	};
 
 	class GenerateFinalImage
@@ -257,6 +400,8 @@ namespace RT::GraphicsAPI
 		ConstantBuffer* m_rtGenerateImageInfoBuffer;
 		RWStructuredBuffer* m_rtResultBuffer;
 		RWTexture2D* m_rtOutputTexture;;
+		RWStructuredBuffer* m_rtSampleMomentsBuffer; // the moments of the luminance of every pixel (see AdaptiveSampling.hlsli)
+		RWStructuredBuffer* m_rtConvergedTileBuffer; // 1 for every tile, which doesn't get new camera rays anymore
 
 
 		//private functions
@@ -270,19 +415,21 @@ namespace RT::GraphicsAPI
 
 
 		//public class functions
-		bool Initialize(GPUScheduler* rtScheduler, DescriptorHeap* rtUAVDescriptorTable,
+		bool Initialize(GPUScheduler* rtScheduler, DescriptorHeap* rtUAVDescriptorTable, const Core::RenderSettings& rtSettings,
 			DXGI_FORMAT dxTargetFormat = DXGI_FORMAT_R16G16B16A16_FLOAT);
-		bool Render(bool bApplyResults = false);
+		bool Render(uint32_t iTile, bool bApplyResults = false);
 
 
 		//helper functions
+		uint32_t GetNumSamples() { return (m_rtInfoData.NumSamples & 0x7fffffff) - 1; };
+		RWStructuredBuffer* GetConvergedTiles() { return m_rtConvergedTileBuffer; };
 
 	};
 
 
 
 	//the raytracer pipeline, which combines all the classes from above
-	class RaytracerPipeline
+	class RaytracerPipeline : public Core::RaytracerBackend
 	{
 	private:
 
@@ -296,6 +443,7 @@ namespace RT::GraphicsAPI
 		GenerateFinalImage*		m_rtImageGeneration;
 		TextureToScreenPass*	m_rtFinalPass;
 		DescriptorHeap*	m_rtUAVDescriptorHeap;
+		uint32_t		m_iMaxRayDepth;
 
 
 		//private functions
@@ -309,11 +457,14 @@ namespace RT::GraphicsAPI
 
 
 		//public class functions
-		bool Initialize(DX12Device* rtDevice, MeshInfo rtMeshData);
-		bool Render();
+		bool Initialize(DX12Device* rtDevice, MeshInfo rtMeshData, const Core::RenderSettings& rtSettings = Core::GetDefaultRenderSettings());
+		bool Render() override;
 
 
 		//helper functions
+		uint32_t GetNumSamples() override { return m_rtImageGeneration ? m_rtImageGeneration->GetNumSamples() : 0; };
+		bool IsConverged() override { return false; }; // the converged tiles stay on the gpu, the window keeps rendering anyway
+		const char* GetBackendName() override { return "Direct3D 12"; };
 
 	};
 }
\ No newline at end of file
@@ -6,13 +6,30 @@
 
 //raytracing properties
 #define RT_SCENE_FILENAME "assets/testscene1.obj"
+#define RT_USE_SCENE_CACHE 1 //stores the loaded scene (and the SAH BVH) in a binary file next to it (RT_SCENE_FILENAME + ".rtcache"), which is loaded much faster at the next start
 #define RT_MAX_RAYS_PER_PIXEL 1; //number of rays per pixel, the higher this value, the better AA and DOF effects will be
-#define RT_MAX_RAY_DEPTH 3; //after shooting this number of rays, we return to shooting a ray from the camera
+#define RT_MAX_RAY_DEPTH 8; //the maximum number of rays of a path, after shooting this number of rays, we return to shooting a ray from the camera
+#define RT_RUSSIAN_ROULETTE_DEPTH 3 //after this number of rays, a path is terminated randomly depending on its throughput (russian roulette), the surviving paths are scaled up instead, disabled at RT_MAX_RAY_DEPTH
 #define RT_AA_SAMPLE_SPREAD 1.5f; //anti-aliasing: the bigger the value, the blurrier the image, disabled at 0.0f, default is 1.0f
 #define RT_DOF_SAMPLE_SPREAD 0.0f; //depth of field: the bigger the value, the stronger the DOF effect, disabled at 0.0f, default is 1.0f
 #define RT_USE_BVH 1 //determines the usage of a bounding volume hierarchy (0: do not use BVH, 1: use BVH)
+#define RT_USE_SAH_BVH 0 //chooses the BVH builder (0: fast build from morton codes, 1: slower binned SAH build on the CPU, which results in much faster ray tracing)
+#define RT_BVH_WIDTH 8 //the number of children per node of the SAH BVH (2: binary tree, 4 or 8: wide BVH with 8 bit child bounds, whose children are tested at once), the morton code BVH is always binary
+#define RT_USE_STACKLESS_BVH 1 //traverses the binary BVH with a skip link per node instead of a stack, which saves the stack of every thread (0: front-to-back with a stack, which tests fewer triangles, 1: skip links), the wide BVH always uses its short stack
+#define RT_USE_PERSISTENT_THREADS 1 //traces the rays with threads, which fetch batches of rays until the queue is empty: a fixed number of thread groups on the gpu, a work stealing thread pool on the cpu (0: one thread per ray, 1: persistent threads)
+#define RT_PERSISTENT_THREAD_GROUPS 512 //the number of thread groups (of 256 threads) of the persistent threads, enough to fill the gpu
+#define RT_USE_RAY_BINNING 1 //sorts the rays of every bounce after the first by their screen tile and direction before tracing them, so neighbouring threads traverse the same nodes (0: trace in queue order, 1: trace in binned order)
+#define RT_USE_LIGHT_SAMPLING 1 //next-event estimation: every hit also traces a shadow ray to a random point on an emissive triangle (picked by its power), this light and the light found by the bounced rays are combined with multiple importance sampling (0: lights are only found by the bounced rays, 1: sample the emissive triangles)
+#define RT_RANDOM_SEED 0 //the seed of all random numbers, so two renders with the same settings and seed are identical (the headless cpu raytracer can change it with --seed)
+#define RT_SAMPLER 1 //the random numbers of the camera rays and the shading, indexed by pixel, sample and dimension (0: xorshift white noise, 1: owen scrambled sobol points, 2: sobol points shifted by a blue noise mask, so the remaining noise is blue noise)
+#define RT_ADAPTIVE_ERROR_THRESHOLD 0.01f //adaptive sampling: a tile of 16x16 pixels stops getting new samples, when the estimated error of all its pixels in the displayed image is below this value (one step of an 8 bit color is about 0.004), disabled at 0.0f
+#define RT_ADAPTIVE_MIN_SAMPLES 16 //the number of samples, which every pixel gets before its error estimate is trusted
+#define RT_RENDER_TILE_SIZE 512 //renders the image in tiles of this size (a multiple of 16) one after the other, so the ray buffers only hold the rays of one tile and every dispatch only covers one tile, 0 renders the whole image at once
 #define RT_MAX_TIME 1e30f //can be used in the expression below
 #define RT_MAX_SECONDS 600.0f //the maximum time in seconds bofore the raytracer finishes (this can be very useful for tesing and comparisons)
+#define RT_MAX_SAMPLES 64 //the headless cpu raytracer stops after accumulating this number of samples per pixel (or after RT_MAX_SECONDS or when the adaptive sampling converged everywhere)
+#define RT_OUTPUT_FILENAME "output.ppm" //the headless cpu raytracer writes the final image to this file
+#define RT_SETTINGS_FILENAME "settings.ini" //the values of this file are only the defaults, the settings file overrides them at runtime, if it exists (see settings.example.ini for the names)
 
 //camera settings
 #define RT_CAMERA_FOV 1.2f //the field of view of the camera in radians
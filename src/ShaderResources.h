@@ -2320,6 +2320,17 @@ namespace RT::GraphicsAPI
 			return true;
 		}
 
+		bool Upload(UploadBuffer* rtSourceBuffer, UINT64 iNumBytes = 0, UINT64 iSourceOffset = 0, UINT64 iDestinationOffset = 0)
+		{
+			ID3D12GraphicsCommandList6* d3dCommandList = m_rtScheduler->GetCommandList();
+			unsigned int iIndex = 0;
+
+			if (iNumBytes == 0) iNumBytes = (UINT64)m_iNumElements * (UINT64)m_iElementSize;
+			if (iNumBytes + iDestinationOffset > (UINT64)m_iNumElements * (UINT64)m_iElementSize) return false;
+
+			return rtSourceBuffer->Upload(m_d3dResource[iIndex], D3D12_RESOURCE_STATE_UNORDERED_ACCESS, iNumBytes, iSourceOffset, iDestinationOffset);
+		}
+
 		bool Readback(ReadbackBuffer* rtDestinationBuffer, UINT64 iNumBytes = 0, UINT64 iSourceOffset = 0, UINT64 iDestinationOffset = 0)
 		{
 			ID3D12GraphicsCommandList6* d3dCommandList = m_rtScheduler->GetCommandList();
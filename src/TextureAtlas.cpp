@@ -10,8 +10,7 @@ namespace RT::GraphicsAPI
 	TextureAtlas::TextureAtlas() :
 		//initialize the variables
 		m_rtScheduler(nullptr),
-		m_stdTextureIDs(),
-		m_stdTextureData(),
+		m_rtTextureData(),
 		m_d3dTextureAtlas(nullptr),
 		m_rtTextureIDs(nullptr),
 		m_iBufferSize(0)
@@ -32,83 +31,20 @@ namespace RT::GraphicsAPI
 
 
 	//public class functions
-	//add a texture to the arrays
+	//add a texture to the atlas (the packing is done by the core library, so the cpu and gpu backends use the same offsets)
 	bool TextureAtlas::AddTexture(uint32_t* iTextureID, TextureInfo rtProperties)
 	{
-		if (iTextureID)
-		{
-			*iTextureID = 0;
-		}
-
-		//make a default texture for  meshes that don't use any textures
-		if (m_iBufferSize == 0)
-		{
-			TextureID rtTextureID{};
-			rtTextureID.Offset = 0;
-			rtTextureID.Width = 1;
-			rtTextureID.Height = 1;
-			rtTextureID.RowPitch = 1;
-
-			TextureInfo rtTextureData{};
-			rtTextureData.Data = (void*)(new uint8_t[8]);
-			memset(rtTextureData.Data, 0xffffffff, 8);
-			rtTextureData.Width = 1;
-			rtTextureData.Height = 1;
-			rtTextureData.BytesPerChannel = 2;
-			rtTextureData.ChannelCount = 4;
-
-			m_stdTextureIDs.push_back(rtTextureID);
-			m_stdTextureData.push_back(rtTextureData);
-			m_iBufferSize += 16;
-		}
-
-		//some safety checks
-		if ((rtProperties.ChannelCount != 4) || (rtProperties.BytesPerChannel != 2)) return false;
-		if ((unsigned int)(rtProperties.ChannelCount) * (unsigned int)(rtProperties.BytesPerChannel) != 8) return false;
-
-		//generate the texture ID and store the texture data
-		TextureID rtTextureID{};
-		rtTextureID.Offset = m_iBufferSize;
-		rtTextureID.Width = rtProperties.Width;
-		rtTextureID.Height = rtProperties.Height;
-		rtTextureID.RowPitch = rtProperties.Width;
-
-		m_stdTextureIDs.push_back(rtTextureID);
-		m_stdTextureData.push_back(rtProperties);
-		m_iBufferSize += ((rtTextureID.Width * rtTextureID.Height * 8) + 15) & ~15; //align the buffer to a multiple of 16
-
-		return true;
+		return m_rtTextureData.AddTexture(iTextureID, rtProperties);
 	}
 
 
 	bool TextureAtlas::Initialize(GPUScheduler* rtScheduler, DescriptorHeapInfo rtDescriptorHeapInfo)
 	{
-		//make a default texture for  meshes that don't use any textures if it wasn't already created
-		if (m_iBufferSize == 0)
-		{
-			TextureID rtTextureID{};
-			rtTextureID.Offset = 0;
-			rtTextureID.Width = 1;
-			rtTextureID.Height = 1;
-			rtTextureID.RowPitch = 1;
-
-			TextureInfo rtTextureData{};
-			rtTextureData.Data = (void*)(new uint8_t[8]);
-			memset(rtTextureData.Data, 0xffffffff, 8);
-			rtTextureData.Width = 1;
-			rtTextureData.Height = 1;
-			rtTextureData.BytesPerChannel = 2;
-			rtTextureData.ChannelCount = 4;
-
-			m_stdTextureIDs.push_back(rtTextureID);
-			m_stdTextureData.push_back(rtTextureData);
-			m_iBufferSize += 16;
-		}
-
-
 		m_rtScheduler = rtScheduler;
 		ID3D12Device8* d3dDevice = m_rtScheduler->GetDX12Device()->GetDevice();
 		unsigned int iNumViews = m_rtScheduler->GetNumMaxTasks();
+		m_iBufferSize = (unsigned int)m_rtTextureData.GetTexelDataSize();
+		unsigned int iTextureIDsSize = sizeof(TextureID) * m_rtTextureData.GetTextureCount();
 
 
 		//fill the resource description
@@ -155,7 +91,7 @@ namespace RT::GraphicsAPI
 		}
 
 		m_rtTextureIDs = new StructuredBuffer();
-		if (!(m_rtTextureIDs->Initialize(m_rtScheduler, sizeof(TextureID), m_stdTextureIDs.size()))) return false;
+		if (!(m_rtTextureIDs->Initialize(m_rtScheduler, sizeof(TextureID), m_rtTextureData.GetTextureCount()))) return false;
 
 
 		GPUScheduler rtUploadScheduler;
@@ -163,43 +99,24 @@ namespace RT::GraphicsAPI
 
 		if (!(rtUploadScheduler.Initialize(m_rtScheduler->GetDX12Device()))) return false;
 		ID3D12GraphicsCommandList6* d3dCommandList = rtUploadScheduler.GetCommandList();
-		if (!(rtUploadBuffer.Initialize(&rtUploadScheduler, max(m_iBufferSize, sizeof(TextureID) * m_stdTextureIDs.size())))) return false;
+		if (!(rtUploadBuffer.Initialize(&rtUploadScheduler, max(m_iBufferSize, iTextureIDsSize)))) return false;
 
-		//upload the textures
-		unsigned int iOffset = 0;
-		for (unsigned int i = 0; i < m_stdTextureData.size(); i++)
-		{
-			TextureInfo rtTextureData = m_stdTextureData[i];
-
-			unsigned int iNumBytes = rtTextureData.Width * rtTextureData.Height * 8;
-			if (!(rtUploadBuffer.Update(rtTextureData.Data, iNumBytes, iOffset))) return false;
-			iOffset += iNumBytes;
-		}
+		//upload the textures (they are already packed in the right layout)
+		if (!(rtUploadBuffer.Update(m_rtTextureData.GetTexelData(), m_iBufferSize, 0))) return false;
 		if (!(rtUploadScheduler.Record())) return false;
 		if (!(rtUploadBuffer.Upload(m_d3dTextureAtlas, D3D12_RESOURCE_STATE_SHADER_RESOURCE, m_iBufferSize, 0, 0))) return false;
 		if (!(rtUploadScheduler.Execute())) return false;
 		rtUploadScheduler.Flush();
 
 		//upload the texture IDs
-		iOffset = 0;
-		for (unsigned int i = 0; i < m_stdTextureIDs.size(); i++)
-		{
-			TextureID rtTextureID = m_stdTextureIDs[i];
-
-			if (!(rtUploadBuffer.Update(&rtTextureID, sizeof(TextureID), iOffset))) return false;
-			iOffset += sizeof(TextureID);
-		}
+		if (!(rtUploadBuffer.Update(m_rtTextureData.GetTextureIDs(), iTextureIDsSize, 0))) return false;
 		if (!(rtUploadScheduler.Record())) return false;
-		if (!(m_rtTextureIDs->UploadAll(&rtUploadBuffer, sizeof(TextureID) * m_stdTextureIDs.size()))) return false;
+		if (!(m_rtTextureIDs->UploadAll(&rtUploadBuffer, iTextureIDsSize))) return false;
 		if (!(rtUploadScheduler.Execute())) return false;
 		rtUploadScheduler.Flush();
 
-		for (unsigned int i = 0; i < m_stdTextureData.size(); i++)
-		{
-			delete[] m_stdTextureData[i].Data;
-		}
-		m_stdTextureIDs.clear();
-		m_stdTextureData.clear();
+		//the textures are on the gpu now, so we don't need the cpu copy anymore
+		m_rtTextureData = Core::TextureAtlasData();
 
 		return true;
 	}
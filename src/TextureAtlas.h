@@ -5,19 +5,14 @@
 #include "GPUScheduler.h"
 #include "ShaderResources.h"
 #include "RaytracerMesh.h"
+#include "Core/Textures.h"
 
 
 
 namespace RT::GraphicsAPI
 {
 
-	struct TextureID
-	{
-		uint32_t Offset;
-		uint32_t Width;
-		uint32_t Height;
-		uint32_t RowPitch;
-	};
+	using Core::TextureID;
 
 
 	class TextureAtlas
@@ -26,8 +21,7 @@ namespace RT::GraphicsAPI
 
 		//declare variables, which store some useful data
 		GPUScheduler* m_rtScheduler;
-		std::vector<TextureID>	m_stdTextureIDs;
-		std::vector<TextureInfo> m_stdTextureData;
+		Core::TextureAtlasData	m_rtTextureData;
 		ID3D12Resource2* m_d3dTextureAtlas;
 		StructuredBuffer* m_rtTextureIDs;
 		unsigned int	m_iBufferSize;
@@ -49,10 +43,11 @@ namespace RT::GraphicsAPI
 
 
 		//helper functions
-		unsigned int GetTextureCount() { return m_stdTextureIDs.size(); };
+		unsigned int GetTextureCount() { return m_rtTextureData.GetTextureCount(); };
 
-		TextureID* GetTextureIDs() { return m_stdTextureIDs.data(); };
-		unsigned int GetTextureIDCount() { return m_stdTextureIDs.size(); };
+		const TextureID* GetTextureIDs() { return m_rtTextureData.GetTextureIDs(); };
+		Core::TextureAtlasData* GetTextureData() { return &m_rtTextureData; };
+		unsigned int GetTextureIDCount() { return m_rtTextureData.GetTextureCount(); };
 
 	};
 